@@ -0,0 +1,421 @@
+#include "bench_report.h"
+
+#include "utils/json.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+// Timing differences below this are noise whatever the threshold says.
+constexpr f64 kMinRegressionMs = 0.05;
+
+/**************************************
+*       WRITING
+**************************************/
+
+FrameTimeStats ComputeFrameTimeStats(f64 *samples, u32 count)
+{
+	FrameTimeStats stats = {};
+	if (count == 0)
+	{
+		return stats;
+	}
+
+	std::sort(samples, samples + count);
+
+	f64 total = 0.0;
+	for (u32 i = 0; i < count; ++i)
+	{
+		total += samples[i];
+	}
+
+	auto percentile = [samples, count](f64 fraction)
+	{
+		const u32 rank = (u32)std::ceil(fraction * (f64)count);
+		return samples[std::clamp(rank, 1u, count) - 1];
+	};
+
+	stats.mean = total / (f64)count;
+	stats.p50  = percentile(0.50);
+	stats.p90  = percentile(0.90);
+	stats.p99  = percentile(0.99);
+	stats.max  = samples[count - 1];
+
+	return stats;
+}
+
+bool WriteBenchReport(const BenchReport &report, const char *path)
+{
+	FILE *file = fopen(path, "w");
+	if (file == nullptr)
+	{
+		CLOG_ERR("Failed to open \"", path, "\" for writing.");
+		return EXIT_FAILURE;
+	}
+
+	fprintf(file, "{\n\t\"device\": ");
+	WriteJsonString(file, report.device.c_str());
+	fprintf(file, ",\n\t\"frames\": %u,\n", report.frameCount);
+	fprintf(file, "\t\"warmupFrames\": %u,\n", report.warmupFrames);
+	fprintf(file, "\t\"startupMs\": %.4f,\n", report.startupMs);
+	fprintf(file, "\t\"scenes\": {");
+
+	for (size_t i = 0; i < report.scenes.size(); ++i)
+	{
+		const SceneReport &scene = report.scenes[i];
+
+		fprintf(file, i == 0 ? "\n\t\t" : ",\n\t\t");
+		WriteJsonString(file, scene.name);
+		fprintf(file, ": {\n");
+		fprintf(file, "\t\t\t\"instanceCount\": %u,\n", scene.instanceCount);
+		fprintf(file, "\t\t\t\"drawCount\": %u,\n", scene.drawCount);
+		fprintf(file, "\t\t\t\"pipelineCount\": %u,\n", scene.pipelineCount);
+		fprintf(file, "\t\t\t\"lightCount\": %u,\n", scene.lightCount);
+		fprintf(file, "\t\t\t\"msaaSamples\": %u,\n", scene.msaaSamples);
+		fprintf(file, "\t\t\t\"setupMs\": %.4f,\n", scene.setupMs);
+
+		fprintf(file,
+				"\t\t\t\"frameMs\": {\"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, "
+				"\"max\": %.4f},\n",
+				scene.frameMs.mean,
+				scene.frameMs.p50,
+				scene.frameMs.p90,
+				scene.frameMs.p99,
+				scene.frameMs.max
+		);
+
+		fprintf(file, "\t\t\t\"phaseMs\": {");
+		for (u32 phase = 0; phase < kBenchPhaseCount; ++phase)
+		{
+			fprintf(file,
+					"%s\"%s\": %.4f",
+					phase == 0 ? "" : ", ",
+					kBenchPhaseNames[phase],
+					scene.phaseMs[phase]
+			);
+		}
+		fprintf(file, "},\n");
+
+		if (scene.allocationsPerFrame.has_value())
+		{
+			const f64 allocations = scene.allocationsPerFrame.value();
+			fprintf(file, "\t\t\t\"allocationsPerFrame\": %.4f\n", allocations);
+		}
+		else
+		{
+			fprintf(file, "\t\t\t\"allocationsPerFrame\": null\n");
+		}
+		fprintf(file, "\t\t}");
+	}
+
+	fprintf(file, "\n\t}\n}\n");
+
+	const bool failed = ferror(file) != 0;
+	fclose(file);
+
+	if (failed)
+	{
+		CLOG_ERR("Failed to write \"", path, "\".");
+		return EXIT_FAILURE;
+	}
+
+	CLOG_INFO("Report written to \"", path, "\".");
+	return EXIT_SUCCESS;
+}
+
+/**************************************
+*       COMPARISON
+**************************************/
+
+using FlatMetrics = std::vector<std::pair<std::string, f64>>;
+
+/* Just enough JSON to read the reports back: numbers are collected under their dotted path,
+ * strings, booleans and nulls are skipped. */
+class JsonFlattener
+{
+public:
+	explicit JsonFlattener(const std::string &text)
+		: mText(text)
+	{
+	}
+
+	bool Parse(FlatMetrics &metrics)
+	{
+		std::string path;
+		if (!ParseValue(path, metrics))
+		{
+			return false;
+		}
+
+		SkipWhitespace();
+		return mPos == mText.size();
+	}
+
+private:
+	void SkipWhitespace()
+	{
+		while (mPos < mText.size() && isspace((unsigned char)mText[mPos]))
+		{
+			++mPos;
+		}
+	}
+
+	bool Consume(char c)
+	{
+		SkipWhitespace();
+		if (mPos < mText.size() && mText[mPos] == c)
+		{
+			++mPos;
+			return true;
+		}
+
+		return false;
+	}
+
+	bool ParseString(std::string &string)
+	{
+		if (!Consume('"'))
+		{
+			return false;
+		}
+
+		string.clear();
+		while (mPos < mText.size() && mText[mPos] != '"')
+		{
+			if (mText[mPos] == '\\' && mPos + 1 < mText.size())
+			{
+				++mPos;
+			}
+			string += mText[mPos++];
+		}
+
+		return Consume('"');
+	}
+
+	bool ParseValue(const std::string &path, FlatMetrics &metrics)
+	{
+		SkipWhitespace();
+		if (mPos >= mText.size())
+		{
+			return false;
+		}
+
+		const char c = mText[mPos];
+		if (c == '{')
+		{
+			return ParseObject(path, metrics);
+		}
+		if (c == '[')
+		{
+			return ParseArray(path, metrics);
+		}
+		if (c == '"')
+		{
+			std::string ignored;
+			return ParseString(ignored);
+		}
+
+		for (const char *literal : {"true", "false", "null"})
+		{
+			const size_t length = strlen(literal);
+			if (mText.compare(mPos, length, literal) == 0)
+			{
+				mPos += length;
+				return true;
+			}
+		}
+
+		const char *begin = mText.c_str() + mPos;
+		char       *end   = nullptr;
+		const f64   value = strtod(begin, &end);
+		if (end == begin)
+		{
+			return false;
+		}
+
+		mPos += (size_t)(end - begin);
+		metrics.emplace_back(path, value);
+		return true;
+	}
+
+	bool ParseObject(const std::string &path, FlatMetrics &metrics)
+	{
+		Consume('{');
+		if (Consume('}'))
+		{
+			return true;
+		}
+
+		std::string key;
+		do
+		{
+			if (!ParseString(key) || !Consume(':'))
+			{
+				return false;
+			}
+			if (!ParseValue(path.empty() ? key : path + "." + key, metrics))
+			{
+				return false;
+			}
+		} while (Consume(','));
+
+		return Consume('}');
+	}
+
+	bool ParseArray(const std::string &path, FlatMetrics &metrics)
+	{
+		Consume('[');
+		if (Consume(']'))
+		{
+			return true;
+		}
+
+		u32 index = 0;
+		do
+		{
+			if (!ParseValue(path + "." + std::to_string(index++), metrics))
+			{
+				return false;
+			}
+		} while (Consume(','));
+
+		return Consume(']');
+	}
+
+private:
+	const std::string &mText;
+	size_t             mPos = 0;
+};
+
+static bool LoadMetrics(const char *path, FlatMetrics &metrics)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		CLOG_ERR("Failed to open \"", path, "\".");
+		return EXIT_FAILURE;
+	}
+
+	std::stringstream stream;
+	stream << file.rdbuf();
+	const std::string text = stream.str();
+
+	JsonFlattener parser(text);
+	if (!parser.Parse(metrics))
+	{
+		CLOG_ERR("\"", path, "\" is not a valid report.");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+static bool EndsWith(const std::string &string, const char *suffix)
+{
+	const size_t length = strlen(suffix);
+	return string.size() >= length && string.compare(string.size() - length, length, suffix) == 0;
+}
+
+// Timings live in "...Ms" values or objects, configuration values are not metrics.
+static bool IsTimingKey(const std::string &key)
+{
+	if (EndsWith(key, "Ms"))
+	{
+		return true;
+	}
+
+	const size_t lastDot = key.rfind('.');
+	return lastDot != std::string::npos && EndsWith(key.substr(0, lastDot), "Ms");
+}
+
+bool CompareBenchReports(
+		const char *basePath,
+		const char *newPath,
+		f64         threshold,
+		u32        &regressions
+)
+{
+	FlatMetrics baseMetrics;
+	FlatMetrics newMetrics;
+	if (LoadMetrics(basePath, baseMetrics) == EXIT_FAILURE
+		|| LoadMetrics(newPath, newMetrics) == EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	regressions = 0;
+	for (const auto &[key, baseValue] : baseMetrics)
+	{
+		const bool timing      = IsTimingKey(key);
+		const bool allocations = EndsWith(key, "allocationsPerFrame");
+		if (!timing && !allocations)
+		{
+			continue;
+		}
+
+		auto found = std::find_if(
+				newMetrics.begin(),
+				newMetrics.end(),
+				[&key](const std::pair<std::string, f64> &metric) { return metric.first == key; }
+		);
+		if (found == newMetrics.end())
+		{
+			CLOG_WARN(key, " is missing from \"", newPath, "\".");
+			continue;
+		}
+
+		const f64 newValue = found->second;
+		const f64 growth   = newValue - baseValue;
+
+		bool regressed = false;
+		if (timing)
+		{
+			// A base of 0 has no relative growth, the absolute amount alone decides.
+			regressed = growth > kMinRegressionMs
+					 && (baseValue <= 0.0 || growth / baseValue > threshold);
+		}
+		else
+		{
+			// Steady state frames are meant to allocate nothing, any growth is a regression.
+			regressed = newValue > baseValue;
+		}
+
+		if (regressed)
+		{
+			++regressions;
+			CLOG_WARN(
+					"REGRESSION ",
+					key,
+					": ",
+					baseValue,
+					" -> ",
+					newValue,
+					" (+",
+					growth,
+					")."
+			);
+		}
+		else
+		{
+			CLOG_INFO(key, ": ", baseValue, " -> ", newValue, ".");
+		}
+	}
+
+	if (regressions > 0)
+	{
+		CLOG_WARN(regressions, " regressions past ", threshold * 100.0, "%.");
+	}
+	else
+	{
+		CLOG_INFO("No regressions past ", threshold * 100.0, "%.");
+	}
+
+	return EXIT_SUCCESS;
+}
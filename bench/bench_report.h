@@ -0,0 +1,88 @@
+#ifndef HEADER_BENCH_REPORT_H
+#define HEADER_BENCH_REPORT_H
+
+#include "definitions.h"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+/* JSON report of the render benchmark and the comparison of two of them.
+ *
+ * Every timing is in milliseconds and lower is better, as are the allocation counts. Comparing
+ * flattens both reports to dotted keys ("scenes.lights.frameMs.p99") and flags the metrics of the
+ * new report that grew past the threshold; configuration values (instance counts, frame counts)
+ * are not compared. */
+
+// CPU phases of a benchmark frame, in the order they run.
+enum class BenchPhase
+{
+	eResize,
+	eWait,
+	eSimulate,
+	eExtract,
+	eRecord,
+	eSubmit,
+	eCount
+};
+
+constexpr u32 kBenchPhaseCount = (u32)BenchPhase::eCount;
+
+constexpr const char *kBenchPhaseNames[kBenchPhaseCount] = {
+		"resize", "wait", "simulate", "extract", "record", "submit"
+};
+
+struct FrameTimeStats
+{
+	f64 mean = 0.0;
+	f64 p50  = 0.0;
+	f64 p90  = 0.0;
+	f64 p99  = 0.0;
+	f64 max  = 0.0;
+};
+
+struct SceneReport
+{
+	const char *name = "";
+
+	u32 instanceCount = 0;
+	u32 drawCount     = 0;
+	u32 pipelineCount = 0;
+	u32 lightCount    = 0;
+	u32 msaaSamples   = 0;
+
+	f64            setupMs = 0.0;
+	FrameTimeStats frameMs;
+	f64            phaseMs[kBenchPhaseCount] = {};// Mean per frame
+
+	// Heap allocations, only counted when built with COV_TRACK_ALLOCATIONS.
+	std::optional<f64> allocationsPerFrame;
+};
+
+struct BenchReport
+{
+	std::string device;
+	u32         frameCount   = 0;
+	u32         warmupFrames = 0;
+	f64         startupMs    = 0.0;
+
+	std::vector<SceneReport> scenes;
+};
+
+// Sorts samples in place, nearest-rank percentiles.
+FrameTimeStats ComputeFrameTimeStats(f64 *samples, u32 count);
+
+bool WriteBenchReport(const BenchReport &report, const char *path);
+
+/* Logs every metric of newPath against basePath. A metric regresses when it grew by more than
+ * threshold (0.1 is 10%) and by more than a small absolute amount, so sub-microsecond phases do
+ * not flag noise. A timing that was 0 has no relative growth, the absolute amount alone decides.
+ * Allocation counts regress on any increase. */
+bool CompareBenchReports(
+		const char *basePath,
+		const char *newPath,
+		f64         threshold,
+		u32        &regressions
+);
+
+#endif// HEADER_BENCH_REPORT_H
@@ -0,0 +1,165 @@
+#include "definitions.h"
+#include "headless_context.h"
+#include "render/vk_dispatch.h"
+#include "utils/logger.h"
+#include "vulkan/vulkan_core.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+/**************************************
+*       DISPATCH MICROBENCHMARK
+**************************************/
+
+/* Per-call cost of recording through the loader's exported trampolines versus the pointers
+ * VulkanDispatch loads from the driver. Runs headless on the first device with a graphics queue
+ * and records dynamic state commands, which are valid outside a render pass and about as cheap
+ * as a driver call gets, so the dispatch overhead is a visible share of it. */
+
+using BenchClock = std::chrono::steady_clock;
+
+// Recorded per command buffer before it is reset, keeps command memory bounded.
+constexpr u32 kCallsPerBatch = 100000;
+
+struct BenchContext
+{
+	HeadlessContext headless;
+	VkCommandPool   commandPool   = VK_NULL_HANDLE;
+	VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+};
+
+static bool CreateContext(BenchContext &context)
+{
+	if (CreateHeadlessContext(context.headless) == EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	const VkDevice device = context.headless.device;
+
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags                   = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex        = context.headless.queueFamily;
+
+	if (vkCreateCommandPool(device, &poolInfo, nullptr, &context.commandPool) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create command pool.");
+		return EXIT_FAILURE;
+	}
+
+	VkCommandBufferAllocateInfo allocInfo = {};
+	allocInfo.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool                 = context.commandPool;
+	allocInfo.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount          = 1;
+
+	if (vkAllocateCommandBuffers(device, &allocInfo, &context.commandBuffer) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to allocate command buffer.");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+static void DestroyContext(BenchContext &context)
+{
+	if (context.headless.device != VK_NULL_HANDLE)
+	{
+		vkDestroyCommandPool(context.headless.device, context.commandPool, nullptr);
+	}
+
+	DestroyHeadlessContext(context.headless);
+}
+
+// Nanoseconds per recorded command, setViewport and setScissor alternating.
+static f64 BenchRecording(
+		const BenchContext  &context,
+		u32                  batchCount,
+		PFN_vkCmdSetViewport cmdSetViewport,
+		PFN_vkCmdSetScissor  cmdSetScissor
+)
+{
+	VkViewport viewport = {0.0f, 0.0f, 1920.0f, 1080.0f, 0.0f, 1.0f};
+	VkRect2D   scissor  = {{0, 0}, {1920, 1080}};
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	f64 totalSeconds = 0.0;
+	for (u32 batch = 0; batch < batchCount; ++batch)
+	{
+		vkResetCommandBuffer(context.commandBuffer, 0);
+		vkBeginCommandBuffer(context.commandBuffer, &beginInfo);
+
+		const auto start = BenchClock::now();
+		for (u32 i = 0; i < kCallsPerBatch; i += 2)
+		{
+			cmdSetViewport(context.commandBuffer, 0, 1, &viewport);
+			cmdSetScissor(context.commandBuffer, 0, 1, &scissor);
+		}
+		totalSeconds += std::chrono::duration<f64>(BenchClock::now() - start).count();
+
+		vkEndCommandBuffer(context.commandBuffer);
+	}
+
+	return totalSeconds * 1e9 / ((f64)batchCount * kCallsPerBatch);
+}
+
+int main(int argc, char **argv)
+{
+	u32 batchCount = 100;
+	for (i32 i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--batches") == 0 && i + 1 < argc)
+		{
+			batchCount = (u32)atoi(argv[++i]);
+		}
+	}
+
+	BenchContext context;
+	if (CreateContext(context) == EXIT_FAILURE)
+	{
+		DestroyContext(context);
+		return EXIT_FAILURE;
+	}
+
+	// Warm-up, the first batches pay for command pool growth.
+	BenchRecording(context, 4, vkCmdSetViewport, vkCmdSetScissor);
+
+	// Alternated so clock changes affect both sides alike.
+	constexpr u32 kRounds = 4;
+
+	f64 loaderNs   = 0.0;
+	f64 dispatchNs = 0.0;
+	for (u32 round = 0; round < kRounds; ++round)
+	{
+		loaderNs += BenchRecording(context, batchCount, vkCmdSetViewport, vkCmdSetScissor);
+		dispatchNs += BenchRecording(
+				context,
+				batchCount,
+				VulkanDispatch::vkCmdSetViewport,
+				VulkanDispatch::vkCmdSetScissor
+		);
+	}
+	loaderNs /= kRounds;
+	dispatchNs /= kRounds;
+
+	CLOG_INFO(
+			"Recording, ",
+			batchCount * kCallsPerBatch,
+			" calls per round: loader ",
+			loaderNs,
+			" ns per call, dispatch table ",
+			dispatchNs,
+			" ns per call, ",
+			loaderNs - dispatchNs,
+			" ns saved."
+	);
+
+	DestroyContext(context);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+#include "headless_context.h"
+
+#include "render/host_allocator.h"
+#include "render/vk_dispatch.h"
+#include "utils/logger.h"
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+bool CreateHeadlessContext(HeadlessContext &context, const char *deviceFilter)
+{
+	// VK_KHR_surface only so the device can enable VK_KHR_swapchain, which the dispatch table
+	// needs for its swap chain functions.
+	const std::array<const char *, 1> instanceExtensions = {VK_KHR_SURFACE_EXTENSION_NAME};
+	const std::array<const char *, 2> deviceExtensions   = {
+            VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME
+    };
+
+	const VkAllocationCallbacks *allocator = HostAllocator::GetCallbacks();
+
+	VkApplicationInfo appInfo = {};
+	appInfo.sType             = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+	appInfo.pApplicationName  = "Benchmark";
+	appInfo.apiVersion        = VK_API_VERSION_1_1;
+
+	VkInstanceCreateInfo instanceInfo    = {};
+	instanceInfo.sType                   = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+	instanceInfo.pApplicationInfo        = &appInfo;
+	instanceInfo.enabledExtensionCount   = (u32)instanceExtensions.size();
+	instanceInfo.ppEnabledExtensionNames = instanceExtensions.data();
+
+	if (vkCreateInstance(&instanceInfo, allocator, &context.instance) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create instance.");
+		return EXIT_FAILURE;
+	}
+
+	u32 deviceCount = 0;
+	vkEnumeratePhysicalDevices(context.instance, &deviceCount, nullptr);
+	std::vector<VkPhysicalDevice> physicalDevices(deviceCount);
+	vkEnumeratePhysicalDevices(context.instance, &deviceCount, physicalDevices.data());
+
+	for (VkPhysicalDevice physicalDevice : physicalDevices)
+	{
+		VkPhysicalDeviceProperties properties = {};
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		if (deviceFilter != nullptr && strstr(properties.deviceName, deviceFilter) == nullptr)
+		{
+			continue;
+		}
+
+		u32 familyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> families(familyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+		for (u32 i = 0; i < familyCount; ++i)
+		{
+			if (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+			{
+				context.physicalDevice = physicalDevice;
+				context.queueFamily    = i;
+				context.properties     = properties;
+				break;
+			}
+		}
+
+		if (context.physicalDevice != VK_NULL_HANDLE)
+		{
+			break;
+		}
+	}
+
+	if (context.physicalDevice == VK_NULL_HANDLE)
+	{
+		CLOG_ERR("No device with a graphics queue", deviceFilter ? " matching the filter." : ".");
+		return EXIT_FAILURE;
+	}
+
+	f32 queuePriority = 1.0f;
+
+	VkDeviceQueueCreateInfo queueInfo = {};
+	queueInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+	queueInfo.queueFamilyIndex        = context.queueFamily;
+	queueInfo.queueCount              = 1;
+	queueInfo.pQueuePriorities        = &queuePriority;
+
+	VkPhysicalDeviceSynchronization2FeaturesKHR sync2Features = {};
+	sync2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+	sync2Features.synchronization2 = VK_TRUE;
+
+	VkDeviceCreateInfo deviceInfo      = {};
+	deviceInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	deviceInfo.pNext                   = &sync2Features;
+	deviceInfo.queueCreateInfoCount    = 1;
+	deviceInfo.pQueueCreateInfos       = &queueInfo;
+	deviceInfo.enabledExtensionCount   = (u32)deviceExtensions.size();
+	deviceInfo.ppEnabledExtensionNames = deviceExtensions.data();
+
+	if (vkCreateDevice(context.physicalDevice, &deviceInfo, allocator, &context.device)
+		!= VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create device.");
+		return EXIT_FAILURE;
+	}
+
+	vkGetDeviceQueue(context.device, context.queueFamily, 0, &context.queue);
+
+	if (VulkanDispatch::LoadInstance(context.instance) == EXIT_FAILURE
+		|| VulkanDispatch::LoadDevice(context.device) == EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	CLOG_INFO("Running on ", context.properties.deviceName, ".");
+	return EXIT_SUCCESS;
+}
+
+void DestroyHeadlessContext(HeadlessContext &context)
+{
+	const VkAllocationCallbacks *allocator = HostAllocator::GetCallbacks();
+
+	if (context.device != VK_NULL_HANDLE)
+	{
+		vkDestroyDevice(context.device, allocator);
+	}
+	if (context.instance != VK_NULL_HANDLE)
+	{
+		vkDestroyInstance(context.instance, allocator);
+	}
+
+	VulkanDispatch::Reset();
+	context = {};
+}
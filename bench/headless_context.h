@@ -0,0 +1,28 @@
+#ifndef HEADER_HEADLESS_CONTEXT_H
+#define HEADER_HEADLESS_CONTEXT_H
+
+#include "definitions.h"
+#include "vulkan/vulkan_core.h"
+
+/* Windowless Vulkan setup shared by the benchmarks: an instance, a device with one graphics
+ * queue and the VulkanDispatch tables loaded. Works on software devices (lavapipe) as well. */
+
+struct HeadlessContext
+{
+	VkInstance       instance       = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice         device         = VK_NULL_HANDLE;
+	VkQueue          queue          = VK_NULL_HANDLE;
+	u32              queueFamily    = ~0u;
+
+	VkPhysicalDeviceProperties properties = {};
+};
+
+/* Picks the first device with a graphics queue whose name contains deviceFilter (any device when
+ * it is nullptr), e.g. "llvmpipe" for lavapipe. */
+bool CreateHeadlessContext(HeadlessContext &context, const char *deviceFilter = nullptr);
+
+// Safe on a partially created context.
+void DestroyHeadlessContext(HeadlessContext &context);
+
+#endif// HEADER_HEADLESS_CONTEXT_H
@@ -0,0 +1,273 @@
+#include "core/alloc_tracker.h"
+#include "core/job_system.h"
+#include "definitions.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/**************************************
+*       JOB SYSTEM MICROBENCHMARKS
+**************************************/
+
+using BenchClock = std::chrono::steady_clock;
+
+static f64 SecondsSince(BenchClock::time_point start)
+{
+	return std::chrono::duration<f64>(BenchClock::now() - start).count();
+}
+
+static void EmptyJob(void *)
+{
+}
+
+// Throughput of tiny jobs, measures pure scheduling overhead.
+static void BenchEmptyJobs(JobSystem &jobSystem, u32 jobCount)
+{
+	const auto start = BenchClock::now();
+
+	JobCounter counter;
+	for (u32 i = 0; i < jobCount; ++i)
+	{
+		jobSystem.Submit(EmptyJob, nullptr, &counter);
+
+		// Local deques are bounded, drain before they overflow into the shared queue.
+		if ((i + 1) % (WorkStealingQueue::kCapacity / 2) == 0)
+		{
+			jobSystem.Wait(counter);
+		}
+	}
+	jobSystem.Wait(counter);
+
+	const f64 seconds = SecondsSince(start);
+	CLOG_INFO(
+			"Empty jobs: ",
+			jobCount,
+			" in ",
+			seconds * 1000.0,
+			" ms, ",
+			(f64)jobCount / seconds / 1.0e6,
+			" Mjobs/s."
+	);
+}
+
+// Fork-join over a data parallel loop, compared against the single threaded version.
+static void BenchParallelFor(JobSystem &jobSystem, u32 itemCount)
+{
+	std::vector<f32> values(itemCount);
+	for (u32 i = 0; i < itemCount; ++i)
+	{
+		values[i] = (f32)i;
+	}
+
+	auto work = [&values](u32 begin, u32 end)
+	{
+		for (u32 i = begin; i < end; ++i)
+		{
+			values[i] = values[i] * 0.5f + 1.0f;
+		}
+	};
+
+	auto start = BenchClock::now();
+	work(0, itemCount);
+	const f64 serialSeconds = SecondsSince(start);
+
+	start = BenchClock::now();
+	jobSystem.ParallelFor(itemCount, 4096, work);
+	const f64 parallelSeconds = SecondsSince(start);
+
+	CLOG_INFO(
+			"ParallelFor: ",
+			itemCount,
+			" items, serial ",
+			serialSeconds * 1000.0,
+			" ms, parallel ",
+			parallelSeconds * 1000.0,
+			" ms, speedup ",
+			serialSeconds / parallelSeconds,
+			"x."
+	);
+}
+
+struct LatencySample
+{
+	BenchClock::time_point submitTime;
+	f64                    latency;
+};
+
+// Time from Submit() until some worker (possibly the waiting one) starts running the job.
+static void BenchSchedulingLatency(JobSystem &jobSystem, u32 sampleCount)
+{
+	std::vector<f64> latencies(sampleCount);
+
+	for (u32 i = 0; i < sampleCount; ++i)
+	{
+		LatencySample sample = {};
+		JobCounter    counter;
+
+		sample.submitTime = BenchClock::now();
+		jobSystem.Submit(
+				[](void *data)
+				{
+					LatencySample *sample = static_cast<LatencySample *>(data);
+					sample->latency =
+							std::chrono::duration<f64>(BenchClock::now() - sample->submitTime)
+									.count();
+				},
+				&sample,
+				&counter
+		);
+		jobSystem.Wait(counter);
+
+		latencies[i] = sample.latency;
+	}
+
+	std::sort(latencies.begin(), latencies.end());
+	auto percentile = [&latencies](f64 p)
+	{
+		return latencies[(size_t)(p * (f64)(latencies.size() - 1))] * 1.0e6;
+	};
+
+	CLOG_INFO(
+			"Scheduling latency over ",
+			sampleCount,
+			" samples: p50 ",
+			percentile(0.5),
+			" us, p90 ",
+			percentile(0.9),
+			" us, p99 ",
+			percentile(0.99),
+			" us."
+	);
+}
+
+struct ForkJoinNode
+{
+	JobSystem *jobSystem;
+	u32        depth;
+};
+
+static void ForkJoinJob(void *data)
+{
+	ForkJoinNode *node = static_cast<ForkJoinNode *>(data);
+	if (node->depth == 0)
+	{
+		return;
+	}
+
+	ForkJoinNode children[2] = {
+			{node->jobSystem, node->depth - 1},
+			{node->jobSystem, node->depth - 1},
+	};
+
+	JobCounter counter;
+	node->jobSystem->Submit(ForkJoinJob, &children[0], &counter);
+	node->jobSystem->Submit(ForkJoinJob, &children[1], &counter);
+	node->jobSystem->Wait(counter);
+}
+
+// Recursive binary fork-join, stresses stealing and waiting inside jobs.
+static void BenchForkJoin(JobSystem &jobSystem, u32 depth)
+{
+	ForkJoinNode root = {&jobSystem, depth};
+
+	const auto start = BenchClock::now();
+	ForkJoinJob(&root);
+	const f64 seconds = SecondsSince(start);
+
+	const u64 jobCount = (1ull << (depth + 1)) - 2;
+	CLOG_INFO(
+			"Fork-join depth ",
+			depth,
+			": ",
+			jobCount,
+			" jobs in ",
+			seconds * 1000.0,
+			" ms, ",
+			(f64)jobCount / seconds / 1.0e6,
+			" Mjobs/s."
+	);
+}
+
+/* Scheduling must not touch the heap once warmed up. Allocations can only be counted when built
+ * with COV_TRACK_ALLOCATIONS, otherwise the check is skipped with a warning. */
+static bool CheckSteadyStateAllocations(JobSystem &jobSystem)
+{
+	if (!AllocationTracker::IsEnabled())
+	{
+		CLOG_WARN("Steady state allocation check skipped, build with COV_TRACK_ALLOCATIONS.");
+		return EXIT_SUCCESS;
+	}
+
+	constexpr u32 kIterations = 100;
+
+	std::vector<u32> values(64 * 1024);
+	auto             work = [&values](u32 begin, u32 end)
+	{
+		for (u32 i = begin; i < end; ++i)
+		{
+			++values[i];
+		}
+	};
+
+	JobCounter counter;
+	u64        allocationsBefore = 0;
+
+	// The first iteration is warm-up.
+	for (u32 iteration = 0; iteration <= kIterations; ++iteration)
+	{
+		if (iteration == 1)
+		{
+			allocationsBefore = AllocationTracker::GetTotalCount();
+		}
+
+		jobSystem.ParallelFor((u32)values.size(), 1024, work);
+		for (u32 i = 0; i < 256; ++i)
+		{
+			jobSystem.Submit(EmptyJob, nullptr, &counter);
+		}
+		jobSystem.Wait(counter);
+	}
+
+	const u64 allocations = AllocationTracker::GetTotalCount() - allocationsBefore;
+	if (allocations > 0)
+	{
+		CLOG_ERR("Job system made ", allocations, " heap allocations in steady state.");
+		return EXIT_FAILURE;
+	}
+
+	CLOG_INFO("Steady state allocations: none in ", kIterations, " iterations.");
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+	u32 workerCount = 0;
+	for (i32 i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+		{
+			workerCount = (u32)atoi(argv[++i]);
+		}
+	}
+
+	JobSystem jobSystem;
+	if (jobSystem.Init(workerCount) == EXIT_FAILURE)
+	{
+		CLOG_ERR("Failed to initialize job system.");
+		return EXIT_FAILURE;
+	}
+
+	BenchEmptyJobs(jobSystem, 1000000);
+	BenchParallelFor(jobSystem, 16 * 1024 * 1024);
+	BenchSchedulingLatency(jobSystem, 10000);
+	BenchForkJoin(jobSystem, 16);
+
+	const bool allocationResult = CheckSteadyStateAllocations(jobSystem);
+
+	jobSystem.Shutdown();
+	return allocationResult;
+}
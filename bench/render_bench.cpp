@@ -0,0 +1,360 @@
+#include "application.h"
+#include "bench_report.h"
+#include "core/alloc_tracker.h"
+#include "definitions.h"
+#include "render/validation.h"
+#include "utils/logger.h"
+#include "vulkan/vulkan_core.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/**************************************
+*       RENDER BENCHMARK
+**************************************/
+
+/* Reproducible frame loop benchmark. Every scene configures an Application, draws it headless
+ * (Application::SetHeadless) for a fixed number of frames and the JSON report gets frame time
+ * percentiles, CPU time per phase, heap allocations and startup time. The frames are recorded by
+ * the application's own code, anything it draws is measured.
+ *
+ * Headless the simulation advances by a fixed time per frame instead of wall time, so every run
+ * records the same commands. Runs on any Vulkan device; on CI pick lavapipe with --device llvmpipe.
+ *
+ *   RenderBench [--scene <name>] [--frames N] [--warmup N] [--device <name substring>]
+ *               [--output report.json] [--no-host-allocator]
+ *   RenderBench --compare base.json new.json [--threshold <percent>]
+ *
+ * Compare mode exits with a failure when a metric regressed. */
+
+using BenchClock = std::chrono::steady_clock;
+
+constexpr VkExtent2D kTargetExtent = {1280, 720};
+
+// Shading cost of every overdraw layer, kShadingIterations of shader_frag.glsl.
+constexpr u32 kOverdrawShadingIterations = 64;
+
+// Application settings of a scene, whatever is not listed keeps the application's default.
+struct SceneDesc
+{
+	const char *name          = "";
+	u32         instanceCount = 0;
+	u32         drawCount     = 1;// Instances split evenly, see Application::SetSceneDrawCount
+	u32         pipelineCount = 1;// Draws cycle through them, one bind per draw when above 1
+	u32         lightCount    = 0;
+	u32         msaaSamples   = 1;
+	bool        depthPrepass  = false;
+	bool        meshlets      = false;
+	bool        occlusion     = false;// Implies meshlets and the depth prepass
+	bool        postProcess   = false;
+	bool        resizeStorm   = false;// Target recreated with a new extent every frame
+	bool        overdraw      = false;// Screen-covering layers stacked back to front
+};
+
+constexpr SceneDesc kScenes[] = {
+		{"instances", 100000, 1, 1, 0, 1, false, false, false, false, false, false},
+		{"draws", 10000, 10000, 1, 0, 1, false, false, false, false, false, false},
+		{"pipelines", 10000, 2000, 64, 0, 1, false, false, false, false, false, false},
+		{"lights", 10000, 1, 1, 256, 1, false, false, false, false, false, false},
+		{"msaa", 10000, 1, 1, 0, 4, false, false, false, false, false, false},
+		{"depth_prepass", 10000, 1, 1, 256, 1, true, false, false, false, false, false},
+		{"meshlets", 10000, 1, 1, 0, 1, false, true, false, false, false, false},
+		{"occlusion", 10000, 1, 1, 0, 1, false, false, true, false, false, false},
+		{"post", 10000, 1, 1, 0, 1, false, false, false, true, false, false},
+		{"resize_storm", 10000, 1, 1, 0, 1, false, false, false, false, true, false},
+		{"overdraw", 64, 1, 1, 0, 1, false, false, false, false, false, true},
+		{"overdraw_prepass", 64, 1, 1, 0, 1, true, false, false, false, false, true},
+};
+
+struct FrameSample
+{
+	f64 frameMs                   = 0.0;
+	f64 phaseMs[kBenchPhaseCount] = {};
+	u64 allocations               = 0;
+};
+
+static f64 MillisecondsSince(BenchClock::time_point start)
+{
+	return std::chrono::duration<f64, std::milli>(BenchClock::now() - start).count();
+}
+
+static void ConfigureScene(
+		Application     &app,
+		const SceneDesc &scene,
+		const char      *deviceFilter,
+		bool             useHostAllocator
+)
+{
+	app.SetHeadless(kTargetExtent);
+	if (deviceFilter != nullptr)
+	{
+		app.SetDeviceFilter(deviceFilter);
+	}
+	app.SetUseHostAllocator(useHostAllocator);
+
+	// The layer would dominate every timing.
+	app.SetValidationPreset(ValidationPreset::eOff);
+
+	app.SetSceneInstanceCount(scene.instanceCount);
+	app.SetSceneDrawCount(scene.drawCount);
+	app.SetScenePipelineCount(scene.pipelineCount);
+	app.SetSceneLightCount(scene.lightCount);
+	app.SetMsaaSamples(scene.msaaSamples);
+	app.SetDepthPrepass(scene.depthPrepass);
+	app.SetMeshletCulling(scene.meshlets);
+	app.SetOcclusionCulling(scene.occlusion);
+	app.SetPostProcessing(scene.postProcess);
+	app.SetSceneOverdraw(scene.overdraw);
+	app.SetShadingIterations(scene.overdraw ? kOverdrawShadingIterations : 0);
+}
+
+static bool DrawFrame(
+		Application     &app,
+		const SceneDesc &scene,
+		u32              frameIndex,
+		FrameSample     &sample
+)
+{
+	const auto frameStart = BenchClock::now();
+
+	if (scene.resizeStorm)
+	{
+		// What a swap chain recreation costs minus the swap chain.
+		const VkExtent2D extent = {
+				kTargetExtent.width / 2 + frameIndex * 37 % (kTargetExtent.width / 2),
+				kTargetExtent.height / 2 + frameIndex * 23 % (kTargetExtent.height / 2),
+		};
+
+		if (app.ResizeHeadless(extent) == EXIT_FAILURE)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+	sample.phaseMs[(u32)BenchPhase::eResize] = MillisecondsSince(frameStart);
+
+	// Recreating the target legitimately allocates, like the application only the frame counts.
+	const u64 allocationsBefore = AllocationTracker::GetTotalCount();
+	if (app.DrawHeadlessFrame() == EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+	sample.allocations = AllocationTracker::GetTotalCount() - allocationsBefore;
+
+	const Application::FrameTimings &timings = app.GetFrameTimings();
+
+	sample.phaseMs[(u32)BenchPhase::eWait]     = timings.waitMs;
+	sample.phaseMs[(u32)BenchPhase::eSimulate] = timings.simulateMs;
+	sample.phaseMs[(u32)BenchPhase::eExtract]  = timings.extractMs;
+	sample.phaseMs[(u32)BenchPhase::eRecord]   = timings.recordMs;
+	sample.phaseMs[(u32)BenchPhase::eSubmit]   = timings.submitMs;
+
+	sample.frameMs = MillisecondsSince(frameStart);
+
+	return EXIT_SUCCESS;
+}
+
+static bool RunScene(
+		const SceneDesc &scene,
+		const char      *deviceFilter,
+		bool             useHostAllocator,
+		u32              warmupFrames,
+		u32              frameCount,
+		SceneReport     &report,
+		std::string     &deviceName
+)
+{
+	const auto setupStart = BenchClock::now();
+
+	Application app = {};
+	ConfigureScene(app, scene, deviceFilter, useHostAllocator);
+
+	if (app.Init() == EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	report               = {};
+	report.name          = scene.name;
+	report.instanceCount = scene.instanceCount;
+	report.drawCount     = scene.drawCount;
+	report.pipelineCount = scene.pipelineCount;
+	report.lightCount    = scene.lightCount;
+	report.msaaSamples   = scene.msaaSamples;
+	report.setupMs       = MillisecondsSince(setupStart);
+
+	deviceName = app.GetDeviceName();
+
+	// Sized up front, the measured frames only write into it.
+	std::vector<FrameSample> samples(frameCount);
+	std::vector<f64>         frameTimes(frameCount);
+
+	bool result = EXIT_SUCCESS;
+	for (u32 frameIndex = 0; frameIndex < warmupFrames + frameCount; ++frameIndex)
+	{
+		FrameSample sample = {};
+		if (DrawFrame(app, scene, frameIndex, sample) == EXIT_FAILURE)
+		{
+			result = EXIT_FAILURE;
+			break;
+		}
+
+		if (frameIndex >= warmupFrames)
+		{
+			samples[frameIndex - warmupFrames] = sample;
+		}
+	}
+
+	app.Shutdown();
+
+	if (result == EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	u64 allocations = 0;
+	for (u32 i = 0; i < frameCount; ++i)
+	{
+		frameTimes[i] = samples[i].frameMs;
+		allocations += samples[i].allocations;
+		for (u32 phase = 0; phase < kBenchPhaseCount; ++phase)
+		{
+			report.phaseMs[phase] += samples[i].phaseMs[phase] / (f64)frameCount;
+		}
+	}
+
+	report.frameMs = ComputeFrameTimeStats(frameTimes.data(), frameCount);
+	if (AllocationTracker::IsEnabled())
+	{
+		report.allocationsPerFrame = (f64)allocations / (f64)frameCount;
+	}
+
+	CLOG_INFO(
+			scene.name,
+			": ",
+			frameCount,
+			" frames, mean ",
+			report.frameMs.mean,
+			" ms, p50 ",
+			report.frameMs.p50,
+			" ms, p99 ",
+			report.frameMs.p99,
+			" ms, max ",
+			report.frameMs.max,
+			" ms."
+	);
+
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+	const auto startupStart = BenchClock::now();
+
+	const char *sceneFilter      = nullptr;
+	const char *deviceFilter     = nullptr;
+	const char *outputPath       = "render_bench.json";
+	const char *compareBase      = nullptr;
+	const char *compareNew       = nullptr;
+	u32         frameCount       = 600;
+	u32         warmupFrames     = 60;
+	f64         thresholdPercent = 10.0;
+	bool        useHostAllocator = true;
+
+	for (i32 i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--scene") == 0 && i + 1 < argc)
+		{
+			sceneFilter = argv[++i];
+		}
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+		{
+			frameCount = std::max((u32)atoi(argv[++i]), 1u);
+		}
+		else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+		{
+			warmupFrames = (u32)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--device") == 0 && i + 1 < argc)
+		{
+			deviceFilter = argv[++i];
+		}
+		else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+		{
+			outputPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--compare") == 0 && i + 2 < argc)
+		{
+			compareBase = argv[++i];
+			compareNew  = argv[++i];
+		}
+		else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+		{
+			thresholdPercent = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--no-host-allocator") == 0)
+		{
+			useHostAllocator = false;
+		}
+	}
+
+	if (compareBase != nullptr)
+	{
+		u32 regressions = 0;
+		if (CompareBenchReports(compareBase, compareNew, thresholdPercent / 100.0, regressions)
+			== EXIT_FAILURE)
+		{
+			return EXIT_FAILURE;
+		}
+
+		return regressions > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	BenchReport report  = {};
+	report.frameCount   = frameCount;
+	report.warmupFrames = warmupFrames;
+
+	// Startup lasts until the first scene is ready to draw, the cold start is its setup.
+	const f64 argumentsMs = MillisecondsSince(startupStart);
+
+	for (const SceneDesc &scene : kScenes)
+	{
+		if (sceneFilter != nullptr && strcmp(sceneFilter, scene.name) != 0)
+		{
+			continue;
+		}
+
+		// Every scene initializes an application of its own.
+		SceneReport sceneReport;
+		if (RunScene(
+					scene,
+					deviceFilter,
+					useHostAllocator,
+					warmupFrames,
+					frameCount,
+					sceneReport,
+					report.device
+			)
+			== EXIT_FAILURE)
+		{
+			CLOG_ERR("Scene \"", scene.name, "\" failed.");
+			return EXIT_FAILURE;
+		}
+
+		if (report.scenes.empty())
+		{
+			report.startupMs = argumentsMs + sceneReport.setupMs;
+		}
+		report.scenes.push_back(sceneReport);
+	}
+
+	if (report.scenes.empty())
+	{
+		CLOG_ERR("No scene named \"", sceneFilter, "\".");
+		return EXIT_FAILURE;
+	}
+
+	return WriteBenchReport(report, outputPath);
+}
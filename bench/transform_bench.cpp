@@ -0,0 +1,295 @@
+#include "core/job_system.h"
+#include "definitions.h"
+#include "pch/glm.h"
+#include "scene/transform_hierarchy.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/**************************************
+*       TRANSFORM HIERARCHY BENCHMARKS
+**************************************/
+
+using BenchClock = std::chrono::steady_clock;
+
+static f64 MillisecondsSince(BenchClock::time_point start)
+{
+	return std::chrono::duration<f64, std::milli>(BenchClock::now() - start).count();
+}
+
+// Roots with a fixed fan-out, similar to a scene of many small prefabs.
+static std::vector<TransformId> BuildHierarchy(TransformHierarchy &hierarchy, u32 nodeCount)
+{
+	constexpr u32 kFanOut = 4;
+
+	std::vector<TransformId> ids;
+	ids.reserve(nodeCount);
+	hierarchy.Reserve(nodeCount);
+
+	for (u32 i = 0; i < nodeCount; ++i)
+	{
+		// Every 256th node starts a new tree, the rest hang below earlier nodes of that tree.
+		const u32         treeStart = i / 256 * 256;
+		const TransformId parent =
+				i == treeStart ? kInvalidTransform : ids[treeStart + (i - treeStart - 1) / kFanOut];
+
+		ids.push_back(hierarchy.AddNode(parent));
+		hierarchy.SetLocal(
+				ids.back(),
+				glm::vec3((f32)(i % 7), (f32)(i % 5), (f32)(i % 3)),
+				glm::angleAxis((f32)i * 0.01f, glm::vec3(0.0f, 1.0f, 0.0f)),
+				glm::vec3(1.0f)
+		);
+	}
+
+	return ids;
+}
+
+static void BenchUpdate(const char *name, u32 nodeCount, f32 dirtyFraction, JobSystem *jobSystem)
+{
+	TransformHierarchy       hierarchy;
+	std::vector<TransformId> ids = BuildHierarchy(hierarchy, nodeCount);
+
+	// First update sorts the arrays and computes everything.
+	hierarchy.Update(jobSystem);
+
+	constexpr u32 kIterations = 10;
+	const u32     dirtyStride = dirtyFraction > 0.0f ? (u32)(1.0f / dirtyFraction) : 0;
+
+	f64 totalMs = 0.0;
+	u32 updated = 0;
+	u32 ranges  = 0;
+	for (u32 iteration = 0; iteration < kIterations; ++iteration)
+	{
+		for (u32 i = iteration % std::max(dirtyStride, 1u); dirtyStride > 0 && i < nodeCount;
+			 i += dirtyStride)
+		{
+			hierarchy.SetLocalPosition(ids[i], glm::vec3((f32)iteration, 0.0f, 0.0f));
+		}
+
+		const auto start = BenchClock::now();
+		hierarchy.Update(jobSystem);
+		totalMs += MillisecondsSince(start);
+		updated += hierarchy.GetStats().updated;
+		ranges  += hierarchy.GetStats().ranges;
+	}
+
+	CLOG_INFO(
+			name,
+			": ",
+			nodeCount,
+			" nodes, ",
+			hierarchy.GetStats().levels,
+			" levels, ",
+			updated / kIterations,
+			" updated per frame in ",
+			ranges / kIterations,
+			" ranges, ",
+			totalMs / kIterations,
+			" ms per update."
+	);
+}
+
+// Relative difference allowed between matrices computed in a different order.
+constexpr f32 kKernelEpsilon = 1e-5f;
+
+// Fills a matrix with distinct values, so a swapped row or column shows up in the comparison.
+static glm::mat4 MakeTestMatrix(u32 seed)
+{
+	glm::mat4 matrix;
+	for (i32 column = 0; column < 4; ++column)
+	{
+		for (i32 row = 0; row < 4; ++row)
+		{
+			const u32 value      = (seed * 16 + (u32)(column * 4 + row)) % 23;
+			matrix[column][row] = (f32)value * 0.25f - 2.5f;
+		}
+	}
+	return matrix;
+}
+
+// Returns EXIT_FAILURE when the matrices differ by more than kKernelEpsilon.
+static bool CheckMatrix(
+		const char      *what,
+		u32              index,
+		const glm::mat4 &expected,
+		const glm::mat4 &actual
+)
+{
+	for (i32 column = 0; column < 4; ++column)
+	{
+		for (i32 row = 0; row < 4; ++row)
+		{
+			const f32 tolerance = kKernelEpsilon * std::max(1.0f, std::abs(expected[column][row]));
+
+			if (std::abs(actual[column][row] - expected[column][row]) > tolerance)
+			{
+				CLOG_ERR(
+						what,
+						" mismatch at matrix ",
+						index,
+						" column ",
+						column,
+						" row ",
+						row,
+						": expected ",
+						expected[column][row],
+						", got ",
+						actual[column][row],
+						"."
+				);
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+static bool BenchKernels(u32 matrixCount)
+{
+	using MatrixBatch = TransformHierarchy::MatrixBatch;
+
+	constexpr u32 kBatchSize = TransformHierarchy::kBatchSize;
+
+	const u32 batchCount = (matrixCount + kBatchSize - 1) / kBatchSize;
+
+	std::vector<MatrixBatch> parents(batchCount);
+	std::vector<MatrixBatch> locals(batchCount);
+	std::vector<MatrixBatch> scalarOutputs(batchCount);
+	std::vector<MatrixBatch> simdOutputs(batchCount);
+
+	for (u32 i = 0; i < matrixCount; ++i)
+	{
+		parents[i / kBatchSize].Set(i % kBatchSize, MakeTestMatrix(i));
+		locals[i / kBatchSize].Set(i % kBatchSize, MakeTestMatrix(i + 7));
+	}
+
+	// The last batch is partly filled, which covers the scalar tail of the SIMD kernel.
+	auto countOf = [&](u32 batch)
+	{
+		return std::min(matrixCount - batch * kBatchSize, kBatchSize);
+	};
+
+	auto start = BenchClock::now();
+	for (u32 batch = 0; batch < batchCount; ++batch)
+	{
+		TransformHierarchy::MultiplyBatchScalar(
+				parents[batch], locals[batch], scalarOutputs[batch], countOf(batch)
+		);
+	}
+	const f64 scalarMs = MillisecondsSince(start);
+
+	start = BenchClock::now();
+	for (u32 batch = 0; batch < batchCount; ++batch)
+	{
+		TransformHierarchy::MultiplyBatch(
+				parents[batch], locals[batch], simdOutputs[batch], countOf(batch)
+		);
+	}
+	const f64 simdMs = MillisecondsSince(start);
+
+	CLOG_INFO(
+			"Matrix kernel: ",
+			matrixCount,
+			" multiplies, scalar ",
+			scalarMs,
+			" ms, simd ",
+			simdMs,
+			" ms."
+	);
+
+	for (u32 i = 0; i < matrixCount; ++i)
+	{
+		const u32 batch = i / kBatchSize;
+		const u32 lane  = i % kBatchSize;
+
+		if (CheckMatrix(
+					"Matrix kernel",
+					i,
+					scalarOutputs[batch].Get(lane),
+					simdOutputs[batch].Get(lane)
+			) == EXIT_FAILURE)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/* Returns EXIT_FAILURE when updating only the dirty ranges does not give the same matrices as
+ * computing the whole hierarchy with the same local transforms. */
+static bool CheckDirtyUpdate(u32 nodeCount, JobSystem *jobSystem)
+{
+	TransformHierarchy       incremental;
+	TransformHierarchy       reference;
+	std::vector<TransformId> ids = BuildHierarchy(incremental, nodeCount);
+	BuildHierarchy(reference, nodeCount);
+
+	incremental.Update(jobSystem);
+
+	// Scattered roots, inner nodes and leaves, so that moved subtrees overlap.
+	for (u32 i = 0; i < nodeCount; i += 97)
+	{
+		const glm::vec3 position((f32)(i % 11), 1.0f, -(f32)(i % 13));
+		incremental.SetLocalPosition(ids[i], position);
+		reference.SetLocalPosition(ids[i], position);
+	}
+
+	incremental.Update(jobSystem);
+	reference.Update(jobSystem);
+
+	for (u32 i = 0; i < nodeCount; ++i)
+	{
+		if (CheckMatrix(
+					"Dirty update",
+					i,
+					reference.GetWorldMatrix(ids[i]),
+					incremental.GetWorldMatrix(ids[i])
+			) == EXIT_FAILURE)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+	u32 nodeCount = 1000000;
+	for (i32 i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc)
+		{
+			nodeCount = (u32)atoi(argv[++i]);
+		}
+	}
+
+	JobSystem jobSystem;
+	if (jobSystem.Init() == EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	if (BenchKernels(nodeCount) == EXIT_FAILURE
+		|| CheckDirtyUpdate(nodeCount, &jobSystem) == EXIT_FAILURE)
+	{
+		jobSystem.Shutdown();
+		return EXIT_FAILURE;
+	}
+
+	BenchUpdate("All dirty, single thread", nodeCount, 1.0f, nullptr);
+	BenchUpdate("All dirty, job system", nodeCount, 1.0f, &jobSystem);
+	BenchUpdate("1% dirty, job system", nodeCount, 0.01f, &jobSystem);
+	BenchUpdate("Nothing dirty", nodeCount, 0.0f, &jobSystem);
+
+	jobSystem.Shutdown();
+	return EXIT_SUCCESS;
+}
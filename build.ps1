@@ -38,10 +38,6 @@ Write-Output ""
 
 Write-Output ""
 
-& .\compile_shaders.bat -$BUILD_TYPE
-
-Write-Output ""
-
 if ($GENERATE_CMAKE) {
     Write-Output ""
     cmake -G Ninja -B "./$BUILD_DIR/" -S . -DCMAKE_BUILD_TYPE=$BUILD_TYPE -DCMAKE_CXX_COMPILER=clang++ -DCMAKE_C_COMPILER=clang -DDO_SANITIZE=true
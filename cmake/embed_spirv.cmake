@@ -0,0 +1,48 @@
+# Writes the SPIR-V binaries in SPIRV_FILES into OUTPUT as constexpr u32 arrays, one per file.
+# shader_vert.spv becomes kShaderVertSpirv. Run with cmake -P from the build.
+
+if (NOT SPIRV_FILES OR NOT OUTPUT)
+    message(FATAL_ERROR "embed_spirv.cmake needs SPIRV_FILES and OUTPUT.")
+endif()
+
+set(CONTENT "// Generated by cmake/embed_spirv.cmake, do not edit.\n\n")
+string(APPEND CONTENT "#ifndef HEADER_EMBEDDED_SHADERS_H\n#define HEADER_EMBEDDED_SHADERS_H\n\n")
+string(APPEND CONTENT "#include \"definitions.h\"\n\n")
+string(APPEND CONTENT "// u32 arrays keep pCode 4 byte aligned and codeSize a multiple of 4, as Vulkan requires.\n")
+
+foreach (SPIRV_FILE ${SPIRV_FILES})
+    get_filename_component(SHADER_NAME ${SPIRV_FILE} NAME_WE)
+
+    # snake_case file name to kPascalCaseSpirv
+    string(REPLACE "_" ";" NAME_PARTS ${SHADER_NAME})
+    set(ARRAY_NAME "k")
+    foreach (PART ${NAME_PARTS})
+        string(SUBSTRING ${PART} 0 1 FIRST)
+        string(SUBSTRING ${PART} 1 -1 REST)
+        string(TOUPPER ${FIRST} FIRST)
+        string(APPEND ARRAY_NAME ${FIRST}${REST})
+    endforeach()
+    string(APPEND ARRAY_NAME "Spirv")
+
+    file(READ ${SPIRV_FILE} HEX HEX)
+    string(LENGTH "${HEX}" HEX_LENGTH)
+    math(EXPR WORD_REMAINDER "${HEX_LENGTH} % 8")
+    if (HEX_LENGTH EQUAL 0 OR NOT WORD_REMAINDER EQUAL 0)
+        message(FATAL_ERROR "${SPIRV_FILE} is not a SPIR-V binary.")
+    endif()
+
+    # SPIR-V words are little-endian, swap the bytes of each word into a hex literal.
+    set(BYTE "[0-9a-f][0-9a-f]")
+    string(REGEX REPLACE "(${BYTE})(${BYTE})(${BYTE})(${BYTE})" "0x\\4\\3\\2\\1, " WORDS "${HEX}")
+    string(REPEAT "0x[0-9a-f]+, " 8 ROW)
+    string(REGEX REPLACE "(${ROW})" "\\1\n\t" WORDS "${WORDS}")
+    string(REGEX REPLACE "[ \t\n]+$" "" WORDS "${WORDS}")
+    string(REGEX REPLACE " \n" "\n" WORDS "${WORDS}")
+
+    string(APPEND CONTENT "\nconstexpr u32 ${ARRAY_NAME}[] = {\n\t${WORDS}\n};\n")
+endforeach()
+
+string(APPEND CONTENT "\n#endif// HEADER_EMBEDDED_SHADERS_H\n")
+
+# Only touch the header when it changed, so unchanged shaders do not rebuild application.cpp.
+file(CONFIGURE OUTPUT ${OUTPUT} CONTENT "${CONTENT}" @ONLY)
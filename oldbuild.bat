@@ -28,10 +28,6 @@ echo:
 call py update_source_files.py
 echo:
 
-echo:
-call compile_shaders.bat -%BUILD_TYPE%
-echo:
-
 if /I "%GENERATE_CMAKE%"=="true" (
     echo:
     cmake -G Ninja -B./%BUILD_DIR%/ -S. -DCMAKE_BUILD_TYPE=%BUILD_TYPE% -D CMAKE_CXX_COMPILER=clang++ -D CMAKE_C_COMPILER=clang -D DO_SANITIZE=true
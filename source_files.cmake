@@ -1,4 +1,29 @@
 set(PROJECT_SOURCE_FILES
+    src/application.cpp
+    src/core/alloc_tracker.cpp
+    src/core/arena.cpp
+    src/core/job_system.cpp
     src/main.cpp
+    src/render/clustered_lighting.cpp
+    src/render/gpu_trace.cpp
+    src/render/hiz_pyramid.cpp
+    src/render/host_allocator.cpp
+    src/render/mesh.cpp
+    src/render/mesh_simplify.cpp
+    src/render/meshlet.cpp
+    src/render/meshlet_culling.cpp
+    src/render/pipeline_layout_cache.cpp
+    src/render/post_process.cpp
+    src/render/render_extract.cpp
+    src/render/render_graph.cpp
+    src/render/shadow_cascades.cpp
+    src/render/spirv_reflect.cpp
+    src/render/validation.cpp
+    src/render/vk_dispatch.cpp
+    src/render/vk_utils.cpp
+    src/scene/ecs.cpp
+    src/scene/simulation.cpp
+    src/utils/json.cpp
     src/utils/logger.cpp
+    src/utils/trace.cpp
 )
@@ -0,0 +1,3826 @@
+#include "application.h"
+
+#include "GLFW/glfw3.h"
+#include "core/alloc_tracker.h"
+#include "core/arena.h"
+#include "definitions.h"
+#include "pch/glm.h"
+#include "pch/stdlib.h"
+#include "render/clustered_lighting.h"
+#include "render/gpu_trace.h"
+#include "render/host_allocator.h"
+#include "render/mesh.h"
+#include "render/render_extract.h"
+#include "render/render_graph.h"
+#include "render/shadow_cascades.h"
+#include "render/validation.h"
+#include "render/vk_dispatch.h"
+#include "render/vk_utils.h"
+#include "scene/ecs.h"
+#include "scene/simulation.h"
+#include "shaders/embedded_shaders.h"
+#include "utils/logger.h"
+#include "utils/trace.h"
+#include "vulkan/vulkan_core.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+/**************************************
+*       CONST DATA            
+**************************************/
+
+constexpr std::array<const char *, 1> kValidationLayers = {
+		"VK_LAYER_KHRONOS_validation",
+};
+
+constexpr std::array<const char *, 2> kDeviceExtensions = {
+		VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+		VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME,
+};
+
+constexpr i32 kMaxFramesInFlight = 2;
+
+constexpr size_t kFrameArenaBlockSize = 1024 * 1024;
+
+// Headless stand-ins for the swap chain images. Post-processing writes them from compute like it
+// does the swap chain, in UNORM with the sRGB encode done by the shader.
+constexpr VkFormat kHeadlessFormat        = VK_FORMAT_R8G8B8A8_SRGB;
+constexpr VkFormat kHeadlessStorageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+struct EmbeddedShader
+{
+	const char *name;
+	const u32  *code;
+	size_t      codeSize;
+};
+
+// Named like the permutations compiled by CMakeLists.txt.
+#define POST_PROCESS_PERMUTATION(BITS)         \
+	{                                          \
+		"post_process_" #BITS "_comp",         \
+		kPostProcess##BITS##CompSpirv,         \
+		sizeof(kPostProcess##BITS##CompSpirv), \
+	}
+
+// Permutations of post_process_comp.glsl, indexed by their PostProcess effect bits.
+constexpr EmbeddedShader kPostProcessPermutations[PostProcess::kPermutationCount] = {
+		POST_PROCESS_PERMUTATION(0),  POST_PROCESS_PERMUTATION(1),  POST_PROCESS_PERMUTATION(2),
+		POST_PROCESS_PERMUTATION(3),  POST_PROCESS_PERMUTATION(4),  POST_PROCESS_PERMUTATION(5),
+		POST_PROCESS_PERMUTATION(6),  POST_PROCESS_PERMUTATION(7),  POST_PROCESS_PERMUTATION(8),
+		POST_PROCESS_PERMUTATION(9),  POST_PROCESS_PERMUTATION(10), POST_PROCESS_PERMUTATION(11),
+		POST_PROCESS_PERMUTATION(12), POST_PROCESS_PERMUTATION(13), POST_PROCESS_PERMUTATION(14),
+		POST_PROCESS_PERMUTATION(15),
+};
+
+#undef POST_PROCESS_PERMUTATION
+
+
+
+/**************************************
+*       MISC FUNCTIONS            
+**************************************/
+
+static std::vector<char> ReadFile(const std::string &fileName)
+{
+	// Starting at the end (std::ios::ate) to know size of a file for our buffer
+	std::ifstream file(fileName, std::ios::ate | std::ios::binary);
+
+	// Callers treat an empty buffer as a failure and report it with more context.
+	if (!file.is_open())
+	{
+		CLOG_ERR("Failed to open file: \"", fileName, "\".");
+		return {};
+	}
+
+	const size_t      fileSize = (size_t)file.tellg();
+	std::vector<char> buffer(fileSize);
+
+	file.seekg(0);
+	file.read(buffer.data(), (i32)fileSize);
+
+	file.close();
+
+	CLOG_INFO("Loaded file \"", fileName, "\" with size of ", fileSize, " bytes.");
+
+	return buffer;
+}
+
+static bool CheckExtensionsSupport(u32 glfwExtensionCount, const char **glfwExtensions)
+{
+	u32 supportedExtensionCount = 0;
+	vkEnumerateInstanceExtensionProperties(nullptr, &supportedExtensionCount, nullptr);
+
+	if (supportedExtensionCount < glfwExtensionCount)
+	{
+		CLOG_WARN("Not all included extensions are supported by your driver.");
+	}
+
+	std::vector<VkExtensionProperties> supportedExtensions(supportedExtensionCount);
+	vkEnumerateInstanceExtensionProperties(
+			nullptr, &supportedExtensionCount, supportedExtensions.data()
+	);
+
+	u32 unsupportedCount = 0;
+	for (u32 glfwExtensionId = 0; glfwExtensionId < glfwExtensionCount; ++glfwExtensionId)
+	{
+		const char *glfwExtension      = glfwExtensions[glfwExtensionId];
+		bool        extensionSupported = false;
+		for (VkExtensionProperties &supportedExtension : supportedExtensions)
+		{
+			// Skip already checked extension
+			if (supportedExtension.extensionName[0] == '\0')
+			{
+				continue;
+			}
+
+			if (strcmp(supportedExtension.extensionName, glfwExtension) == 0)
+			{
+				supportedExtension.extensionName[0] = '\0';
+				extensionSupported                  = true;
+				break;
+			}
+		}
+
+		if (!extensionSupported)
+		{
+			++unsupportedCount;
+			CLOG_ERR("Extension is unsupported: ", glfwExtension);
+		}
+	}
+
+	return unsupportedCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+bool CheckDeviceExtensionSupport(VkPhysicalDevice device)
+{
+	u32 extensionCount = 0;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+	std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(
+			device, nullptr, &extensionCount, availableExtensions.data()
+	);
+
+	std::set<std::string> requiredExtensions(kDeviceExtensions.begin(), kDeviceExtensions.end());
+	for (const auto &extension : availableExtensions)
+	{
+		requiredExtensions.erase(extension.extensionName);
+	}
+
+	return requiredExtensions.empty();
+}
+
+static bool IsDeviceExtensionSupported(VkPhysicalDevice device, const char *extensionName)
+{
+	u32 extensionCount = 0;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+	std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(
+			device, nullptr, &extensionCount, availableExtensions.data()
+	);
+
+	for (const VkExtensionProperties &extension : availableExtensions)
+	{
+		if (strcmp(extension.extensionName, extensionName) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool CheckValidationLayerSupport()
+{
+	u32 layerCount = 0;
+	vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+
+	std::vector<VkLayerProperties> availableLayers(layerCount);
+	vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
+
+	for (const char *validationLayer : kValidationLayers)
+	{
+		bool layerFound = false;
+		for (VkLayerProperties &availableLayer : availableLayers)
+		{
+			if (strcmp(validationLayer, availableLayer.layerName) == 0)
+			{
+				layerFound = true;
+				break;
+			}
+		}
+
+		if (!layerFound)
+		{
+			CLOG_ERR("Layer not found: ", validationLayer);
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+std::vector<const char *> GetRequiredExtensions(bool validation, bool headless)
+{
+	std::vector<const char *> extensions;
+	if (headless)
+	{
+		// No window, VK_KHR_surface only so the device can enable VK_KHR_swapchain, which the
+		// dispatch table loads its swap chain functions from.
+		extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+	}
+	else
+	{
+		u32          glfwExtensionCount = 0;
+		const char **glfwExtensions     = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+
+		extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+	}
+
+	if (validation)
+	{
+		extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+	}
+
+	return extensions;
+}
+
+VkResult CreateDebugUtilsMessengerEXT(
+		VkInstance                                instance,
+		const VkDebugUtilsMessengerCreateInfoEXT *pCreateInfo,
+		const VkAllocationCallbacks              *pAllocator,
+		VkDebugUtilsMessengerEXT                 *pDebugMessenger
+)
+{
+	if (VulkanDispatch::vkCreateDebugUtilsMessengerEXT != nullptr)
+	{
+		return VulkanDispatch::vkCreateDebugUtilsMessengerEXT(
+				instance, pCreateInfo, pAllocator, pDebugMessenger
+		);
+	}
+
+	return VK_ERROR_EXTENSION_NOT_PRESENT;
+}
+
+void DestroyDebugUtilsMessengerEXT(
+		VkInstance                   instance,
+		VkDebugUtilsMessengerEXT     debugMessenger,
+		const VkAllocationCallbacks *pAllocator
+)
+{
+	if (VulkanDispatch::vkDestroyDebugUtilsMessengerEXT != nullptr)
+	{
+		VulkanDispatch::vkDestroyDebugUtilsMessengerEXT(instance, debugMessenger, pAllocator);
+	}
+}
+
+struct QueueFamilyIndices
+{
+	std::optional<u32> graphicsFamily;
+	std::optional<u32> presentFamily;
+
+	[[nodiscard]] bool IsComplete() const
+	{
+		return graphicsFamily.has_value() && presentFamily.has_value();
+	}
+};
+
+QueueFamilyIndices FindQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface)
+{
+	QueueFamilyIndices indices = {};
+
+	u32 queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+
+	ScratchScope                         scratch;
+	ArenaVector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+
+	int i = 0;
+	for (const VkQueueFamilyProperties &queueFamily : queueFamilies)
+	{
+		if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+		{
+			indices.graphicsFamily = i;
+		}
+
+		// Headless nothing is presented, the graphics queue stands in for the present queue.
+		VkBool32 presentSupport = false;
+		if (surface != VK_NULL_HANDLE)
+		{
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, (u32)i, surface, &presentSupport);
+		}
+		else
+		{
+			presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) ? VK_TRUE : VK_FALSE;
+		}
+
+		if (presentSupport)
+		{
+			indices.presentFamily = i;
+		}
+
+		if (indices.IsComplete())
+		{
+			break;
+		}
+
+		++i;
+	}
+
+	return indices;
+}
+
+// Lists are allocated from the scratch arena, callers keep them inside a ScratchScope.
+struct SwapChainSupportDetails
+{
+	VkSurfaceCapabilitiesKHR        capabilities;
+	ArenaVector<VkSurfaceFormatKHR> formats;
+	ArenaVector<VkPresentModeKHR>   presentModes;
+};
+
+SwapChainSupportDetails QuerySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface)
+{
+	SwapChainSupportDetails details = {};
+
+	vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.capabilities);
+
+	u32 formatCount = 0;
+	vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, nullptr);
+
+	if (formatCount != 0)
+	{
+		details.formats.resize(formatCount);
+		vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, details.formats.data());
+	}
+
+	u32 presentModeCount = 0;
+	vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, nullptr);
+
+	if (presentModeCount != 0)
+	{
+		details.presentModes.resize(presentModeCount);
+		vkGetPhysicalDeviceSurfacePresentModesKHR(
+				device, surface, &presentModeCount, details.presentModes.data()
+		);
+	}
+
+	return details;
+}
+
+/* Without a surface (headless) there is no swap chain to check. A name filter replaces the
+ * discrete GPU requirement, it may well pick a software device. */
+bool IsDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface, const std::string &nameFilter)
+{
+	VkPhysicalDeviceProperties deviceProperties = {};
+	vkGetPhysicalDeviceProperties(device, &deviceProperties);
+
+	if (!nameFilter.empty() && strstr(deviceProperties.deviceName, nameFilter.c_str()) == nullptr)
+	{
+		return false;
+	}
+
+	VkPhysicalDeviceFeatures deviceFeatures;
+	vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
+
+	QueueFamilyIndices indices = FindQueueFamilies(device, surface);
+
+	const bool extensionsSupported = CheckDeviceExtensionSupport(device);
+	bool       swapChainAdequate   = surface == VK_NULL_HANDLE;
+	bool       sync2Supported      = false;
+	if (extensionsSupported)
+	{
+		if (surface != VK_NULL_HANDLE)
+		{
+			ScratchScope            scratch;
+			SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport(device, surface);
+			swapChainAdequate =
+					!swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
+		}
+
+		// The render graph records all of its barriers with synchronization2.
+		VkPhysicalDeviceSynchronization2FeaturesKHR sync2Features = {};
+		sync2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+
+		VkPhysicalDeviceFeatures2 features2 = {};
+		features2.sType                     = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.pNext                     = &sync2Features;
+		vkGetPhysicalDeviceFeatures2(device, &features2);
+
+		sync2Supported = sync2Features.synchronization2 == VK_TRUE;
+	}
+
+	const bool discrete = deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU;
+
+	const bool result = (discrete || !nameFilter.empty()) && deviceFeatures.geometryShader
+					 && indices.IsComplete() && extensionsSupported && swapChainAdequate
+					 && sync2Supported;
+	return result;
+}
+
+VkSurfaceFormatKHR ChooseSwapSurfaceFormat(const ArenaVector<VkSurfaceFormatKHR> &availableFormats)
+{
+	assert(!availableFormats.empty());
+
+	for (const auto &availableFormat : availableFormats)
+	{
+		if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB
+			&& availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+		{
+			return availableFormat;
+		}
+	}
+
+	return availableFormats[0];
+}
+
+/* Formats compute can write the swap chain image in, for post-processing. sRGB formats rarely
+ * support storage, the shader encodes sRGB into a UNORM format instead. */
+std::optional<VkSurfaceFormatKHR> FindStorageSurfaceFormat(
+		VkPhysicalDevice                       physicalDevice,
+		const ArenaVector<VkSurfaceFormatKHR> &availableFormats
+)
+{
+	for (const auto &availableFormat : availableFormats)
+	{
+		if ((availableFormat.format != VK_FORMAT_B8G8R8A8_UNORM
+			 && availableFormat.format != VK_FORMAT_R8G8B8A8_UNORM)
+			|| availableFormat.colorSpace != VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+		{
+			continue;
+		}
+
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, availableFormat.format, &properties);
+
+		if (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT)
+		{
+			return availableFormat;
+		}
+	}
+
+	return std::nullopt;
+}
+
+VkPresentModeKHR ChooseSwapPresentMode(const ArenaVector<VkPresentModeKHR> &availablePresentModes)
+{
+	assert(!availablePresentModes.empty());
+
+	for (const auto &availablePresentMode : availablePresentModes)
+	{
+		if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+		{
+			return availablePresentMode;
+		}
+	}
+
+	return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+VkExtent2D ChooseSwapExtent(GLFWwindow *window, const VkSurfaceCapabilitiesKHR &capabilities)
+{
+	if (capabilities.currentExtent.width != std::numeric_limits<u32>::max())
+	{
+		return capabilities.currentExtent;
+	}
+
+	i32 width = 0, height = 0;
+	glfwGetFramebufferSize(window, &width, &height);
+
+	VkExtent2D actualExtent = {static_cast<u32>(width), static_cast<u32>(height)};
+
+	actualExtent.width = std::clamp(
+			actualExtent.width,               //
+			capabilities.minImageExtent.width,//
+			capabilities.maxImageExtent.width //
+	);
+
+	actualExtent.height = std::clamp(
+			actualExtent.height,               //
+			capabilities.minImageExtent.height,//
+			capabilities.maxImageExtent.height //
+	);
+
+	return actualExtent;
+}
+
+// Milliseconds since startNs, on the Trace::Now() clock.
+f64 MillisecondsSince(u64 startNs)
+{
+	return (f64)(Trace::Now() - startNs) * 1e-6;
+}
+
+std::optional<VkShaderModule> CreateShaderModule(VkDevice device, const u32 *code, size_t codeSize)
+{
+	VkShaderModuleCreateInfo createInfo = {};
+
+	createInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.codeSize = codeSize;
+	createInfo.pCode    = code;
+
+	const VkAllocationCallbacks *allocator = HostAllocator::GetCallbacks();
+
+	VkShaderModule shaderModule;
+	if (vkCreateShaderModule(device, &createInfo, allocator, &shaderModule) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create shader module.");
+		return std::nullopt;
+	}
+
+	return shaderModule;
+}
+
+/**************************************
+*       APPLICATION            
+**************************************/
+
+bool Application::Run()
+{
+	if (Init() == EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	if (mResizeStressFrames > 0)
+	{
+		ResizeStressLoop();
+	}
+	else
+	{
+		MainLoop();
+	}
+
+	const bool allocationResult = LogAllocationCheck();
+
+	Cleanup();
+
+	return mIdleCheck.failed ? EXIT_FAILURE : allocationResult;
+}
+
+bool Application::Init()
+{
+	CLOG_INFO("Starting...");
+
+	if (!mTracePath.empty())
+	{
+		Trace::SetThreadName("Main");
+		Trace::Start();
+	}
+
+	if (mJobSystem.Init() == EXIT_FAILURE)
+	{
+		CLOG_ERR("Failed to initialize job system.");
+		return EXIT_FAILURE;
+	}
+
+	mFrameArena.Init(kMaxFramesInFlight, kFrameArenaBlockSize);
+
+	if (!mHeadless && InitWindow() == EXIT_FAILURE)
+	{
+		CLOG_ERR("Failed to initialize window.");
+		return EXIT_FAILURE;
+	}
+
+	HostAllocator::Init(mUseHostAllocator);
+	mAllocator = HostAllocator::GetCallbacks();
+
+	if (InitVulkan() == EXIT_FAILURE)
+	{
+		CLOG_ERR("Failed to initialize vulkan.");
+		return EXIT_FAILURE;
+	}
+
+	CreateScene();
+
+	// Headless frames advance the simulation themselves, see DrawHeadlessFrame.
+	mSimulation.SetManualClock(mHeadless);
+	if (mSimulation.Start() == EXIT_FAILURE)
+	{
+		CLOG_ERR("Failed to start simulation.");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void Application::Shutdown()
+{
+	vkDeviceWaitIdle(mDevice);
+	Cleanup();
+}
+
+bool Application::InitWindow()
+{
+	if (glfwInit() != GLFW_TRUE)
+	{
+		CLOG_ERR("glfwInit failed.");
+		return EXIT_FAILURE;
+	}
+
+	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+	glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+
+	mWindow = glfwCreateWindow(kWindowWidth, kWindowHeight, "VulkanTest", nullptr, nullptr);
+	if (!mWindow)
+	{
+		CLOG_ERR("glfwCreateWindow failed.");
+		return EXIT_FAILURE;
+	}
+
+	glfwSetWindowUserPointer(mWindow, this);
+	glfwSetFramebufferSizeCallback(mWindow, FramebufferResizeCallback);
+	glfwSetWindowRefreshCallback(mWindow, WindowRefreshCallback);
+	glfwSetWindowIconifyCallback(mWindow, WindowIconifyCallback);
+
+	// Any input may change what is on screen, so every input event invalidates the frame.
+	glfwSetKeyCallback(mWindow, KeyCallback);
+	glfwSetMouseButtonCallback(mWindow, MouseButtonCallback);
+	glfwSetCursorPosCallback(mWindow, CursorPosCallback);
+	glfwSetScrollCallback(mWindow, ScrollCallback);
+
+	CLOG_INFO("Window initialized successfully.");
+	return EXIT_SUCCESS;
+}
+
+static Application *GetWindowApplication(GLFWwindow *window)
+{
+	void        *userPtr = glfwGetWindowUserPointer(window);
+	Application *app     = reinterpret_cast<Application *>(userPtr);
+	COV_ASSERT(app != nullptr, "WindowUserPointer is not an Application class pointer.");
+	return app;
+}
+
+void Application::FramebufferResizeCallback(GLFWwindow *window, int /*width*/, int /*height*/)
+{
+	Application *app = GetWindowApplication(window);
+	const f64    now = glfwGetTime();
+
+	// Events are coalesced: only the time of the first unserved event and of the latest one
+	// are kept, the extent itself is queried when the swap chain is actually recreated.
+	if (!app->mFramebufferResized)
+	{
+		app->mFirstPendingResizeTime = now;
+	}
+
+	app->mFramebufferResized  = true;
+	app->mLastResizeEventTime = now;
+	++app->mResizeStats.resizeEvents;
+
+	app->RequestRedraw();
+}
+
+void Application::WindowRefreshCallback(GLFWwindow *window)
+{
+	// Window contents were damaged (exposed, uncovered, etc.)
+	GetWindowApplication(window)->RequestRedraw();
+}
+
+void Application::WindowIconifyCallback(GLFWwindow *window, int iconified)
+{
+	Application *app = GetWindowApplication(window);
+
+	app->mWindowIconified = iconified == GLFW_TRUE;
+	app->RequestRedraw();
+}
+
+void Application::KeyCallback(
+		GLFWwindow *window,
+		int         key,
+		int        /*scancode*/,
+		int         action,
+		int        /*mods*/
+)
+{
+	Application *app = GetWindowApplication(window);
+
+	// Served by the main loop, between two frames.
+	if (key == GLFW_KEY_F5 && action == GLFW_PRESS)
+	{
+		app->mShaderReloadRequested = true;
+	}
+
+	app->RequestRedraw();
+}
+
+void Application::MouseButtonCallback(
+		GLFWwindow *window,
+		int        /*button*/,
+		int        /*action*/,
+		int        /*mods*/
+)
+{
+	GetWindowApplication(window)->RequestRedraw();
+}
+
+void Application::CursorPosCallback(GLFWwindow *window, double /*x*/, double /*y*/)
+{
+	GetWindowApplication(window)->RequestRedraw();
+}
+
+void Application::ScrollCallback(GLFWwindow *window, double /*x*/, double /*y*/)
+{
+	GetWindowApplication(window)->RequestRedraw();
+}
+
+void Application::SetRenderMode(RenderMode mode)
+{
+	mRenderMode = mode;
+	RequestRedraw();
+}
+
+void Application::RequestRedraw()
+{
+	mRedrawRequested = true;
+}
+
+void Application::SetAnimating(bool animating)
+{
+	mAnimating = animating;
+	RequestRedraw();
+}
+
+void Application::SetResizePolicy(const ResizePolicy &policy)
+{
+	mResizePolicy = policy;
+}
+
+void Application::SetSceneInstanceCount(u32 count)
+{
+	mSceneInstanceCount = count;
+}
+
+void Application::SetSceneLightCount(u32 count)
+{
+	mSceneLightCount = count;
+}
+
+void Application::SetSceneDrawCount(u32 count)
+{
+	mSceneDrawCount = std::max(count, 1u);
+}
+
+void Application::SetScenePipelineCount(u32 count)
+{
+	mScenePipelineCount = std::max(count, 1u);
+}
+
+void Application::SetSceneOverdraw(bool enabled)
+{
+	mSceneOverdraw = enabled;
+}
+
+void Application::SetShadingIterations(u32 iterations)
+{
+	mShadingIterations = iterations;
+}
+
+void Application::SetShadowCascades(u32 cascadeCount, u32 resolution)
+{
+	mShadowSettings.cascadeCount = std::clamp(cascadeCount, 1u, ShadowCascades::kMaxCascades);
+	mShadowSettings.resolution   = resolution;
+}
+
+void Application::SetLodPixelError(f32 pixelError)
+{
+	mLodPixelError = std::max(pixelError, 0.0f);
+}
+
+void Application::SetMeshletCulling(bool enabled)
+{
+	mUseMeshlets = enabled;
+}
+
+void Application::SetOcclusionCulling(bool enabled)
+{
+	mOcclusionCulling = enabled;
+}
+
+void Application::SetPostProcessing(bool enabled, u32 effects)
+{
+	mPostProcessing       = enabled;
+	mPostSettings.effects = effects & PostProcess::kAllEffects;
+}
+
+void Application::SetSimulationTickRate(f64 tickRate)
+{
+	mSimulation.SetTickRate(tickRate);
+}
+
+void Application::SetMsaaSamples(u32 samples)
+{
+	mRequestedMsaaSamples = samples;
+}
+
+void Application::SetDepthPrepass(bool enabled)
+{
+	mDepthPrepass = enabled;
+}
+
+void Application::SetFailOnFrameAllocation(bool fail)
+{
+	if (fail && !AllocationTracker::IsEnabled())
+	{
+		CLOG_WARN("Built without COV_TRACK_ALLOCATIONS, frame allocations can not be checked.");
+	}
+
+	mAllocationCheck.failOnAllocation = fail;
+}
+
+void Application::SetIdleCheck(f64 timeout)
+{
+	mIdleCheck.timeout = timeout;
+}
+
+void Application::SetUseHostAllocator(bool use)
+{
+	mUseHostAllocator = use;
+}
+
+void Application::SetShaderDirectory(const char *directory)
+{
+	mShaderDirectory = directory;
+}
+
+void Application::SetValidationPreset(ValidationPreset preset)
+{
+	mValidationPreset = preset;
+}
+
+void Application::SetTracePath(const char *path)
+{
+	mTracePath = path;
+}
+
+void Application::EnableResizeStress(u32 frameCount)
+{
+	mResizeStressFrames = frameCount;
+}
+
+void Application::SetHeadless(VkExtent2D extent)
+{
+	mHeadless       = true;
+	mHeadlessExtent = extent;
+}
+
+void Application::SetDeviceFilter(const char *filter)
+{
+	mDeviceFilter = filter;
+}
+
+bool Application::InitVulkan()
+{
+	if (CreateInstance() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateInstance failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (VulkanDispatch::LoadInstance(mInstance) == EXIT_FAILURE)
+	{
+		CLOG_ERR("Loading instance functions failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (SetupDebugMessenger() == EXIT_FAILURE)
+	{
+		CLOG_ERR("SetupDebugMessenger failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (!mHeadless && CreateSurface() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateSurface failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (PickPhysicalDevice() == EXIT_FAILURE)
+	{
+		CLOG_ERR("PickPhysycalDevice failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (CreateLogicalDevice() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateLogicalDevice failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (VulkanDispatch::LoadDevice(mDevice) == EXIT_FAILURE)
+	{
+		CLOG_ERR("Loading device functions failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (mHeadless && CreateHeadlessImages() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateHeadlessImages failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (!mHeadless && CreateSwapChain(VK_NULL_HANDLE) == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateSwapChain failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (CreateImageViews() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateImageViews failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (CreateRenderPass() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateRenderPass failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (mDepthPrepass
+		&& CreateDepthPrepassRenderPass(VK_ATTACHMENT_LOAD_OP_CLEAR, mDepthPrepassRenderPass)
+				   == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateDepthPrepassRenderPass failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (mOcclusionCulling
+		&& CreateDepthPrepassRenderPass(VK_ATTACHMENT_LOAD_OP_LOAD, mDepthPrepassLoadRenderPass)
+				   == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateDepthPrepassRenderPass failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (CreateSceneMesh() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateSceneMesh failed.");
+		return EXIT_FAILURE;
+	}
+
+	// Meshlet culling references the instance buffers from its descriptor sets.
+	if (CreateInstanceBuffers() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateInstanceBuffers failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (mUseMeshlets && CreateMeshletCulling() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateMeshletCulling failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (mOcclusionCulling && CreateHiZPyramid() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateHiZPyramid failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (mPostProcessing && CreatePostProcess() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreatePostProcess failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (mSceneLightCount > 0 && CreateClusteredLighting() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateClusteredLighting failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (mSceneLightCount > 0 && CreateShadowCascades() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateShadowCascades failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (CreateGraphicsPipeline() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateGraphicsPipeline failed.");
+		return EXIT_FAILURE;
+	}
+
+	// Framebuffers reference the graph's transient attachments.
+	if (CreateRenderGraph() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateRenderGraph failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (CreateFramebuffers() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateFramebuffers failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (CreateCommandPool() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateCommandPool failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (CreateCommandBuffers() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateCommandBuffer failed.");
+		return EXIT_FAILURE;
+	}
+
+	if (CreateSyncObjects() == EXIT_FAILURE)
+	{
+		CLOG_ERR("CreateSyncObjects failed.");
+		return EXIT_FAILURE;
+	}
+
+	QueueFamilyIndices indices = FindQueueFamilies(mPhysicalDevice, mSurface);
+	if (mGpuTracer.Init(
+				mPhysicalDevice,
+				mDevice,
+				mGraphicsQueue,
+				indices.graphicsFamily.value(),
+				kMaxFramesInFlight,
+				mCalibratedTimestamps,
+				mAllocator
+		)
+		== EXIT_FAILURE)
+	{
+		CLOG_ERR("GpuTracer initialization failed.");
+		return EXIT_FAILURE;
+	}
+
+	CLOG_INFO("Vulkan initialized successfully.");
+	return EXIT_SUCCESS;
+}
+
+bool Application::CreateInstance()
+{
+	const bool validation = mValidationPreset != ValidationPreset::eOff;
+	if (validation && CheckValidationLayerSupport() == EXIT_FAILURE)
+	{
+		CLOG_ERR("Validation layers are enabled, but not available.");
+		return EXIT_FAILURE;
+	}
+
+	VkApplicationInfo appInfo  = {};
+	appInfo.sType              = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+	appInfo.pApplicationName   = "VulkanTest";
+	appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+	appInfo.pEngineName        = "No Engine";
+	appInfo.engineVersion      = VK_MAKE_VERSION(1, 0, 0);
+	appInfo.apiVersion         = VK_API_VERSION_1_1;
+
+	VkInstanceCreateInfo createInfo = {};
+	createInfo.sType                = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+	createInfo.pApplicationInfo     = &appInfo;
+
+	std::vector<const char *> glfwExtensions = GetRequiredExtensions(validation, mHeadless);
+
+	if (CheckExtensionsSupport((u32)glfwExtensions.size(), glfwExtensions.data()) == EXIT_FAILURE)
+	{
+		CLOG_ERR("Not all extensions are included.");
+		return EXIT_FAILURE;
+	}
+
+	createInfo.enabledExtensionCount   = (u32)glfwExtensions.size();
+	createInfo.ppEnabledExtensionNames = glfwExtensions.data();
+
+	// Instance creation and destruction messages go through the same messenger.
+	VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo = {};
+
+	std::array<VkValidationFeatureEnableEXT, 2> enabledFeatures = {};
+
+	VkValidationFeaturesEXT validationFeatures    = {};
+	validationFeatures.sType                      = VK_STRUCTURE_TYPE_VALIDATION_FEATURES_EXT;
+	validationFeatures.pEnabledValidationFeatures = enabledFeatures.data();
+
+	if (mValidationPreset == ValidationPreset::eSynchronization)
+	{
+		enabledFeatures[0] = VK_VALIDATION_FEATURE_ENABLE_SYNCHRONIZATION_VALIDATION_EXT;
+		validationFeatures.enabledValidationFeatureCount = 1;
+	}
+	else if (mValidationPreset == ValidationPreset::eGpuAssisted)
+	{
+		enabledFeatures[0] = VK_VALIDATION_FEATURE_ENABLE_GPU_ASSISTED_EXT;
+		enabledFeatures[1] = VK_VALIDATION_FEATURE_ENABLE_GPU_ASSISTED_RESERVE_BINDING_SLOT_EXT;
+		validationFeatures.enabledValidationFeatureCount = 2;
+	}
+
+	if (validation)
+	{
+		createInfo.enabledLayerCount   = kValidationLayers.size();
+		createInfo.ppEnabledLayerNames = kValidationLayers.data();
+
+		mValidationMessenger.PopulateCreateInfo(debugCreateInfo);
+		createInfo.pNext = &debugCreateInfo;
+
+		if (validationFeatures.enabledValidationFeatureCount > 0)
+		{
+			// Provided by the layer, the loader does not list it among the instance extensions.
+			glfwExtensions.push_back(VK_EXT_VALIDATION_FEATURES_EXTENSION_NAME);
+			createInfo.enabledExtensionCount   = (u32)glfwExtensions.size();
+			createInfo.ppEnabledExtensionNames = glfwExtensions.data();
+
+			debugCreateInfo.pNext = &validationFeatures;
+		}
+
+		CLOG_INFO(
+				"Validation preset \"",
+				kValidationPresetNames[(u32)mValidationPreset],
+				"\"."
+		);
+	}
+	else
+	{
+		createInfo.enabledLayerCount = 0;
+
+		createInfo.ppEnabledLayerNames = nullptr;
+		createInfo.pNext               = nullptr;
+	}
+
+
+	if (vkCreateInstance(&createInfo, mAllocator, &mInstance) != VK_SUCCESS)
+	{
+		CLOG_ERR("Vulkan instance creation failed.");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+bool Application::SetupDebugMessenger()
+{
+	if (mValidationPreset == ValidationPreset::eOff)
+	{
+		return EXIT_SUCCESS;
+	}
+
+	VkDebugUtilsMessengerCreateInfoEXT createInfo = {};
+	mValidationMessenger.PopulateCreateInfo(createInfo);
+
+	if (CreateDebugUtilsMessengerEXT(mInstance, &createInfo, mAllocator, &mDebugMessenger)
+		!= VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create debug utils messenger.");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+bool Application::PickPhysicalDevice()
+{
+	u32 deviceCount = 0;
+	vkEnumeratePhysicalDevices(mInstance, &deviceCount, nullptr);
+
+	if (deviceCount == 0)
+	{
+		CLOG_ERR("Failed to find any GPU.");
+		return EXIT_FAILURE;
+	}
+
+	std::vector<VkPhysicalDevice> devices(deviceCount);
+	vkEnumeratePhysicalDevices(mInstance, &deviceCount, devices.data());
+
+	for (VkPhysicalDevice &device : devices)
+	{
+		if (IsDeviceSuitable(device, mSurface, mDeviceFilter))
+		{
+			mPhysicalDevice = device;
+			break;
+		}
+	}
+
+	if (mPhysicalDevice == VK_NULL_HANDLE)
+	{
+		CLOG_ERR("Failed to find suitable GPU.");
+		return EXIT_FAILURE;
+	}
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(mPhysicalDevice, &properties);
+
+	mDeviceName = properties.deviceName;
+	CLOG_INFO("Using \"", mDeviceName, "\".");
+
+	SelectMsaaSamples();
+
+	// The depth pyramid is reduced from single-sampled depth.
+	if (mOcclusionCulling && mMsaaSamples != VK_SAMPLE_COUNT_1_BIT)
+	{
+		CLOG_WARN("Occlusion culling does not support MSAA, disabling it.");
+		mOcclusionCulling = false;
+	}
+
+	// Culls meshlets, which the prepass draws before the pyramid is built from its depth.
+	VkFormatFeatureFlags depthFeatures = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	if (mOcclusionCulling)
+	{
+		mUseMeshlets   = true;
+		mDepthPrepass  = true;
+		depthFeatures |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+	}
+
+	// Post-processing writes the swap chain image from compute, in a format picked at runtime.
+	if (mPostProcessing)
+	{
+		VkPhysicalDeviceFeatures features;
+		vkGetPhysicalDeviceFeatures(mPhysicalDevice, &features);
+
+		bool storageSupported = false;
+		if (mHeadless)
+		{
+			VkFormatProperties formatProperties;
+			vkGetPhysicalDeviceFormatProperties(
+					mPhysicalDevice, kHeadlessStorageFormat, &formatProperties
+			);
+
+			storageSupported = formatProperties.optimalTilingFeatures
+							 & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+		}
+		else
+		{
+			ScratchScope            scratch;
+			SwapChainSupportDetails swapChainSupport =
+					QuerySwapChainSupport(mPhysicalDevice, mSurface);
+
+			storageSupported =
+					(swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_STORAGE_BIT)
+					&& FindStorageSurfaceFormat(mPhysicalDevice, swapChainSupport.formats)
+							   .has_value();
+		}
+
+		if (!features.shaderStorageImageWriteWithoutFormat || !storageSupported)
+		{
+			CLOG_WARN("Swap chain images can not be written from compute, disabling post.");
+			mPostProcessing = false;
+		}
+	}
+
+	std::optional<VkFormat> depthFormat = FindDepthFormat(mPhysicalDevice, depthFeatures);
+	if (!depthFormat.has_value())
+	{
+		CLOG_ERR("No supported depth attachment format.");
+		return EXIT_FAILURE;
+	}
+	mDepthFormat = depthFormat.value();
+
+	return EXIT_SUCCESS;
+}
+
+void Application::SelectMsaaSamples()
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(mPhysicalDevice, &properties);
+
+	const VkSampleCountFlags supported = properties.limits.framebufferColorSampleCounts
+									   & properties.limits.framebufferDepthSampleCounts;
+
+	u32 samples = 1;
+	while (samples * 2 <= std::min(mRequestedMsaaSamples, 8u) && (supported & (samples * 2)))
+	{
+		samples *= 2;
+	}
+
+	mMsaaSamples = (VkSampleCountFlagBits)samples;
+
+	if (samples != mRequestedMsaaSamples)
+	{
+		CLOG_WARN("MSAA ", mRequestedMsaaSamples, "x is not supported, using ", samples, "x.");
+	}
+	else if (samples > 1)
+	{
+		CLOG_INFO("MSAA ", samples, "x.");
+	}
+}
+
+bool Application::CreateLogicalDevice()
+{
+	QueueFamilyIndices indices = FindQueueFamilies(mPhysicalDevice, mSurface);
+
+	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+	std::set<u32>                        uniqueQueueFamilies = {
+            indices.graphicsFamily.value(), indices.presentFamily.value()
+    };
+
+	float queuePriority = 1.0f;
+	for (u32 queueFamily : uniqueQueueFamilies)
+	{
+		VkDeviceQueueCreateInfo queueCreateInfo = {};
+		queueCreateInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queueCreateInfo.queueFamilyIndex        = queueFamily;
+		queueCreateInfo.queueCount              = 1;
+		queueCreateInfo.pQueuePriorities        = &queuePriority;
+		queueCreateInfos.push_back(queueCreateInfo);
+	}
+
+	VkPhysicalDeviceFeatures deviceFeatures = {};
+
+	// GPU-assisted validation instruments shaders with storage buffer writes.
+	if (mValidationPreset == ValidationPreset::eGpuAssisted)
+	{
+		VkPhysicalDeviceFeatures supported;
+		vkGetPhysicalDeviceFeatures(mPhysicalDevice, &supported);
+
+		deviceFeatures.vertexPipelineStoresAndAtomics = supported.vertexPipelineStoresAndAtomics;
+		deviceFeatures.fragmentStoresAndAtomics       = supported.fragmentStoresAndAtomics;
+	}
+
+	// Checked by PickPhysicalDevice, post-processing writes the swap chain image without a format.
+	deviceFeatures.shaderStorageImageWriteWithoutFormat = mPostProcessing ? VK_TRUE : VK_FALSE;
+
+	VkPhysicalDeviceSynchronization2FeaturesKHR sync2Features = {};
+	sync2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+	sync2Features.synchronization2 = VK_TRUE;
+
+	VkDeviceCreateInfo createInfo   = {};
+	createInfo.sType                = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	createInfo.pNext                = &sync2Features;
+	createInfo.pQueueCreateInfos    = queueCreateInfos.data();
+	createInfo.queueCreateInfoCount = (u32)queueCreateInfos.size();
+
+	createInfo.pEnabledFeatures = &deviceFeatures;
+
+	std::vector<const char *> extensions(kDeviceExtensions.begin(), kDeviceExtensions.end());
+
+	// Optional, GPU trace scopes fall back to a calibration by submission without it.
+	mCalibratedTimestamps = IsDeviceExtensionSupported(
+			mPhysicalDevice, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME
+	);
+	if (mCalibratedTimestamps)
+	{
+		extensions.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+	}
+
+	createInfo.ppEnabledExtensionNames = extensions.data();
+	createInfo.enabledExtensionCount   = (u32)extensions.size();
+
+	if (mValidationPreset != ValidationPreset::eOff)
+	{
+		createInfo.ppEnabledLayerNames = kValidationLayers.data();
+		createInfo.enabledLayerCount   = kValidationLayers.size();
+	}
+	else
+	{
+		createInfo.enabledLayerCount = 0;
+	}
+
+	if (vkCreateDevice(mPhysicalDevice, &createInfo, mAllocator, &mDevice))
+	{
+		CLOG_ERR("Failed to create logical device.");
+		return EXIT_FAILURE;
+	}
+
+
+	vkGetDeviceQueue(mDevice, indices.graphicsFamily.value(), 0, &mGraphicsQueue);
+	vkGetDeviceQueue(mDevice, indices.presentFamily.value(), 0, &mPresentQueue);
+
+	mRenderGraph.Init(mDevice, mPhysicalDevice);
+	mRenderGraph.SetGpuTracer(&mGpuTracer);
+	mLayoutCache.Init(mDevice);
+
+	return EXIT_SUCCESS;
+}
+
+bool Application::CreateSurface()
+{
+	if (glfwCreateWindowSurface(mInstance, mWindow, mAllocator, &mSurface) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create window surface.");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+bool Application::CreateSwapChain(VkSwapchainKHR oldSwapChain)
+{
+	ScratchScope            scratch;
+	SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport(mPhysicalDevice, mSurface);
+
+	VkPresentModeKHR presentMode = ChooseSwapPresentMode(swapChainSupport.presentModes);
+	VkExtent2D       extent      = ChooseSwapExtent(mWindow, swapChainSupport.capabilities);
+
+	// Post-processing writes the images from compute, the main pass renders elsewhere then.
+	VkSurfaceFormatKHR surfaceFormat = ChooseSwapSurfaceFormat(swapChainSupport.formats);
+	VkImageUsageFlags  imageUsage    = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	if (mPostProcessing)
+	{
+		std::optional<VkSurfaceFormatKHR> storageFormat =
+				FindStorageSurfaceFormat(mPhysicalDevice, swapChainSupport.formats);
+		if (!storageFormat.has_value())
+		{
+			CLOG_ERR("The surface no longer has a format compute can write.");
+			return EXIT_FAILURE;
+		}
+
+		surfaceFormat = storageFormat.value();
+		imageUsage    = VK_IMAGE_USAGE_STORAGE_BIT;
+	}
+
+	u32 imageCount = swapChainSupport.capabilities.minImageCount + 1;
+	if (swapChainSupport.capabilities.maxImageCount > 0
+		&& imageCount > swapChainSupport.capabilities.maxImageCount)
+	{
+		imageCount = swapChainSupport.capabilities.maxImageCount;
+	}
+
+	VkSwapchainCreateInfoKHR createInfo = {};
+
+	createInfo.sType            = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+	createInfo.surface          = mSurface;
+	createInfo.minImageCount    = imageCount;
+	createInfo.imageFormat      = surfaceFormat.format;
+	createInfo.imageColorSpace  = surfaceFormat.colorSpace;
+	createInfo.imageExtent      = extent;
+	createInfo.imageArrayLayers = 1;
+	createInfo.imageUsage       = imageUsage;
+
+	QueueFamilyIndices indices = FindQueueFamilies(mPhysicalDevice, mSurface);
+	u32 queueFamilyIndices[]   = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+
+	if (indices.graphicsFamily != indices.presentFamily)
+	{
+		createInfo.imageSharingMode      = VK_SHARING_MODE_CONCURRENT;
+		createInfo.queueFamilyIndexCount = 2;
+		createInfo.pQueueFamilyIndices   = queueFamilyIndices;
+	}
+	else
+	{
+		createInfo.imageSharingMode      = VK_SHARING_MODE_EXCLUSIVE;
+		createInfo.queueFamilyIndexCount = 0;
+		createInfo.pQueueFamilyIndices   = nullptr;
+	}
+
+	createInfo.preTransform   = swapChainSupport.capabilities.currentTransform;
+	createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+	createInfo.presentMode    = presentMode;
+	createInfo.clipped        = VK_TRUE;
+
+	// Handing over the old swap chain lets the driver reuse its resources and keep presenting
+	// it until the new one is ready.
+	createInfo.oldSwapchain = oldSwapChain;
+
+	if (vkCreateSwapchainKHR(mDevice, &createInfo, mAllocator, &mSwapChain) != VK_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	vkGetSwapchainImagesKHR(mDevice, mSwapChain, &imageCount, nullptr);
+	mSwapChainImages.resize(imageCount);
+	vkGetSwapchainImagesKHR(mDevice, mSwapChain, &imageCount, mSwapChainImages.data());
+
+	mSwapChainImageFormat = surfaceFormat.format;
+	mSwapChainExtent      = extent;
+
+	return EXIT_SUCCESS;
+}
+
+bool Application::CreateHeadlessImages()
+{
+	// Post-processing writes the images from compute, the main pass renders elsewhere then. They
+	// end every frame ready to be copied out, like swap chain images end ready to be presented.
+	VkImageUsageFlags imageUsage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	if (mPostProcessing)
+	{
+		mSwapChainImageFormat  = kHeadlessStorageFormat;
+		imageUsage            |= VK_IMAGE_USAGE_STORAGE_BIT;
+	}
+	else
+	{
+		mSwapChainImageFormat  = kHeadlessFormat;
+		imageUsage            |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	}
+	mSwapChainExtent = mHeadlessExtent;
+
+	// One per frame in flight, the frame's fence then covers its image like acquire would.
+	mSwapChainImages.assign(kMaxFramesInFlight, VK_NULL_HANDLE);
+	mHeadlessImagesMemory.assign(kMaxFramesInFlight, VK_NULL_HANDLE);
+
+	for (u32 i = 0; i < mSwapChainImages.size(); ++i)
+	{
+		VkImageCreateInfo imageInfo = {};
+
+		imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+		imageInfo.format        = mSwapChainImageFormat;
+		imageInfo.extent        = {mSwapChainExtent.width, mSwapChainExtent.height, 1};
+		imageInfo.mipLevels     = 1;
+		imageInfo.arrayLayers   = 1;
+		imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage         = imageUsage;
+		imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		if (vkCreateImage(mDevice, &imageInfo, mAllocator, &mSwapChainImages[i]) != VK_SUCCESS)
+		{
+			CLOG_ERR("Failed to create headless image.");
+			return EXIT_FAILURE;
+		}
+
+		VkMemoryRequirements requirements;
+		vkGetImageMemoryRequirements(mDevice, mSwapChainImages[i], &requirements);
+
+		std::optional<u32> memoryType = FindMemoryType(
+				mPhysicalDevice, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		);
+		if (!memoryType.has_value())
+		{
+			CLOG_ERR("No device local memory for the headless images.");
+			return EXIT_FAILURE;
+		}
+
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize       = requirements.size;
+		allocInfo.memoryTypeIndex      = memoryType.value();
+
+		VkDeviceMemory &memory = mHeadlessImagesMemory[i];
+		if (vkAllocateMemory(mDevice, &allocInfo, mAllocator, &memory) != VK_SUCCESS
+			|| vkBindImageMemory(mDevice, mSwapChainImages[i], memory, 0) != VK_SUCCESS)
+		{
+			CLOG_ERR("Failed to allocate headless image memory.");
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void Application::DestroyHeadlessImages()
+{
+	for (u32 i = 0; i < mSwapChainImages.size(); ++i)
+	{
+		vkDestroyImage(mDevice, mSwapChainImages[i], mAllocator);
+		vkFreeMemory(mDevice, mHeadlessImagesMemory[i], mAllocator);
+	}
+
+	mSwapChainImages.clear();
+	mHeadlessImagesMemory.clear();
+}
+
+bool Application::CreateImageViews()
+{
+	mSwapChainImageViews.resize(mSwapChainImages.size());
+	for (u32 i = 0; i < mSwapChainImages.size(); ++i)
+	{
+		VkImageViewCreateInfo createInfo = {};
+
+		createInfo.sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		createInfo.image    = mSwapChainImages[i];
+		createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		createInfo.format   = mSwapChainImageFormat;
+
+		createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+		createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+		createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+		createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+
+		createInfo.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+		createInfo.subresourceRange.baseMipLevel   = 0;
+		createInfo.subresourceRange.levelCount     = 1;
+		createInfo.subresourceRange.baseArrayLayer = 0;
+		createInfo.subresourceRange.layerCount     = 1;
+
+		if (vkCreateImageView(mDevice, &createInfo, mAllocator, &mSwapChainImageViews[i])
+			!= VK_SUCCESS)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+std::optional<VkShaderModule> Application::LoadShader(
+		const char       *name,
+		const u32        *code,
+		size_t            codeSize,
+		ShaderReflection &reflection
+)
+{
+	std::vector<char> file;
+	if (!mShaderDirectory.empty())
+	{
+		// vector storage comes from operator new, aligned enough for pCode.
+		file = ReadFile(mShaderDirectory + "/" + name + ".spv");
+		if (file.empty() || file.size() % sizeof(u32) != 0)
+		{
+			CLOG_ERR("\"", name, ".spv\" in \"", mShaderDirectory, "\" is not valid SPIR-V.");
+			return std::nullopt;
+		}
+
+		code     = reinterpret_cast<const u32 *>(file.data());
+		codeSize = file.size();
+	}
+
+	if (ReflectSpirv(code, codeSize, reflection) == EXIT_FAILURE)
+	{
+		CLOG_ERR("Failed to reflect \"", name, "\".");
+		return std::nullopt;
+	}
+
+	return CreateShaderModule(mDevice, code, codeSize);
+}
+
+bool Application::CreateClusteredLighting()
+{
+	ShaderReflection cullReflection;
+
+	std::optional<VkShaderModule> cullModule = LoadShader(
+			"light_cull_comp", kLightCullCompSpirv, sizeof(kLightCullCompSpirv), cullReflection
+	);
+	if (!cullModule.has_value())
+	{
+		return EXIT_FAILURE;
+	}
+
+	const bool result = mClusteredLighting.Init(
+			mDevice,
+			mPhysicalDevice,
+			mLayoutCache,
+			cullModule.value(),
+			cullReflection,
+			kMaxFramesInFlight,
+			mSceneLightCount,
+			mAllocator
+	);
+
+	vkDestroyShaderModule(mDevice, cullModule.value(), mAllocator);
+	return result;
+}
+
+bool Application::CreateShadowCascades()
+{
+	ShaderReflection vertReflection;
+
+	std::optional<VkShaderModule> vertModule = LoadShader(
+			"shadow_vert", kShadowVertSpirv, sizeof(kShadowVertSpirv), vertReflection
+	);
+	if (!vertModule.has_value())
+	{
+		return EXIT_FAILURE;
+	}
+
+	const bool result = mShadowCascades.Init(
+			mDevice,
+			mPhysicalDevice,
+			mLayoutCache,
+			vertModule.value(),
+			vertReflection,
+			kMaxFramesInFlight,
+			mShadowSettings,
+			mAllocator
+	);
+
+	vkDestroyShaderModule(mDevice, vertModule.value(), mAllocator);
+	return result;
+}
+
+bool Application::CreateSceneMesh()
+{
+	std::vector<glm::vec3> positions;
+	std::vector<u32>       indices;
+	CreateBlobMesh(4, positions, indices);
+
+	const MeshData mesh = ImportMesh(std::move(positions), std::move(indices));
+	return mSceneMesh.Init(mDevice, mPhysicalDevice, mesh, mAllocator);
+}
+
+bool Application::CreateMeshletCulling()
+{
+	ShaderReflection cullReflection;
+
+	// The occlusion variant also declares the depth pyramids of mHiZPyramid.
+	const char  *cullName = mOcclusionCulling ? "meshlet_cull_occlusion_comp" : "meshlet_cull_comp";
+	const u32   *cullCode = mOcclusionCulling ? kMeshletCullOcclusionCompSpirv
+											  : kMeshletCullCompSpirv;
+	const size_t cullSize = mOcclusionCulling ? sizeof(kMeshletCullOcclusionCompSpirv)
+											  : sizeof(kMeshletCullCompSpirv);
+
+	std::optional<VkShaderModule> cullModule =
+			LoadShader(cullName, cullCode, cullSize, cullReflection);
+	if (!cullModule.has_value())
+	{
+		return EXIT_FAILURE;
+	}
+
+	const bool result = mMeshletCulling.Init(
+			mDevice,
+			mPhysicalDevice,
+			mLayoutCache,
+			cullModule.value(),
+			cullReflection,
+			mSceneMesh,
+			mInstanceBuffers.data(),
+			kMaxFramesInFlight,
+			MeshletCulling::kDefaultMaxClusters,
+			mAllocator
+	);
+
+	vkDestroyShaderModule(mDevice, cullModule.value(), mAllocator);
+	return result;
+}
+
+bool Application::CreateHiZPyramid()
+{
+	ShaderReflection buildReflection;
+
+	std::optional<VkShaderModule> buildModule = LoadShader(
+			"hiz_build_comp", kHizBuildCompSpirv, sizeof(kHizBuildCompSpirv), buildReflection
+	);
+	if (!buildModule.has_value())
+	{
+		return EXIT_FAILURE;
+	}
+
+	const bool result = mHiZPyramid.Init(
+			mDevice,
+			mPhysicalDevice,
+			mLayoutCache,
+			buildModule.value(),
+			buildReflection,
+			kMaxFramesInFlight,
+			mAllocator
+	);
+
+	vkDestroyShaderModule(mDevice, buildModule.value(), mAllocator);
+	if (result == EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	// Set 0 of the culling shader holds the meshlet buffers.
+	return mHiZPyramid.BindCullLayout(mMeshletCulling.GetCullLayout(), 1);
+}
+
+bool Application::CreatePostProcess()
+{
+	// Only the permutation of the enabled effects is loaded.
+	const EmbeddedShader &permutation = kPostProcessPermutations[mPostSettings.effects];
+
+	ShaderReflection reflection;
+
+	std::optional<VkShaderModule> module = LoadShader(
+			permutation.name, permutation.code, permutation.codeSize, reflection
+	);
+	if (!module.has_value())
+	{
+		return EXIT_FAILURE;
+	}
+
+	const bool result = mPostProcess.Init(
+			mDevice, mLayoutCache, module.value(), reflection, mPostSettings, mAllocator
+	);
+
+	vkDestroyShaderModule(mDevice, module.value(), mAllocator);
+	return result;
+}
+
+bool Application::CreateGraphicsPipeline()
+{
+	ScratchScope scratch;
+
+	ShaderReflection vertReflection;
+	ShaderReflection fragReflection;
+
+	VkShaderModule vertShaderModule;
+	{
+		// Meshlet draws pull their vertices from storage buffers.
+		const char  *vertName = mUseMeshlets ? "meshlet_vert" : "mesh_vert";
+		const u32   *vertCode = mUseMeshlets ? kMeshletVertSpirv : kMeshVertSpirv;
+		const size_t vertSize = mUseMeshlets ? sizeof(kMeshletVertSpirv) : sizeof(kMeshVertSpirv);
+
+		std::optional<VkShaderModule> handle =
+				LoadShader(vertName, vertCode, vertSize, vertReflection);
+		if (!handle.has_value())
+		{
+			return EXIT_FAILURE;
+		}
+		vertShaderModule = handle.value();
+	}
+
+	// Lit scenes shade with the lights binned by mClusteredLighting.
+	const bool   clustered = mSceneLightCount > 0;
+	const char  *fragName  = clustered ? "clustered_frag" : "shader_frag";
+	const u32   *fragCode  = clustered ? kClusteredFragSpirv : kShaderFragSpirv;
+	const size_t fragSize  = clustered ? sizeof(kClusteredFragSpirv) : sizeof(kShaderFragSpirv);
+
+	VkShaderModule fragShaderModule;
+	{
+		std::optional<VkShaderModule> handle =
+				LoadShader(fragName, fragCode, fragSize, fragReflection);
+		if (!handle.has_value())
+		{
+			vkDestroyShaderModule(mDevice, vertShaderModule, mAllocator);
+			return EXIT_FAILURE;
+		}
+		fragShaderModule = handle.value();
+	}
+
+	VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
+	vertShaderStageInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	vertShaderStageInfo.stage  = VK_SHADER_STAGE_VERTEX_BIT;
+	vertShaderStageInfo.module = vertShaderModule;
+	vertShaderStageInfo.pName  = "main";
+
+	// kShadingIterations of shader_frag.glsl.
+	const u32 shadingIterations = mShadingIterations;
+
+	VkSpecializationMapEntry shadingEntry = {0, 0, sizeof(u32)};
+
+	VkSpecializationInfo specialization = {};
+	specialization.mapEntryCount        = 1;
+	specialization.pMapEntries          = &shadingEntry;
+	specialization.dataSize             = sizeof(shadingIterations);
+	specialization.pData                = &shadingIterations;
+
+	VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
+	fragShaderStageInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	fragShaderStageInfo.stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
+	fragShaderStageInfo.module = fragShaderModule;
+	fragShaderStageInfo.pName  = "main";
+
+	fragShaderStageInfo.pSpecializationInfo = clustered ? nullptr : &specialization;
+
+	VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
+
+
+	// Mesh positions per vertex, InstanceData per instance. meshlet_vert has no vertex inputs.
+	MeshVertexInput vertexInput;
+
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	if (!mUseMeshlets)
+	{
+		if (BuildMeshVertexInput(vertReflection, sizeof(InstanceData), vertexInput) == EXIT_FAILURE)
+		{
+			vkDestroyShaderModule(mDevice, vertShaderModule, mAllocator);
+			vkDestroyShaderModule(mDevice, fragShaderModule, mAllocator);
+			return EXIT_FAILURE;
+		}
+		vertexInputInfo = vertexInput.GetCreateInfo();
+	}
+
+
+	ArenaVector<VkDynamicState> dynamicStates = {
+			VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR
+	};
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+	inputAssembly.sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+
+	VkViewport viewport = {};
+	viewport.x          = 0.0f;
+	viewport.y          = 0.0f;
+	viewport.width      = (f32)mSwapChainExtent.width;
+	viewport.height     = (f32)mSwapChainExtent.height;
+	viewport.minDepth   = 0.0f;
+	viewport.maxDepth   = 1.0f;
+
+
+	VkRect2D scissor = {};
+	scissor.offset   = {0, 0};
+	scissor.extent   = mSwapChainExtent;
+
+
+	VkPipelineDynamicStateCreateInfo dynamicState = {};
+	dynamicState.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = (u32)dynamicStates.size();
+	dynamicState.pDynamicStates    = dynamicStates.data();
+
+
+	VkPipelineViewportStateCreateInfo viewportState = {};
+	viewportState.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportState.viewportCount = 1;
+	viewportState.pViewports    = &viewport;
+	viewportState.scissorCount  = 1;
+	viewportState.pScissors     = &scissor;
+
+
+	VkPipelineRasterizationStateCreateInfo rasterizer = {};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+
+	rasterizer.depthClampEnable        = VK_FALSE;
+	rasterizer.rasterizerDiscardEnable = VK_FALSE;
+	rasterizer.polygonMode             = VK_POLYGON_MODE_FILL;
+
+	rasterizer.lineWidth = 1.0f;
+
+	rasterizer.cullMode  = VK_CULL_MODE_BACK_BIT;
+	rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+
+	rasterizer.depthBiasEnable         = VK_FALSE;
+	rasterizer.depthBiasConstantFactor = 0.0f;
+	rasterizer.depthBiasClamp          = 0.0f;
+	rasterizer.depthBiasSlopeFactor    = 0.0f;
+
+
+	VkPipelineMultisampleStateCreateInfo multisampling = {};
+	multisampling.sType                 = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisampling.sampleShadingEnable   = VK_FALSE;
+	multisampling.rasterizationSamples  = mMsaaSamples;
+	multisampling.minSampleShading      = 1.0f;
+	multisampling.pSampleMask           = nullptr;
+	multisampling.alphaToCoverageEnable = VK_FALSE;
+	multisampling.alphaToOneEnable      = VK_FALSE;
+
+
+	VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT
+										| VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+	colorBlendAttachment.blendEnable         = VK_FALSE;
+	colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+	colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+	colorBlendAttachment.colorBlendOp        = VK_BLEND_OP_ADD;
+	colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	colorBlendAttachment.alphaBlendOp        = VK_BLEND_OP_ADD;
+
+
+	VkPipelineColorBlendStateCreateInfo colorBlending = {};
+	colorBlending.sType             = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlending.logicOpEnable     = VK_FALSE;
+	colorBlending.logicOp           = VK_LOGIC_OP_COPY;
+	colorBlending.attachmentCount   = 1;
+	colorBlending.pAttachments      = &colorBlendAttachment;
+	colorBlending.blendConstants[0] = 0.f;
+	colorBlending.blendConstants[1] = 0.f;
+	colorBlending.blendConstants[2] = 0.f;
+	colorBlending.blendConstants[3] = 0.f;
+
+	// Pipeline variants only differ by a tint, blended in as a constant color.
+	if (mScenePipelineCount > 1)
+	{
+		colorBlendAttachment.blendEnable         = VK_TRUE;
+		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_CONSTANT_COLOR;
+		for (f32 &constant : colorBlending.blendConstants)
+		{
+			constant = 0.5f;
+		}
+	}
+
+
+	// After a prepass the depth buffer holds the nearest surfaces, only their fragments are shaded.
+	VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+
+	depthStencil.depthTestEnable       = VK_TRUE;
+	depthStencil.depthWriteEnable      = mDepthPrepass ? VK_FALSE : VK_TRUE;
+	depthStencil.depthCompareOp        = mDepthPrepass ? VK_COMPARE_OP_EQUAL : VK_COMPARE_OP_LESS;
+	depthStencil.depthBoundsTestEnable = VK_FALSE;
+	depthStencil.stencilTestEnable     = VK_FALSE;
+
+
+	const ShaderReflection *stageReflections[] = {&vertReflection, &fragReflection};
+
+	std::optional<VkPipelineLayout> pipelineLayout =
+			mLayoutCache.GetPipelineLayout(stageReflections, (u32)std::size(stageReflections));
+	if (!pipelineLayout.has_value())
+	{
+		CLOG_ERR("Pipeline layout creation failed.");
+		vkDestroyShaderModule(mDevice, vertShaderModule, mAllocator);
+		vkDestroyShaderModule(mDevice, fragShaderModule, mAllocator);
+		return EXIT_FAILURE;
+	}
+
+	// A reload keeps the descriptor sets allocated for the layout, the interface can not change.
+	const bool reload = mPipelineLayout != VK_NULL_HANDLE;
+	if (reload && pipelineLayout.value() != mPipelineLayout)
+	{
+		CLOG_ERR("Reloaded shaders changed the pipeline layout, restart to use them.");
+		vkDestroyShaderModule(mDevice, vertShaderModule, mAllocator);
+		vkDestroyShaderModule(mDevice, fragShaderModule, mAllocator);
+		return EXIT_FAILURE;
+	}
+	mPipelineLayout = pipelineLayout.value();
+
+	// clustered_frag declares the lights at set 0 and the shadow atlas at set 1.
+	if (!reload && clustered
+		&& (mClusteredLighting.BindGraphicsLayout(mPipelineLayout) == EXIT_FAILURE
+			|| mShadowCascades.BindGraphicsLayout(mPipelineLayout, 1) == EXIT_FAILURE))
+	{
+		vkDestroyShaderModule(mDevice, vertShaderModule, mAllocator);
+		vkDestroyShaderModule(mDevice, fragShaderModule, mAllocator);
+		return EXIT_FAILURE;
+	}
+
+	// meshlet_vert declares its buffers at set 2, after the lighting sets.
+	if (!reload && mUseMeshlets
+		&& mMeshletCulling.BindGraphicsLayout(mPipelineLayout, 2) == EXIT_FAILURE)
+	{
+		vkDestroyShaderModule(mDevice, vertShaderModule, mAllocator);
+		vkDestroyShaderModule(mDevice, fragShaderModule, mAllocator);
+		return EXIT_FAILURE;
+	}
+
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType                        = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount                   = 2;
+	pipelineInfo.pStages                      = shaderStages;
+
+	pipelineInfo.pVertexInputState   = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState      = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pMultisampleState   = &multisampling;
+	pipelineInfo.pDepthStencilState  = &depthStencil;
+	pipelineInfo.pColorBlendState    = &colorBlending;
+	pipelineInfo.pDynamicState       = &dynamicState;
+
+	pipelineInfo.layout             = mPipelineLayout;
+	pipelineInfo.renderPass         = mRenderPass;
+	pipelineInfo.subpass            = 0;
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	pipelineInfo.basePipelineIndex  = -1;
+
+	if (vkCreateGraphicsPipelines(
+				mDevice, VK_NULL_HANDLE, 1, &pipelineInfo, mAllocator, &mGraphicsPipeline
+		)
+		!= VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create the graphics pipeline.");
+		vkDestroyShaderModule(mDevice, vertShaderModule, mAllocator);
+		vkDestroyShaderModule(mDevice, fragShaderModule, mAllocator);
+		return EXIT_FAILURE;
+	}
+
+	mScenePipelines.assign(mScenePipelineCount - 1, VK_NULL_HANDLE);
+	for (u32 i = 0; i < mScenePipelines.size(); ++i)
+	{
+		const f32 tint = 0.5f + 0.5f * (f32)(i + 1) / (f32)mScenePipelineCount;
+		for (f32 &constant : colorBlending.blendConstants)
+		{
+			constant = tint;
+		}
+
+		if (vkCreateGraphicsPipelines(
+					mDevice, VK_NULL_HANDLE, 1, &pipelineInfo, mAllocator, &mScenePipelines[i]
+			)
+			!= VK_SUCCESS)
+		{
+			CLOG_ERR("Failed to create scene pipeline ", i + 1, ".");
+			vkDestroyShaderModule(mDevice, vertShaderModule, mAllocator);
+			vkDestroyShaderModule(mDevice, fragShaderModule, mAllocator);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (mDepthPrepass)
+	{
+		// Same vertex stage and rasterization, so depth matches bit for bit. No color output.
+		VkPipelineDepthStencilStateCreateInfo prepassDepthStencil = depthStencil;
+		prepassDepthStencil.depthWriteEnable                      = VK_TRUE;
+		prepassDepthStencil.depthCompareOp                        = VK_COMPARE_OP_LESS;
+
+		VkPipelineColorBlendStateCreateInfo prepassColorBlending = colorBlending;
+		prepassColorBlending.attachmentCount                     = 0;
+		prepassColorBlending.pAttachments                        = nullptr;
+
+		pipelineInfo.stageCount         = 1;
+		pipelineInfo.pDepthStencilState = &prepassDepthStencil;
+		pipelineInfo.pColorBlendState   = &prepassColorBlending;
+		pipelineInfo.renderPass         = mDepthPrepassRenderPass;
+
+		if (vkCreateGraphicsPipelines(
+					mDevice, VK_NULL_HANDLE, 1, &pipelineInfo, mAllocator, &mDepthPrepassPipeline
+			)
+			!= VK_SUCCESS)
+		{
+			CLOG_ERR("Failed to create the depth prepass pipeline.");
+			vkDestroyShaderModule(mDevice, vertShaderModule, mAllocator);
+			vkDestroyShaderModule(mDevice, fragShaderModule, mAllocator);
+			return EXIT_FAILURE;
+		}
+	}
+
+	vkDestroyShaderModule(mDevice, vertShaderModule, mAllocator);
+	vkDestroyShaderModule(mDevice, fragShaderModule, mAllocator);
+
+	return EXIT_SUCCESS;
+}
+
+void Application::DestroyGraphicsPipelines()
+{
+	vkDestroyPipeline(mDevice, mGraphicsPipeline, mAllocator);
+	for (VkPipeline pipeline : mScenePipelines)
+	{
+		vkDestroyPipeline(mDevice, pipeline, mAllocator);
+	}
+	vkDestroyPipeline(mDevice, mDepthPrepassPipeline, mAllocator);
+
+	mGraphicsPipeline     = VK_NULL_HANDLE;
+	mDepthPrepassPipeline = VK_NULL_HANDLE;
+	mScenePipelines.clear();
+}
+
+void Application::ReloadShaders()
+{
+	if (mShaderDirectory.empty())
+	{
+		CLOG_WARN("Shaders are embedded, set a shader directory to reload them.");
+		return;
+	}
+
+	// No frame in flight may still use the pipelines replaced below.
+	vkDeviceWaitIdle(mDevice);
+
+	// Set aside, a shader that fails to build keeps the previous pipelines drawing.
+	const VkPipeline        graphicsPipeline     = mGraphicsPipeline;
+	const VkPipeline        depthPrepassPipeline = mDepthPrepassPipeline;
+	std::vector<VkPipeline> scenePipelines       = std::move(mScenePipelines);
+
+	mGraphicsPipeline     = VK_NULL_HANDLE;
+	mDepthPrepassPipeline = VK_NULL_HANDLE;
+	mScenePipelines.clear();
+
+	if (CreateGraphicsPipeline() == EXIT_FAILURE)
+	{
+		CLOG_ERR("Shader reload failed, the previous pipelines are kept.");
+		DestroyGraphicsPipelines();
+
+		mGraphicsPipeline     = graphicsPipeline;
+		mDepthPrepassPipeline = depthPrepassPipeline;
+		mScenePipelines       = std::move(scenePipelines);
+		return;
+	}
+
+	vkDestroyPipeline(mDevice, graphicsPipeline, mAllocator);
+	for (VkPipeline pipeline : scenePipelines)
+	{
+		vkDestroyPipeline(mDevice, pipeline, mAllocator);
+	}
+	vkDestroyPipeline(mDevice, depthPrepassPipeline, mAllocator);
+
+	CLOG_INFO("Scene shaders reloaded from \"", mShaderDirectory, "\".");
+}
+
+bool Application::CreateRenderPass()
+{
+	const bool msaa = mMsaaSamples != VK_SAMPLE_COUNT_1_BIT;
+
+	// With post-processing the scene is rendered in HDR, the swap chain image is written later.
+	const VkFormat colorFormat = mPostProcessing ? PostProcess::kHdrFormat : mSwapChainImageFormat;
+
+	VkAttachmentDescription colorAttachment = {};
+	colorAttachment.format                  = colorFormat;
+	colorAttachment.samples                 = mMsaaSamples;
+
+	// The multisampled image only lives inside the pass, on tilers it never leaves tile memory.
+	colorAttachment.loadOp  = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachment.storeOp = msaa ? VK_ATTACHMENT_STORE_OP_DONT_CARE
+								   : VK_ATTACHMENT_STORE_OP_STORE;
+
+	colorAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+	// Layout transitions and their synchronization are done by the render graph.
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorAttachment.finalLayout   = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	// The swap chain or HDR image, fully written by the resolve at the end of the subpass.
+	VkAttachmentDescription resolveAttachment = {};
+	resolveAttachment.format                  = colorFormat;
+	resolveAttachment.samples                 = VK_SAMPLE_COUNT_1_BIT;
+
+	resolveAttachment.loadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	resolveAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+
+	resolveAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	resolveAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+	resolveAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	resolveAttachment.finalLayout   = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	// Filled by the prepass and only tested here, otherwise cleared and dropped like MSAA color.
+	VkAttachmentDescription depthAttachment = {};
+	depthAttachment.format                  = mDepthFormat;
+	depthAttachment.samples                 = mMsaaSamples;
+
+	depthAttachment.loadOp  = mDepthPrepass ? VK_ATTACHMENT_LOAD_OP_LOAD
+											: VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+	depthAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthAttachment.finalLayout   = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	const VkAttachmentDescription attachments[] = {
+			colorAttachment, depthAttachment, resolveAttachment
+	};
+
+
+	VkAttachmentReference colorAttachmentRef = {};
+	colorAttachmentRef.attachment            = 0;
+	colorAttachmentRef.layout                = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference depthAttachmentRef = {};
+	depthAttachmentRef.attachment            = 1;
+	depthAttachmentRef.layout                = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference resolveAttachmentRef = {};
+	resolveAttachmentRef.attachment            = 2;
+	resolveAttachmentRef.layout                = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+
+	VkSubpassDescription subpass    = {};
+	subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount    = 1;
+	subpass.pColorAttachments       = &colorAttachmentRef;
+	subpass.pResolveAttachments     = msaa ? &resolveAttachmentRef : nullptr;
+	subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+
+	VkRenderPassCreateInfo renderPassInfo = {};
+	renderPassInfo.sType                  = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount        = msaa ? 3 : 2;
+	renderPassInfo.pAttachments           = attachments;
+	renderPassInfo.subpassCount           = 1;
+	renderPassInfo.pSubpasses             = &subpass;
+	renderPassInfo.dependencyCount        = 0;
+	renderPassInfo.pDependencies          = nullptr;
+
+	if (vkCreateRenderPass(mDevice, &renderPassInfo, mAllocator, &mRenderPass) != VK_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+bool Application::CreateDepthPrepassRenderPass(VkAttachmentLoadOp loadOp, VkRenderPass &renderPass)
+{
+	VkAttachmentDescription depthAttachment = {};
+	depthAttachment.format                  = mDepthFormat;
+	depthAttachment.samples                 = mMsaaSamples;
+
+	// Kept for the main pass.
+	depthAttachment.loadOp  = loadOp;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+
+	depthAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthAttachment.finalLayout   = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+
+	VkAttachmentReference depthAttachmentRef = {};
+	depthAttachmentRef.attachment            = 0;
+	depthAttachmentRef.layout                = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+
+	VkSubpassDescription subpass    = {};
+	subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+
+	VkRenderPassCreateInfo renderPassInfo = {};
+	renderPassInfo.sType                  = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount        = 1;
+	renderPassInfo.pAttachments           = &depthAttachment;
+	renderPassInfo.subpassCount           = 1;
+	renderPassInfo.pSubpasses             = &subpass;
+
+	if (vkCreateRenderPass(mDevice, &renderPassInfo, mAllocator, &renderPass) != VK_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+bool Application::CreateFramebuffers()
+{
+	mSwapChainFramebuffers.resize(mSwapChainImageViews.size());
+
+	for (size_t i = 0; i < mSwapChainImageViews.size(); ++i)
+	{
+		// Post-processing reads the HDR image, every framebuffer renders into it then.
+		const VkImageView colorView = mHdrTarget != kInvalidRGHandle
+											? mRenderGraph.GetImageView(mHdrTarget)
+											: mSwapChainImageViews[i];
+
+		// With MSAA the color image is the resolve attachment.
+		const bool  msaa          = mMsaaTarget != kInvalidRGHandle;
+		VkImageView attachments[] = {
+				colorView, mRenderGraph.GetImageView(mDepthTarget), VK_NULL_HANDLE
+		};
+		if (msaa)
+		{
+			attachments[0] = mRenderGraph.GetImageView(mMsaaTarget);
+			attachments[2] = colorView;
+		}
+
+		VkFramebufferCreateInfo framebufferInfo = {};
+		framebufferInfo.sType                   = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass              = mRenderPass;
+		framebufferInfo.attachmentCount         = msaa ? 3 : 2;
+		framebufferInfo.pAttachments            = attachments;
+		framebufferInfo.width                   = mSwapChainExtent.width;
+		framebufferInfo.height                  = mSwapChainExtent.height;
+		framebufferInfo.layers                  = 1;
+
+		if (vkCreateFramebuffer(mDevice, &framebufferInfo, mAllocator, &mSwapChainFramebuffers[i])
+			!= VK_SUCCESS)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (mDepthPrepass)
+	{
+		VkImageView depthView = mRenderGraph.GetImageView(mDepthTarget);
+
+		VkFramebufferCreateInfo framebufferInfo = {};
+		framebufferInfo.sType                   = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass              = mDepthPrepassRenderPass;
+		framebufferInfo.attachmentCount         = 1;
+		framebufferInfo.pAttachments            = &depthView;
+		framebufferInfo.width                   = mSwapChainExtent.width;
+		framebufferInfo.height                  = mSwapChainExtent.height;
+		framebufferInfo.layers                  = 1;
+
+		if (vkCreateFramebuffer(mDevice, &framebufferInfo, mAllocator, &mDepthPrepassFramebuffer)
+			!= VK_SUCCESS)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void Application::DestroyFramebuffers()
+{
+	for (VkFramebuffer framebuffer : mSwapChainFramebuffers)
+	{
+		vkDestroyFramebuffer(mDevice, framebuffer, mAllocator);
+	}
+
+	vkDestroyFramebuffer(mDevice, mDepthPrepassFramebuffer, mAllocator);
+	mDepthPrepassFramebuffer = VK_NULL_HANDLE;
+}
+
+bool Application::CreateCommandPool()
+{
+	QueueFamilyIndices queueFamilyIndices = FindQueueFamilies(mPhysicalDevice, mSurface);
+
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags                   = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex        = queueFamilyIndices.graphicsFamily.value();
+
+	if (vkCreateCommandPool(mDevice, &poolInfo, mAllocator, &mCommandPool) != VK_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+bool Application::CreateCommandBuffers()
+{
+	mCommandBuffers.resize(kMaxFramesInFlight);
+
+	VkCommandBufferAllocateInfo allocInfo = {};
+
+	allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool        = mCommandPool;
+	allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = (u32)mCommandBuffers.size();
+
+	if (vkAllocateCommandBuffers(mDevice, &allocInfo, mCommandBuffers.data()) != VK_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+bool Application::CreateInstanceBuffers()
+{
+	mInstanceBuffers.resize(kMaxFramesInFlight, VK_NULL_HANDLE);
+	mInstanceBuffersMemory.resize(kMaxFramesInFlight, VK_NULL_HANDLE);
+	mInstanceBuffersMapped.resize(kMaxFramesInFlight, nullptr);
+
+	// Written by the CPU every frame and read once by the GPU, so they stay host visible and
+	// persistently mapped instead of going through a staging copy. Meshlet culling reads them as
+	// storage buffers.
+	const VkDeviceSize bufferSize = sizeof(InstanceData) * kMaxInstances;
+
+	for (u32 i = 0; i < kMaxFramesInFlight; ++i)
+	{
+		if (CreateBuffer(
+					mDevice,
+					mPhysicalDevice,
+					bufferSize,
+					VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+					mInstanceBuffers[i],
+					mInstanceBuffersMemory[i]
+			)
+			== EXIT_FAILURE)
+		{
+			return EXIT_FAILURE;
+		}
+
+		void *mapped = nullptr;
+		if (vkMapMemory(mDevice, mInstanceBuffersMemory[i], 0, bufferSize, 0, &mapped) != VK_SUCCESS)
+		{
+			CLOG_ERR("Failed to map instance buffer.");
+			return EXIT_FAILURE;
+		}
+		mInstanceBuffersMapped[i] = static_cast<InstanceData *>(mapped);
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void Application::DestroyInstanceBuffers()
+{
+	for (u32 i = 0; i < mInstanceBuffers.size(); ++i)
+	{
+		vkDestroyBuffer(mDevice, mInstanceBuffers[i], mAllocator);
+		vkFreeMemory(mDevice, mInstanceBuffersMemory[i], mAllocator);
+	}
+
+	mInstanceBuffers.clear();
+	mInstanceBuffersMemory.clear();
+	mInstanceBuffersMapped.clear();
+}
+
+void Application::CreateScene()
+{
+	if (mSceneOverdraw)
+	{
+		CreateOverdrawScene();
+		return;
+	}
+
+	// Square grid covering the screen, one small mesh per cell.
+	const u32 side     = std::max((u32)std::ceil(std::sqrt((f64)mSceneInstanceCount)), 1u);
+	const f32 cellSize = 2.0f / (f32)side;
+	const f32 scale    = mSceneInstanceCount == 1 ? 1.0f : cellSize * 0.8f;
+
+	for (u32 i = 0; i < mSceneInstanceCount; ++i)
+	{
+		const u32 x = i % side;
+		const u32 y = i / side;
+
+		InstanceTransform transform = {};
+		InstanceColor     color     = {};
+
+		if (mSceneInstanceCount > 1)
+		{
+			transform.position = glm::vec3(
+					-1.0f + cellSize * ((f32)x + 0.5f), -1.0f + cellSize * ((f32)y + 0.5f), 0.0f
+			);
+			color.color = glm::vec4((f32)x / (f32)side, (f32)y / (f32)side, 1.0f, 1.0f);
+		}
+		transform.scale = scale;
+
+		// Meshes reach kMeshDepthScale times their radius in front of their center.
+		transform.position.z = 0.1f;
+
+		// Kick every body in a different direction so they swing around their grid cell, until the
+		// damping of the simulation brings them to rest.
+		const f32       angle    = (f32)i * 2.39996f;
+		const glm::vec3 velocity = glm::vec3(std::cos(angle), std::sin(angle), 0.0f) * scale * 0.3f;
+
+		SimulatedBody body = {};
+		body.index         = mSimulation.AddBody(transform.position, velocity);
+
+		mWorld.CreateEntity(transform, color, body);
+	}
+
+	// Lights drift over the grid just above it, each pulled back to its own spot by the simulation.
+	for (u32 i = 0; i < mSceneLightCount; ++i)
+	{
+		const f32 u = std::fmod((f32)i * 0.618034f, 1.0f);
+		const f32 v = std::fmod((f32)i * 0.754878f + 0.5f, 1.0f);
+		const f32 w = std::fmod((f32)i * 0.569840f, 1.0f);
+
+		InstanceTransform transform = {};
+		transform.position          = glm::vec3(u * 2.0f - 1.0f, v * 2.0f - 1.0f, w * 0.1f);
+
+		PointLight light = {};
+		light.color      = glm::vec3(0.5f + 0.5f * u, 0.5f + 0.5f * v, 0.5f + 0.5f * (1.0f - u));
+		light.radius     = 0.1f + 0.2f * w;
+
+		const f32       angle    = (f32)i * 2.39996f;
+		const glm::vec3 velocity = glm::vec3(std::cos(angle), std::sin(angle), 0.0f) * 0.2f;
+
+		SimulatedBody body = {};
+		body.index         = mSimulation.AddBody(transform.position, velocity);
+
+		mWorld.CreateEntity(transform, light, body);
+	}
+
+	// Static backdrop behind the grid for the shadows to fall on. Without a SimulatedBody these
+	// are drawn once into the shadow cache instead of every frame.
+	if (mSceneLightCount > 0)
+	{
+		constexpr u32 kBackdropSide = 8;
+		constexpr f32 kBackdropCell = 2.0f / (f32)kBackdropSide;
+
+		for (u32 i = 0; i < kBackdropSide * kBackdropSide; ++i)
+		{
+			const u32 x = i % kBackdropSide;
+			const u32 y = i / kBackdropSide;
+
+			InstanceTransform transform = {};
+			transform.position.x        = -1.0f + kBackdropCell * ((f32)x + 0.5f);
+			transform.position.y        = -1.0f + kBackdropCell * ((f32)y + 0.5f);
+			transform.position.z        = 0.9f;
+			transform.scale             = kBackdropCell * 1.5f;
+
+			InstanceColor color = {};
+			color.color         = glm::vec4(glm::vec3((x + y) % 2 == 0 ? 0.6f : 0.5f), 1.0f);
+
+			mWorld.CreateEntity(transform, color);
+		}
+	}
+
+	CLOG_INFO("Scene created with ", mWorld.GetEntityCount(), " entities.");
+}
+
+void Application::CreateOverdrawScene()
+{
+	// Large enough for the smallest lump of the mesh to reach past the screen corners.
+	constexpr f32 kLayerScale = 5.0f;
+
+	/* Creation order is draw order, the first layer is the farthest. Without a SimulatedBody the
+	 * layers never move, and the same LOD keeps them in that order within its draw. */
+	for (u32 i = 0; i < mSceneInstanceCount; ++i)
+	{
+		const f32 layer = (f32)i / (f32)mSceneInstanceCount;
+
+		InstanceTransform transform = {};
+		transform.position.z        = 0.95f - 0.55f * layer;
+		transform.scale             = kLayerScale;
+
+		InstanceColor color = {};
+		color.color         = glm::vec4(layer, 1.0f - layer, 0.5f, 1.0f);
+
+		mWorld.CreateEntity(transform, color);
+	}
+
+	CLOG_INFO("Overdraw scene created with ", mWorld.GetEntityCount(), " layers.");
+}
+
+bool Application::CreateRenderGraph()
+{
+	RGImageDesc swapChainDesc = {};
+	swapChainDesc.format      = mSwapChainImageFormat;
+	swapChainDesc.extent      = mSwapChainExtent;
+	swapChainDesc.usage       = mPostProcessing ? VK_IMAGE_USAGE_STORAGE_BIT
+												: VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+	// Contents are cleared or fully overwritten, so the previous layout does not matter. The
+	// stage matches the image available semaphore wait in DrawFrame.
+	mSwapChainTarget = mRenderGraph.ImportImage(
+			"SwapChain",
+			swapChainDesc,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR,
+			mHeadless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+	);
+	mRenderGraph.MarkOutput(mSwapChainTarget);
+
+	// Without a prepass depth never leaves the main pass and can stay lazily allocated too.
+	RGImageDesc depthDesc = {};
+	depthDesc.format      = mDepthFormat;
+	depthDesc.extent      = mSwapChainExtent;
+	depthDesc.usage       = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	depthDesc.aspect      = GetDepthFormatAspect(mDepthFormat);
+	depthDesc.samples     = mMsaaSamples;
+	if (!mDepthPrepass)
+	{
+		depthDesc.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+	}
+	if (mOcclusionCulling)
+	{
+		depthDesc.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+	}
+	mDepthTarget = mRenderGraph.CreateImage("Depth", depthDesc);
+
+	if (mSceneLightCount > 0)
+	{
+		// Only writes buffers, which the graph does not track.
+		mRenderGraph
+				.AddPass(
+						"LightBinning",
+						[this](VkCommandBuffer commandBuffer) { RecordLightBinning(commandBuffer); }
+				)
+				.SetSideEffects();
+	}
+
+	if (mUseMeshlets)
+	{
+		// Only writes buffers too, the prepass and main pass draw what it kept.
+		mRenderGraph
+				.AddPass(
+						"MeshletCull",
+						[this](VkCommandBuffer commandBuffer) { RecordMeshletCull(commandBuffer); }
+				)
+				.SetSideEffects();
+	}
+
+	mShadowAtlas = kInvalidRGHandle;
+	if (mSceneLightCount > 0)
+	{
+		// Rebuilt every frame from the cache copy, the previous contents never matter.
+		mShadowAtlas = mRenderGraph.ImportImage(
+				"ShadowAtlas",
+				mShadowCascades.GetAtlasDesc(),
+				VK_IMAGE_LAYOUT_UNDEFINED,
+				VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		);
+		mRenderGraph.SetImportedImage(
+				mShadowAtlas, mShadowCascades.GetAtlasImage(), mShadowCascades.GetAtlasView()
+		);
+
+		mRenderGraph
+				.AddPass(
+						"ShadowCache",
+						[this](VkCommandBuffer commandBuffer) { RecordShadowCache(commandBuffer); }
+				)
+				.Write(mShadowAtlas, RGAccess::eTransferDst);
+
+		mRenderGraph
+				.AddPass(
+						"ShadowDynamic",
+						[this](VkCommandBuffer commandBuffer)
+						{ RecordShadowDynamic(commandBuffer); }
+				)
+				.Write(mShadowAtlas, RGAccess::eDepthAttachmentWrite);
+	}
+
+	if (mDepthPrepass)
+	{
+		// With occlusion culling only what the previous frame's depth left visible.
+		const MeshletCulling::ClusterDraws draws = mOcclusionCulling
+														 ? MeshletCulling::ClusterDraws::eEarly
+														 : MeshletCulling::ClusterDraws::eAll;
+		mRenderGraph
+				.AddPass(
+						"DepthPrepass",
+						[this, draws](VkCommandBuffer commandBuffer)
+						{ RecordDepthPrepass(commandBuffer, draws); }
+				)
+				.Write(mDepthTarget, RGAccess::eDepthAttachmentWrite);
+	}
+
+	if (mOcclusionCulling)
+	{
+		// The pyramid of the early depth decides which of the hidden clusters reappeared.
+		mRenderGraph
+				.AddPass(
+						"HiZBuild",
+						[this](VkCommandBuffer commandBuffer) { RecordHiZBuild(commandBuffer); }
+				)
+				.Read(mDepthTarget, RGAccess::eComputeSampled)
+				.SetSideEffects();
+
+		mRenderGraph
+				.AddPass(
+						"MeshletCullLate",
+						[this](VkCommandBuffer commandBuffer)
+						{ RecordMeshletCullLate(commandBuffer); }
+				)
+				.SetSideEffects();
+
+		mRenderGraph
+				.AddPass(
+						"DepthPrepassLate",
+						[this](VkCommandBuffer commandBuffer)
+						{ RecordDepthPrepass(commandBuffer, MeshletCulling::ClusterDraws::eLate); }
+				)
+				.Write(mDepthTarget, RGAccess::eDepthAttachmentWrite);
+	}
+
+	RenderGraph::PassBuilder mainPass = mRenderGraph.AddPass(
+			"Main", [this](VkCommandBuffer commandBuffer) { RecordMainPass(commandBuffer); }
+	);
+
+	if (mShadowAtlas != kInvalidRGHandle)
+	{
+		mainPass.Read(mShadowAtlas, RGAccess::eFragmentSampled);
+	}
+
+	if (mDepthPrepass)
+	{
+		mainPass.Read(mDepthTarget, RGAccess::eDepthAttachmentRead);
+	}
+	else
+	{
+		mainPass.Write(mDepthTarget, RGAccess::eDepthAttachmentWrite);
+	}
+
+	// The scene color post-processing reads, rendered or resolved into instead of the swap chain.
+	mHdrTarget           = kInvalidRGHandle;
+	RGHandle colorTarget = mSwapChainTarget;
+	if (mPostProcessing)
+	{
+		RGImageDesc hdrDesc = {};
+		hdrDesc.format      = PostProcess::kHdrFormat;
+		hdrDesc.extent      = mSwapChainExtent;
+		hdrDesc.usage       = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+		mHdrTarget  = mRenderGraph.CreateImage("HdrColor", hdrDesc);
+		colorTarget = mHdrTarget;
+	}
+
+	mMsaaTarget = kInvalidRGHandle;
+	if (mMsaaSamples != VK_SAMPLE_COUNT_1_BIT)
+	{
+		// Cleared, drawn and resolved within the pass, so it can stay lazily allocated.
+		RGImageDesc msaaDesc = {};
+		msaaDesc.format      = mPostProcessing ? PostProcess::kHdrFormat : mSwapChainImageFormat;
+		msaaDesc.extent      = mSwapChainExtent;
+		msaaDesc.usage       = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+						 | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		msaaDesc.samples     = mMsaaSamples;
+
+		mMsaaTarget = mRenderGraph.CreateImage("MsaaColor", msaaDesc);
+		mainPass.Write(mMsaaTarget, RGAccess::eColorAttachmentWrite)
+				.Write(colorTarget, RGAccess::eResolveWrite);
+	}
+	else
+	{
+		mainPass.Write(colorTarget, RGAccess::eColorAttachmentWrite);
+	}
+
+	if (mPostProcessing)
+	{
+		// Every effect in one dispatch, the HDR image is read once and the swap chain written once.
+		mRenderGraph
+				.AddPass(
+						"PostProcess",
+						[this](VkCommandBuffer commandBuffer) { RecordPostProcess(commandBuffer); }
+				)
+				.Read(mHdrTarget, RGAccess::eComputeSampled)
+				.Write(mSwapChainTarget, RGAccess::eComputeStorageWrite);
+	}
+
+	if (mRenderGraph.Compile() == EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	// Compiling allocated the HDR image, the swap chain views are already created.
+	if (mPostProcessing)
+	{
+		const VkImageView hdrView = mRenderGraph.GetImageView(mHdrTarget);
+		if (mPostProcess.Resize(hdrView, mSwapChainImageViews, mSwapChainExtent) == EXIT_FAILURE)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Compiling allocated the depth image the pyramids are built from.
+	if (mOcclusionCulling
+		&& mHiZPyramid.Resize(mRenderGraph.GetImage(mDepthTarget), mDepthFormat, mSwapChainExtent)
+				   == EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	mRenderGraph.LogStats();
+	return EXIT_SUCCESS;
+}
+
+void Application::RecordMainPass(VkCommandBuffer commandBuffer)
+{
+	VkRenderPassBeginInfo renderPassInfo = {};
+
+	renderPassInfo.sType       = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass  = mRenderPass;
+	renderPassInfo.framebuffer = mSwapChainFramebuffers[mCurrentImageIndex];
+
+	renderPassInfo.renderArea.offset = {0, 0};
+	renderPassInfo.renderArea.extent = mSwapChainExtent;
+
+	VkClearValue clearValues[2]    = {};
+	clearValues[0].color           = {{0.0f, 0.0f, 0.0f, 1.0f}};
+	clearValues[1].depthStencil    = {1.0f, 0};
+	renderPassInfo.clearValueCount = (u32)std::size(clearValues);
+	renderPassInfo.pClearValues    = clearValues;
+
+	VulkanDispatch::vkCmdBeginRenderPass(
+			commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE
+	);
+
+	VulkanDispatch::vkCmdBindPipeline(
+			commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mGraphicsPipeline
+	);
+
+	if (mSceneLightCount > 0)
+	{
+		mClusteredLighting.BindForShading(commandBuffer, mCurrentFrame);
+		mShadowCascades.BindForShading(commandBuffer, mCurrentFrame);
+	}
+
+	RecordSceneDraw(commandBuffer, MeshletCulling::ClusterDraws::eAll, true);
+
+	VulkanDispatch::vkCmdEndRenderPass(commandBuffer);
+}
+
+void Application::RecordPostProcess(VkCommandBuffer commandBuffer)
+{
+	mPostProcess.Record(commandBuffer, mCurrentImageIndex);
+}
+
+void Application::RecordLightBinning(VkCommandBuffer commandBuffer)
+{
+	mClusteredLighting.RecordBinning(commandBuffer, mCurrentFrame, mLightCount, mSwapChainExtent);
+}
+
+void Application::RecordMeshletCull(VkCommandBuffer commandBuffer)
+{
+	// Without a pyramid from the previous frame everything in view is drawn early.
+	MeshletCulling::CullPhase phase = MeshletCulling::CullPhase::eNoOcclusion;
+	if (mOcclusionCulling)
+	{
+		mHiZPyramid.BindForCulling(commandBuffer, mCurrentFrame);
+		if (mHiZPyramid.HasHistory(mCurrentFrame))
+		{
+			phase = MeshletCulling::CullPhase::eEarly;
+		}
+	}
+
+	mMeshletCulling.RecordCull(
+			commandBuffer,
+			mCurrentFrame,
+			mInstanceBatches.draws,
+			mInstanceBatches.drawCount,
+			phase,
+			mSwapChainExtent
+	);
+}
+
+void Application::RecordHiZBuild(VkCommandBuffer commandBuffer)
+{
+	mHiZPyramid.RecordBuild(commandBuffer, mCurrentFrame);
+}
+
+void Application::RecordMeshletCullLate(VkCommandBuffer commandBuffer)
+{
+	if (!mHiZPyramid.HasHistory(mCurrentFrame))
+	{
+		return;
+	}
+
+	// The pyramid build bound another layout in between.
+	mHiZPyramid.BindForCulling(commandBuffer, mCurrentFrame);
+	mMeshletCulling.RecordCull(
+			commandBuffer,
+			mCurrentFrame,
+			mInstanceBatches.draws,
+			mInstanceBatches.drawCount,
+			MeshletCulling::CullPhase::eLate,
+			mSwapChainExtent
+	);
+}
+
+void Application::RecordShadowCache(VkCommandBuffer commandBuffer)
+{
+	mShadowCascades.RecordCache(
+			commandBuffer,
+			mSceneMesh,
+			mInstanceBuffers[mCurrentFrame],
+			mInstanceBatches.draws,
+			mInstanceBatches.staticDrawCount
+	);
+}
+
+void Application::RecordShadowDynamic(VkCommandBuffer commandBuffer)
+{
+	mShadowCascades.RecordDynamic(
+			commandBuffer,
+			mSceneMesh,
+			mInstanceBuffers[mCurrentFrame],
+			mInstanceBatches.draws + mInstanceBatches.staticDrawCount,
+			mInstanceBatches.drawCount - mInstanceBatches.staticDrawCount
+	);
+}
+
+void Application::RecordDepthPrepass(
+		VkCommandBuffer              commandBuffer,
+		MeshletCulling::ClusterDraws draws
+)
+{
+	// The late clusters add to the depth of the early ones.
+	const bool late = draws == MeshletCulling::ClusterDraws::eLate;
+
+	VkRenderPassBeginInfo renderPassInfo = {};
+
+	renderPassInfo.sType       = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass  = late ? mDepthPrepassLoadRenderPass : mDepthPrepassRenderPass;
+	renderPassInfo.framebuffer = mDepthPrepassFramebuffer;
+
+	renderPassInfo.renderArea.offset = {0, 0};
+	renderPassInfo.renderArea.extent = mSwapChainExtent;
+
+	VkClearValue clearDepth        = {};
+	clearDepth.depthStencil        = {1.0f, 0};
+	renderPassInfo.clearValueCount = late ? 0 : 1;
+	renderPassInfo.pClearValues    = &clearDepth;
+
+	VulkanDispatch::vkCmdBeginRenderPass(
+			commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE
+	);
+
+	VulkanDispatch::vkCmdBindPipeline(
+			commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mDepthPrepassPipeline
+	);
+
+	RecordSceneDraw(commandBuffer, draws, false);
+
+	VulkanDispatch::vkCmdEndRenderPass(commandBuffer);
+}
+
+void Application::RecordSceneDraw(
+		VkCommandBuffer              commandBuffer,
+		MeshletCulling::ClusterDraws draws,
+		bool                         mainPass
+)
+{
+	VkViewport viewport = {};
+	viewport.x          = 0.0f;
+	viewport.y          = 0.0f;
+	viewport.width      = static_cast<float>(mSwapChainExtent.width);
+	viewport.height     = static_cast<float>(mSwapChainExtent.height);
+	viewport.minDepth   = 0.0f;
+	viewport.maxDepth   = 1.0f;
+	VulkanDispatch::vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+	VkRect2D scissor = {};
+	scissor.offset   = {0, 0};
+	scissor.extent   = mSwapChainExtent;
+	VulkanDispatch::vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	if (mUseMeshlets)
+	{
+		mMeshletCulling.RecordDraw(commandBuffer, mCurrentFrame, draws);
+		return;
+	}
+
+	mSceneMesh.Bind(commandBuffer, mInstanceBuffers[mCurrentFrame]);
+
+	if (mSceneDrawCount == 1 && mScenePipelineCount == 1)
+	{
+		mSceneMesh.Draw(commandBuffer, mInstanceBatches.draws, mInstanceBatches.drawCount);
+		return;
+	}
+
+	// Every LOD batch cut into draws of instancesPerDraw, the main pass switching pipelines.
+	const u32 instancesPerDraw = std::max(mInstanceCount / mSceneDrawCount, 1u);
+
+	u32 drawIndex = 0;
+	for (u32 i = 0; i < mInstanceBatches.drawCount; ++i)
+	{
+		const MeshDraw &batch = mInstanceBatches.draws[i];
+		for (u32 offset = 0; offset < batch.instanceCount; offset += instancesPerDraw)
+		{
+			const u32 variant = drawIndex % mScenePipelineCount;
+			if (mainPass && mScenePipelineCount > 1)
+			{
+				VulkanDispatch::vkCmdBindPipeline(
+						commandBuffer,
+						VK_PIPELINE_BIND_POINT_GRAPHICS,
+						variant == 0 ? mGraphicsPipeline : mScenePipelines[variant - 1]
+				);
+			}
+
+			MeshDraw draw      = batch;
+			draw.firstInstance = batch.firstInstance + offset;
+			draw.instanceCount = std::min(instancesPerDraw, batch.instanceCount - offset);
+
+			mSceneMesh.Draw(commandBuffer, &draw, 1);
+			++drawIndex;
+		}
+	}
+}
+
+bool Application::RecordCommandBuffer(VkCommandBuffer commandBuffer, u32 imageIndex)
+{
+	VkCommandBufferBeginInfo beginInfo = {};
+
+	beginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags            = 0;
+	beginInfo.pInheritanceInfo = nullptr;
+
+	if (VulkanDispatch::vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to begin recording command buffer.");
+		return EXIT_FAILURE;
+	}
+
+	mCurrentImageIndex = imageIndex;
+	mRenderGraph.SetImportedImage(
+			mSwapChainTarget, mSwapChainImages[imageIndex], mSwapChainImageViews[imageIndex]
+	);
+
+	// The frame's fence was waited, its previous timestamps are ready.
+	mGpuTracer.BeginFrame(commandBuffer, mCurrentFrame);
+	{
+		COV_TRACE_GPU_SCOPE(&mGpuTracer, commandBuffer, "Frame");
+		mRenderGraph.Execute(commandBuffer);
+	}
+
+	if (VulkanDispatch::vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to record command buffer.");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+bool Application::CreateSyncObjects()
+{
+	mImageAvailableSemaphores.resize(kMaxFramesInFlight);
+	mRenderFinishedSemaphores.resize(kMaxFramesInFlight);
+	mInFlightFences.resize(kMaxFramesInFlight);
+
+	VkSemaphoreCreateInfo semaphoreInfo = {};
+	semaphoreInfo.sType                 = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	VkFenceCreateInfo fenceInfo = {};
+	fenceInfo.sType             = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceInfo.flags             = VK_FENCE_CREATE_SIGNALED_BIT;
+
+	for (u32 i = 0; i < kMaxFramesInFlight; ++i)
+	{
+		if (vkCreateSemaphore(mDevice, &semaphoreInfo, mAllocator, &mImageAvailableSemaphores[i])
+			!= VK_SUCCESS)
+		{
+			return EXIT_FAILURE;
+		}
+
+		if (vkCreateSemaphore(mDevice, &semaphoreInfo, mAllocator, &mRenderFinishedSemaphores[i])
+			!= VK_SUCCESS)
+		{
+			return EXIT_FAILURE;
+		}
+
+		if (vkCreateFence(mDevice, &fenceInfo, mAllocator, &mInFlightFences[i]) != VK_SUCCESS)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+bool Application::RecreateSwapChain()
+{
+	i32 width = 0, height = 0;
+	glfwGetFramebufferSize(mWindow, &width, &height);
+	while (width == 0 || height == 0)
+	{
+		glfwGetFramebufferSize(mWindow, &width, &height);
+		glfwWaitEvents();
+	}
+
+	const f64 startTime = glfwGetTime();
+
+	// Only the frames in flight can reference the swap chain images, waiting for their fences is
+	// enough and does not drain unrelated queue work like vkDeviceWaitIdle does.
+	vkWaitForFences(mDevice, (u32)mInFlightFences.size(), mInFlightFences.data(), VK_TRUE, UINT64_MAX);
+
+	DestroyFramebuffers();
+
+	for (auto *imageView : mSwapChainImageViews)
+	{
+		vkDestroyImageView(mDevice, imageView, mAllocator);
+	}
+
+	mHiZPyramid.ReleaseDepth();
+	mRenderGraph.Reset();
+
+	VkSwapchainKHR oldSwapChain = mSwapChain;
+	const bool     created      = CreateSwapChain(oldSwapChain) == EXIT_SUCCESS;
+
+	/* The fences only cover the submissions, presents of the old swap chain can still be queued
+	 * and waiting on their semaphores. It stays alive until the first frame submitted after it
+	 * has finished, see DestroyRetiredSwapChains. */
+	mRetiredSwapChains.push_back({oldSwapChain, mSubmittedFrames + kMaxFramesInFlight});
+
+	if (!created)
+	{
+		return EXIT_FAILURE;
+	}
+
+	if (CreateImageViews() != EXIT_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	if (CreateRenderGraph() != EXIT_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	if (CreateFramebuffers() != EXIT_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	// The LODs of static casters depend on the extent, the cached shadows have to follow.
+	if (mSceneLightCount > 0)
+	{
+		mShadowCascades.InvalidateStatic();
+	}
+
+	const f64 endTime      = glfwGetTime();
+	const f64 recreateTime = endTime - startTime;
+
+	mResizeStats.recreateTimeTotal += recreateTime;
+	mResizeStats.recreateTimeMax    = std::max(mResizeStats.recreateTimeMax, recreateTime);
+
+	if (mFramebufferResized)
+	{
+		const f64 latency = endTime - mFirstPendingResizeTime;
+
+		mResizeStats.latencyTotal += latency;
+		mResizeStats.latencyMax    = std::max(mResizeStats.latencyMax, latency);
+	}
+
+	++mResizeStats.recreations;
+
+	mFramebufferResized = false;
+	mLastRecreateTime   = endTime;
+
+	return EXIT_SUCCESS;
+}
+
+bool Application::ResizeHeadless(VkExtent2D extent)
+{
+	COV_ASSERT(mHeadless, "Only headless targets can be resized directly.");
+
+	// Everything RecreateSwapChain rebuilds, minus the swap chain and the window.
+	vkWaitForFences(
+			mDevice, (u32)mInFlightFences.size(), mInFlightFences.data(), VK_TRUE, UINT64_MAX
+	);
+
+	DestroyFramebuffers();
+
+	for (auto *imageView : mSwapChainImageViews)
+	{
+		vkDestroyImageView(mDevice, imageView, mAllocator);
+	}
+
+	mHiZPyramid.ReleaseDepth();
+	mRenderGraph.Reset();
+	DestroyHeadlessImages();
+
+	mHeadlessExtent = extent;
+	if (CreateHeadlessImages() != EXIT_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	if (CreateImageViews() != EXIT_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	if (CreateRenderGraph() != EXIT_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	if (CreateFramebuffers() != EXIT_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	if (mSceneLightCount > 0)
+	{
+		mShadowCascades.InvalidateStatic();
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void Application::MarkSwapChainOutdated()
+{
+	if (!mFramebufferResized)
+	{
+		mFramebufferResized     = true;
+		mFirstPendingResizeTime = glfwGetTime();
+		mLastResizeEventTime    = mFirstPendingResizeTime;
+	}
+}
+
+bool Application::ShouldRecreateSwapChain(f64 now) const
+{
+	if (!mFramebufferResized)
+	{
+		return false;
+	}
+
+	// The resize storm is over, serve the final extent right away.
+	if (now - mLastResizeEventTime >= mResizePolicy.settleDelay)
+	{
+		return true;
+	}
+
+	// Still resizing: keep presenting the old (scaled) swap chain, but do not fall too far
+	// behind the window either.
+	return now - mLastRecreateTime >= mResizePolicy.minRecreateInterval;
+}
+
+bool Application::DestroyRetiredSwapChains()
+{
+	// Retired in submission order, the oldest ones are due first.
+	u32 destroyed = 0;
+	while (destroyed < mRetiredSwapChains.size()
+		   && mRetiredSwapChains[destroyed].destroyFrame <= mSubmittedFrames)
+	{
+		vkDestroySwapchainKHR(mDevice, mRetiredSwapChains[destroyed].swapChain, mAllocator);
+		++destroyed;
+	}
+
+	mRetiredSwapChains.erase(mRetiredSwapChains.begin(), mRetiredSwapChains.begin() + destroyed);
+
+	return destroyed > 0;
+}
+
+void Application::LogResizeStats() const
+{
+	const ResizeStats &stats       = mResizeStats;
+	const f64          recreations = std::max<f64>(stats.recreations, 1.0);
+
+	CLOG_INFO(
+			"Resize stats: ",
+			stats.resizeEvents,
+			" resize events, ",
+			stats.recreations,
+			" swap chain recreations, recreate time avg ",
+			stats.recreateTimeTotal / recreations * 1000.0,
+			" ms / max ",
+			stats.recreateTimeMax * 1000.0,
+			" ms, latency avg ",
+			stats.latencyTotal / recreations * 1000.0,
+			" ms / max ",
+			stats.latencyMax * 1000.0,
+			" ms."
+	);
+}
+
+void Application::CleanupSwapchain()
+{
+	DestroyFramebuffers();
+
+	// After the framebuffers and the pyramid's depth view, they reference the graph's images.
+	mHiZPyramid.ReleaseDepth();
+	mRenderGraph.Reset();
+
+	for (auto *imageView : mSwapChainImageViews)
+	{
+		vkDestroyImageView(mDevice, imageView, mAllocator);
+	}
+
+	if (mHeadless)
+	{
+		DestroyHeadlessImages();
+		return;
+	}
+
+	// The device is idle, whatever was presented from the retired swap chains is done.
+	for (const RetiredSwapChain &retired : mRetiredSwapChains)
+	{
+		vkDestroySwapchainKHR(mDevice, retired.swapChain, mAllocator);
+	}
+	mRetiredSwapChains.clear();
+
+	vkDestroySwapchainKHR(mDevice, mSwapChain, mAllocator);
+}
+
+bool Application::WaitForFrame()
+{
+	const u64 waitStart = Trace::Now();
+	{
+		COV_TRACE_SCOPE("WaitForFence");
+		VulkanDispatch::vkWaitForFences(
+				mDevice, 1, &mInFlightFences[mCurrentFrame], VK_TRUE, UINT64_MAX
+		);
+	}
+	mFrameTimings.waitMs = MillisecondsSince(waitStart);
+
+	// The fence just waited for proves the frame kMaxFramesInFlight frames ago has finished.
+	return DestroyRetiredSwapChains();
+}
+
+bool Application::SubmitFrame(
+		u32         imageIndex,
+		VkSemaphore waitSemaphore,
+		VkSemaphore signalSemaphore
+)
+{
+	VulkanDispatch::vkResetFences(mDevice, 1, &mInFlightFences[mCurrentFrame]);
+
+	// Never blocks on the simulation thread, uses the newest snapshot it published. Headless
+	// there is no thread, the frame steps the simulation itself.
+	const u64 simulateStart = Trace::Now();
+	{
+		COV_TRACE_SCOPE("Interpolate");
+		if (mHeadless)
+		{
+			mSimulation.Advance(kHeadlessFrameTime);
+		}
+		mSimulation.Interpolate(mWorld, mJobSystem);
+	}
+	mFrameTimings.simulateMs = MillisecondsSince(simulateStart);
+
+	// The fence wait above guarantees the GPU is done with this frame's instance buffer and
+	// with everything allocated from its frame arena.
+	mFrameArena.BeginFrame(mCurrentFrame);
+
+	const u64 extractStart = Trace::Now();
+	{
+		COV_TRACE_SCOPE("Extract");
+
+		// NDC spans 2 units over the viewport, both axes keep the same scale in the mesh.
+		LodSelection lodSelection  = {};
+		lodSelection.lods          = mSceneMesh.GetLods();
+		lodSelection.lodCount      = mSceneMesh.GetLodCount();
+		lodSelection.pixelsPerUnit = 0.5f
+								   * (f32)std::max(mSwapChainExtent.width, mSwapChainExtent.height);
+		lodSelection.maxPixelError = mLodPixelError;
+
+		mInstanceCount = ExtractInstances(
+				mWorld,
+				mJobSystem,
+				mFrameArena.Get(),
+				mInstanceBuffersMapped[mCurrentFrame],
+				kMaxInstances,
+				lodSelection,
+				&mInstanceBatches
+		);
+
+		if (mSceneLightCount > 0)
+		{
+			mLightCount = ExtractLights(
+					mWorld,
+					mJobSystem,
+					mFrameArena.Get(),
+					mClusteredLighting.GetLights(mCurrentFrame),
+					mClusteredLighting.GetMaxLights()
+			);
+
+			// Shadows cover the whole view box: x and y in NDC, z in depth.
+			mShadowCascades.Update(
+					mCurrentFrame,
+					glm::vec3(-1.0f, -1.0f, 0.0f),
+					glm::vec3(1.0f, 1.0f, 1.0f),
+					mInstanceBatches.staticCount
+			);
+		}
+	}
+	mFrameTimings.extractMs = MillisecondsSince(extractStart);
+
+	const u64 recordStart = Trace::Now();
+	{
+		COV_TRACE_SCOPE("Record");
+		VulkanDispatch::vkResetCommandBuffer(mCommandBuffers[mCurrentFrame], 0);
+		if (RecordCommandBuffer(mCommandBuffers[mCurrentFrame], imageIndex) == EXIT_FAILURE)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+	mFrameTimings.recordMs = MillisecondsSince(recordStart);
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType        = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+	submitInfo.waitSemaphoreCount = waitSemaphore != VK_NULL_HANDLE ? 1 : 0;
+	submitInfo.pWaitSemaphores    = &waitSemaphore;
+	submitInfo.pWaitDstStageMask  = &waitStage;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers    = &mCommandBuffers[mCurrentFrame];
+
+	submitInfo.signalSemaphoreCount = signalSemaphore != VK_NULL_HANDLE ? 1 : 0;
+	submitInfo.pSignalSemaphores    = &signalSemaphore;
+
+	const u64 submitStart = Trace::Now();
+	{
+		COV_TRACE_SCOPE("Submit");
+		if (VulkanDispatch::vkQueueSubmit(
+					mGraphicsQueue, 1, &submitInfo, mInFlightFences[mCurrentFrame]
+			)
+			!= VK_SUCCESS)
+		{
+			CLOG_ERR("Failed to submit draw command buffer.");
+			return EXIT_FAILURE;
+		}
+	}
+	mFrameTimings.submitMs = MillisecondsSince(submitStart);
+	++mSubmittedFrames;
+
+	return EXIT_SUCCESS;
+}
+
+void Application::DrawFrame()
+{
+	COV_TRACE_SCOPE("Frame");
+
+	const u64 allocationsBefore = AllocationTracker::GetTotalCount();
+	const u32 recreationsBefore = mResizeStats.recreations;
+
+	const bool destroyedRetired = WaitForFrame();
+
+	u32      imageIndex = 0;
+	VkResult result     = VK_SUCCESS;
+	{
+		COV_TRACE_SCOPE("Acquire");
+		result = VulkanDispatch::vkAcquireNextImageKHR(
+				mDevice,
+				mSwapChain,
+				UINT64_MAX,
+				mImageAvailableSemaphores[mCurrentFrame],
+				VK_NULL_HANDLE,
+				&imageIndex
+		);
+	}
+
+	if (result == VK_ERROR_OUT_OF_DATE_KHR)
+	{
+		// Nothing can be presented until the swap chain is recreated, but a resize storm still
+		// goes through the resize policy. The frame is skipped while it holds recreation back.
+		MarkSwapChainOutdated();
+		if (ShouldRecreateSwapChain(glfwGetTime()))
+		{
+			RecreateSwapChain();
+		}
+		return;
+	}
+	if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+	{
+		COV_ASSERT(0, "Failed to acquire swap chain image");
+	}
+
+	VkSemaphore renderFinished = mRenderFinishedSemaphores[mCurrentFrame];
+	if (SubmitFrame(imageIndex, mImageAvailableSemaphores[mCurrentFrame], renderFinished)
+		== EXIT_FAILURE)
+	{
+		COV_ASSERT(0, "Failed to submit draw command buffer.");
+	}
+
+	VkPresentInfoKHR presentInfo = {};
+	presentInfo.sType            = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+
+	presentInfo.waitSemaphoreCount = 1;
+	presentInfo.pWaitSemaphores    = &renderFinished;
+
+
+	VkSwapchainKHR swapChains[] = {mSwapChain};
+
+	presentInfo.swapchainCount = 1;
+	presentInfo.pSwapchains    = swapChains;
+	presentInfo.pImageIndices  = &imageIndex;
+
+	presentInfo.pResults = nullptr;
+
+	{
+		COV_TRACE_SCOPE("Present");
+		result = VulkanDispatch::vkQueuePresentKHR(mPresentQueue, &presentInfo);
+	}
+	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || mFramebufferResized)
+	{
+		/* A suboptimal swap chain is still presentable (scaled by the compositor). An out of date
+		 * one is not, but recreating it on every event of a resize storm costs more than the
+		 * frames skipped at acquire. Both are recreated when the resize policy allows it. */
+		MarkSwapChainOutdated();
+
+		if (ShouldRecreateSwapChain(glfwGetTime()))
+		{
+			RecreateSwapChain();
+		}
+	}
+	else if (result != VK_SUCCESS)
+	{
+		COV_ASSERT(0, "Failed to present swap chain image.");
+	}
+
+	mCurrentFrame = (mCurrentFrame + 1) % kMaxFramesInFlight;
+
+	// Recreating the swap chain or destroying a retired one legitimately allocates, such frames
+	// are not steady state.
+	if (mResizeStats.recreations == recreationsBefore && !destroyedRetired)
+	{
+		CheckFrameAllocations(AllocationTracker::GetTotalCount() - allocationsBefore);
+	}
+}
+
+bool Application::DrawHeadlessFrame()
+{
+	COV_TRACE_SCOPE("Frame");
+
+	const u64 allocationsBefore = AllocationTracker::GetTotalCount();
+
+	WaitForFrame();
+
+	// Nothing to acquire or present, every frame in flight renders into its own image.
+	const bool result = SubmitFrame(mCurrentFrame, VK_NULL_HANDLE, VK_NULL_HANDLE);
+
+	mCurrentFrame = (mCurrentFrame + 1) % kMaxFramesInFlight;
+
+	CheckFrameAllocations(AllocationTracker::GetTotalCount() - allocationsBefore);
+
+	return result;
+}
+
+void Application::CheckFrameAllocations(u64 allocations)
+{
+	++mAllocationCheck.frames;
+
+	if (mAllocationCheck.frames < kAllocationWarmupFrames)
+	{
+		return;
+	}
+
+	if (mAllocationCheck.frames == kAllocationWarmupFrames)
+	{
+		// From now on any allocation is unexpected, log where the first ones come from.
+		AllocationTracker::SetReportCallSites(AllocationTracker::IsEnabled());
+		return;
+	}
+
+	if (allocations == 0)
+	{
+		return;
+	}
+
+	++mAllocationCheck.framesWithAllocations;
+	mAllocationCheck.steadyStateAllocations += allocations;
+
+	// Only the first offending frame is logged, the summary at shutdown has the totals.
+	if (mAllocationCheck.framesWithAllocations == 1)
+	{
+		CLOG_WARN(
+				"Frame ",
+				mAllocationCheck.frames,
+				" made ",
+				allocations,
+				" heap allocations after warm-up, DrawFrame should not allocate."
+		);
+	}
+}
+
+bool Application::LogAllocationCheck() const
+{
+	if (!AllocationTracker::IsEnabled())
+	{
+		// Said again at exit, a passing run must not read as a passed check.
+		if (mAllocationCheck.failOnAllocation)
+		{
+			CLOG_WARN("Steady state allocation check skipped, build with COV_TRACK_ALLOCATIONS.");
+		}
+		return EXIT_SUCCESS;
+	}
+
+	// Shutdown allocates and frees plenty, nothing worth reporting.
+	AllocationTracker::SetReportCallSites(false);
+
+	const u64 steadyFrames = mAllocationCheck.frames > kAllocationWarmupFrames
+								   ? mAllocationCheck.frames - kAllocationWarmupFrames
+								   : 0;
+
+	CLOG_INFO(
+			"Allocation check: ",
+			mAllocationCheck.steadyStateAllocations,
+			" allocations in ",
+			mAllocationCheck.framesWithAllocations,
+			" of ",
+			steadyFrames,
+			" steady state frames, ",
+			AllocationTracker::GetTotalCount(),
+			" allocations (",
+			AllocationTracker::GetTotalBytes() / 1024,
+			" KB) in total."
+	);
+
+	if (mAllocationCheck.failOnAllocation && mAllocationCheck.steadyStateAllocations > 0)
+	{
+		CLOG_ERR("DrawFrame allocated in steady state.");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+bool Application::IsWindowRenderable() const
+{
+	if (mWindowIconified || glfwGetWindowAttrib(mWindow, GLFW_VISIBLE) == GLFW_FALSE)
+	{
+		return false;
+	}
+
+	i32 width = 0, height = 0;
+	glfwGetFramebufferSize(mWindow, &width, &height);
+
+	return width != 0 && height != 0;
+}
+
+bool Application::HasPendingWork() const
+{
+	// Moving simulated bodies keep on-demand mode drawing, a settled simulation lets it go idle.
+	return mRenderMode == RenderMode::eContinuous || mAnimating || mRedrawRequested
+		   || mSimulation.NeedsRedraw();
+}
+
+void Application::MainLoop()
+{
+	const f64 loopStart = glfwGetTime();
+
+	while (!glfwWindowShouldClose(mWindow))
+	{
+		// Nothing to draw: sleep until an event arrives instead of spinning on the CPU.
+		// The timeout keeps the loop ticking for anything that is not event driven.
+		if (HasPendingWork() && IsWindowRenderable())
+		{
+			glfwPollEvents();
+		}
+		else if (mFramebufferResized)
+		{
+			// A debounced resize is waiting, wake up in time to serve it.
+			glfwWaitEventsTimeout(mResizePolicy.settleDelay);
+			RequestRedraw();
+		}
+		else
+		{
+			glfwWaitEventsTimeout(kIdleWaitTimeout);
+
+			if (!HasPendingWork())
+			{
+				++mIdleCheck.idleWaits;
+			}
+		}
+
+		if (mIdleCheck.timeout > 0.0)
+		{
+			const f64 elapsed = glfwGetTime() - loopStart;
+			if (mIdleCheck.idleWaits > 0)
+			{
+				CLOG_INFO("Idle check: the main loop went idle after ", elapsed, " s.");
+				break;
+			}
+			if (elapsed > mIdleCheck.timeout)
+			{
+				CLOG_ERR("Idle check: the main loop still drew after ", elapsed, " s.");
+				mIdleCheck.failed = true;
+				break;
+			}
+		}
+
+		// Minimized or hidden windows are never drawn, the frame is kept stale until they are
+		// visible again.
+		if (!IsWindowRenderable() || !HasPendingWork())
+		{
+			continue;
+		}
+
+		if (mShaderReloadRequested)
+		{
+			mShaderReloadRequested = false;
+			ReloadShaders();
+		}
+
+		mRedrawRequested = false;
+		DrawFrame();
+	}
+
+	vkDeviceWaitIdle(mDevice);
+}
+
+void Application::ResizeStressLoop()
+{
+	CLOG_INFO("Running resize stress benchmark for ", mResizeStressFrames, " frames.");
+
+	const f64 startTime = glfwGetTime();
+
+	for (u32 frame = 0; frame < mResizeStressFrames && !glfwWindowShouldClose(mWindow); ++frame)
+	{
+		// Sweep the window size like a user dragging the window edge back and forth.
+		const f64 t      = (f64)frame / 60.0;
+		const i32 width  = (i32)(kWindowWidth * (0.75 + 0.25 * std::sin(t * 2.0)));
+		const i32 height = (i32)(kWindowHeight * (0.75 + 0.25 * std::cos(t * 3.0)));
+		glfwSetWindowSize(mWindow, width, height);
+
+		glfwPollEvents();
+
+		if (IsWindowRenderable())
+		{
+			DrawFrame();
+		}
+	}
+
+	vkDeviceWaitIdle(mDevice);
+
+	const f64 totalTime = glfwGetTime() - startTime;
+	CLOG_INFO(
+			"Resize stress finished in ",
+			totalTime,
+			" s, ",
+			totalTime / (f64)mResizeStressFrames * 1000.0,
+			" ms per frame."
+	);
+	LogResizeStats();
+}
+
+void Application::Cleanup()
+{
+	CLOG_INFO("Cleaning up...");
+
+	mSimulation.Stop();
+	mSimulation.LogStats();
+	mFrameArena.LogStats();
+
+	if (!mTracePath.empty())
+	{
+		// The device is idle since the main loop ended, every timestamp is available.
+		mGpuTracer.CollectAll();
+		Trace::Stop();
+		Trace::WriteChromeJson(mTracePath.c_str());
+	}
+
+	CleanupSwapchain();
+
+	DestroyGraphicsPipelines();
+	mShadowCascades.LogStats();
+	mShadowCascades.Destroy();
+	mMeshletCulling.LogStats();
+	mMeshletCulling.Destroy();
+	mHiZPyramid.LogStats();
+	mHiZPyramid.Destroy();
+	mPostProcess.LogStats();
+	mPostProcess.Destroy();
+	mClusteredLighting.Destroy();
+	mLayoutCache.Destroy();
+	vkDestroyRenderPass(mDevice, mRenderPass, mAllocator);
+	vkDestroyRenderPass(mDevice, mDepthPrepassRenderPass, mAllocator);
+	vkDestroyRenderPass(mDevice, mDepthPrepassLoadRenderPass, mAllocator);
+
+	for (u32 i = 0; i < kMaxFramesInFlight; ++i)
+	{
+		vkDestroySemaphore(mDevice, mImageAvailableSemaphores[i], mAllocator);
+		vkDestroySemaphore(mDevice, mRenderFinishedSemaphores[i], mAllocator);
+		vkDestroyFence(mDevice, mInFlightFences[i], mAllocator);
+	}
+
+	DestroyInstanceBuffers();
+	mSceneMesh.Destroy();
+
+	vkDestroyCommandPool(mDevice, mCommandPool, mAllocator);
+
+	mGpuTracer.Destroy();
+
+	vkDestroyDevice(mDevice, mAllocator);
+
+	if (mValidationPreset != ValidationPreset::eOff)
+	{
+		DestroyDebugUtilsMessengerEXT(mInstance, mDebugMessenger, mAllocator);
+	}
+
+	if (!mHeadless)
+	{
+		vkDestroySurfaceKHR(mInstance, mSurface, mAllocator);
+	}
+
+	vkDestroyInstance(mInstance, mAllocator);
+	mValidationMessenger.LogSummary();
+	VulkanDispatch::Reset();
+
+	HostAllocator::LogReport();
+	HostAllocator::Shutdown();
+	mAllocator = nullptr;
+
+	if (!mHeadless)
+	{
+		glfwDestroyWindow(mWindow);
+
+		glfwTerminate();
+	}
+
+	mJobSystem.Shutdown();
+
+	CLOG_INFO("Clean up successfull");
+}
@@ -0,0 +1,559 @@
+#ifndef HEADER_APPLICATION_H
+#define HEADER_APPLICATION_H
+
+#include "core/arena.h"
+#include "core/job_system.h"
+#include "definitions.h"
+#include "render/clustered_lighting.h"
+#include "render/gpu_trace.h"
+#include "render/hiz_pyramid.h"
+#include "render/mesh.h"
+#include "render/meshlet_culling.h"
+#include "render/pipeline_layout_cache.h"
+#include "render/post_process.h"
+#include "render/render_extract.h"
+#include "render/render_graph.h"
+#include "render/shadow_cascades.h"
+#include "render/validation.h"
+#include "scene/ecs.h"
+#include "scene/simulation.h"
+#include "vulkan/vulkan_core.h"
+
+#include <GLFW/glfw3.h>
+#include <string>
+#include <vector>
+
+
+class Application
+{
+public:
+	static constexpr u32 kWindowWidth  = 1280;
+	static constexpr u32 kWindowHeight = 720;
+
+	// How long MainLoop sleeps in glfwWaitEventsTimeout when there is nothing to draw.
+	static constexpr f64 kIdleWaitTimeout = 0.25;
+
+	// Frames drawn before DrawFrame is expected to stop allocating.
+	static constexpr u32 kAllocationWarmupFrames = 120;
+
+	// MSAA used unless SetMsaaSamples() says otherwise, capped by the device.
+	static constexpr u32 kDefaultMsaaSamples = 4;
+
+	// Capacity of each per-frame instance buffer.
+	static constexpr u32 kMaxInstances = 256 * 1024;
+
+	// Point lights the default scene spawns, 0 shades without lights.
+	static constexpr u32 kDefaultLightCount = 256;
+
+	// Screen-space error in pixels a mesh LOD may show before a finer one is drawn.
+	static constexpr f32 kDefaultLodPixelError = 1.0f;
+
+	// Simulated time every headless frame advances, however long it took to draw.
+	static constexpr f64 kHeadlessFrameTime = 1.0 / 60.0;
+
+	enum class RenderMode
+	{
+		eContinuous,
+		eOnDemand,
+	};
+
+	struct ResizePolicy
+	{
+		// Minimum time between two swap chain recreations while the extent keeps changing.
+		f64 minRecreateInterval = 1.0 / 10.0;
+		// A resize is considered finished once no resize event arrived for this long.
+		f64 settleDelay = 0.05;
+	};
+
+	// Heap allocations made by DrawFrame, counted when built with COV_TRACK_ALLOCATIONS.
+	struct AllocationCheck
+	{
+		bool failOnAllocation = false;// Run() fails if any steady state frame allocated
+
+		u64 frames                 = 0;
+		u64 framesWithAllocations  = 0;
+		u64 steadyStateAllocations = 0;
+	};
+
+	// Whether on-demand mode blocks on events once the scene settles, see SetIdleCheck.
+	struct IdleCheck
+	{
+		f64 timeout = 0.0;// Seconds the main loop may draw before failing, 0 disables
+
+		u64  idleWaits = 0;// glfwWaitEventsTimeout calls with nothing left to draw
+		bool failed    = false;
+	};
+
+	struct ResizeStats
+	{
+		u32 resizeEvents = 0;
+		u32 recreations  = 0;
+
+		// Time spent inside RecreateSwapChain.
+		f64 recreateTimeTotal = 0.0;
+		f64 recreateTimeMax   = 0.0;
+
+		// Time from the first unserved resize event until the swap chain matches it.
+		f64 latencyTotal = 0.0;
+		f64 latencyMax   = 0.0;
+	};
+
+	// CPU time of the phases of the last frame drawn, in milliseconds.
+	struct FrameTimings
+	{
+		f64 waitMs     = 0.0;// Frame fence
+		f64 simulateMs = 0.0;// Headless stepping and interpolation
+		f64 extractMs  = 0.0;
+		f64 recordMs   = 0.0;
+		f64 submitMs   = 0.0;
+	};
+
+public:
+	bool Run();
+
+	// What Run() does before and after its loop, for callers drawing the frames themselves.
+	bool Init();
+
+	// Only after a successful Init().
+	void Shutdown();
+
+	/* Draws into offscreen images of extent instead of a window's swap chain, nothing is
+	 * presented. The simulation runs on the calling thread and advances by kHeadlessFrameTime
+	 * every frame, so every run draws the same frames. Driven through Init(), DrawHeadlessFrame()
+	 * and Shutdown(), Run() needs a window. */
+	void SetHeadless(VkExtent2D extent);
+
+	// Headless only, fails when the frame could not be recorded or submitted.
+	bool DrawHeadlessFrame();
+
+	// Headless only. Recreates the offscreen images like a window resize does the swap chain.
+	bool ResizeHeadless(VkExtent2D extent);
+
+	[[nodiscard]] const FrameTimings &GetFrameTimings() const
+	{
+		return mFrameTimings;
+	}
+
+	[[nodiscard]] const std::string &GetDeviceName() const
+	{
+		return mDeviceName;
+	}
+
+	// Instances extracted by the last frame.
+	[[nodiscard]] u32 GetInstanceCount() const
+	{
+		return mInstanceCount;
+	}
+
+	// The first device whose name contains filter, e.g. "llvmpipe", instead of a discrete GPU.
+	void SetDeviceFilter(const char *filter);
+
+	void SetRenderMode(RenderMode mode);
+
+	// Marks the current frame as stale, on-demand mode draws once more after this.
+	void RequestRedraw();
+
+	// While animating, on-demand mode renders every frame like continuous mode.
+	void SetAnimating(bool animating);
+
+	void SetResizePolicy(const ResizePolicy &policy);
+
+	// Replaces MainLoop with a benchmark that resizes the window every frame.
+	void EnableResizeStress(u32 frameCount);
+
+	// Number of entities the default scene spawns, laid out as a grid.
+	void SetSceneInstanceCount(u32 count);
+
+	// Point lights moving over the scene, binned into clusters for the main pass.
+	void SetSceneLightCount(u32 count);
+
+	/* Splits the instanced draws into about count draws, standing in for a scene of that many
+	 * meshes. 1 draws every LOD batch at once. Ignored with meshlet culling. */
+	void SetSceneDrawCount(u32 count);
+
+	/* Variants of the main pipeline, differing by a blend tint, the main pass binds the next one
+	 * for every draw. 1 binds the pipeline once. Ignored with meshlet culling. */
+	void SetScenePipelineCount(u32 count);
+
+	/* Replaces the grid with the instances stacked as screen-covering layers, drawn back to front
+	 * so that every layer passes the depth test: the worst case of overdraw, which a depth
+	 * prepass brings down to one shaded layer. The scene lights are not created. */
+	void SetSceneOverdraw(bool enabled);
+
+	/* Extra arithmetic per fragment of the unlit shader, kShadingIterations of shader_frag.glsl,
+	 * standing in for expensive shading. */
+	void SetShadingIterations(u32 iterations);
+
+	/* Cascades of the sun's shadow map (1 to ShadowCascades::kMaxCascades) and the resolution
+	 * of each. Only lit scenes cast shadows. */
+	void SetShadowCascades(u32 cascadeCount, u32 resolution);
+
+	// LOD selection threshold, 0 always draws the full mesh.
+	void SetLodPixelError(f32 pixelError);
+
+	/* Draws the scene as meshlets culled by a compute pass into one indirect draw, instead of one
+	 * indexed draw per LOD batch. Shadows keep the indexed draws. */
+	void SetMeshletCulling(bool enabled);
+
+	/* Also culls meshlets hidden behind the depth of the previous frame, in two phases so that
+	 * what it hid but became visible is still drawn. Implies meshlet culling and the depth
+	 * prepass, and is disabled with MSAA. */
+	void SetOcclusionCulling(bool enabled);
+
+	/* Renders the scene into an HDR target and runs the PostProcess effects in effects over it
+	 * in one compute dispatch, writing the swap chain image. Disabled when the device can not
+	 * write swap chain images from compute. */
+	void SetPostProcessing(bool enabled, u32 effects = PostProcess::kAllEffects);
+
+	void SetSimulationTickRate(f64 tickRate);
+
+	// 1, 2, 4 or 8, lowered to what the device supports. 1 disables MSAA.
+	void SetMsaaSamples(u32 samples);
+
+	/* Renders depth alone first, the main pass then shades only the fragments matching it
+	 * (EQUAL compare, no depth writes). Pays off when fragment shading outweighs drawing twice. */
+	void SetDepthPrepass(bool enabled);
+
+	void SetFailOnFrameAllocation(bool fail);
+
+	/* Closes the window once the main loop blocks in glfwWaitEventsTimeout with nothing to draw,
+	 * Run() fails if that did not happen within timeout seconds. For on-demand mode, continuous
+	 * mode never idles. */
+	void SetIdleCheck(f64 timeout);
+
+	// Vulkan host allocations go through HostAllocator pools unless disabled.
+	void SetUseHostAllocator(bool use);
+
+	/* Loads <directory>/<name>.spv at pipeline creation instead of the SPIR-V embedded at build
+	 * time, so shaders can be recompiled without rebuilding. F5 reloads the scene shaders while
+	 * running. Empty uses the embedded code. */
+	void SetShaderDirectory(const char *directory);
+
+	// Defaults to kDefaultValidationPreset, the layer has to be installed for anything but eOff.
+	void SetValidationPreset(ValidationPreset preset);
+
+	// Captures CPU and GPU scopes for the whole run, written as Chrome trace JSON at exit.
+	void SetTracePath(const char *path);
+
+private:
+	bool InitWindow();
+
+    static void FramebufferResizeCallback(GLFWwindow* window, int width, int height);
+
+	static void WindowRefreshCallback(GLFWwindow *window);
+
+	static void WindowIconifyCallback(GLFWwindow *window, int iconified);
+
+	static void KeyCallback(GLFWwindow *window, int key, int scancode, int action, int mods);
+
+	static void MouseButtonCallback(GLFWwindow *window, int button, int action, int mods);
+
+	static void CursorPosCallback(GLFWwindow *window, double x, double y);
+
+	static void ScrollCallback(GLFWwindow *window, double x, double y);
+
+	bool InitVulkan();
+
+	bool CreateInstance();
+
+	bool SetupDebugMessenger();
+
+	bool PickPhysicalDevice();
+
+	bool CreateLogicalDevice();
+
+	// Highest sample count up to the requested one both color and depth attachments support.
+	void SelectMsaaSamples();
+
+	bool CreateSurface();
+
+	bool CreateSwapChain(VkSwapchainKHR oldSwapChain);
+
+	// Stand-ins for the swap chain images, one per frame in flight.
+	bool CreateHeadlessImages();
+
+	void DestroyHeadlessImages();
+
+	bool CreateImageViews();
+
+	bool CreateClusteredLighting();
+
+	bool CreateShadowCascades();
+
+	// Imports the scene mesh with its LODs and uploads it.
+	bool CreateSceneMesh();
+
+	bool CreateMeshletCulling();
+
+	bool CreateHiZPyramid();
+
+	bool CreatePostProcess();
+
+	// Also rebuilds the pipelines for ReloadShaders, with the same layout and descriptor sets.
+	bool CreateGraphicsPipeline();
+
+	void DestroyGraphicsPipelines();
+
+	/* Rebuilds the scene pipelines from the shader directory once the device is idle, F5 asks
+	 * for it. Compute passes and shadows keep the shaders they were created with. */
+	void ReloadShaders();
+
+	// Embedded SPIR-V, or the file from the shader directory when one is set.
+	std::optional<VkShaderModule> LoadShader(
+			const char       *name,
+			const u32        *code,
+			size_t            codeSize,
+			ShaderReflection &reflection
+	);
+
+	bool CreateRenderPass();
+
+	// Clearing for the prepass, loading for the late prepass of occlusion culling.
+	bool CreateDepthPrepassRenderPass(VkAttachmentLoadOp loadOp, VkRenderPass &renderPass);
+
+	bool CreateFramebuffers();
+
+	void DestroyFramebuffers();
+
+	bool CreateCommandPool();
+
+	bool CreateCommandBuffers();
+
+	bool CreateInstanceBuffers();
+
+	void DestroyInstanceBuffers();
+
+	bool CreateRenderGraph();
+
+	void CreateScene();
+
+	void CreateOverdrawScene();
+
+	void RecordLightBinning(VkCommandBuffer commandBuffer);
+
+	void RecordMeshletCull(VkCommandBuffer commandBuffer);
+
+	void RecordHiZBuild(VkCommandBuffer commandBuffer);
+
+	void RecordMeshletCullLate(VkCommandBuffer commandBuffer);
+
+	void RecordShadowCache(VkCommandBuffer commandBuffer);
+
+	void RecordShadowDynamic(VkCommandBuffer commandBuffer);
+
+	void RecordDepthPrepass(VkCommandBuffer commandBuffer, MeshletCulling::ClusterDraws draws);
+
+	void RecordMainPass(VkCommandBuffer commandBuffer);
+
+	/* Viewport, scissor, mesh and the per-LOD instanced draws shared by both passes. draws only
+	 * selects among meshlet clusters, mainPass binds the pipeline variants between draws. */
+	void RecordSceneDraw(
+			VkCommandBuffer              commandBuffer,
+			MeshletCulling::ClusterDraws draws,
+			bool                         mainPass
+	);
+
+	void RecordPostProcess(VkCommandBuffer commandBuffer);
+
+	bool RecordCommandBuffer(VkCommandBuffer commandBuffer, u32 imageIndex);
+
+	bool CreateSyncObjects();
+
+	bool RecreateSwapChain();
+
+	// Flags the swap chain as stale when no resize did, ShouldRecreateSwapChain then decides when.
+	void MarkSwapChainOutdated();
+
+	[[nodiscard]] bool ShouldRecreateSwapChain(f64 now) const;
+
+	// Returns whether any retired swap chain was destroyed.
+	bool DestroyRetiredSwapChains();
+
+	void LogResizeStats() const;
+
+	void CleanupSwapchain();
+
+	// Waits for the current frame's fence, returns whether a retired swap chain was destroyed.
+	bool WaitForFrame();
+
+	/* Extracts, records and submits the current frame into the image at imageIndex. The
+	 * semaphores are skipped when VK_NULL_HANDLE. */
+	bool SubmitFrame(u32 imageIndex, VkSemaphore waitSemaphore, VkSemaphore signalSemaphore);
+
+	void DrawFrame();
+
+	void CheckFrameAllocations(u64 allocations);
+
+	[[nodiscard]] bool LogAllocationCheck() const;
+
+	[[nodiscard]] bool IsWindowRenderable() const;
+
+	[[nodiscard]] bool HasPendingWork() const;
+
+	void MainLoop();
+
+	void ResizeStressLoop();
+
+	void Cleanup();
+
+private:
+	GLFWwindow *mWindow;
+
+	// Engine-side parallel work (culling, command recording, asset decoding, pipeline
+	// compilation), the main thread is worker 0.
+	JobSystem mJobSystem;
+
+	// Per-frame transient CPU memory, one arena per frame in flight.
+	FrameArena mFrameArena;
+
+	// HostAllocator callbacks, nullptr when the driver allocates on its own.
+	const VkAllocationCallbacks *mAllocator        = nullptr;
+	bool                         mUseHostAllocator = true;
+
+	ValidationPreset    mValidationPreset = kDefaultValidationPreset;
+	ValidationMessenger mValidationMessenger;
+
+	VkInstance               mInstance;
+	VkPhysicalDevice         mPhysicalDevice;
+	VkDevice                 mDevice;
+	VkQueue                  mGraphicsQueue;
+	VkQueue                  mPresentQueue;
+	VkDebugUtilsMessengerEXT mDebugMessenger;
+	VkSurfaceKHR             mSurface;
+
+	VkSwapchainKHR       mSwapChain;
+	std::vector<VkImage> mSwapChainImages;// Headless: mHeadlessImages
+	VkFormat             mSwapChainImageFormat;
+	VkExtent2D           mSwapChainExtent;
+
+	std::vector<VkImageView> mSwapChainImageViews;
+
+	// No window, no surface and no swap chain, see SetHeadless.
+	bool                        mHeadless       = false;
+	VkExtent2D                  mHeadlessExtent = {};
+	std::vector<VkDeviceMemory> mHeadlessImagesMemory;
+
+	std::string mDeviceFilter;
+	std::string mDeviceName;
+
+	VkRenderPass     mRenderPass;
+	VkPipelineLayout mPipelineLayout = VK_NULL_HANDLE;// Owned by mLayoutCache
+	VkPipeline       mGraphicsPipeline;
+
+	// Variants of mGraphicsPipeline after the first, see SetScenePipelineCount.
+	std::vector<VkPipeline> mScenePipelines;
+
+	bool          mDepthPrepass               = false;
+	VkFormat      mDepthFormat                = VK_FORMAT_UNDEFINED;
+	VkRenderPass  mDepthPrepassRenderPass     = VK_NULL_HANDLE;
+	VkRenderPass  mDepthPrepassLoadRenderPass = VK_NULL_HANDLE;// Occlusion culling only
+	VkPipeline    mDepthPrepassPipeline       = VK_NULL_HANDLE;// Vertex stage only
+	VkFramebuffer mDepthPrepassFramebuffer    = VK_NULL_HANDLE;
+
+	PipelineLayoutCache mLayoutCache;
+
+	// Only initialized when the scene has lights, the main pass uses clustered_frag then.
+	ClusteredLighting mClusteredLighting;
+
+	// Initialized along with mClusteredLighting, the main pass samples its atlas.
+	ShadowCascades           mShadowCascades;
+	ShadowCascades::Settings mShadowSettings;
+
+	std::vector<VkFramebuffer> mSwapChainFramebuffers;
+
+	// Timestamps of the frame and render graph passes, added to the trace while capturing.
+	GpuTracer mGpuTracer;
+	bool      mCalibratedTimestamps = false;// VK_EXT_calibrated_timestamps enabled
+
+	u32                   mRequestedMsaaSamples = kDefaultMsaaSamples;
+	VkSampleCountFlagBits mMsaaSamples          = VK_SAMPLE_COUNT_1_BIT;
+
+	RenderGraph mRenderGraph;
+	RGHandle    mSwapChainTarget   = kInvalidRGHandle;
+	RGHandle    mMsaaTarget        = kInvalidRGHandle;// Resolved into the swap chain image
+	RGHandle    mHdrTarget         = kInvalidRGHandle;// Post-processed into the swap chain image
+	RGHandle    mDepthTarget       = kInvalidRGHandle;
+	RGHandle    mShadowAtlas       = kInvalidRGHandle;
+	u32         mCurrentImageIndex = 0;
+
+	// Renderable entities, extracted into this frame's instance buffer before recording.
+	EcsWorld mWorld;
+	u32      mSceneInstanceCount = 1;
+	u32      mInstanceCount      = 0;
+	u32      mSceneLightCount    = kDefaultLightCount;
+	u32      mSceneDrawCount     = 1;
+	u32      mScenePipelineCount = 1;
+	bool     mSceneOverdraw      = false;
+	u32      mShadingIterations  = 0;
+	u32      mLightCount         = 0;
+
+	// Mesh drawn by every instance, and this frame's instances batched by LOD.
+	GpuMesh         mSceneMesh;
+	InstanceBatches mInstanceBatches;
+	f32             mLodPixelError = kDefaultLodPixelError;
+
+	// Only initialized with meshlet culling, the main and prepass draws then use meshlet_vert.
+	MeshletCulling mMeshletCulling;
+	bool           mUseMeshlets = false;
+
+	// Built from the depth prepass, culls meshlets against the previous frame's depth.
+	HiZPyramid mHiZPyramid;
+	bool       mOcclusionCulling = false;
+
+	// Only initialized with post-processing, the main pass then renders into mHdrTarget.
+	PostProcess           mPostProcess;
+	PostProcess::Settings mPostSettings;
+	bool                  mPostProcessing = false;
+
+	// Moves the scene entities at a fixed rate on its own thread, DrawFrame interpolates.
+	Simulation mSimulation;
+
+	std::vector<VkBuffer>       mInstanceBuffers;
+	std::vector<VkDeviceMemory> mInstanceBuffersMemory;
+	std::vector<InstanceData *> mInstanceBuffersMapped;
+
+	VkCommandPool                mCommandPool;
+	std::vector<VkCommandBuffer> mCommandBuffers;
+
+	std::vector<VkSemaphore> mImageAvailableSemaphores;
+	std::vector<VkSemaphore> mRenderFinishedSemaphores;
+	std::vector<VkFence>     mInFlightFences;
+
+	bool mFramebufferResized = false;
+
+	/* Swap chains replaced by RecreateSwapChain. No fence covers their queued presents, they are
+	 * destroyed once a frame submitted after the replacement has finished. */
+	struct RetiredSwapChain
+	{
+		VkSwapchainKHR swapChain    = VK_NULL_HANDLE;
+		u64            destroyFrame = 0;// Compared against mSubmittedFrames
+	};
+
+	std::vector<RetiredSwapChain> mRetiredSwapChains;
+
+	ResizePolicy mResizePolicy;
+	ResizeStats  mResizeStats;
+	f64          mFirstPendingResizeTime = 0.0;
+	f64          mLastResizeEventTime    = 0.0;
+	f64          mLastRecreateTime       = 0.0;
+	u32          mResizeStressFrames     = 0;
+
+	std::string mShaderDirectory;
+	bool        mShaderReloadRequested = false;
+	std::string mTracePath;
+
+	AllocationCheck mAllocationCheck;
+	IdleCheck       mIdleCheck;
+	FrameTimings    mFrameTimings;
+
+	RenderMode mRenderMode      = RenderMode::eContinuous;
+	bool       mRedrawRequested = true;
+	bool       mAnimating       = false;
+	bool       mWindowIconified = false;
+
+	u32 mCurrentFrame    = 0;
+	u64 mSubmittedFrames = 0;
+};
+
+
+#endif// HEADER_APPLICATION_H
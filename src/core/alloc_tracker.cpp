@@ -0,0 +1,247 @@
+#include "alloc_tracker.h"
+
+#include "utils/logger.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(COV_TRACK_ALLOCATIONS) && (defined(__linux__) || defined(__APPLE__))
+#include <execinfo.h>
+#define COV_HAS_BACKTRACE 1
+#endif
+
+/**************************************
+*       ALLOCATION TRACKER
+**************************************/
+
+static std::atomic<u64>  sTotalCount{0};
+static std::atomic<u64>  sTotalBytes{0};
+static std::atomic<bool> sReportCallSites{false};
+static std::atomic<u32>  sReportedCallSites{0};
+
+static thread_local u64  tThreadCount = 0;
+static thread_local bool tReporting   = false;
+
+u64 AllocationTracker::GetTotalCount()
+{
+	return sTotalCount.load(std::memory_order_relaxed);
+}
+
+u64 AllocationTracker::GetTotalBytes()
+{
+	return sTotalBytes.load(std::memory_order_relaxed);
+}
+
+u64 AllocationTracker::GetThreadCount()
+{
+	return tThreadCount;
+}
+
+void AllocationTracker::SetReportCallSites(bool report)
+{
+	sReportCallSites.store(report, std::memory_order_relaxed);
+}
+
+AllocationScope::AllocationScope(const char *name, bool expectNone)
+	: mName(name)
+	, mStartCount(AllocationTracker::GetThreadCount())
+	, mExpectNone(expectNone)
+{
+}
+
+AllocationScope::~AllocationScope()
+{
+	const u64 count = GetCount();
+	if (mExpectNone && count > 0)
+	{
+		CLOG_WARN("Scope \"", mName, "\" made ", count, " heap allocations, expected none.");
+	}
+}
+
+
+/**************************************
+*       GLOBAL NEW / DELETE
+**************************************/
+
+#ifdef COV_TRACK_ALLOCATIONS
+
+static void ReportCallSite(size_t size)
+{
+	const u32 reportIndex = sReportedCallSites.fetch_add(1, std::memory_order_relaxed);
+	if (reportIndex >= AllocationTracker::kMaxReportedCallSites)
+	{
+		return;
+	}
+
+	// The report itself may allocate, that must not recurse into another report.
+	tReporting = true;
+
+	CLOG_WARN("Heap allocation of ", size, " bytes while call sites are reported:");
+
+#ifdef COV_HAS_BACKTRACE
+	void     *frames[32];
+	const int frameCount = backtrace(frames, 32);
+
+	// Skips this function, writes straight to stdout without allocating.
+	fflush(stdout);
+	backtrace_symbols_fd(frames + 1, frameCount - 1, 1);
+#endif
+
+	tReporting = false;
+}
+
+static void *TrackedAllocate(size_t size, size_t alignment)
+{
+	sTotalCount.fetch_add(1, std::memory_order_relaxed);
+	sTotalBytes.fetch_add(size, std::memory_order_relaxed);
+	++tThreadCount;
+
+	if (sReportCallSites.load(std::memory_order_relaxed) && !tReporting)
+	{
+		ReportCallSite(size);
+	}
+
+	size = size > 0 ? size : 1;
+	if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+	{
+		return malloc(size);
+	}
+
+#ifdef _WIN32
+	return _aligned_malloc(size, alignment);
+#else
+	// aligned_alloc wants the size to be a multiple of the alignment.
+	return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+}
+
+static void TrackedFree(void *ptr, size_t alignment)
+{
+#ifdef _WIN32
+	if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+	{
+		_aligned_free(ptr);
+		return;
+	}
+#endif
+	(void)alignment;
+	free(ptr);
+}
+
+// Built without exceptions, a failed allocation can not throw std::bad_alloc.
+static void *TrackedAllocateOrAbort(size_t size, size_t alignment)
+{
+	void *ptr = TrackedAllocate(size, alignment);
+	if (ptr == nullptr)
+	{
+		abort();
+	}
+
+	return ptr;
+}
+
+constexpr size_t kDefaultAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+void *operator new(size_t size)
+{
+	return TrackedAllocateOrAbort(size, kDefaultAlignment);
+}
+
+void *operator new[](size_t size)
+{
+	return TrackedAllocateOrAbort(size, kDefaultAlignment);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+	return TrackedAllocate(size, kDefaultAlignment);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+	return TrackedAllocate(size, kDefaultAlignment);
+}
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+	return TrackedAllocateOrAbort(size, (size_t)alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+	return TrackedAllocateOrAbort(size, (size_t)alignment);
+}
+
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	return TrackedAllocate(size, (size_t)alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	return TrackedAllocate(size, (size_t)alignment);
+}
+
+void operator delete(void *ptr) noexcept
+{
+	TrackedFree(ptr, kDefaultAlignment);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+	TrackedFree(ptr, kDefaultAlignment);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+	TrackedFree(ptr, kDefaultAlignment);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+	TrackedFree(ptr, kDefaultAlignment);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+	TrackedFree(ptr, kDefaultAlignment);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+	TrackedFree(ptr, kDefaultAlignment);
+}
+
+void operator delete(void *ptr, std::align_val_t alignment) noexcept
+{
+	TrackedFree(ptr, (size_t)alignment);
+}
+
+void operator delete[](void *ptr, std::align_val_t alignment) noexcept
+{
+	TrackedFree(ptr, (size_t)alignment);
+}
+
+void operator delete(void *ptr, size_t, std::align_val_t alignment) noexcept
+{
+	TrackedFree(ptr, (size_t)alignment);
+}
+
+void operator delete[](void *ptr, size_t, std::align_val_t alignment) noexcept
+{
+	TrackedFree(ptr, (size_t)alignment);
+}
+
+void operator delete(void *ptr, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	TrackedFree(ptr, (size_t)alignment);
+}
+
+void operator delete[](void *ptr, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	TrackedFree(ptr, (size_t)alignment);
+}
+
+#endif// COV_TRACK_ALLOCATIONS
@@ -0,0 +1,67 @@
+#ifndef HEADER_ALLOC_TRACKER_H
+#define HEADER_ALLOC_TRACKER_H
+
+#include "definitions.h"
+
+/* Heap allocation counting, for asserting that hot paths do not allocate.
+ *
+ * Building with COV_TRACK_ALLOCATIONS replaces the global operator new/delete with versions that
+ * count every allocation, per thread and process wide. Without it the counters stay at zero and
+ * every check passes, so callers do not need their own #ifdefs.
+ *
+ * Only C++ allocations are seen. malloc calls from C code (GLFW, the Vulkan loader and driver)
+ * go straight to the C runtime and are not counted. */
+
+class AllocationTracker
+{
+public:
+	static constexpr u32 kMaxReportedCallSites = 16;
+
+public:
+	[[nodiscard]] static constexpr bool IsEnabled()
+	{
+#ifdef COV_TRACK_ALLOCATIONS
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	// Allocations made by all threads since startup.
+	[[nodiscard]] static u64 GetTotalCount();
+
+	[[nodiscard]] static u64 GetTotalBytes();
+
+	// Allocations made by the calling thread since it started.
+	[[nodiscard]] static u64 GetThreadCount();
+
+	/* While enabled, every allocation on any thread logs its size and a backtrace (where the
+	 * platform provides one), up to kMaxReportedCallSites reports in total. */
+	static void SetReportCallSites(bool report);
+};
+
+// Counts the calling thread's allocations during its lifetime.
+class AllocationScope
+{
+public:
+	// With expectNone, the destructor warns if anything was allocated.
+	explicit AllocationScope(const char *name, bool expectNone = false);
+
+	AllocationScope(const AllocationScope &) = delete;
+
+	AllocationScope &operator=(const AllocationScope &) = delete;
+
+	~AllocationScope();
+
+	[[nodiscard]] u64 GetCount() const
+	{
+		return AllocationTracker::GetThreadCount() - mStartCount;
+	}
+
+private:
+	const char *mName;
+	u64         mStartCount;
+	bool        mExpectNone;
+};
+
+#endif// HEADER_ALLOC_TRACKER_H
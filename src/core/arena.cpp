@@ -0,0 +1,191 @@
+#include "arena.h"
+
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <new>
+
+constexpr std::align_val_t kBlockAlignment{64};
+
+static thread_local LinearArena tScratchArena;
+
+static size_t AlignOffset(const u8 *base, size_t offset, size_t alignment)
+{
+	const uintptr_t address = reinterpret_cast<uintptr_t>(base) + offset;
+	const uintptr_t aligned = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	return offset + (size_t)(aligned - address);
+}
+
+
+/**************************************
+*       LINEAR ARENA
+**************************************/
+
+LinearArena::LinearArena(size_t blockSize)
+	: mBlockSize(blockSize)
+{
+}
+
+LinearArena::~LinearArena()
+{
+	for (Block &block : mBlocks)
+	{
+		FreeBlock(block);
+	}
+}
+
+void *LinearArena::Allocate(size_t size, size_t alignment)
+{
+	if (mBlocks.empty())
+	{
+		AddBlock(size + alignment);
+	}
+
+	size_t start = AlignOffset(mBlocks[mCurrentBlock].data, mOffset, alignment);
+	while (start + size > mBlocks[mCurrentBlock].size)
+	{
+		// The unused tail of the block counts as used until the next rewind.
+		mUsed += mBlocks[mCurrentBlock].size - mOffset;
+
+		if (mCurrentBlock + 1 == mBlocks.size() || mBlocks[mCurrentBlock + 1].size < size + alignment)
+		{
+			AddBlock(size + alignment);
+		}
+
+		++mCurrentBlock;
+		mOffset = 0;
+		start   = AlignOffset(mBlocks[mCurrentBlock].data, 0, alignment);
+	}
+
+	mUsed   += start + size - mOffset;
+	mOffset  = start + size;
+	mPeak    = std::max(mPeak, mUsed);
+
+	return mBlocks[mCurrentBlock].data + start;
+}
+
+void LinearArena::Free(void *ptr, size_t size)
+{
+	if (mBlocks.empty())
+	{
+		return;
+	}
+
+	u8 *top = mBlocks[mCurrentBlock].data + mOffset;
+	if (static_cast<u8 *>(ptr) + size == top)
+	{
+		mOffset -= size;
+		mUsed   -= size;
+	}
+}
+
+void LinearArena::Rewind(const Marker &marker)
+{
+	mCurrentBlock = marker.block;
+	mOffset       = marker.offset;
+	mUsed         = marker.used;
+}
+
+void LinearArena::Reset()
+{
+	Rewind({});
+
+	if (mBlocks.size() > 1)
+	{
+		// Merge the chain so the next frame of the same size fits in one block.
+		const size_t totalSize = GetCapacity();
+		for (Block &block : mBlocks)
+		{
+			FreeBlock(block);
+		}
+		mBlocks.clear();
+
+		AddBlock(totalSize);
+	}
+}
+
+size_t LinearArena::GetCapacity() const
+{
+	size_t capacity = 0;
+	for (const Block &block : mBlocks)
+	{
+		capacity += block.size;
+	}
+
+	return capacity;
+}
+
+void LinearArena::AddBlock(size_t minSize)
+{
+	Block block = {};
+	block.size  = std::max(mBlockSize, minSize);
+	block.data  = static_cast<u8 *>(::operator new(block.size, kBlockAlignment));
+
+	// Inserted right after the current block, a too small successor is replaced.
+	const size_t position = mBlocks.empty() ? 0 : mCurrentBlock + 1;
+	if (position < mBlocks.size())
+	{
+		FreeBlock(mBlocks[position]);
+		mBlocks[position] = block;
+	}
+	else
+	{
+		mBlocks.push_back(block);
+	}
+}
+
+void LinearArena::FreeBlock(Block &block)
+{
+	::operator delete(block.data, kBlockAlignment);
+	block = {};
+}
+
+
+/**************************************
+*       FRAME ARENA
+**************************************/
+
+void FrameArena::Init(u32 frameCount, size_t blockSize)
+{
+	mArenas.clear();
+	for (u32 i = 0; i < frameCount; ++i)
+	{
+		mArenas.push_back(std::make_unique<LinearArena>(blockSize));
+	}
+
+	mCurrentFrame = 0;
+}
+
+void FrameArena::BeginFrame(u32 frameIndex)
+{
+	COV_ASSERT(frameIndex < mArenas.size(), "Frame index out of range.");
+
+	mCurrentFrame = frameIndex;
+	mArenas[mCurrentFrame]->Reset();
+}
+
+void FrameArena::LogStats() const
+{
+	for (u32 i = 0; i < mArenas.size(); ++i)
+	{
+		CLOG_INFO(
+				"Frame arena ",
+				i,
+				": peak ",
+				mArenas[i]->GetPeak() / 1024,
+				" KB, capacity ",
+				mArenas[i]->GetCapacity() / 1024,
+				" KB."
+		);
+	}
+}
+
+
+/**************************************
+*       SCRATCH ARENA
+**************************************/
+
+LinearArena &GetScratchArena()
+{
+	return tScratchArena;
+}
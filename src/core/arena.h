@@ -0,0 +1,202 @@
+#ifndef HEADER_ARENA_H
+#define HEADER_ARENA_H
+
+#include "definitions.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/* Linear (bump) allocator for short-lived CPU allocations.
+ *
+ * Allocating moves an offset forward, individual frees are no-ops except for the most recent
+ * allocation, and everything is released at once by Rewind() or Reset(). Memory comes in blocks;
+ * when a block runs out another one is chained, and the next Reset() merges them into a single
+ * block big enough for the peak, so after warm-up an arena lives in one block.
+ *
+ * Two flavours are used:
+ *  - FrameArena: one arena per frame in flight, reset once the GPU finished the frame that last
+ *    used it. For per-frame data (draw lists, barrier arrays, submit infos).
+ *  - Scratch arena: one per thread, used through ScratchScope for temporaries of a single
+ *    function. Default constructed ArenaAllocators allocate from it. */
+
+class LinearArena
+{
+public:
+	static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+	struct Marker
+	{
+		u32    block  = 0;
+		size_t offset = 0;
+		size_t used   = 0;
+	};
+
+public:
+	explicit LinearArena(size_t blockSize = kDefaultBlockSize);
+
+	LinearArena(const LinearArena &) = delete;
+
+	LinearArena &operator=(const LinearArena &) = delete;
+
+	~LinearArena();
+
+	[[nodiscard]] void *Allocate(size_t size, size_t alignment);
+
+	// Gives the memory back only if it is the most recent allocation, lets vectors grow in place.
+	void Free(void *ptr, size_t size);
+
+	[[nodiscard]] Marker GetMarker() const
+	{
+		return {mCurrentBlock, mOffset, mUsed};
+	}
+
+	// Frees everything allocated after the marker was taken.
+	void Rewind(const Marker &marker);
+
+	void Reset();
+
+	[[nodiscard]] size_t GetUsed() const
+	{
+		return mUsed;
+	}
+
+	[[nodiscard]] size_t GetPeak() const
+	{
+		return mPeak;
+	}
+
+	[[nodiscard]] size_t GetCapacity() const;
+
+private:
+	struct Block
+	{
+		u8    *data = nullptr;
+		size_t size = 0;
+	};
+
+	void AddBlock(size_t minSize);
+
+	static void FreeBlock(Block &block);
+
+private:
+	std::vector<Block> mBlocks;
+	size_t             mBlockSize;
+	u32                mCurrentBlock = 0;
+	size_t             mOffset       = 0;
+	size_t             mUsed         = 0;// Including alignment padding and skipped block tails
+	size_t             mPeak         = 0;
+};
+
+class FrameArena
+{
+public:
+	void Init(u32 frameCount, size_t blockSize = LinearArena::kDefaultBlockSize);
+
+	/* Switches to the arena of frameIndex and frees its contents. Only call after waiting for the
+	 * GPU to finish the previous frame that used this index. */
+	void BeginFrame(u32 frameIndex);
+
+	[[nodiscard]] LinearArena &Get()
+	{
+		return *mArenas[mCurrentFrame];
+	}
+
+	void LogStats() const;
+
+private:
+	std::vector<std::unique_ptr<LinearArena>> mArenas;
+	u32                                       mCurrentFrame = 0;
+};
+
+// The calling thread's scratch arena.
+LinearArena &GetScratchArena();
+
+// Frees every scratch allocation made by this thread during the scope's lifetime.
+class ScratchScope
+{
+public:
+	ScratchScope()
+		: mArena(GetScratchArena())
+		, mMarker(mArena.GetMarker())
+	{
+	}
+
+	ScratchScope(const ScratchScope &) = delete;
+
+	ScratchScope &operator=(const ScratchScope &) = delete;
+
+	~ScratchScope()
+	{
+		mArena.Rewind(mMarker);
+	}
+
+	[[nodiscard]] LinearArena &GetArena() const
+	{
+		return mArena;
+	}
+
+private:
+	LinearArena        &mArena;
+	LinearArena::Marker mMarker;
+};
+
+/* STL allocator adaptor. Without an explicit arena it binds to the thread's scratch arena, so a
+ * container created inside a ScratchScope must not outlive it. */
+template<typename T>
+class ArenaAllocator
+{
+public:
+	using value_type = T;
+
+	ArenaAllocator() noexcept
+		: mArena(&GetScratchArena())
+	{
+	}
+
+	explicit ArenaAllocator(LinearArena &arena) noexcept
+		: mArena(&arena)
+	{
+	}
+
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U> &other) noexcept
+		: mArena(other.GetArena())
+	{
+	}
+
+	[[nodiscard]] T *allocate(size_t count)
+	{
+		return static_cast<T *>(mArena->Allocate(count * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T *ptr, size_t count)
+	{
+		mArena->Free(ptr, count * sizeof(T));
+	}
+
+	[[nodiscard]] LinearArena *GetArena() const
+	{
+		return mArena;
+	}
+
+	template<typename U>
+	bool operator==(const ArenaAllocator<U> &other) const
+	{
+		return mArena == other.GetArena();
+	}
+
+	template<typename U>
+	bool operator!=(const ArenaAllocator<U> &other) const
+	{
+		return mArena != other.GetArena();
+	}
+
+private:
+	LinearArena *mArena;
+};
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif// HEADER_ARENA_H
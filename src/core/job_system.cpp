@@ -0,0 +1,337 @@
+#include "job_system.h"
+
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Spins a worker does looking for work before it goes to sleep.
+constexpr u32 kIdleSpinCount = 256;
+
+static thread_local u32 tWorkerIndex = JobSystem::kInvalidWorker;
+
+
+/**************************************
+*       WORK STEALING QUEUE
+**************************************/
+
+void WorkStealingQueue::StoreSlot(i64 index, const Job &job)
+{
+	Slot &slot = mSlots[index & (kCapacity - 1)];
+	slot.function.store(job.function, std::memory_order_relaxed);
+	slot.data.store(job.data, std::memory_order_relaxed);
+	slot.counter.store(job.counter, std::memory_order_relaxed);
+}
+
+Job WorkStealingQueue::LoadSlot(i64 index) const
+{
+	const Slot &slot = mSlots[index & (kCapacity - 1)];
+
+	Job job      = {};
+	job.function = slot.function.load(std::memory_order_relaxed);
+	job.data     = slot.data.load(std::memory_order_relaxed);
+	job.counter  = slot.counter.load(std::memory_order_relaxed);
+	return job;
+}
+
+bool WorkStealingQueue::Push(const Job &job)
+{
+	const i64 bottom = mBottom.load(std::memory_order_relaxed);
+	const i64 top    = mTop.load(std::memory_order_acquire);
+
+	if (bottom - top >= kCapacity)
+	{
+		return false;
+	}
+
+	StoreSlot(bottom, job);
+	std::atomic_thread_fence(std::memory_order_release);
+	mBottom.store(bottom + 1, std::memory_order_relaxed);
+
+	return true;
+}
+
+bool WorkStealingQueue::Pop(Job &job)
+{
+	const i64 bottom = mBottom.load(std::memory_order_relaxed) - 1;
+	mBottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	i64 top = mTop.load(std::memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		// Empty
+		mBottom.store(bottom + 1, std::memory_order_relaxed);
+		return false;
+	}
+
+	job = LoadSlot(bottom);
+	if (top != bottom)
+	{
+		return true;
+	}
+
+	// Last job: race against thieves for it
+	const bool won = mTop.compare_exchange_strong(
+			top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed
+	);
+	mBottom.store(bottom + 1, std::memory_order_relaxed);
+
+	return won;
+}
+
+bool WorkStealingQueue::Steal(Job &job)
+{
+	i64 top = mTop.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	const i64 bottom = mBottom.load(std::memory_order_acquire);
+
+	if (top >= bottom)
+	{
+		return false;
+	}
+
+	job = LoadSlot(top);
+	return mTop.compare_exchange_strong(
+			top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed
+	);
+}
+
+
+/**************************************
+*       JOB SYSTEM
+**************************************/
+
+JobSystem::~JobSystem()
+{
+	Shutdown();
+}
+
+bool JobSystem::Init(u32 workerCount, bool pinThreads)
+{
+	COV_ASSERT(!mInitialized, "JobSystem is already initialized.");
+
+	const u32 hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	if (workerCount == 0)
+	{
+		workerCount = hardwareThreads;
+	}
+	workerCount = std::clamp(workerCount, 1u, kMaxWorkers);
+
+	// More pinned workers than cores would stack threads on the same core.
+	const bool pin = pinThreads && workerCount <= hardwareThreads;
+
+	mWorkerCount = workerCount;
+	mQueues      = std::make_unique<WorkStealingQueue[]>(workerCount);
+	mRunning.store(true, std::memory_order_release);
+
+	tWorkerIndex = 0;
+
+	mThreads.reserve(workerCount - 1);
+	for (u32 workerIndex = 1; workerIndex < workerCount; ++workerIndex)
+	{
+		mThreads.emplace_back(&JobSystem::WorkerLoop, this, workerIndex);
+
+		if (pin && !PinThread(mThreads.back().native_handle(), workerIndex))
+		{
+			CLOG_WARN("Failed to pin job worker ", workerIndex, " to its core.");
+		}
+	}
+
+	mInitialized = true;
+
+	CLOG_INFO("Job system started with ", workerCount, " workers", pin ? " (pinned)." : ".");
+	return EXIT_SUCCESS;
+}
+
+void JobSystem::Shutdown()
+{
+	if (!mInitialized)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mRunning.store(false, std::memory_order_release);
+	}
+	mWakeCondition.notify_all();
+
+	for (std::thread &thread : mThreads)
+	{
+		thread.join();
+	}
+
+	mThreads.clear();
+	mQueues.reset();
+	mExternalQueue.clear();
+
+	tWorkerIndex = kInvalidWorker;
+	mInitialized = false;
+}
+
+u32 JobSystem::GetCurrentWorkerIndex()
+{
+	return tWorkerIndex;
+}
+
+void JobSystem::Submit(JobFunction function, void *data, JobCounter *counter)
+{
+	Job job      = {};
+	job.function = function;
+	job.data     = data;
+	job.counter  = counter;
+
+	if (counter)
+	{
+		counter->mValue.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// seq_cst on both sides pairs with the sleeping worker's check, otherwise the wake up could
+	// be missed.
+	mPendingJobs.fetch_add(1);
+
+	const u32 workerIndex = tWorkerIndex;
+	if (workerIndex >= mWorkerCount || !mQueues[workerIndex].Push(job))
+	{
+		// Foreign thread or full local queue
+		std::lock_guard<std::mutex> lock(mExternalMutex);
+		mExternalQueue.push_back(job);
+		mExternalJobs.fetch_add(1, std::memory_order_release);
+	}
+
+	if (mSleepingWorkers.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mWakeCondition.notify_one();
+	}
+}
+
+void JobSystem::Wait(JobCounter &counter)
+{
+	const u32 workerIndex = tWorkerIndex;
+
+	while (!counter.IsDone())
+	{
+		if (!TryExecuteOne(workerIndex))
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::WorkerLoop(u32 workerIndex)
+{
+	tWorkerIndex = workerIndex;
+
+	char threadName[Trace::kMaxThreadNameSize];
+	snprintf(threadName, sizeof(threadName), "Worker %u", workerIndex);
+	Trace::SetThreadName(threadName);
+
+	u32 idleSpins = 0;
+	while (mRunning.load(std::memory_order_acquire))
+	{
+		if (TryExecuteOne(workerIndex))
+		{
+			idleSpins = 0;
+			continue;
+		}
+
+		if (++idleSpins < kIdleSpinCount)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		mSleepingWorkers.fetch_add(1);
+		mWakeCondition.wait(
+				lock,
+				[this]
+				{
+					return !mRunning.load(std::memory_order_acquire) || mPendingJobs.load() > 0;
+				}
+		);
+		mSleepingWorkers.fetch_sub(1, std::memory_order_acq_rel);
+		idleSpins = 0;
+	}
+}
+
+bool JobSystem::TryExecuteOne(u32 workerIndex)
+{
+	Job job = {};
+	if (!FindJob(workerIndex, job))
+	{
+		return false;
+	}
+
+	mPendingJobs.fetch_sub(1, std::memory_order_acq_rel);
+	Execute(job);
+	return true;
+}
+
+bool JobSystem::FindJob(u32 workerIndex, Job &job)
+{
+	if (workerIndex < mWorkerCount && mQueues[workerIndex].Pop(job))
+	{
+		return true;
+	}
+
+	// Cheap check first, idle workers poll this constantly.
+	if (mExternalJobs.load(std::memory_order_acquire) > 0)
+	{
+		std::lock_guard<std::mutex> lock(mExternalMutex);
+		if (!mExternalQueue.empty())
+		{
+			job = mExternalQueue.front();
+			mExternalQueue.pop_front();
+			mExternalJobs.fetch_sub(1, std::memory_order_release);
+			return true;
+		}
+	}
+
+	// Start stealing from the neighbour so thieves do not all hammer worker 0.
+	const u32 start = workerIndex < mWorkerCount ? workerIndex + 1 : 0;
+	for (u32 i = 0; i < mWorkerCount; ++i)
+	{
+		const u32 victim = (start + i) % mWorkerCount;
+		if (victim != workerIndex && mQueues[victim].Steal(job))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void JobSystem::Execute(const Job &job)
+{
+	job.function(job.data);
+
+	if (job.counter)
+	{
+		job.counter->mValue.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+bool JobSystem::PinThread(std::thread::native_handle_type thread, u32 core)
+{
+#ifdef _WIN32
+	const DWORD_PTR mask = DWORD_PTR(1) << core;
+	return SetThreadAffinityMask(thread, mask) != 0;
+#else
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	CPU_SET(core, &cpuSet);
+	return pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuSet) == 0;
+#endif
+}
@@ -0,0 +1,199 @@
+#ifndef HEADER_JOB_SYSTEM_H
+#define HEADER_JOB_SYSTEM_H
+
+#include "definitions.h"
+#include "utils/trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using JobFunction = void (*)(void *data);
+
+/* Fork-join primitive: every submitted job increments the counter, every finished one
+ * decrements it. JobSystem::Wait() returns once it reaches zero. */
+class JobCounter
+{
+public:
+	[[nodiscard]] bool IsDone() const
+	{
+		return mValue.load(std::memory_order_acquire) == 0;
+	}
+
+private:
+	friend class JobSystem;
+
+	std::atomic<u32> mValue{0};
+};
+
+struct Job
+{
+	JobFunction function = nullptr;
+	void       *data     = nullptr;
+	JobCounter *counter  = nullptr;
+};
+
+/* Chase-Lev work-stealing deque with a fixed capacity. Only the owning worker pushes and pops
+ * (LIFO, cache warm), any other worker can steal from the opposite end (FIFO). */
+class WorkStealingQueue
+{
+public:
+	static constexpr i64 kCapacity = 4096;
+
+	static_assert((kCapacity & (kCapacity - 1)) == 0, "Capacity must be a power of two.");
+
+public:
+	bool Push(const Job &job);
+
+	bool Pop(Job &job);
+
+	bool Steal(Job &job);
+
+private:
+	struct Slot
+	{
+		std::atomic<JobFunction>  function{nullptr};
+		std::atomic<void *>       data{nullptr};
+		std::atomic<JobCounter *> counter{nullptr};
+	};
+
+	void StoreSlot(i64 index, const Job &job);
+
+	Job LoadSlot(i64 index) const;
+
+private:
+	alignas(64) std::atomic<i64> mTop{0};
+	alignas(64) std::atomic<i64> mBottom{0};
+
+	Slot mSlots[kCapacity];
+};
+
+class JobSystem
+{
+public:
+	static constexpr u32 kMaxWorkers            = 64;
+	static constexpr u32 kMaxParallelForBatches = 256;
+
+	// Worker index of threads which are not part of the job system.
+	static constexpr u32 kInvalidWorker = ~0u;
+
+public:
+	JobSystem() = default;
+
+	JobSystem(const JobSystem &) = delete;
+
+	JobSystem &operator=(const JobSystem &) = delete;
+
+	~JobSystem();
+
+	/* The calling thread becomes worker 0 and takes part in the work while waiting.
+	 * workerCount == 0 uses one worker per hardware thread. With pinThreads, worker N is bound to
+	 * core N (the calling thread is left unpinned). */
+	bool Init(u32 workerCount = 0, bool pinThreads = true);
+
+	void Shutdown();
+
+	void Submit(JobFunction function, void *data, JobCounter *counter);
+
+	// Executes pending jobs on the calling thread until the counter reaches zero.
+	void Wait(JobCounter &counter);
+
+	/* Calls func(begin, end) for consecutive ranges of at most batchSize items covering
+	 * [0, count), spread over all workers. Blocks until every range is done. */
+	template<typename Func>
+	void ParallelFor(u32 count, u32 batchSize, Func &func);
+
+	[[nodiscard]] u32 GetWorkerCount() const
+	{
+		return mWorkerCount;
+	}
+
+	static u32 GetCurrentWorkerIndex();
+
+private:
+	void WorkerLoop(u32 workerIndex);
+
+	bool TryExecuteOne(u32 workerIndex);
+
+	bool FindJob(u32 workerIndex, Job &job);
+
+	static void Execute(const Job &job);
+
+	static bool PinThread(std::thread::native_handle_type thread, u32 core);
+
+private:
+	u32  mWorkerCount = 0;
+	bool mInitialized = false;
+
+	std::vector<std::thread>             mThreads;
+	std::unique_ptr<WorkStealingQueue[]> mQueues;
+
+	// Jobs submitted from threads outside of the job system.
+	std::mutex       mExternalMutex;
+	std::deque<Job>  mExternalQueue;
+	std::atomic<u32> mExternalJobs{0};
+
+	std::atomic<bool> mRunning{false};
+	std::atomic<u32>  mPendingJobs{0};
+	std::atomic<u32>  mSleepingWorkers{0};
+
+	std::mutex              mSleepMutex;
+	std::condition_variable mWakeCondition;
+};
+
+template<typename Func>
+void JobSystem::ParallelFor(u32 count, u32 batchSize, Func &func)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	batchSize = batchSize == 0 ? 1 : batchSize;
+
+	// Batches live on this stack frame, so their count is capped instead of allocating.
+	u32 batchCount = (count + batchSize - 1) / batchSize;
+	if (batchCount > kMaxParallelForBatches)
+	{
+		batchSize  = (count + kMaxParallelForBatches - 1) / kMaxParallelForBatches;
+		batchCount = (count + batchSize - 1) / batchSize;
+	}
+
+	struct Batch
+	{
+		Func *func;
+		u32   begin;
+		u32   end;
+	};
+
+	Batch      batches[kMaxParallelForBatches];
+	JobCounter counter;
+
+	for (u32 i = 0; i < batchCount; ++i)
+	{
+		batches[i].func  = &func;
+		batches[i].begin = i * batchSize;
+		batches[i].end   = std::min(count, batches[i].begin + batchSize);
+
+		Submit(
+				[](void *data)
+				{
+					COV_TRACE_SCOPE("ParallelFor");
+
+					Batch *batch = static_cast<Batch *>(data);
+					(*batch->func)(batch->begin, batch->end);
+				},
+				&batches[i],
+				&counter
+		);
+	}
+
+	Wait(counter);
+}
+
+#endif// HEADER_JOB_SYSTEM_H
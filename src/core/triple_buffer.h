@@ -0,0 +1,66 @@
+#ifndef HEADER_TRIPLE_BUFFER_H
+#define HEADER_TRIPLE_BUFFER_H
+
+#include "definitions.h"
+
+#include <atomic>
+
+/* Lock-free single producer, single consumer triple buffer.
+ *
+ * The producer always owns one slot to write into, the consumer one slot to read from and the
+ * third slot holds the latest published value. Publishing and acquiring swap the owned slot
+ * with the middle one, so neither side ever waits for the other: the producer overwrites values
+ * the consumer skipped and the consumer keeps the last value while nothing new arrived. */
+template<typename T>
+class TripleBuffer
+{
+public:
+	// Producer side: the slot to fill before Publish().
+	T &GetWriteBuffer()
+	{
+		return mBuffers[mWriteIndex];
+	}
+
+	void Publish()
+	{
+		const u8 previous = mMiddle.exchange(mWriteIndex | kFreshBit, std::memory_order_acq_rel);
+		mWriteIndex       = previous & kIndexMask;
+	}
+
+	// Consumer side: switches to the latest published value, false if there is none newer.
+	bool Acquire()
+	{
+		if ((mMiddle.load(std::memory_order_relaxed) & kFreshBit) == 0)
+		{
+			return false;
+		}
+
+		const u8 previous = mMiddle.exchange(mReadIndex, std::memory_order_acq_rel);
+		mReadIndex        = previous & kIndexMask;
+		return true;
+	}
+
+	// Consumer side: whether Acquire() would switch to a newer value.
+	[[nodiscard]] bool HasFresh() const
+	{
+		return (mMiddle.load(std::memory_order_relaxed) & kFreshBit) != 0;
+	}
+
+	[[nodiscard]] const T &GetReadBuffer() const
+	{
+		return mBuffers[mReadIndex];
+	}
+
+private:
+	static constexpr u8 kIndexMask = 0x3;
+	static constexpr u8 kFreshBit  = 0x4;
+
+	T mBuffers[3] = {};
+
+	// Both sides hit the middle index, keep it away from the slots and the owned indices.
+	alignas(64) std::atomic<u8> mMiddle{1};
+	alignas(64) u8 mWriteIndex = 0;
+	alignas(64) u8 mReadIndex  = 2;
+};
+
+#endif// HEADER_TRIPLE_BUFFER_H
@@ -0,0 +1,367 @@
+#include "clustered_lighting.h"
+
+#include "render/pipeline_layout_cache.h"
+#include "render/vk_dispatch.h"
+#include "render/vk_utils.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// Lights, clusters, indices and counter.
+constexpr u32 kCullBindingCount    = 4;
+constexpr u32 kShadingBindingCount = 3;
+
+bool ClusteredLighting::Init(
+		VkDevice                     device,
+		VkPhysicalDevice             physicalDevice,
+		PipelineLayoutCache         &layoutCache,
+		VkShaderModule               cullModule,
+		const ShaderReflection      &cullReflection,
+		u32                          frameCount,
+		u32                          maxLights,
+		const VkAllocationCallbacks *allocator
+)
+{
+	mDevice         = device;
+	mPhysicalDevice = physicalDevice;
+	mLayoutCache    = &layoutCache;
+	mAllocator      = allocator;
+	mMaxLights      = std::max(maxLights, 1u);
+
+	mPushConstants.gridSize      = glm::uvec4(kClusterCountX, kClusterCountY, kClusterCountZ, 0);
+	mPushConstants.indexCapacity = kMaxLightIndices;
+
+	mFrames.resize(frameCount);
+	for (FrameResources &frame : mFrames)
+	{
+		if (CreateFrameBuffers(frame) == EXIT_FAILURE)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+
+	// One compute and one shading set per frame.
+	VkDescriptorPoolSize poolSize = {};
+	poolSize.type                 = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount      = frameCount * (kCullBindingCount + kShadingBindingCount);
+
+	VkDescriptorPoolCreateInfo poolInfo = {};
+
+	poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.maxSets       = frameCount * 2;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes    = &poolSize;
+
+	if (vkCreateDescriptorPool(mDevice, &poolInfo, mAllocator, &mDescriptorPool) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create the light binning descriptor pool.");
+		return EXIT_FAILURE;
+	}
+
+	if (CreateCullPipeline(cullModule, cullReflection) == EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	CLOG_INFO(
+			"Clustered lighting: ",
+			kClusterCountX,
+			"x",
+			kClusterCountY,
+			"x",
+			kClusterCountZ,
+			" clusters, up to ",
+			mMaxLights,
+			" lights."
+	);
+	return EXIT_SUCCESS;
+}
+
+void ClusteredLighting::Destroy()
+{
+	if (mDevice == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	vkDestroyPipeline(mDevice, mCullPipeline, mAllocator);
+	vkDestroyDescriptorPool(mDevice, mDescriptorPool, mAllocator);
+
+	for (FrameResources &frame : mFrames)
+	{
+		vkDestroyBuffer(mDevice, frame.lights, mAllocator);
+		vkFreeMemory(mDevice, frame.lightsMemory, mAllocator);
+		vkDestroyBuffer(mDevice, frame.clusters, mAllocator);
+		vkFreeMemory(mDevice, frame.clustersMemory, mAllocator);
+		vkDestroyBuffer(mDevice, frame.indices, mAllocator);
+		vkFreeMemory(mDevice, frame.indicesMemory, mAllocator);
+		vkDestroyBuffer(mDevice, frame.counter, mAllocator);
+		vkFreeMemory(mDevice, frame.counterMemory, mAllocator);
+	}
+	mFrames.clear();
+
+	mCullPipeline   = VK_NULL_HANDLE;
+	mDescriptorPool = VK_NULL_HANDLE;
+	mCullLayout     = VK_NULL_HANDLE;
+	mShadingLayout  = VK_NULL_HANDLE;
+	mDevice         = VK_NULL_HANDLE;
+}
+
+bool ClusteredLighting::BindGraphicsLayout(VkPipelineLayout pipelineLayout)
+{
+	std::optional<VkDescriptorSetLayout> setLayout = mLayoutCache->FindSetLayout(pipelineLayout, 0);
+	if (!setLayout.has_value())
+	{
+		CLOG_ERR("Shading pipeline layout has no light set.");
+		return EXIT_FAILURE;
+	}
+
+	mShadingLayout = pipelineLayout;
+	return AllocateSets(setLayout.value(), kShadingBindingCount, &FrameResources::shadingSet);
+}
+
+void ClusteredLighting::RecordBinning(
+		VkCommandBuffer commandBuffer,
+		u32             frameIndex,
+		u32             lightCount,
+		VkExtent2D      viewport
+)
+{
+	const FrameResources &frame = mFrames[frameIndex];
+
+	mPushConstants.viewportSize = glm::vec2((f32)viewport.width, (f32)viewport.height);
+	mPushConstants.lightCount   = std::min(lightCount, mMaxLights);
+
+	// The previous use of the counter was this frame's binning, which its fence has covered.
+	VulkanDispatch::vkCmdFillBuffer(commandBuffer, frame.counter, 0, VK_WHOLE_SIZE, 0);
+
+	VkMemoryBarrier2KHR clearBarrier = {};
+	clearBarrier.sType               = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+	clearBarrier.srcStageMask        = VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR;
+	clearBarrier.srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR;
+	clearBarrier.dstStageMask        = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+
+	clearBarrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR
+							   | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR;
+
+	VkDependencyInfoKHR dependencyInfo = {};
+	dependencyInfo.sType               = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+	dependencyInfo.memoryBarrierCount  = 1;
+	dependencyInfo.pMemoryBarriers     = &clearBarrier;
+
+	VulkanDispatch::vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+
+	VulkanDispatch::vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mCullPipeline);
+	VulkanDispatch::vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			mCullLayout,
+			0,
+			1,
+			&frame.cullSet,
+			0,
+			nullptr
+	);
+	VulkanDispatch::vkCmdPushConstants(
+			commandBuffer,
+			mCullLayout,
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			0,
+			sizeof(PushConstants),
+			&mPushConstants
+	);
+	VulkanDispatch::vkCmdDispatch(
+			commandBuffer, (kClusterCount + kWorkgroupSize - 1) / kWorkgroupSize, 1, 1
+	);
+
+	VkMemoryBarrier2KHR binningBarrier = {};
+	binningBarrier.sType               = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+	binningBarrier.srcStageMask        = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+	binningBarrier.srcAccessMask       = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR;
+	binningBarrier.dstStageMask        = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR;
+	binningBarrier.dstAccessMask       = VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR;
+
+	dependencyInfo.pMemoryBarriers = &binningBarrier;
+
+	VulkanDispatch::vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+}
+
+void ClusteredLighting::BindForShading(VkCommandBuffer commandBuffer, u32 frameIndex) const
+{
+	VulkanDispatch::vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			mShadingLayout,
+			0,
+			1,
+			&mFrames[frameIndex].shadingSet,
+			0,
+			nullptr
+	);
+	VulkanDispatch::vkCmdPushConstants(
+			commandBuffer,
+			mShadingLayout,
+			VK_SHADER_STAGE_FRAGMENT_BIT,
+			0,
+			sizeof(PushConstants),
+			&mPushConstants
+	);
+}
+
+bool ClusteredLighting::CreateFrameBuffers(FrameResources &frame)
+{
+	// Lights are rewritten by the CPU every frame like instances, the rest never leaves the GPU.
+	const VkDeviceSize lightsSize = sizeof(LightData) * mMaxLights;
+	if (CreateBuffer(
+				mDevice,
+				mPhysicalDevice,
+				lightsSize,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				frame.lights,
+				frame.lightsMemory
+		)
+		== EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	void *mapped = nullptr;
+	if (vkMapMemory(mDevice, frame.lightsMemory, 0, lightsSize, 0, &mapped) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to map light buffer.");
+		return EXIT_FAILURE;
+	}
+	frame.lightsMapped = static_cast<LightData *>(mapped);
+
+	if (CreateBuffer(
+				mDevice,
+				mPhysicalDevice,
+				sizeof(glm::uvec2) * kClusterCount,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				frame.clusters,
+				frame.clustersMemory
+		)
+		== EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	if (CreateBuffer(
+				mDevice,
+				mPhysicalDevice,
+				sizeof(u32) * kMaxLightIndices,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				frame.indices,
+				frame.indicesMemory
+		)
+		== EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	return CreateBuffer(
+			mDevice,
+			mPhysicalDevice,
+			sizeof(u32),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			frame.counter,
+			frame.counterMemory
+	);
+}
+
+bool ClusteredLighting::CreateCullPipeline(
+		VkShaderModule          cullModule,
+		const ShaderReflection &cullReflection
+)
+{
+	const ShaderReflection *stages[] = {&cullReflection};
+
+	std::optional<VkPipelineLayout> layout = mLayoutCache->GetPipelineLayout(stages, 1);
+	if (!layout.has_value())
+	{
+		CLOG_ERR("Light binning pipeline layout creation failed.");
+		return EXIT_FAILURE;
+	}
+	mCullLayout = layout.value();
+
+	VkComputePipelineCreateInfo pipelineInfo = {};
+
+	pipelineInfo.sType        = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = cullModule;
+	pipelineInfo.stage.pName  = "main";
+	pipelineInfo.layout       = mCullLayout;
+
+	if (vkCreateComputePipelines(
+				mDevice, VK_NULL_HANDLE, 1, &pipelineInfo, mAllocator, &mCullPipeline
+		)
+		!= VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create the light binning pipeline.");
+		return EXIT_FAILURE;
+	}
+
+	std::optional<VkDescriptorSetLayout> setLayout = mLayoutCache->FindSetLayout(mCullLayout, 0);
+	if (!setLayout.has_value())
+	{
+		CLOG_ERR("Light binning shader declares no descriptor set.");
+		return EXIT_FAILURE;
+	}
+
+	return AllocateSets(setLayout.value(), kCullBindingCount, &FrameResources::cullSet);
+}
+
+bool ClusteredLighting::AllocateSets(
+		VkDescriptorSetLayout            setLayout,
+		u32                              bindingCount,
+		VkDescriptorSet FrameResources::*setMember
+)
+{
+	COV_ASSERT(bindingCount <= kCullBindingCount, "Too many light bindings.");
+
+	for (FrameResources &frame : mFrames)
+	{
+		VkDescriptorSetAllocateInfo allocInfo = {};
+
+		allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool     = mDescriptorPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts        = &setLayout;
+
+		if (vkAllocateDescriptorSets(mDevice, &allocInfo, &(frame.*setMember)) != VK_SUCCESS)
+		{
+			CLOG_ERR("Failed to allocate a light binning descriptor set.");
+			return EXIT_FAILURE;
+		}
+
+		const VkBuffer buffers[kCullBindingCount] = {
+				frame.lights, frame.clusters, frame.indices, frame.counter
+		};
+
+		VkDescriptorBufferInfo bufferInfos[kCullBindingCount] = {};
+		VkWriteDescriptorSet   writes[kCullBindingCount]      = {};
+		for (u32 i = 0; i < bindingCount; ++i)
+		{
+			bufferInfos[i].buffer = buffers[i];
+			bufferInfos[i].offset = 0;
+			bufferInfos[i].range  = VK_WHOLE_SIZE;
+
+			writes[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet          = frame.*setMember;
+			writes[i].dstBinding      = i;
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[i].pBufferInfo     = &bufferInfos[i];
+		}
+
+		vkUpdateDescriptorSets(mDevice, bindingCount, writes, 0, nullptr);
+	}
+
+	return EXIT_SUCCESS;
+}
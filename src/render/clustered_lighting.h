@@ -0,0 +1,142 @@
+#ifndef HEADER_CLUSTERED_LIGHTING_H
+#define HEADER_CLUSTERED_LIGHTING_H
+
+#include "definitions.h"
+#include "pch/glm.h"
+#include "render/render_extract.h"
+#include "render/spirv_reflect.h"
+#include "vulkan/vulkan_core.h"
+
+#include <vector>
+
+class PipelineLayoutCache;
+
+/* Clustered forward lighting: the view is split into a kClusterCountX * Y * Z grid, a compute
+ * pass bins the frame's point lights into the clusters they touch and the fragment shader of the
+ * main pass only loops over the lights of its own cluster, so shading cost follows the local
+ * light density instead of the total light count.
+ *
+ * Binning writes one (offset, count) pair per cluster and a flat light index list, compacted
+ * through an atomic counter; clusters past kMaxLightIndices lose their lights for the frame.
+ * Every frame in flight owns its buffers. The render graph only tracks images, so the binning
+ * records its own buffer barriers and its pass has to be marked with side effects. Lights are
+ * placed in the space the scene is drawn in (x and y in NDC, z in depth), slices are linear. */
+class ClusteredLighting
+{
+public:
+	static constexpr u32 kClusterCountX = 16;
+	static constexpr u32 kClusterCountY = 9;
+	static constexpr u32 kClusterCountZ = 24;
+	static constexpr u32 kClusterCount  = kClusterCountX * kClusterCountY * kClusterCountZ;
+
+	// Index list capacity, as an average over all clusters.
+	static constexpr u32 kAverageLightsPerCluster = 32;
+	static constexpr u32 kMaxLightIndices         = kClusterCount * kAverageLightsPerCluster;
+
+	// Matches local_size_x of light_cull_comp.glsl.
+	static constexpr u32 kWorkgroupSize = 64;
+
+	// Matches ClusterParams of light_cull_comp.glsl and clustered_frag.glsl.
+	struct PushConstants
+	{
+		glm::uvec4 gridSize;
+		glm::vec2  viewportSize;
+		u32        lightCount;
+		u32        indexCapacity;
+	};
+
+public:
+	/* cullModule is light_cull_comp.glsl, only used during the call. Layouts come from
+	 * layoutCache, which has to outlive this object. */
+	bool Init(
+			VkDevice                     device,
+			VkPhysicalDevice             physicalDevice,
+			PipelineLayoutCache         &layoutCache,
+			VkShaderModule               cullModule,
+			const ShaderReflection      &cullReflection,
+			u32                          frameCount,
+			u32                          maxLights,
+			const VkAllocationCallbacks *allocator
+	);
+
+	void Destroy();
+
+	/* Allocates the per-frame sets of a graphics pipeline layout whose set 0 declares the light,
+	 * cluster and index buffers like clustered_frag.glsl. */
+	bool BindGraphicsLayout(VkPipelineLayout pipelineLayout);
+
+	// Persistently mapped, written by the CPU before the frame is recorded.
+	[[nodiscard]] LightData *GetLights(u32 frameIndex) const
+	{
+		return mFrames[frameIndex].lightsMapped;
+	}
+
+	[[nodiscard]] u32 GetMaxLights() const
+	{
+		return mMaxLights;
+	}
+
+	// Outside render passes. Shading in fragment shaders can follow without further barriers.
+	void RecordBinning(
+			VkCommandBuffer commandBuffer,
+			u32             frameIndex,
+			u32             lightCount,
+			VkExtent2D      viewport
+	);
+
+	// Binds set 0 and the push constants of the layout given to BindGraphicsLayout.
+	void BindForShading(VkCommandBuffer commandBuffer, u32 frameIndex) const;
+
+private:
+	struct FrameResources
+	{
+		VkBuffer       lights       = VK_NULL_HANDLE;
+		VkDeviceMemory lightsMemory = VK_NULL_HANDLE;
+		LightData     *lightsMapped = nullptr;
+
+		VkBuffer       clusters       = VK_NULL_HANDLE;
+		VkDeviceMemory clustersMemory = VK_NULL_HANDLE;
+
+		VkBuffer       indices       = VK_NULL_HANDLE;
+		VkDeviceMemory indicesMemory = VK_NULL_HANDLE;
+
+		VkBuffer       counter       = VK_NULL_HANDLE;
+		VkDeviceMemory counterMemory = VK_NULL_HANDLE;
+
+		VkDescriptorSet cullSet    = VK_NULL_HANDLE;
+		VkDescriptorSet shadingSet = VK_NULL_HANDLE;
+	};
+
+	bool CreateFrameBuffers(FrameResources &frame);
+
+	bool CreateCullPipeline(VkShaderModule cullModule, const ShaderReflection &cullReflection);
+
+	// Writes the first bindingCount buffers (lights, clusters, indices, counter) of every frame.
+	bool AllocateSets(
+			VkDescriptorSetLayout            setLayout,
+			u32                              bindingCount,
+			VkDescriptorSet FrameResources::*setMember
+	);
+
+private:
+	VkDevice                     mDevice         = VK_NULL_HANDLE;
+	VkPhysicalDevice             mPhysicalDevice = VK_NULL_HANDLE;
+	PipelineLayoutCache         *mLayoutCache    = nullptr;
+	const VkAllocationCallbacks *mAllocator      = nullptr;
+
+	u32 mMaxLights = 0;
+
+	VkDescriptorPool mDescriptorPool = VK_NULL_HANDLE;
+
+	VkPipelineLayout mCullLayout   = VK_NULL_HANDLE;// Owned by mLayoutCache
+	VkPipeline       mCullPipeline = VK_NULL_HANDLE;
+
+	VkPipelineLayout mShadingLayout = VK_NULL_HANDLE;// Owned by mLayoutCache
+
+	// Pushed again for shading, the fragment shader needs the same grid and viewport.
+	PushConstants mPushConstants = {};
+
+	std::vector<FrameResources> mFrames;
+};
+
+#endif// HEADER_CLUSTERED_LIGHTING_H
@@ -0,0 +1,407 @@
+#include "gpu_trace.h"
+
+#include "render/vk_dispatch.h"
+#include "utils/logger.h"
+
+#include <cstdlib>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+// Host clock of VK_EXT_calibrated_timestamps that std::chrono::steady_clock reads.
+#ifdef _WIN32
+constexpr VkTimeDomainEXT kHostTimeDomain = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+constexpr VkTimeDomainEXT kHostTimeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+
+// Host domain timestamp to Trace::Now() nanoseconds.
+static u64 HostTimestampToNs(u64 timestamp)
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+
+	const u64 ticksPerSecond = (u64)frequency.QuadPart;
+	return timestamp / ticksPerSecond * 1'000'000'000
+		 + timestamp % ticksPerSecond * 1'000'000'000 / ticksPerSecond;
+#else
+	return timestamp;
+#endif
+}
+
+static u32 GetQueryIndex(u32 frameIndex, u32 scope)
+{
+	return (frameIndex * GpuTracer::kMaxScopesPerFrame + scope) * 2;
+}
+
+bool GpuTracer::Init(
+		VkPhysicalDevice             physicalDevice,
+		VkDevice                     device,
+		VkQueue                      queue,
+		u32                          queueFamily,
+		u32                          frameCount,
+		bool                         calibratedTimestamps,
+		const VkAllocationCallbacks *allocator
+)
+{
+	mDevice      = device;
+	mQueue       = queue;
+	mQueueFamily = queueFamily;
+	mAllocator   = allocator;
+
+	u32 familyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> families(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+	const u32 validBits = families[queueFamily].timestampValidBits;
+	if (validBits == 0)
+	{
+		CLOG_WARN("Queue family has no timestamps, GPU scopes are not traced.");
+		return EXIT_SUCCESS;
+	}
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+	mTimestampPeriod = (f64)properties.limits.timestampPeriod;
+	mTimestampMask   = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+	VkQueryPoolCreateInfo poolInfo = {};
+	poolInfo.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	poolInfo.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+	poolInfo.queryCount            = GetQueryIndex(frameCount, 0) + 1;
+
+	if (vkCreateQueryPool(mDevice, &poolInfo, mAllocator, &mQueryPool) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create timestamp query pool.");
+		return EXIT_FAILURE;
+	}
+
+	mFrames.assign(frameCount, {});
+	mResults.resize(kMaxScopesPerFrame * 2);
+
+	if (calibratedTimestamps
+		&& VulkanDispatch::vkGetPhysicalDeviceCalibrateableTimeDomainsEXT != nullptr
+		&& VulkanDispatch::vkGetCalibratedTimestampsEXT != nullptr)
+	{
+		u32 domainCount = 0;
+		VulkanDispatch::vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(
+				physicalDevice, &domainCount, nullptr
+		);
+		std::vector<VkTimeDomainEXT> domains(domainCount);
+		VulkanDispatch::vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(
+				physicalDevice, &domainCount, domains.data()
+		);
+
+		bool hasDevice = false;
+		bool hasHost   = false;
+		for (VkTimeDomainEXT domain : domains)
+		{
+			hasDevice |= domain == VK_TIME_DOMAIN_DEVICE_EXT;
+			hasHost |= domain == kHostTimeDomain;
+		}
+
+		mCalibratedTimestamps = hasDevice && hasHost;
+		mHostDomain           = kHostTimeDomain;
+	}
+
+	if (!mCalibratedTimestamps)
+	{
+		VkCommandPoolCreateInfo commandPoolInfo = {};
+		commandPoolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		commandPoolInfo.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		commandPoolInfo.queueFamilyIndex = mQueueFamily;
+
+		if (vkCreateCommandPool(mDevice, &commandPoolInfo, mAllocator, &mCommandPool)
+			!= VK_SUCCESS)
+		{
+			CLOG_ERR("Failed to create calibration command pool.");
+			return EXIT_FAILURE;
+		}
+
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool                 = mCommandPool;
+		allocInfo.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount          = 1;
+
+		if (vkAllocateCommandBuffers(mDevice, &allocInfo, &mCommandBuffer) != VK_SUCCESS)
+		{
+			CLOG_ERR("Failed to allocate calibration command buffer.");
+			return EXIT_FAILURE;
+		}
+
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType             = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		if (vkCreateFence(mDevice, &fenceInfo, mAllocator, &mFence) != VK_SUCCESS)
+		{
+			CLOG_ERR("Failed to create calibration fence.");
+			return EXIT_FAILURE;
+		}
+	}
+
+	mEnabled = true;
+
+	CLOG_INFO(
+			"GPU tracing with ",
+			mTimestampPeriod,
+			" ns ticks, calibrated ",
+			mCalibratedTimestamps ? "with VK_EXT_calibrated_timestamps." : "by submission."
+	);
+	return EXIT_SUCCESS;
+}
+
+void GpuTracer::Destroy()
+{
+	if (mFence != VK_NULL_HANDLE)
+	{
+		vkDestroyFence(mDevice, mFence, mAllocator);
+		mFence = VK_NULL_HANDLE;
+	}
+
+	if (mCommandPool != VK_NULL_HANDLE)
+	{
+		vkDestroyCommandPool(mDevice, mCommandPool, mAllocator);
+		mCommandPool   = VK_NULL_HANDLE;
+		mCommandBuffer = VK_NULL_HANDLE;
+	}
+
+	if (mQueryPool != VK_NULL_HANDLE)
+	{
+		vkDestroyQueryPool(mDevice, mQueryPool, mAllocator);
+		mQueryPool = VK_NULL_HANDLE;
+	}
+
+	mFrames.clear();
+	mEnabled = false;
+}
+
+void GpuTracer::BeginFrame(VkCommandBuffer commandBuffer, u32 frameIndex)
+{
+	if (!mEnabled)
+	{
+		return;
+	}
+
+	mCurrentFrame = frameIndex;
+
+	const bool capturing = Trace::IsCapturing();
+	if (capturing && ++mFramesSinceCalibration >= kCalibrationInterval)
+	{
+		if (Calibrate() == EXIT_FAILURE)
+		{
+			CLOG_WARN("GPU timestamp calibration failed, keeping the previous one.");
+		}
+		mFramesSinceCalibration = 0;
+	}
+
+	Collect(frameIndex);
+
+	if (capturing)
+	{
+		VulkanDispatch::vkCmdResetQueryPool(
+				commandBuffer, mQueryPool, GetQueryIndex(frameIndex, 0), kMaxScopesPerFrame * 2
+		);
+		mFrames[frameIndex].recorded = true;
+	}
+}
+
+u32 GpuTracer::BeginScope(VkCommandBuffer commandBuffer, const char *name)
+{
+	if (!mEnabled)
+	{
+		return kInvalidScope;
+	}
+
+	FrameQueries &frame = mFrames[mCurrentFrame];
+	if (!frame.recorded || frame.scopeCount == kMaxScopesPerFrame)
+	{
+		return kInvalidScope;
+	}
+
+	const u32 scope    = frame.scopeCount++;
+	frame.names[scope] = name;
+
+	VulkanDispatch::vkCmdWriteTimestamp(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			mQueryPool,
+			GetQueryIndex(mCurrentFrame, scope)
+	);
+	return scope;
+}
+
+void GpuTracer::EndScope(VkCommandBuffer commandBuffer, u32 scope)
+{
+	VulkanDispatch::vkCmdWriteTimestamp(
+			commandBuffer,
+			VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			mQueryPool,
+			GetQueryIndex(mCurrentFrame, scope) + 1
+	);
+}
+
+void GpuTracer::CollectAll()
+{
+	if (!mEnabled)
+	{
+		return;
+	}
+
+	for (u32 i = 0; i < (u32)mFrames.size(); ++i)
+	{
+		Collect(i);
+	}
+}
+
+void GpuTracer::Collect(u32 frameIndex)
+{
+	FrameQueries &frame = mFrames[frameIndex];
+	if (!frame.recorded)
+	{
+		return;
+	}
+
+	const u32 scopeCount = frame.scopeCount;
+	frame.recorded       = false;
+	frame.scopeCount     = 0;
+
+	if (scopeCount == 0)
+	{
+		return;
+	}
+
+	// The frame's fence was waited, so every query is available.
+	if (VulkanDispatch::vkGetQueryPoolResults(
+				mDevice,
+				mQueryPool,
+				GetQueryIndex(frameIndex, 0),
+				scopeCount * 2,
+				scopeCount * 2 * sizeof(u64),
+				mResults.data(),
+				sizeof(u64),
+				VK_QUERY_RESULT_64_BIT
+		)
+		!= VK_SUCCESS)
+	{
+		return;
+	}
+
+	for (u32 i = 0; i < scopeCount; ++i)
+	{
+		Trace::AddGpuScope(
+				frame.names[i], ToCpuTime(mResults[i * 2]), ToCpuTime(mResults[i * 2 + 1])
+		);
+	}
+}
+
+bool GpuTracer::Calibrate()
+{
+	COV_TRACE_SCOPE("GpuCalibration");
+	return mCalibratedTimestamps ? CalibrateWithExtension() : CalibrateWithSubmit();
+}
+
+bool GpuTracer::CalibrateWithExtension()
+{
+	VkCalibratedTimestampInfoEXT timestampInfos[2] = {};
+	timestampInfos[0].sType      = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+	timestampInfos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+	timestampInfos[1].sType      = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+	timestampInfos[1].timeDomain = mHostDomain;
+
+	u64 timestamps[2] = {};
+	u64 maxDeviation  = 0;
+	if (VulkanDispatch::vkGetCalibratedTimestampsEXT(
+				mDevice, 2, timestampInfos, timestamps, &maxDeviation
+		)
+		!= VK_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	mCalibrationTicks = timestamps[0] & mTimestampMask;
+	mCalibrationTime  = HostTimestampToNs(timestamps[1]);
+	return EXIT_SUCCESS;
+}
+
+bool GpuTracer::CalibrateWithSubmit()
+{
+	const u32 query = GetQueryIndex((u32)mFrames.size(), 0);
+
+	// An idle queue runs the timestamp as soon as it is submitted.
+	vkQueueWaitIdle(mQueue);
+
+	VulkanDispatch::vkResetCommandBuffer(mCommandBuffer, 0);
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if (VulkanDispatch::vkBeginCommandBuffer(mCommandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	VulkanDispatch::vkCmdResetQueryPool(mCommandBuffer, mQueryPool, query, 1);
+	VulkanDispatch::vkCmdWriteTimestamp(
+			mCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mQueryPool, query
+	);
+
+	if (VulkanDispatch::vkEndCommandBuffer(mCommandBuffer) != VK_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	VkSubmitInfo submitInfo       = {};
+	submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers    = &mCommandBuffer;
+
+	const u64 submitTime = Trace::Now();
+	if (VulkanDispatch::vkQueueSubmit(mQueue, 1, &submitInfo, mFence) != VK_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+	VulkanDispatch::vkWaitForFences(mDevice, 1, &mFence, VK_TRUE, UINT64_MAX);
+	const u64 completeTime = Trace::Now();
+
+	VulkanDispatch::vkResetFences(mDevice, 1, &mFence);
+
+	u64 ticks = 0;
+	if (VulkanDispatch::vkGetQueryPoolResults(
+				mDevice,
+				mQueryPool,
+				query,
+				1,
+				sizeof(ticks),
+				&ticks,
+				sizeof(ticks),
+				VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT
+		)
+		!= VK_SUCCESS)
+	{
+		return EXIT_FAILURE;
+	}
+
+	mCalibrationTicks = ticks & mTimestampMask;
+	mCalibrationTime  = submitTime + (completeTime - submitTime) / 2;
+	return EXIT_SUCCESS;
+}
+
+u64 GpuTracer::ToCpuTime(u64 ticks) const
+{
+	// Counters narrower than 64 bits wrap, ticks before the calibration end up in the upper half.
+	const u64  delta  = (ticks - mCalibrationTicks) & mTimestampMask;
+	const bool before = delta > (mTimestampMask >> 1);
+
+	const u64 distance = before ? (mCalibrationTicks - ticks) & mTimestampMask : delta;
+	const u64 ns       = (u64)((f64)distance * mTimestampPeriod);
+
+	return before ? mCalibrationTime - ns : mCalibrationTime + ns;
+}
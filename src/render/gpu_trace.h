@@ -0,0 +1,143 @@
+#ifndef HEADER_GPU_TRACE_H
+#define HEADER_GPU_TRACE_H
+
+#include "definitions.h"
+#include "utils/trace.h"
+#include "vulkan/vulkan_core.h"
+
+#include <vector>
+
+/* GPU scopes of the trace (utils/trace.h): timestamp queries around command buffer ranges, read
+ * back once the frame's fence has been waited and added on the CPU timeline.
+ *
+ * Each frame in flight owns a range of one query pool. BeginFrame reads what the range captured
+ * the last time the frame was recorded and resets it, scopes are only written while a capture
+ * runs. GPU ticks are mapped to Trace::Now() through a calibration point refreshed every
+ * kCalibrationInterval frames, as the two clocks drift apart. With VK_EXT_calibrated_timestamps
+ * both clocks are sampled at once; without it the queue is drained and a lone timestamp is
+ * matched to the middle of the CPU time spent submitting and waiting for it, which is only as
+ * exact as the submit and wake-up latencies are symmetric. */
+class GpuTracer
+{
+public:
+	static constexpr u32 kMaxScopesPerFrame = 64;
+
+	// In frames, only counted while capturing.
+	static constexpr u32 kCalibrationInterval = 600;
+
+	static constexpr u32 kInvalidScope = ~0u;
+
+public:
+	/* calibratedTimestamps: VK_EXT_calibrated_timestamps is enabled on the device. Leaves the
+	 * tracer disabled (every call a no-op) when the queue family has no timestamp support. */
+	bool Init(
+			VkPhysicalDevice             physicalDevice,
+			VkDevice                     device,
+			VkQueue                      queue,
+			u32                          queueFamily,
+			u32                          frameCount,
+			bool                         calibratedTimestamps,
+			const VkAllocationCallbacks *allocator
+	);
+
+	void Destroy();
+
+	/* Right after vkBeginCommandBuffer, once the frame's previous submission is known to be
+	 * complete. Outside render passes. */
+	void BeginFrame(VkCommandBuffer commandBuffer, u32 frameIndex);
+
+	// kInvalidScope when not capturing or out of queries, such a scope is not ended.
+	u32 BeginScope(VkCommandBuffer commandBuffer, const char *name);
+
+	void EndScope(VkCommandBuffer commandBuffer, u32 scope);
+
+	// Adds the scopes of every frame, call with the device idle before stopping the capture.
+	void CollectAll();
+
+private:
+	struct FrameQueries
+	{
+		const char *names[kMaxScopesPerFrame] = {};
+		u32         scopeCount                = 0;
+		bool        recorded                  = false;// Queries reset and written last time
+	};
+
+	void Collect(u32 frameIndex);
+
+	bool Calibrate();
+
+	bool CalibrateWithExtension();
+
+	bool CalibrateWithSubmit();
+
+	// Ticks to Trace::Now() nanoseconds, relative to the last calibration.
+	[[nodiscard]] u64 ToCpuTime(u64 ticks) const;
+
+private:
+	VkDevice                     mDevice      = VK_NULL_HANDLE;
+	VkQueue                      mQueue       = VK_NULL_HANDLE;
+	u32                          mQueueFamily = 0;
+	const VkAllocationCallbacks *mAllocator   = nullptr;
+
+	bool mEnabled = false;
+
+	VkQueryPool               mQueryPool = VK_NULL_HANDLE;
+	std::vector<FrameQueries> mFrames;
+	std::vector<u64>          mResults;// One frame of readback
+	u32                       mCurrentFrame = 0;
+
+	f64 mTimestampPeriod = 1.0;// Nanoseconds per tick
+	u64 mTimestampMask   = ~0ull;
+
+	bool            mCalibratedTimestamps   = false;
+	VkTimeDomainEXT mHostDomain             = VK_TIME_DOMAIN_DEVICE_EXT;
+	u64             mCalibrationTicks       = 0;
+	u64             mCalibrationTime        = 0;
+	u32             mFramesSinceCalibration = kCalibrationInterval;
+
+	// Fallback calibration, the timestamp uses the query after the frame ranges.
+	VkCommandPool   mCommandPool   = VK_NULL_HANDLE;
+	VkCommandBuffer mCommandBuffer = VK_NULL_HANDLE;
+	VkFence         mFence         = VK_NULL_HANDLE;
+};
+
+class GpuTraceScope
+{
+public:
+	// tracer can be nullptr.
+	GpuTraceScope(GpuTracer *tracer, VkCommandBuffer commandBuffer, const char *name)
+		: mTracer(tracer)
+		, mCommandBuffer(commandBuffer)
+		, mScope(GpuTracer::kInvalidScope)
+	{
+		if (tracer != nullptr)
+		{
+			mScope = tracer->BeginScope(commandBuffer, name);
+		}
+	}
+
+	~GpuTraceScope()
+	{
+		if (mScope != GpuTracer::kInvalidScope)
+		{
+			mTracer->EndScope(mCommandBuffer, mScope);
+		}
+	}
+
+	GpuTraceScope(const GpuTraceScope &)            = delete;
+	GpuTraceScope &operator=(const GpuTraceScope &) = delete;
+
+private:
+	GpuTracer      *mTracer;
+	VkCommandBuffer mCommandBuffer;
+	u32             mScope;
+};
+
+#ifdef COV_DISABLE_TRACING
+#define COV_TRACE_GPU_SCOPE(tracer, commandBuffer, name)
+#else
+#define COV_TRACE_GPU_SCOPE(tracer, commandBuffer, name)                                           \
+	GpuTraceScope COV_TRACE_CONCAT(gpuTraceScope, __LINE__)(tracer, commandBuffer, name)
+#endif
+
+#endif// HEADER_GPU_TRACE_H
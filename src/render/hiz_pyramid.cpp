@@ -0,0 +1,632 @@
+#include "hiz_pyramid.h"
+
+#include "render/pipeline_layout_cache.h"
+#include "render/vk_dispatch.h"
+#include "render/vk_utils.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+constexpr VkFormat kPyramidFormat = VK_FORMAT_R32_SFLOAT;
+
+// Build set: depth, every mip and the workgroup counter. Cull set: both pyramids.
+constexpr u32 kBuildSamplerCount = 1;
+constexpr u32 kCullSamplerCount  = 2;
+
+static u32 NextPowerOfTwo(u32 value)
+{
+	u32 result = 1;
+	while (result < value)
+	{
+		result <<= 1;
+	}
+	return result;
+}
+
+static std::optional<VkImageView> CreateMipView(
+		VkDevice                     device,
+		VkImage                      image,
+		u32                          baseMip,
+		u32                          mipCount,
+		const VkAllocationCallbacks *allocator
+)
+{
+	VkImageViewCreateInfo createInfo = {};
+
+	createInfo.sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	createInfo.image    = image;
+	createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	createInfo.format   = kPyramidFormat;
+
+	createInfo.subresourceRange.aspectMask   = VK_IMAGE_ASPECT_COLOR_BIT;
+	createInfo.subresourceRange.baseMipLevel = baseMip;
+	createInfo.subresourceRange.levelCount   = mipCount;
+	createInfo.subresourceRange.layerCount   = 1;
+
+	VkImageView imageView;
+	if (vkCreateImageView(device, &createInfo, allocator, &imageView) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create a depth pyramid view.");
+		return std::nullopt;
+	}
+
+	return imageView;
+}
+
+bool HiZPyramid::Init(
+		VkDevice                     device,
+		VkPhysicalDevice             physicalDevice,
+		PipelineLayoutCache         &layoutCache,
+		VkShaderModule               buildModule,
+		const ShaderReflection      &buildReflection,
+		u32                          frameCount,
+		const VkAllocationCallbacks *allocator
+)
+{
+	mDevice         = device;
+	mPhysicalDevice = physicalDevice;
+	mLayoutCache    = &layoutCache;
+	mAllocator      = allocator;
+
+	// texelFetch only, filtering never applies.
+	VkSamplerCreateInfo samplerInfo = {};
+
+	samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter    = VK_FILTER_NEAREST;
+	samplerInfo.minFilter    = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod       = VK_LOD_CLAMP_NONE;
+
+	if (vkCreateSampler(mDevice, &samplerInfo, mAllocator, &mSampler) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create the depth pyramid sampler.");
+		return EXIT_FAILURE;
+	}
+
+	// One build and one culling set per frame.
+	VkDescriptorPoolSize poolSizes[3] = {};
+
+	poolSizes[0].type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[0].descriptorCount = frameCount * (kBuildSamplerCount + kCullSamplerCount);
+	poolSizes[1].type            = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	poolSizes[1].descriptorCount = frameCount * kMaxMips;
+	poolSizes[2].type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[2].descriptorCount = frameCount;
+
+	VkDescriptorPoolCreateInfo poolInfo = {};
+
+	poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.maxSets       = frameCount * 2;
+	poolInfo.poolSizeCount = (u32)std::size(poolSizes);
+	poolInfo.pPoolSizes    = poolSizes;
+
+	if (vkCreateDescriptorPool(mDevice, &poolInfo, mAllocator, &mDescriptorPool) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create the depth pyramid descriptor pool.");
+		return EXIT_FAILURE;
+	}
+
+	mFrames.resize(frameCount);
+	for (FrameResources &frame : mFrames)
+	{
+		if (CreateBuffer(
+					mDevice,
+					mPhysicalDevice,
+					sizeof(u32),
+					VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+					frame.counter,
+					frame.counterMemory
+			)
+			== EXIT_FAILURE)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+
+	return CreateBuildPipeline(buildModule, buildReflection);
+}
+
+void HiZPyramid::Destroy()
+{
+	if (mDevice == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	DestroyPyramids();
+	ReleaseDepth();
+
+	for (FrameResources &frame : mFrames)
+	{
+		vkDestroyBuffer(mDevice, frame.counter, mAllocator);
+		vkFreeMemory(mDevice, frame.counterMemory, mAllocator);
+	}
+	mFrames.clear();
+
+	vkDestroyPipeline(mDevice, mBuildPipeline, mAllocator);
+	vkDestroyDescriptorPool(mDevice, mDescriptorPool, mAllocator);
+	vkDestroySampler(mDevice, mSampler, mAllocator);
+
+	mBuildPipeline  = VK_NULL_HANDLE;
+	mDescriptorPool = VK_NULL_HANDLE;
+	mSampler        = VK_NULL_HANDLE;
+	mBuildLayout    = VK_NULL_HANDLE;
+	mCullLayout     = VK_NULL_HANDLE;
+	mDevice         = VK_NULL_HANDLE;
+}
+
+bool HiZPyramid::BindCullLayout(VkPipelineLayout pipelineLayout, u32 set)
+{
+	std::optional<VkDescriptorSetLayout> setLayout =
+			mLayoutCache->FindSetLayout(pipelineLayout, set);
+	if (!setLayout.has_value())
+	{
+		CLOG_ERR("Culling pipeline layout has no depth pyramid set.");
+		return EXIT_FAILURE;
+	}
+
+	mCullLayout = pipelineLayout;
+	mCullSet    = set;
+
+	for (FrameResources &frame : mFrames)
+	{
+		VkDescriptorSetAllocateInfo allocInfo = {};
+
+		allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool     = mDescriptorPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts        = &setLayout.value();
+
+		if (vkAllocateDescriptorSets(mDevice, &allocInfo, &frame.cullSet) != VK_SUCCESS)
+		{
+			CLOG_ERR("Failed to allocate a depth pyramid culling set.");
+			return EXIT_FAILURE;
+		}
+	}
+
+	WriteSets();
+	return EXIT_SUCCESS;
+}
+
+bool HiZPyramid::Resize(VkImage depthImage, VkFormat depthFormat, VkExtent2D extent)
+{
+	DestroyPyramids();
+	ReleaseDepth();
+
+	/* A power of two mip 0 halves exactly down the chain, so a level l texel always covers
+	 * 2^(l + 1) pixels and every level covers the whole depth image. With Vulkan's floored mip
+	 * sizes the last row and column of pixels would drop out of odd sized levels. */
+	mDepthExtent       = extent;
+	mMip0Extent.width  = NextPowerOfTwo((extent.width + 1) / 2);
+	mMip0Extent.height = NextPowerOfTwo((extent.height + 1) / 2);
+	mSupported         = extent.width <= kMaxDepthExtent && extent.height <= kMaxDepthExtent;
+
+	const u32 mip0Size = std::max(mMip0Extent.width, mMip0Extent.height);
+
+	mMipCount = 1;
+	while (mMipCount < kMaxMips && (mip0Size >> mMipCount) > 0)
+	{
+		++mMipCount;
+	}
+
+	if (!mSupported)
+	{
+		CLOG_WARN(
+				"Depth extent ",
+				extent.width,
+				"x",
+				extent.height,
+				" is too large for the depth pyramid, occlusion culling is off."
+		);
+	}
+
+	// The sampled view skips stencil, combined formats cannot sample both aspects at once.
+	std::optional<VkImageView> depthView =
+			CreateImageView(mDevice, depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+	if (!depthView.has_value())
+	{
+		return EXIT_FAILURE;
+	}
+	mDepthView = depthView.value();
+
+	for (FrameResources &frame : mFrames)
+	{
+		if (CreatePyramid(frame) == EXIT_FAILURE)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+	mUndefined = true;
+
+	WriteSets();
+	return EXIT_SUCCESS;
+}
+
+void HiZPyramid::ReleaseDepth()
+{
+	if (mDepthView == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	vkDestroyImageView(mDevice, mDepthView, mAllocator);
+	mDepthView = VK_NULL_HANDLE;
+}
+
+bool HiZPyramid::HasHistory(u32 frameIndex) const
+{
+	const u32 frameCount = (u32)mFrames.size();
+	return mFrames[(frameIndex + frameCount - 1) % frameCount].built;
+}
+
+void HiZPyramid::BindForCulling(VkCommandBuffer commandBuffer, u32 frameIndex)
+{
+	if (mUndefined)
+	{
+		VkImageMemoryBarrier2KHR layoutBarrier = {};
+
+		layoutBarrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+		layoutBarrier.srcStageMask        = VK_PIPELINE_STAGE_2_NONE_KHR;
+		layoutBarrier.dstStageMask        = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+		layoutBarrier.dstAccessMask       = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR;
+		layoutBarrier.oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+		layoutBarrier.newLayout           = VK_IMAGE_LAYOUT_GENERAL;
+		layoutBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		layoutBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+		layoutBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		layoutBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+		layoutBarrier.subresourceRange.layerCount = 1;
+
+		VkDependencyInfoKHR dependencyInfo     = {};
+		dependencyInfo.sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+		dependencyInfo.imageMemoryBarrierCount = 1;
+		dependencyInfo.pImageMemoryBarriers    = &layoutBarrier;
+
+		for (const FrameResources &frame : mFrames)
+		{
+			layoutBarrier.image = frame.pyramid;
+			VulkanDispatch::vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+		}
+		mUndefined = false;
+	}
+
+	VulkanDispatch::vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			mCullLayout,
+			mCullSet,
+			1,
+			&mFrames[frameIndex].cullSet,
+			0,
+			nullptr
+	);
+}
+
+void HiZPyramid::RecordBuild(VkCommandBuffer commandBuffer, u32 frameIndex)
+{
+	// Culling moves the pyramids out of UNDEFINED before any build.
+	if (!mSupported || mUndefined)
+	{
+		return;
+	}
+
+	FrameResources &frame = mFrames[frameIndex];
+
+	// The pyramid stays in GENERAL, so memory barriers cover it. Earlier culling has to be done
+	// sampling it and the previous build with the counter.
+	VkMemoryBarrier2KHR barrier = {};
+	barrier.sType               = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+	barrier.srcStageMask        = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+	barrier.srcAccessMask       = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR;
+	barrier.dstStageMask        = VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR;
+	barrier.dstAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR;
+
+	VkDependencyInfoKHR dependencyInfo = {};
+	dependencyInfo.sType               = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+	dependencyInfo.memoryBarrierCount  = 1;
+	dependencyInfo.pMemoryBarriers     = &barrier;
+
+	VulkanDispatch::vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+	VulkanDispatch::vkCmdFillBuffer(commandBuffer, frame.counter, 0, VK_WHOLE_SIZE, 0);
+
+	barrier.srcStageMask = VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR
+						 | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+	barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR;
+	barrier.dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+	barrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR
+						  | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR;
+
+	VulkanDispatch::vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+
+	const u32 groupsX = (mMip0Extent.width + kTileSize - 1) / kTileSize;
+	const u32 groupsY = (mMip0Extent.height + kTileSize - 1) / kTileSize;
+
+	PushConstants pushConstants  = {};
+	pushConstants.depthSize      = {mDepthExtent.width, mDepthExtent.height};
+	pushConstants.mipCount       = mMipCount;
+	pushConstants.workgroupCount = groupsX * groupsY;
+
+	VulkanDispatch::vkCmdBindPipeline(
+			commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mBuildPipeline
+	);
+	VulkanDispatch::vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			mBuildLayout,
+			0,
+			1,
+			&frame.buildSet,
+			0,
+			nullptr
+	);
+	VulkanDispatch::vkCmdPushConstants(
+			commandBuffer,
+			mBuildLayout,
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			0,
+			sizeof(PushConstants),
+			&pushConstants
+	);
+	VulkanDispatch::vkCmdDispatch(commandBuffer, groupsX, groupsY, 1);
+
+	// Culling of this frame's late phase and of the next frame samples it.
+	barrier.srcStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+	barrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR;
+	barrier.dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+	barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR;
+
+	VulkanDispatch::vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+
+	frame.built = true;
+	++mBuilds;
+}
+
+void HiZPyramid::LogStats() const
+{
+	if (mBuilds == 0)
+	{
+		return;
+	}
+
+	CLOG_INFO(
+			"Depth pyramid: ",
+			mBuilds,
+			" builds, ",
+			mMipCount,
+			" mips from ",
+			mMip0Extent.width,
+			"x",
+			mMip0Extent.height,
+			"."
+	);
+}
+
+bool HiZPyramid::CreateBuildPipeline(
+		VkShaderModule          buildModule,
+		const ShaderReflection &buildReflection
+)
+{
+	const ShaderReflection *stages[] = {&buildReflection};
+
+	std::optional<VkPipelineLayout> layout = mLayoutCache->GetPipelineLayout(stages, 1);
+	if (!layout.has_value())
+	{
+		CLOG_ERR("Depth pyramid pipeline layout creation failed.");
+		return EXIT_FAILURE;
+	}
+	mBuildLayout = layout.value();
+
+	VkComputePipelineCreateInfo pipelineInfo = {};
+
+	pipelineInfo.sType        = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = buildModule;
+	pipelineInfo.stage.pName  = "main";
+	pipelineInfo.layout       = mBuildLayout;
+
+	if (vkCreateComputePipelines(
+				mDevice, VK_NULL_HANDLE, 1, &pipelineInfo, mAllocator, &mBuildPipeline
+		)
+		!= VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create the depth pyramid pipeline.");
+		return EXIT_FAILURE;
+	}
+
+	std::optional<VkDescriptorSetLayout> setLayout = mLayoutCache->FindSetLayout(mBuildLayout, 0);
+	if (!setLayout.has_value())
+	{
+		CLOG_ERR("Depth pyramid shader declares no descriptor set.");
+		return EXIT_FAILURE;
+	}
+
+	for (FrameResources &frame : mFrames)
+	{
+		VkDescriptorSetAllocateInfo allocInfo = {};
+
+		allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool     = mDescriptorPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts        = &setLayout.value();
+
+		if (vkAllocateDescriptorSets(mDevice, &allocInfo, &frame.buildSet) != VK_SUCCESS)
+		{
+			CLOG_ERR("Failed to allocate a depth pyramid build set.");
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+bool HiZPyramid::CreatePyramid(FrameResources &frame)
+{
+	VkImageCreateInfo imageInfo = {};
+
+	imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+	imageInfo.format        = kPyramidFormat;
+	imageInfo.extent        = {mMip0Extent.width, mMip0Extent.height, 1};
+	imageInfo.mipLevels     = mMipCount;
+	imageInfo.arrayLayers   = 1;
+	imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage         = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	if (vkCreateImage(mDevice, &imageInfo, mAllocator, &frame.pyramid) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create a depth pyramid image.");
+		return EXIT_FAILURE;
+	}
+
+	VkMemoryRequirements requirements = {};
+	vkGetImageMemoryRequirements(mDevice, frame.pyramid, &requirements);
+
+	std::optional<u32> memoryType = FindMemoryType(
+			mPhysicalDevice, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+	);
+	if (!memoryType.has_value())
+	{
+		CLOG_ERR("No memory type for the depth pyramid.");
+		return EXIT_FAILURE;
+	}
+
+	VkMemoryAllocateInfo allocInfo = {};
+
+	allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize  = requirements.size;
+	allocInfo.memoryTypeIndex = memoryType.value();
+
+	if (vkAllocateMemory(mDevice, &allocInfo, mAllocator, &frame.pyramidMemory) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to allocate depth pyramid memory.");
+		return EXIT_FAILURE;
+	}
+	vkBindImageMemory(mDevice, frame.pyramid, frame.pyramidMemory, 0);
+
+	std::optional<VkImageView> view =
+			CreateMipView(mDevice, frame.pyramid, 0, mMipCount, mAllocator);
+	if (!view.has_value())
+	{
+		return EXIT_FAILURE;
+	}
+	frame.pyramidView = view.value();
+
+	for (u32 mip = 0; mip < mMipCount; ++mip)
+	{
+		view = CreateMipView(mDevice, frame.pyramid, mip, 1, mAllocator);
+		if (!view.has_value())
+		{
+			return EXIT_FAILURE;
+		}
+		frame.mipViews[mip] = view.value();
+	}
+
+	frame.built = false;
+	return EXIT_SUCCESS;
+}
+
+void HiZPyramid::DestroyPyramids()
+{
+	for (FrameResources &frame : mFrames)
+	{
+		for (VkImageView &mipView : frame.mipViews)
+		{
+			vkDestroyImageView(mDevice, mipView, mAllocator);
+			mipView = VK_NULL_HANDLE;
+		}
+		vkDestroyImageView(mDevice, frame.pyramidView, mAllocator);
+		vkDestroyImage(mDevice, frame.pyramid, mAllocator);
+		vkFreeMemory(mDevice, frame.pyramidMemory, mAllocator);
+
+		frame.pyramidView   = VK_NULL_HANDLE;
+		frame.pyramid       = VK_NULL_HANDLE;
+		frame.pyramidMemory = VK_NULL_HANDLE;
+		frame.built         = false;
+	}
+	mUndefined = false;
+}
+
+void HiZPyramid::WriteSets()
+{
+	if (mDepthView == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	const u32 frameCount = (u32)mFrames.size();
+	for (u32 i = 0; i < frameCount; ++i)
+	{
+		FrameResources &frame = mFrames[i];
+
+		VkDescriptorImageInfo depthInfo = {};
+		depthInfo.sampler               = mSampler;
+		depthInfo.imageView             = mDepthView;
+		depthInfo.imageLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		// Bindings past the last mip repeat it, the shader never writes them.
+		VkDescriptorImageInfo mipInfos[kMaxMips] = {};
+		for (u32 mip = 0; mip < kMaxMips; ++mip)
+		{
+			mipInfos[mip].imageView   = frame.mipViews[std::min(mip, mMipCount - 1)];
+			mipInfos[mip].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		}
+
+		VkDescriptorBufferInfo counterInfo = {};
+		counterInfo.buffer                 = frame.counter;
+		counterInfo.offset                 = 0;
+		counterInfo.range                  = VK_WHOLE_SIZE;
+
+		// The frame before culls against the previous pyramid, the frame's own is current.
+		VkDescriptorImageInfo pyramidInfos[kCullSamplerCount] = {};
+		pyramidInfos[0].sampler     = mSampler;
+		pyramidInfos[0].imageView   = mFrames[(i + frameCount - 1) % frameCount].pyramidView;
+		pyramidInfos[0].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		pyramidInfos[1].sampler     = mSampler;
+		pyramidInfos[1].imageView   = frame.pyramidView;
+		pyramidInfos[1].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkWriteDescriptorSet writes[4] = {};
+
+		writes[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[0].dstSet          = frame.buildSet;
+		writes[0].dstBinding      = 0;
+		writes[0].descriptorCount = kBuildSamplerCount;
+		writes[0].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].pImageInfo      = &depthInfo;
+
+		writes[1].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[1].dstSet          = frame.buildSet;
+		writes[1].dstBinding      = 1;
+		writes[1].descriptorCount = kMaxMips;
+		writes[1].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writes[1].pImageInfo      = mipInfos;
+
+		writes[2].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[2].dstSet          = frame.buildSet;
+		writes[2].dstBinding      = 2;
+		writes[2].descriptorCount = 1;
+		writes[2].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[2].pBufferInfo     = &counterInfo;
+
+		// Both pyramids sit at consecutive bindings, one write fills them.
+		writes[3].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[3].dstSet          = frame.cullSet;
+		writes[3].dstBinding      = 0;
+		writes[3].descriptorCount = kCullSamplerCount;
+		writes[3].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[3].pImageInfo      = pyramidInfos;
+
+		const u32 writeCount = frame.cullSet != VK_NULL_HANDLE ? 4 : 3;
+		vkUpdateDescriptorSets(mDevice, writeCount, writes, 0, nullptr);
+	}
+}
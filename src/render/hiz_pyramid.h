@@ -0,0 +1,134 @@
+#ifndef HEADER_HIZ_PYRAMID_H
+#define HEADER_HIZ_PYRAMID_H
+
+#include "definitions.h"
+#include "pch/glm.h"
+#include "render/spirv_reflect.h"
+#include "vulkan/vulkan_core.h"
+
+#include <vector>
+
+class PipelineLayoutCache;
+
+/* Farthest depth pyramids for occlusion culling, one per frame in flight.
+ *
+ * Mip 0 is half the depth resolution rounded up to a power of two, and every texel holds the
+ * farthest depth of the pixels it covers, so bounds whose nearest point lies behind every texel
+ * they overlap are hidden. Texels past the edge of the depth image are never sampled.
+ * hiz_build_comp.glsl builds all mips in a single dispatch. A frame builds its own pyramid from
+ * its depth and culls against the one of the frame before, which holds as long as the frame index
+ * advances by one per submitted frame.
+ *
+ * The pyramids are private and stay in GENERAL, their barriers are recorded here. The depth image
+ * belongs to the render graph: the build pass reads it as eComputeSampled and has to be marked
+ * with side effects. */
+class HiZPyramid
+{
+public:
+	// Matches kMaxMips of hiz_build_comp.glsl.
+	static constexpr u32 kMaxMips = 12;
+
+	// Largest depth extent one dispatch reduces down to a single texel, mip 0 of 2048.
+	static constexpr u32 kMaxDepthExtent = 4096;
+
+	// Mip 0 texels per workgroup along each axis.
+	static constexpr u32 kTileSize = 32;
+
+	// Matches BuildParams of hiz_build_comp.glsl.
+	struct PushConstants
+	{
+		glm::uvec2 depthSize;
+		u32        mipCount;
+		u32        workgroupCount;
+	};
+
+public:
+	// buildModule is hiz_build_comp.glsl, only used during the call.
+	bool Init(
+			VkDevice                     device,
+			VkPhysicalDevice             physicalDevice,
+			PipelineLayoutCache         &layoutCache,
+			VkShaderModule               buildModule,
+			const ShaderReflection      &buildReflection,
+			u32                          frameCount,
+			const VkAllocationCallbacks *allocator
+	);
+
+	void Destroy();
+
+	/* Allocates the per-frame sets of a compute pipeline layout whose set declares the previous
+	 * and the current pyramid, as meshlet_cull_comp.glsl does with HIZ_OCCLUSION. */
+	bool BindCullLayout(VkPipelineLayout pipelineLayout, u32 set);
+
+	/* Recreates the pyramids for a depth image with SAMPLED usage, which drops the history.
+	 * Depth extents past kMaxDepthExtent are never built, culling then never has a history. */
+	bool Resize(VkImage depthImage, VkFormat depthFormat, VkExtent2D extent);
+
+	// Destroys the view of the depth image, before the image itself is destroyed.
+	void ReleaseDepth();
+
+	// Whether the pyramid of the frame before frameIndex was built since the last Resize.
+	[[nodiscard]] bool HasHistory(u32 frameIndex) const;
+
+	/* Binds the pyramids for culling in the frame. Pyramids created since Resize are moved to
+	 * GENERAL first, culling shaders may declare them before they are ever built. */
+	void BindForCulling(VkCommandBuffer commandBuffer, u32 frameIndex);
+
+	// Builds the frame's pyramid from the depth image in SHADER_READ_ONLY_OPTIMAL.
+	void RecordBuild(VkCommandBuffer commandBuffer, u32 frameIndex);
+
+	void LogStats() const;
+
+private:
+	struct FrameResources
+	{
+		VkImage        pyramid            = VK_NULL_HANDLE;
+		VkDeviceMemory pyramidMemory      = VK_NULL_HANDLE;
+		VkImageView    pyramidView        = VK_NULL_HANDLE;// Every mip, for sampling
+		VkImageView    mipViews[kMaxMips] = {};            // One per mip, for storage
+		bool           built              = false;
+
+		// Counts finished workgroups, so the last one knows to reduce the remaining mips.
+		VkBuffer       counter       = VK_NULL_HANDLE;
+		VkDeviceMemory counterMemory = VK_NULL_HANDLE;
+
+		VkDescriptorSet buildSet = VK_NULL_HANDLE;
+		VkDescriptorSet cullSet  = VK_NULL_HANDLE;
+	};
+
+	bool CreateBuildPipeline(VkShaderModule buildModule, const ShaderReflection &buildReflection);
+
+	bool CreatePyramid(FrameResources &frame);
+	void DestroyPyramids();
+
+	// Writes the build sets and the cull sets allocated so far.
+	void WriteSets();
+
+private:
+	VkDevice                     mDevice         = VK_NULL_HANDLE;
+	VkPhysicalDevice             mPhysicalDevice = VK_NULL_HANDLE;
+	PipelineLayoutCache         *mLayoutCache    = nullptr;
+	const VkAllocationCallbacks *mAllocator      = nullptr;
+
+	VkSampler        mSampler        = VK_NULL_HANDLE;
+	VkDescriptorPool mDescriptorPool = VK_NULL_HANDLE;
+
+	VkPipelineLayout mBuildLayout   = VK_NULL_HANDLE;// Owned by mLayoutCache
+	VkPipeline       mBuildPipeline = VK_NULL_HANDLE;
+
+	VkPipelineLayout mCullLayout = VK_NULL_HANDLE;// Owned by mLayoutCache
+	u32              mCullSet    = 0;
+
+	VkImageView mDepthView   = VK_NULL_HANDLE;// Depth aspect only
+	VkExtent2D  mDepthExtent = {};
+	VkExtent2D  mMip0Extent  = {};
+	u32         mMipCount    = 0;
+	bool        mSupported   = false;
+	bool        mUndefined   = false;// Pyramids still in UNDEFINED
+
+	std::vector<FrameResources> mFrames;
+
+	u64 mBuilds = 0;
+};
+
+#endif// HEADER_HIZ_PYRAMID_H
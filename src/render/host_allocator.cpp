@@ -0,0 +1,425 @@
+#include "host_allocator.h"
+
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+/**************************************
+*       ACCOUNTING
+**************************************/
+
+struct ScopeStats
+{
+	std::atomic<u64> liveBytes{0};
+	std::atomic<u64> peakBytes{0};
+	std::atomic<u64> allocations{0};
+	std::atomic<u64> reallocations{0};
+	std::atomic<u64> frees{0};
+
+	// Memory the driver allocated itself and only reported through the notification callbacks.
+	std::atomic<u64> internalBytes{0};
+};
+
+static ScopeStats sScopeStats[HostAllocator::kScopeCount];
+
+constexpr const char *kScopeNames[HostAllocator::kScopeCount] = {
+		"Command",
+		"Object",
+		"Cache",
+		"Device",
+		"Instance",
+};
+
+static ScopeStats &GetScopeStats(u32 scope)
+{
+	return sScopeStats[std::min(scope, HostAllocator::kScopeCount - 1)];
+}
+
+static void RecordAllocation(u32 scope, u64 size)
+{
+	ScopeStats &stats = GetScopeStats(scope);
+
+	const u64 live = stats.liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+	stats.allocations.fetch_add(1, std::memory_order_relaxed);
+
+	u64 peak = stats.peakBytes.load(std::memory_order_relaxed);
+	while (live > peak
+		   && !stats.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+	{
+	}
+}
+
+static void RecordFree(u32 scope, u64 size)
+{
+	ScopeStats &stats = GetScopeStats(scope);
+
+	stats.liveBytes.fetch_sub(size, std::memory_order_relaxed);
+	stats.frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+/**************************************
+*       POOLS
+**************************************/
+
+// Placed right in front of every returned pointer.
+struct AllocationHeader
+{
+	u32 offset;// From the start of the block to the returned pointer
+	u16 sizeClass;
+	u16 scope;
+	u64 size;
+};
+
+static_assert(sizeof(AllocationHeader) == HostAllocator::kMinBlockSize);
+
+constexpr u16 kLargeSizeClass = 0xFFFF;
+
+struct SizeClassPool
+{
+	std::mutex          mutex;
+	void               *freeList    = nullptr;
+	u64                 blocksInUse = 0;
+	std::vector<void *> pages;
+};
+
+static SizeClassPool         sPools[HostAllocator::kSizeClassCount];
+static std::atomic<u64>      sLargeAllocations{0};
+static bool                  sEnabled   = false;
+static VkAllocationCallbacks sCallbacks = {};
+
+static void *AlignedAlloc(size_t alignment, size_t size)
+{
+#ifdef _WIN32
+	return _aligned_malloc(size, alignment);
+#else
+	return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+}
+
+static void AlignedFree(void *ptr)
+{
+#ifdef _WIN32
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
+static u32 GetBlockSize(u16 sizeClass)
+{
+	return HostAllocator::kMinBlockSize << sizeClass;
+}
+
+static u16 GetSizeClass(size_t size)
+{
+	u16 sizeClass = 0;
+	while (GetBlockSize(sizeClass) < size)
+	{
+		++sizeClass;
+	}
+
+	return sizeClass;
+}
+
+static void *PoolAllocate(u16 sizeClass)
+{
+	SizeClassPool              &pool = sPools[sizeClass];
+	std::lock_guard<std::mutex> lock(pool.mutex);
+
+	if (pool.freeList == nullptr)
+	{
+		// Pages are page size aligned, so every block is aligned to its own size.
+		constexpr u32 kPageSize = HostAllocator::kPageSize;
+
+		u8 *page = static_cast<u8 *>(AlignedAlloc(kPageSize, kPageSize));
+		if (page == nullptr)
+		{
+			return nullptr;
+		}
+		pool.pages.push_back(page);
+
+		const u32 blockSize = GetBlockSize(sizeClass);
+		for (u32 offset = kPageSize; offset >= blockSize; offset -= blockSize)
+		{
+			void *block                        = page + offset - blockSize;
+			*reinterpret_cast<void **>(block) = pool.freeList;
+			pool.freeList                      = block;
+		}
+	}
+
+	void *block   = pool.freeList;
+	pool.freeList = *reinterpret_cast<void **>(block);
+	++pool.blocksInUse;
+
+	return block;
+}
+
+static void PoolFree(u16 sizeClass, void *block)
+{
+	SizeClassPool              &pool = sPools[sizeClass];
+	std::lock_guard<std::mutex> lock(pool.mutex);
+
+	*reinterpret_cast<void **>(block) = pool.freeList;
+	pool.freeList                      = block;
+	--pool.blocksInUse;
+}
+
+
+/**************************************
+*       CALLBACKS
+**************************************/
+
+static AllocationHeader &GetHeader(void *ptr)
+{
+	u8 *header = static_cast<u8 *>(ptr) - sizeof(AllocationHeader);
+	return *reinterpret_cast<AllocationHeader *>(header);
+}
+
+static void *VKAPI_CALL Allocate(
+		void                   *,
+		size_t                  size,
+		size_t                  alignment,
+		VkSystemAllocationScope scope
+)
+{
+	if (size == 0)
+	{
+		return nullptr;
+	}
+
+	// The header sits in the padding in front of the pointer, which keeps the pointer aligned.
+	const size_t headerSpace = std::max<size_t>(alignment, sizeof(AllocationHeader));
+	const size_t totalSize   = size + headerSpace;
+
+	u8 *block     = nullptr;
+	u16 sizeClass = kLargeSizeClass;
+	if (totalSize <= HostAllocator::kMaxPooledSize)
+	{
+		sizeClass = GetSizeClass(totalSize);
+		block     = static_cast<u8 *>(PoolAllocate(sizeClass));
+	}
+	else
+	{
+		block = static_cast<u8 *>(AlignedAlloc(headerSpace, totalSize));
+		sLargeAllocations.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	if (block == nullptr)
+	{
+		return nullptr;
+	}
+
+	void             *ptr    = block + headerSpace;
+	AllocationHeader &header = GetHeader(ptr);
+	header.offset            = (u32)headerSpace;
+	header.sizeClass         = sizeClass;
+	header.scope             = (u16)scope;
+	header.size              = size;
+
+	RecordAllocation(scope, size);
+	return ptr;
+}
+
+static void VKAPI_CALL Free(void *, void *ptr)
+{
+	if (ptr == nullptr)
+	{
+		return;
+	}
+
+	const AllocationHeader header = GetHeader(ptr);
+	RecordFree(header.scope, header.size);
+
+	u8 *block = static_cast<u8 *>(ptr) - header.offset;
+	if (header.sizeClass == kLargeSizeClass)
+	{
+		AlignedFree(block);
+		sLargeAllocations.fetch_sub(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		PoolFree(header.sizeClass, block);
+	}
+}
+
+static void *VKAPI_CALL Reallocate(
+		void                   *userData,
+		void                   *original,
+		size_t                  size,
+		size_t                  alignment,
+		VkSystemAllocationScope scope
+)
+{
+	if (original == nullptr)
+	{
+		return Allocate(userData, size, alignment, scope);
+	}
+
+	if (size == 0)
+	{
+		Free(userData, original);
+		return nullptr;
+	}
+
+	AllocationHeader &header = GetHeader(original);
+	GetScopeStats(header.scope).reallocations.fetch_add(1, std::memory_order_relaxed);
+
+	// Pooled blocks are rounded up to a power of two, often the new size still fits.
+	const size_t headerSpace = std::max<size_t>(alignment, sizeof(AllocationHeader));
+	if (header.sizeClass != kLargeSizeClass && header.offset == headerSpace
+		&& size + headerSpace <= GetBlockSize(header.sizeClass))
+	{
+		RecordFree(header.scope, header.size);
+		RecordAllocation(scope, size);
+		header.scope = (u16)scope;
+		header.size  = size;
+		return original;
+	}
+
+	void *ptr = Allocate(userData, size, alignment, scope);
+	if (ptr == nullptr)
+	{
+		// The original allocation stays valid on failure.
+		return nullptr;
+	}
+
+	memcpy(ptr, original, std::min<size_t>(size, header.size));
+	Free(userData, original);
+
+	return ptr;
+}
+
+static void VKAPI_CALL InternalAllocation(
+		void                   *,
+		size_t                  size,
+		VkInternalAllocationType,
+		VkSystemAllocationScope scope
+)
+{
+	GetScopeStats(scope).internalBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+static void VKAPI_CALL InternalFree(
+		void                   *,
+		size_t                  size,
+		VkInternalAllocationType,
+		VkSystemAllocationScope scope
+)
+{
+	GetScopeStats(scope).internalBytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+
+/**************************************
+*       HOST ALLOCATOR
+**************************************/
+
+void HostAllocator::Init(bool enabled)
+{
+	sEnabled = enabled;
+
+	sCallbacks                       = {};
+	sCallbacks.pfnAllocation         = Allocate;
+	sCallbacks.pfnReallocation       = Reallocate;
+	sCallbacks.pfnFree               = Free;
+	sCallbacks.pfnInternalAllocation = InternalAllocation;
+	sCallbacks.pfnInternalFree       = InternalFree;
+
+	CLOG_INFO(enabled ? "Using pooled Vulkan host allocator." : "Using driver host allocator.");
+}
+
+void HostAllocator::Shutdown()
+{
+	for (u32 scope = 0; scope < kScopeCount; ++scope)
+	{
+		const u64 liveBytes = sScopeStats[scope].liveBytes.load(std::memory_order_relaxed);
+		if (liveBytes > 0)
+		{
+			CLOG_WARN("Driver leaked ", liveBytes, " bytes of ", kScopeNames[scope], " memory.");
+		}
+	}
+
+	for (SizeClassPool &pool : sPools)
+	{
+		std::lock_guard<std::mutex> lock(pool.mutex);
+
+		// Blocks still in use belong to leaked allocations, their pages are kept alive.
+		if (pool.blocksInUse > 0)
+		{
+			continue;
+		}
+
+		for (void *page : pool.pages)
+		{
+			AlignedFree(page);
+		}
+		pool.pages.clear();
+		pool.freeList = nullptr;
+	}
+}
+
+const VkAllocationCallbacks *HostAllocator::GetCallbacks()
+{
+	return sEnabled ? &sCallbacks : nullptr;
+}
+
+void HostAllocator::LogReport()
+{
+	if (!sEnabled)
+	{
+		return;
+	}
+
+	CLOG_INFO("Vulkan host memory by scope:");
+	for (u32 scope = 0; scope < kScopeCount; ++scope)
+	{
+		const ScopeStats &stats = sScopeStats[scope];
+		CLOG_INFO(
+				"  ",
+				kScopeNames[scope],
+				": live ",
+				stats.liveBytes.load(std::memory_order_relaxed) / 1024,
+				" KB, peak ",
+				stats.peakBytes.load(std::memory_order_relaxed) / 1024,
+				" KB, ",
+				stats.allocations.load(std::memory_order_relaxed),
+				" allocations, ",
+				stats.reallocations.load(std::memory_order_relaxed),
+				" reallocations, ",
+				stats.frees.load(std::memory_order_relaxed),
+				" frees, internal ",
+				stats.internalBytes.load(std::memory_order_relaxed) / 1024,
+				" KB."
+		);
+	}
+
+	for (u16 sizeClass = 0; sizeClass < kSizeClassCount; ++sizeClass)
+	{
+		SizeClassPool              &pool = sPools[sizeClass];
+		std::lock_guard<std::mutex> lock(pool.mutex);
+
+		if (pool.pages.empty())
+		{
+			continue;
+		}
+
+		CLOG_INFO(
+				"  Pool ",
+				GetBlockSize(sizeClass),
+				" B: ",
+				pool.pages.size(),
+				" pages, ",
+				pool.blocksInUse,
+				" blocks in use."
+		);
+	}
+
+	const u64 largeAllocations = sLargeAllocations.load(std::memory_order_relaxed);
+	CLOG_INFO("  Large allocations alive: ", largeAllocations, ".");
+}
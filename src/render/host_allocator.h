@@ -0,0 +1,44 @@
+#ifndef HEADER_HOST_ALLOCATOR_H
+#define HEADER_HOST_ALLOCATOR_H
+
+#include "definitions.h"
+#include "vulkan/vulkan_core.h"
+
+/* VkAllocationCallbacks for the driver's host memory.
+ *
+ * Requests up to kMaxPooledSize bytes (header and alignment included) are served from power of
+ * two size classes, each a free list over 64 KB pages, so the many small, short-lived
+ * allocations drivers make during object creation and command recording stop hitting malloc.
+ * Bigger requests go to the aligned C allocator. Every allocation carries a small header with its
+ * size class and VkSystemAllocationScope, which feeds the per-scope accounting in LogReport().
+ *
+ * Pass GetCallbacks() as pAllocator to every vkCreate / vkDestroy / vkAllocate / vkFree call; an
+ * object has to be destroyed with the same callbacks it was created with. */
+class HostAllocator
+{
+public:
+	static constexpr u32 kMinBlockSize   = 16;
+	static constexpr u32 kMaxPooledSize  = 4096;
+	static constexpr u32 kSizeClassCount = 9;// 16, 32, ... 4096
+	static constexpr u32 kPageSize       = 64 * 1024;
+
+	static_assert(kMinBlockSize << (kSizeClassCount - 1) == kMaxPooledSize);
+
+	// Scopes reported by LogReport(), VkSystemAllocationScope values index into it.
+	static constexpr u32 kScopeCount = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+public:
+	/* When disabled, GetCallbacks() returns nullptr and the driver uses its own allocator. Has to
+	 * be called before the instance is created and not changed afterwards. */
+	static void Init(bool enabled);
+
+	// Releases the pools, call after the instance is destroyed.
+	static void Shutdown();
+
+	[[nodiscard]] static const VkAllocationCallbacks *GetCallbacks();
+
+	// Driver host memory by allocation scope and pool usage.
+	static void LogReport();
+};
+
+#endif// HEADER_HOST_ALLOCATOR_H
@@ -0,0 +1,402 @@
+#include "mesh.h"
+
+#include "render/mesh_simplify.h"
+#include "render/vk_dispatch.h"
+#include "render/vk_utils.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+
+// Simplification giving back less than this share of the previous LOD's triangles ends the chain.
+constexpr f32 kMinLodReduction = 0.05f;
+
+MeshData ImportMesh(
+		std::vector<glm::vec3> positions,
+		std::vector<u32>       indices,
+		const MeshLodSettings &settings
+)
+{
+	MeshData mesh;
+	mesh.positions = std::move(positions);
+	mesh.indices   = std::move(indices);
+
+	for (const glm::vec3 &position : mesh.positions)
+	{
+		mesh.radius = std::max(mesh.radius, glm::length(position));
+	}
+
+	const u32 baseIndexCount = (u32)mesh.indices.size();
+
+	mesh.lods[0].indexCount = baseIndexCount;
+	mesh.lodCount           = 1;
+
+	const u32 maxLods = std::clamp(settings.maxLods, 1u, kMaxMeshLods);
+
+	std::vector<u32> simplified(baseIndexCount);
+	while (mesh.lodCount < maxLods)
+	{
+		const MeshLod &previous = mesh.lods[mesh.lodCount - 1];
+
+		const u32 targetTriangles = (u32)((f32)(previous.indexCount / 3) * settings.triangleRatio);
+		if (targetTriangles < settings.minTriangles)
+		{
+			break;
+		}
+
+		f32       error      = 0.0f;
+		const u32 indexCount = SimplifyMesh(
+				mesh.positions.data(),
+				(u32)mesh.positions.size(),
+				mesh.indices.data(),
+				baseIndexCount,
+				targetTriangles * 3,
+				simplified.data(),
+				&error
+		);
+
+		if ((f32)indexCount > (f32)previous.indexCount * (1.0f - kMinLodReduction))
+		{
+			break;
+		}
+
+		MeshLod &lod   = mesh.lods[mesh.lodCount++];
+		lod.firstIndex = (u32)mesh.indices.size();
+		lod.indexCount = indexCount;
+		lod.error      = std::max(error, previous.error);
+
+		mesh.indices.insert(
+				mesh.indices.end(), simplified.begin(), simplified.begin() + indexCount
+		);
+	}
+
+	for (u32 i = 0; i < mesh.lodCount; ++i)
+	{
+		MeshLod &lod = mesh.lods[i];
+
+		lod.firstMeshlet = (u32)mesh.meshlets.size();
+		BuildMeshlets(
+				mesh.positions.data(),
+				(u32)mesh.positions.size(),
+				mesh.indices.data() + lod.firstIndex,
+				lod.indexCount,
+				mesh.meshlets,
+				mesh.meshletVertices,
+				mesh.meshletTriangles
+		);
+		lod.meshletCount = (u32)mesh.meshlets.size() - lod.firstMeshlet;
+
+		CLOG_INFO(
+				"Mesh LOD ",
+				i,
+				": ",
+				lod.indexCount / 3,
+				" triangles in ",
+				lod.meshletCount,
+				" meshlets, error ",
+				lod.error
+		);
+	}
+
+	return mesh;
+}
+
+void CreateBlobMesh(
+		u32                     subdivisions,
+		std::vector<glm::vec3> &positions,
+		std::vector<u32>       &indices
+)
+{
+	const f32 t = (1.0f + std::sqrt(5.0f)) * 0.5f;
+
+	positions = {
+			{-1.0f, t, 0.0f},
+			{1.0f, t, 0.0f},
+			{-1.0f, -t, 0.0f},
+			{1.0f, -t, 0.0f},
+			{0.0f, -1.0f, t},
+			{0.0f, 1.0f, t},
+			{0.0f, -1.0f, -t},
+			{0.0f, 1.0f, -t},
+			{t, 0.0f, -1.0f},
+			{t, 0.0f, 1.0f},
+			{-t, 0.0f, -1.0f},
+			{-t, 0.0f, 1.0f},
+	};
+
+	indices = {
+			0, 11, 5,  0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
+			1, 5,  9,  5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+			3, 9,  4,  3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
+			4, 9,  5,  2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1,
+	};
+
+	for (glm::vec3 &position : positions)
+	{
+		position = glm::normalize(position);
+	}
+
+	// Each subdivision splits a triangle in four at its edge midpoints, shared between neighbours.
+	std::unordered_map<u64, u32> midpoints;
+	auto                         midpoint = [&](u32 a, u32 b)
+	{
+		const u64 key = a < b ? ((u64)a << 32) | b : ((u64)b << 32) | a;
+
+		auto [it, inserted] = midpoints.try_emplace(key, (u32)positions.size());
+		if (inserted)
+		{
+			positions.push_back(glm::normalize(positions[a] + positions[b]));
+		}
+		return it->second;
+	};
+
+	for (u32 level = 0; level < subdivisions; ++level)
+	{
+		std::vector<u32> subdivided;
+		subdivided.reserve(indices.size() * 4);
+
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			const u32 a  = indices[i + 0];
+			const u32 b  = indices[i + 1];
+			const u32 c  = indices[i + 2];
+			const u32 ab = midpoint(a, b);
+			const u32 bc = midpoint(b, c);
+			const u32 ca = midpoint(c, a);
+
+			subdivided.insert(subdivided.end(), {a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca});
+		}
+
+		indices = std::move(subdivided);
+		midpoints.clear();
+	}
+
+	// Low frequency lumps, fixed so that every run imports the same mesh.
+	for (glm::vec3 &position : positions)
+	{
+		const f32 lumps = std::sin(position.x * 5.0f) * std::sin(position.y * 4.0f + 1.0f)
+						* std::sin(position.z * 3.0f + 2.0f);
+		position *= 0.5f * (1.0f + 0.2f * lumps);
+	}
+
+	// The icosahedron winds outwards, front faces have to wind inwards (see mesh.h).
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		const glm::vec3 &a = positions[indices[i + 0]];
+		const glm::vec3 &b = positions[indices[i + 1]];
+		const glm::vec3 &c = positions[indices[i + 2]];
+
+		if (glm::dot(glm::cross(b - a, c - a), a + b + c) > 0.0f)
+		{
+			std::swap(indices[i + 1], indices[i + 2]);
+		}
+	}
+}
+
+VkPipelineVertexInputStateCreateInfo MeshVertexInput::GetCreateInfo() const
+{
+	VkPipelineVertexInputStateCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+	createInfo.vertexBindingDescriptionCount   = (u32)std::size(bindings);
+	createInfo.pVertexBindingDescriptions      = bindings;
+	createInfo.vertexAttributeDescriptionCount = attributeCount;
+	createInfo.pVertexAttributeDescriptions    = attributes;
+
+	return createInfo;
+}
+
+bool BuildMeshVertexInput(
+		const ShaderReflection &vertReflection,
+		u32                     instanceStride,
+		MeshVertexInput        &vertexInput
+)
+{
+	vertexInput = {};
+
+	vertexInput.bindings[0].binding   = 0;
+	vertexInput.bindings[0].stride    = sizeof(glm::vec3);
+	vertexInput.bindings[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+	vertexInput.bindings[1].binding   = 1;
+	vertexInput.bindings[1].stride    = instanceStride;
+	vertexInput.bindings[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+	if (vertReflection.inputs.size() > MeshVertexInput::kMaxAttributes)
+	{
+		CLOG_ERR("Mesh vertex shader has too many inputs.");
+		return EXIT_FAILURE;
+	}
+
+	bool hasPosition = false;
+	u32  offset      = 0;
+	for (const ReflectedVertexInput &input : vertReflection.inputs)
+	{
+		VkVertexInputAttributeDescription &attribute =
+				vertexInput.attributes[vertexInput.attributeCount++];
+		attribute.location = input.location;
+		attribute.format   = input.format;
+
+		if (input.location == 0)
+		{
+			attribute.binding = 0;
+			attribute.offset  = 0;
+			hasPosition       = input.format == VK_FORMAT_R32G32B32_SFLOAT;
+			continue;
+		}
+
+		attribute.binding = 1;
+		attribute.offset  = offset;
+		offset           += input.size;
+	}
+
+	if (!hasPosition || offset != instanceStride)
+	{
+		CLOG_ERR("Mesh vertex shader inputs do not match a vec3 position and the instance data.");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+bool GpuMesh::Init(
+		VkDevice                     device,
+		VkPhysicalDevice             physicalDevice,
+		const MeshData              &mesh,
+		const VkAllocationCallbacks *allocator
+)
+{
+	mDevice    = device;
+	mAllocator = allocator;
+
+	std::copy(mesh.lods, mesh.lods + mesh.lodCount, mLods);
+	mLodCount = mesh.lodCount;
+	mRadius   = mesh.radius;
+
+	struct Upload
+	{
+		const void        *data;
+		VkDeviceSize       size;
+		VkBufferUsageFlags usage;
+		HostBuffer        *hostBuffer;
+	};
+
+	const VkBufferUsageFlags storage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	const VkBufferUsageFlags vertex  = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | storage;
+
+	const Upload uploads[] = {
+			{mesh.positions.data(), sizeof(glm::vec3) * mesh.positions.size(), vertex, &mVertices},
+			{mesh.indices.data(),
+			 sizeof(u32) * mesh.indices.size(),
+			 VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+			 &mIndices},
+			{mesh.meshlets.data(), sizeof(Meshlet) * mesh.meshlets.size(), storage, &mMeshlets},
+			{mesh.meshletVertices.data(),
+			 sizeof(u32) * mesh.meshletVertices.size(),
+			 storage,
+			 &mMeshletVertices},
+			{mesh.meshletTriangles.data(),
+			 sizeof(u32) * mesh.meshletTriangles.size(),
+			 storage,
+			 &mMeshletTriangles},
+	};
+
+	for (const Upload &upload : uploads)
+	{
+		if (CreateHostBuffer(
+					physicalDevice, upload.data, upload.size, upload.usage, *upload.hostBuffer
+			)
+			== EXIT_FAILURE)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void GpuMesh::Destroy()
+{
+	if (mDevice == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	DestroyHostBuffer(mVertices);
+	DestroyHostBuffer(mIndices);
+	DestroyHostBuffer(mMeshlets);
+	DestroyHostBuffer(mMeshletVertices);
+	DestroyHostBuffer(mMeshletTriangles);
+
+	mDevice = VK_NULL_HANDLE;
+}
+
+void GpuMesh::Bind(VkCommandBuffer commandBuffer, VkBuffer instanceBuffer) const
+{
+	const VkBuffer     buffers[2] = {mVertices.buffer, instanceBuffer};
+	const VkDeviceSize offsets[2] = {0, 0};
+	VulkanDispatch::vkCmdBindVertexBuffers(commandBuffer, 0, 2, buffers, offsets);
+
+	VulkanDispatch::vkCmdBindIndexBuffer(commandBuffer, mIndices.buffer, 0, VK_INDEX_TYPE_UINT32);
+}
+
+void GpuMesh::Draw(VkCommandBuffer commandBuffer, const MeshDraw *draws, u32 drawCount) const
+{
+	for (u32 i = 0; i < drawCount; ++i)
+	{
+		const MeshDraw &draw = draws[i];
+		const MeshLod  &lod  = mLods[std::min(draw.lod, mLodCount - 1)];
+
+		VulkanDispatch::vkCmdDrawIndexed(
+				commandBuffer,
+				lod.indexCount,
+				draw.instanceCount,
+				lod.firstIndex,
+				0,
+				draw.firstInstance
+		);
+	}
+}
+
+bool GpuMesh::CreateHostBuffer(
+		VkPhysicalDevice   physicalDevice,
+		const void        *data,
+		VkDeviceSize       size,
+		VkBufferUsageFlags usage,
+		HostBuffer        &hostBuffer
+)
+{
+	if (CreateBuffer(
+				mDevice,
+				physicalDevice,
+				size,
+				usage,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				hostBuffer.buffer,
+				hostBuffer.memory
+		)
+		== EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	void *mapped = nullptr;
+	if (vkMapMemory(mDevice, hostBuffer.memory, 0, size, 0, &mapped) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to map a mesh buffer.");
+		return EXIT_FAILURE;
+	}
+	std::memcpy(mapped, data, size);
+	vkUnmapMemory(mDevice, hostBuffer.memory);
+
+	return EXIT_SUCCESS;
+}
+
+void GpuMesh::DestroyHostBuffer(HostBuffer &hostBuffer)
+{
+	vkDestroyBuffer(mDevice, hostBuffer.buffer, mAllocator);
+	vkFreeMemory(mDevice, hostBuffer.memory, mAllocator);
+	hostBuffer = {};
+}
@@ -0,0 +1,192 @@
+#ifndef HEADER_MESH_H
+#define HEADER_MESH_H
+
+#include "definitions.h"
+#include "pch/glm.h"
+#include "render/meshlet.h"
+#include "render/spirv_reflect.h"
+#include "vulkan/vulkan_core.h"
+
+#include <vector>
+
+/* Indexed triangle meshes with a chain of levels of detail, and their vertex buffers.
+ *
+ * Every LOD is a range of the same index buffer over one shared vertex array: lods[0] is the
+ * imported mesh, each further one a simplification of it (render/mesh_simplify.h) with its error
+ * in object units, and its triangles are also split into meshlets (render/meshlet.h) for GPU
+ * culling. Meshes are placed like the instances of the main pass: x and y scaled by the
+ * instance into NDC, z into depth squashed by kMeshDepthScale. Triangles are wound so that
+ * cross(b - a, c - a) points into the mesh, which is clockwise on screen for front faces. */
+
+constexpr u32 kMaxMeshLods = 8;
+
+// Matches kDepthScale of mesh_vert.glsl and shadow_vert.glsl.
+constexpr f32 kMeshDepthScale = 0.1f;
+
+struct MeshLod
+{
+	u32 firstIndex   = 0;
+	u32 indexCount   = 0;
+	f32 error        = 0.0f;// Object space, 0 for the imported mesh
+	u32 firstMeshlet = 0;
+	u32 meshletCount = 0;
+};
+
+struct MeshData
+{
+	std::vector<glm::vec3> positions;
+	std::vector<u32>       indices;// Every LOD, one after the other
+
+	MeshLod lods[kMaxMeshLods];
+	u32     lodCount = 0;
+
+	// Meshlets of every LOD, one after the other.
+	std::vector<Meshlet> meshlets;
+	std::vector<u32>     meshletVertices;
+	std::vector<u32>     meshletTriangles;
+
+	f32 radius = 0.0f;// Of the bounding sphere around the origin
+};
+
+struct MeshLodSettings
+{
+	u32 maxLods       = kMaxMeshLods;
+	f32 triangleRatio = 0.5f;// Target triangle count of each LOD relative to the previous one
+	u32 minTriangles  = 32;  // No LOD goes below this
+};
+
+// Instances drawn with one LOD, instanceCount of them from firstInstance.
+struct MeshDraw
+{
+	u32 lod           = 0;
+	u32 firstInstance = 0;
+	u32 instanceCount = 0;
+};
+
+/* Builds the LOD chain of a mesh and the meshlets of every LOD. Each LOD is simplified from the
+ * imported triangles, not from the previous LOD, so its error is measured against the original
+ * surface. The chain ends early when simplification stops making progress. */
+MeshData ImportMesh(
+		std::vector<glm::vec3> positions,
+		std::vector<u32>       indices,
+		const MeshLodSettings &settings = {}
+);
+
+/* Stand-in for an asset until the tree loads any: a subdivided icosahedron of radius about 0.5,
+ * displaced into a lumpy blob so that simplification has curvature to preserve. Subdivision s
+ * has 20 * 4^s triangles. */
+void CreateBlobMesh(
+		u32                     subdivisions,
+		std::vector<glm::vec3> &positions,
+		std::vector<u32>       &indices
+);
+
+/* Vertex input of a mesh pipeline: location 0 is the vec3 mesh position at binding 0, every
+ * other input is a per-instance attribute at binding 1, packed in location order. */
+struct MeshVertexInput
+{
+	static constexpr u32 kMaxAttributes = 8;
+
+	VkVertexInputBindingDescription   bindings[2]                = {};
+	VkVertexInputAttributeDescription attributes[kMaxAttributes] = {};
+	u32                               attributeCount             = 0;
+
+	// Points into this object, which has to outlive the pipeline creation.
+	[[nodiscard]] VkPipelineVertexInputStateCreateInfo GetCreateInfo() const;
+};
+
+// Fails when the instance inputs of the shader do not add up to instanceStride bytes.
+bool BuildMeshVertexInput(
+		const ShaderReflection &vertReflection,
+		u32                     instanceStride,
+		MeshVertexInput        &vertexInput
+);
+
+/* Vertex and index buffer of a mesh, and its meshlets as storage buffers. The vertex buffer
+ * can be read as storage as well, as a tightly packed float array. Written once through a
+ * host-visible mapping at creation, meshes this small do not warrant a staging upload. */
+class GpuMesh
+{
+public:
+	bool Init(
+			VkDevice                     device,
+			VkPhysicalDevice             physicalDevice,
+			const MeshData              &mesh,
+			const VkAllocationCallbacks *allocator
+	);
+
+	void Destroy();
+
+	// Mesh vertices at binding 0, instanceBuffer at binding 1, and the index buffer.
+	void Bind(VkCommandBuffer commandBuffer, VkBuffer instanceBuffer) const;
+
+	void Draw(VkCommandBuffer commandBuffer, const MeshDraw *draws, u32 drawCount) const;
+
+	[[nodiscard]] const MeshLod *GetLods() const
+	{
+		return mLods;
+	}
+
+	[[nodiscard]] u32 GetLodCount() const
+	{
+		return mLodCount;
+	}
+
+	[[nodiscard]] f32 GetRadius() const
+	{
+		return mRadius;
+	}
+
+	[[nodiscard]] VkBuffer GetVertexBuffer() const
+	{
+		return mVertices.buffer;
+	}
+
+	[[nodiscard]] VkBuffer GetMeshletBuffer() const
+	{
+		return mMeshlets.buffer;
+	}
+
+	[[nodiscard]] VkBuffer GetMeshletVertexBuffer() const
+	{
+		return mMeshletVertices.buffer;
+	}
+
+	[[nodiscard]] VkBuffer GetMeshletTriangleBuffer() const
+	{
+		return mMeshletTriangles.buffer;
+	}
+
+private:
+	struct HostBuffer
+	{
+		VkBuffer       buffer = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+	};
+
+	bool CreateHostBuffer(
+			VkPhysicalDevice   physicalDevice,
+			const void        *data,
+			VkDeviceSize       size,
+			VkBufferUsageFlags usage,
+			HostBuffer        &hostBuffer
+	);
+
+	void DestroyHostBuffer(HostBuffer &hostBuffer);
+
+private:
+	VkDevice                     mDevice    = VK_NULL_HANDLE;
+	const VkAllocationCallbacks *mAllocator = nullptr;
+
+	HostBuffer mVertices;
+	HostBuffer mIndices;
+	HostBuffer mMeshlets;
+	HostBuffer mMeshletVertices;
+	HostBuffer mMeshletTriangles;
+
+	MeshLod mLods[kMaxMeshLods] = {};
+	u32     mLodCount           = 0;
+	f32     mRadius             = 0.0f;
+};
+
+#endif// HEADER_MESH_H
@@ -0,0 +1,377 @@
+#include "mesh_simplify.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+// Weight of the planes holding open borders, relative to the area weight of surface planes.
+constexpr f64 kBorderWeight = 10.0;
+
+// Smallest cosine between a triangle's normal before and after a collapse.
+constexpr f32 kMinNormalCosine = 0.2f;
+
+// Symmetric 4x4 matrix of the summed planes, stored as its upper triangle.
+struct Quadric
+{
+	f64 xx = 0.0, xy = 0.0, xz = 0.0, xw = 0.0;
+	f64 yy = 0.0, yz = 0.0, yw = 0.0;
+	f64 zz = 0.0, zw = 0.0;
+	f64 ww = 0.0;
+
+	f64 weight = 0.0;// Total weight of the planes, to turn an error back into a distance
+};
+
+struct Collapse
+{
+	f64 cost;
+	u32 from;
+	u32 to;
+	u32 fromVersion;
+	u32 toVersion;
+
+	bool operator>(const Collapse &other) const
+	{
+		return cost > other.cost;
+	}
+};
+
+static void AddPlane(Quadric &q, const glm::dvec3 &normal, f64 distance, f64 weight)
+{
+	q.xx += weight * normal.x * normal.x;
+	q.xy += weight * normal.x * normal.y;
+	q.xz += weight * normal.x * normal.z;
+	q.xw += weight * normal.x * distance;
+	q.yy += weight * normal.y * normal.y;
+	q.yz += weight * normal.y * normal.z;
+	q.yw += weight * normal.y * distance;
+	q.zz += weight * normal.z * normal.z;
+	q.zw += weight * normal.z * distance;
+	q.ww += weight * distance * distance;
+
+	q.weight += weight;
+}
+
+static void AddQuadric(Quadric &q, const Quadric &other)
+{
+	q.xx += other.xx;
+	q.xy += other.xy;
+	q.xz += other.xz;
+	q.xw += other.xw;
+	q.yy += other.yy;
+	q.yz += other.yz;
+	q.yw += other.yw;
+	q.zz += other.zz;
+	q.zw += other.zw;
+	q.ww += other.ww;
+
+	q.weight += other.weight;
+}
+
+// Weighted sum of the squared distances from p to the planes of q.
+static f64 EvaluateQuadric(const Quadric &q, const glm::vec3 &p)
+{
+	const f64 x = p.x;
+	const f64 y = p.y;
+	const f64 z = p.z;
+
+	const f64 error = q.xx * x * x + q.yy * y * y + q.zz * z * z + q.ww
+					+ 2.0 * (q.xy * x * y + q.xz * x * z + q.yz * y * z)
+					+ 2.0 * (q.xw * x + q.yw * y + q.zw * z);
+	return std::max(error, 0.0);
+}
+
+static u64 EdgeKey(u32 a, u32 b)
+{
+	return a < b ? ((u64)a << 32) | b : ((u64)b << 32) | a;
+}
+
+u32 SimplifyMesh(
+		const glm::vec3 *positions,
+		u32              vertexCount,
+		const u32       *indices,
+		u32              indexCount,
+		u32              targetIndexCount,
+		u32             *dst,
+		f32             *error
+)
+{
+	const u32 triangleCount = indexCount / 3;
+
+	std::vector<u32>  triangles(indices, indices + triangleCount * 3);
+	std::vector<bool> removed(triangleCount, false);
+	u32               liveTriangles = triangleCount;
+
+	std::vector<Quadric>          quadrics(vertexCount);
+	std::vector<std::vector<u32>> vertexTriangles(vertexCount);
+	std::unordered_map<u64, u32>  edgeUses;
+
+	for (u32 t = 0; t < triangleCount; ++t)
+	{
+		const u32 *tri = &triangles[t * 3];
+
+		const glm::dvec3 a = positions[tri[0]];
+		const glm::dvec3 b = positions[tri[1]];
+		const glm::dvec3 c = positions[tri[2]];
+
+		const glm::dvec3 cross  = glm::cross(b - a, c - a);
+		const f64        length = glm::length(cross);
+		if (length > 0.0)
+		{
+			const glm::dvec3 normal = cross / length;
+			for (u32 k = 0; k < 3; ++k)
+			{
+				AddPlane(quadrics[tri[k]], normal, -glm::dot(normal, a), length * 0.5);
+			}
+		}
+
+		for (u32 k = 0; k < 3; ++k)
+		{
+			vertexTriangles[tri[k]].push_back(t);
+			++edgeUses[EdgeKey(tri[k], tri[(k + 1) % 3])];
+		}
+	}
+
+	// Edges of a single triangle are borders: a plane through the edge, perpendicular to the
+	// triangle, keeps collapses from pulling them inwards.
+	for (u32 t = 0; t < triangleCount; ++t)
+	{
+		const u32 *tri = &triangles[t * 3];
+
+		const glm::dvec3 a      = positions[tri[0]];
+		const glm::dvec3 b      = positions[tri[1]];
+		const glm::dvec3 c      = positions[tri[2]];
+		const glm::dvec3 normal = glm::cross(b - a, c - a);
+
+		for (u32 k = 0; k < 3; ++k)
+		{
+			const u32 v0 = tri[k];
+			const u32 v1 = tri[(k + 1) % 3];
+			if (edgeUses[EdgeKey(v0, v1)] != 1)
+			{
+				continue;
+			}
+
+			const glm::dvec3 p0   = positions[v0];
+			const glm::dvec3 edge = glm::dvec3(positions[v1]) - p0;
+			const glm::dvec3 side = glm::cross(edge, normal);
+			const f64        size = glm::length(side);
+			if (size > 0.0)
+			{
+				const glm::dvec3 sideNormal = side / size;
+				const f64        weight     = glm::dot(edge, edge) * kBorderWeight;
+
+				AddPlane(quadrics[v0], sideNormal, -glm::dot(sideNormal, p0), weight);
+				AddPlane(quadrics[v1], sideNormal, -glm::dot(sideNormal, p0), weight);
+			}
+		}
+	}
+
+	std::vector<u32> versions(vertexCount, 0);
+	std::vector<u32> collapsedInto(vertexCount, ~0u);
+
+	std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+
+	// Pushes the cheaper direction of the edge.
+	auto pushEdge = [&](u32 a, u32 b)
+	{
+		Quadric merged = quadrics[a];
+		AddQuadric(merged, quadrics[b]);
+
+		const f64 costToA = EvaluateQuadric(merged, positions[a]);
+		const f64 costToB = EvaluateQuadric(merged, positions[b]);
+
+		if (costToB <= costToA)
+		{
+			queue.push({costToB, a, b, versions[a], versions[b]});
+		}
+		else
+		{
+			queue.push({costToA, b, a, versions[b], versions[a]});
+		}
+	};
+
+	for (const auto &[key, uses] : edgeUses)
+	{
+		pushEdge((u32)(key >> 32), (u32)(key & 0xffffffffu));
+	}
+
+	std::vector<u32> neighbours;
+	std::vector<u32> fromNeighbours;
+
+	auto gatherNeighbours = [&](u32 vertex, std::vector<u32> &out)
+	{
+		out.clear();
+		for (u32 t : vertexTriangles[vertex])
+		{
+			if (removed[t])
+			{
+				continue;
+			}
+
+			for (u32 k = 0; k < 3; ++k)
+			{
+				if (triangles[t * 3 + k] != vertex)
+				{
+					out.push_back(triangles[t * 3 + k]);
+				}
+			}
+		}
+		std::sort(out.begin(), out.end());
+		out.erase(std::unique(out.begin(), out.end()), out.end());
+	};
+
+	f64 maxError = 0.0;
+
+	while (liveTriangles * 3 > targetIndexCount && !queue.empty())
+	{
+		const Collapse collapse = queue.top();
+		queue.pop();
+
+		const u32 from = collapse.from;
+		const u32 to   = collapse.to;
+
+		// Either endpoint changed since the cost was computed: a fresher entry exists.
+		if (collapsedInto[from] != ~0u || collapsedInto[to] != ~0u
+			|| collapse.fromVersion != versions[from] || collapse.toVersion != versions[to])
+		{
+			continue;
+		}
+
+		// Link condition: the endpoints may only share the neighbours of their shared
+		// triangles, otherwise the collapse glues two surface sheets together.
+		u32 sharedTriangles = 0;
+		for (u32 t : vertexTriangles[from])
+		{
+			if (removed[t])
+			{
+				continue;
+			}
+
+			const u32 *tri = &triangles[t * 3];
+			if (tri[0] == to || tri[1] == to || tri[2] == to)
+			{
+				++sharedTriangles;
+			}
+		}
+
+		if (sharedTriangles == 0)
+		{
+			continue;
+		}
+
+		gatherNeighbours(from, fromNeighbours);
+		gatherNeighbours(to, neighbours);
+
+		u32 sharedNeighbours = 0;
+		for (u32 vertex : fromNeighbours)
+		{
+			if (vertex != to && std::binary_search(neighbours.begin(), neighbours.end(), vertex))
+			{
+				++sharedNeighbours;
+			}
+		}
+
+		if (sharedNeighbours > sharedTriangles)
+		{
+			continue;
+		}
+
+		// The triangles that keep existing must not flip or collapse to a line.
+		bool flips = false;
+		for (u32 t : vertexTriangles[from])
+		{
+			const u32 *tri = &triangles[t * 3];
+			if (removed[t] || tri[0] == to || tri[1] == to || tri[2] == to)
+			{
+				continue;
+			}
+
+			glm::vec3 corners[3] = {positions[tri[0]], positions[tri[1]], positions[tri[2]]};
+
+			const glm::vec3 before =
+					glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+			for (u32 k = 0; k < 3; ++k)
+			{
+				if (tri[k] == from)
+				{
+					corners[k] = positions[to];
+				}
+			}
+			const glm::vec3 after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+
+			const f32 lengths = glm::length(before) * glm::length(after);
+			if (lengths <= 0.0f || glm::dot(before, after) < kMinNormalCosine * lengths)
+			{
+				flips = true;
+				break;
+			}
+		}
+
+		if (flips)
+		{
+			continue;
+		}
+
+		for (u32 t : vertexTriangles[from])
+		{
+			if (removed[t])
+			{
+				continue;
+			}
+
+			u32 *tri = &triangles[t * 3];
+			if (tri[0] == to || tri[1] == to || tri[2] == to)
+			{
+				removed[t] = true;
+				--liveTriangles;
+				continue;
+			}
+
+			for (u32 k = 0; k < 3; ++k)
+			{
+				if (tri[k] == from)
+				{
+					tri[k] = to;
+				}
+			}
+			vertexTriangles[to].push_back(t);
+		}
+
+		AddQuadric(quadrics[to], quadrics[from]);
+		collapsedInto[from] = to;
+		++versions[from];
+		++versions[to];
+
+		if (quadrics[to].weight > 0.0)
+		{
+			maxError = std::max(maxError, std::sqrt(collapse.cost / quadrics[to].weight));
+		}
+
+		// Costs of every edge at the kept vertex changed with its quadric.
+		gatherNeighbours(to, neighbours);
+		for (u32 vertex : neighbours)
+		{
+			pushEdge(to, vertex);
+		}
+	}
+
+	u32 written = 0;
+	for (u32 t = 0; t < triangleCount; ++t)
+	{
+		if (!removed[t])
+		{
+			dst[written++] = triangles[t * 3 + 0];
+			dst[written++] = triangles[t * 3 + 1];
+			dst[written++] = triangles[t * 3 + 2];
+		}
+	}
+
+	if (error != nullptr)
+	{
+		*error = (f32)maxError;
+	}
+
+	return written;
+}
@@ -0,0 +1,29 @@
+#ifndef HEADER_MESH_SIMPLIFY_H
+#define HEADER_MESH_SIMPLIFY_H
+
+#include "definitions.h"
+#include "pch/glm.h"
+
+/* Edge collapse simplification driven by quadric error metrics (Garland and Heckbert).
+ *
+ * Every vertex accumulates the planes of its triangles, weighted by area, and edges are collapsed
+ * cheapest first. A collapse moves one endpoint onto the other instead of solving for an optimal
+ * position, so the result keeps indexing the original vertices and every level of detail can
+ * share one vertex buffer. Collapses that flip a triangle or pinch the surface into a
+ * non-manifold edge are skipped, open borders are held in place by extra perpendicular planes.
+ *
+ * Writes the remaining triangles to dst, which needs room for indexCount indices, and returns
+ * their index count. It stays above targetIndexCount when no valid collapse is left. error
+ * receives the largest error of the applied collapses, as the RMS distance in object units of
+ * the moved vertex to the planes it gathered. Runs at import time and allocates freely. */
+u32 SimplifyMesh(
+		const glm::vec3 *positions,
+		u32              vertexCount,
+		const u32       *indices,
+		u32              indexCount,
+		u32              targetIndexCount,
+		u32             *dst,
+		f32             *error
+);
+
+#endif// HEADER_MESH_SIMPLIFY_H
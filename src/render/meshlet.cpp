@@ -0,0 +1,234 @@
+#include "meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Marks vertices that are not part of the meshlet being built.
+constexpr u32 kNoLocalIndex = ~0u;
+
+static u32 PackTriangle(u32 a, u32 b, u32 c)
+{
+	return a | (b << 8) | (c << 16);
+}
+
+// Bounding sphere and normal cone of the meshlet's triangles.
+static void ComputeMeshletBounds(
+		const glm::vec3 *positions,
+		const u32       *vertices,
+		const u32       *triangles,
+		Meshlet         &meshlet
+)
+{
+	glm::vec3 boundsMin = positions[vertices[0]];
+	glm::vec3 boundsMax = boundsMin;
+	for (u32 i = 1; i < meshlet.vertexCount; ++i)
+	{
+		boundsMin = glm::min(boundsMin, positions[vertices[i]]);
+		boundsMax = glm::max(boundsMax, positions[vertices[i]]);
+	}
+
+	const glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+
+	f32 radius = 0.0f;
+	for (u32 i = 0; i < meshlet.vertexCount; ++i)
+	{
+		radius = std::max(radius, glm::length(positions[vertices[i]] - center));
+	}
+	meshlet.boundingSphere = glm::vec4(center, radius);
+
+	glm::vec3 normals[kMaxMeshletTriangles];
+	u32       normalCount = 0;
+	glm::vec3 axis        = glm::vec3(0.0f);
+	for (u32 t = 0; t < meshlet.triangleCount; ++t)
+	{
+		const u32       packed = triangles[t];
+		const glm::vec3 a      = positions[vertices[packed & 0xff]];
+		const glm::vec3 b      = positions[vertices[(packed >> 8) & 0xff]];
+		const glm::vec3 c      = positions[vertices[(packed >> 16) & 0xff]];
+
+		const glm::vec3 normal = glm::cross(b - a, c - a);
+		const f32       length = glm::length(normal);
+		if (length > 0.0f)
+		{
+			normals[normalCount] = normal / length;
+			axis                += normals[normalCount];
+			++normalCount;
+		}
+	}
+
+	// Without a usable cone the meshlet is never considered back facing.
+	meshlet.cone = glm::vec4(0.0f, 0.0f, 1.0f, -1.0f);
+
+	const f32 axisLength = glm::length(axis);
+	if (axisLength <= 0.0f)
+	{
+		return;
+	}
+	axis /= axisLength;
+
+	f32 minCosine = 1.0f;
+	for (u32 i = 0; i < normalCount; ++i)
+	{
+		minCosine = std::min(minCosine, glm::dot(axis, normals[i]));
+	}
+
+	// Normals spread over a half space or more can face any direction.
+	if (minCosine <= 0.0f)
+	{
+		meshlet.cone = glm::vec4(axis, -1.0f);
+		return;
+	}
+
+	// Every normal is within acos(minCosine) of the axis. They all point away from +z once the
+	// axis is more than 90 degrees plus that angle away from it: axis.z < -sin(angle).
+	meshlet.cone = glm::vec4(axis, -std::sqrt(1.0f - minCosine * minCosine));
+}
+
+void BuildMeshlets(
+		const glm::vec3      *positions,
+		u32                   vertexCount,
+		const u32            *indices,
+		u32                   indexCount,
+		std::vector<Meshlet> &meshlets,
+		std::vector<u32>     &meshletVertices,
+		std::vector<u32>     &meshletTriangles
+)
+{
+	const u32 triangleCount = indexCount / 3;
+
+	// Triangles around every vertex, vertex v owning [offsets[v], offsets[v + 1]).
+	std::vector<u32> vertexTriangleOffsets(vertexCount + 1, 0);
+	for (u32 i = 0; i < triangleCount * 3; ++i)
+	{
+		++vertexTriangleOffsets[indices[i] + 1];
+	}
+	for (u32 v = 0; v < vertexCount; ++v)
+	{
+		vertexTriangleOffsets[v + 1] += vertexTriangleOffsets[v];
+	}
+
+	std::vector<u32> vertexTriangles(triangleCount * 3);
+	{
+		std::vector<u32> cursors(vertexTriangleOffsets.begin(), vertexTriangleOffsets.end() - 1);
+		for (u32 i = 0; i < triangleCount * 3; ++i)
+		{
+			vertexTriangles[cursors[indices[i]]++] = i / 3;
+		}
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<u32>  localIndices(vertexCount, kNoLocalIndex);
+
+	// The meshlet being built, the unemitted triangles touching its vertices and its centroid.
+	std::vector<u32> vertices;
+	std::vector<u32> triangles;
+	std::vector<u32> candidates;
+	glm::vec3        centroidSum = glm::vec3(0.0f);
+	glm::vec3        centroid    = glm::vec3(0.0f);
+
+	auto finishMeshlet = [&]()
+	{
+		if (triangles.empty())
+		{
+			return;
+		}
+
+		Meshlet meshlet        = {};
+		meshlet.vertexOffset   = (u32)meshletVertices.size();
+		meshlet.vertexCount    = (u32)vertices.size();
+		meshlet.triangleOffset = (u32)meshletTriangles.size();
+		meshlet.triangleCount  = (u32)triangles.size();
+		ComputeMeshletBounds(positions, vertices.data(), triangles.data(), meshlet);
+
+		meshlets.push_back(meshlet);
+		meshletVertices.insert(meshletVertices.end(), vertices.begin(), vertices.end());
+		meshletTriangles.insert(meshletTriangles.end(), triangles.begin(), triangles.end());
+
+		for (u32 vertex : vertices)
+		{
+			localIndices[vertex] = kNoLocalIndex;
+		}
+		vertices.clear();
+		triangles.clear();
+		candidates.clear();
+		centroidSum = glm::vec3(0.0f);
+	};
+
+	u32 nextSeed = 0;
+	for (;;)
+	{
+		// Adjacent triangle adding the fewest vertices, on ties the one nearest to the centroid so
+		// that the patch stays round. Emitted triangles are dropped from the candidates on the way.
+		u32 best         = ~0u;
+		u32 bestVertices = 4;
+		f32 bestDistance = 0.0f;
+		u32 kept         = 0;
+		for (u32 triangle : candidates)
+		{
+			if (emitted[triangle])
+			{
+				continue;
+			}
+			candidates[kept++] = triangle;
+
+			u32 newVertices = 0;
+			for (u32 k = 0; k < 3; ++k)
+			{
+				newVertices += localIndices[indices[triangle * 3 + k]] == kNoLocalIndex ? 1 : 0;
+			}
+
+			const glm::vec3 offset   = positions[indices[triangle * 3]] - centroid;
+			const f32       distance = glm::dot(offset, offset);
+			if (newVertices < bestVertices
+				|| (newVertices == bestVertices && distance < bestDistance))
+			{
+				best         = triangle;
+				bestVertices = newVertices;
+				bestDistance = distance;
+			}
+		}
+		candidates.resize(kept);
+
+		// Full, or the patch ran out of neighbours: start the next meshlet at the first triangle
+		// left in index order.
+		if (best == ~0u || vertices.size() + bestVertices > kMaxMeshletVertices
+			|| triangles.size() == kMaxMeshletTriangles)
+		{
+			finishMeshlet();
+
+			while (nextSeed < triangleCount && emitted[nextSeed])
+			{
+				++nextSeed;
+			}
+			if (nextSeed == triangleCount)
+			{
+				break;
+			}
+			best = nextSeed;
+		}
+
+		emitted[best] = true;
+
+		u32 local[3];
+		for (u32 k = 0; k < 3; ++k)
+		{
+			const u32 vertex = indices[best * 3 + k];
+			if (localIndices[vertex] == kNoLocalIndex)
+			{
+				localIndices[vertex] = (u32)vertices.size();
+				vertices.push_back(vertex);
+				centroidSum += positions[vertex];
+
+				candidates.insert(
+						candidates.end(),
+						vertexTriangles.begin() + vertexTriangleOffsets[vertex],
+						vertexTriangles.begin() + vertexTriangleOffsets[vertex + 1]
+				);
+			}
+			local[k] = localIndices[vertex];
+		}
+
+		triangles.push_back(PackTriangle(local[0], local[1], local[2]));
+		centroid = centroidSum / (f32)vertices.size();
+	}
+}
@@ -0,0 +1,48 @@
+#ifndef HEADER_MESHLET_H
+#define HEADER_MESHLET_H
+
+#include "definitions.h"
+#include "pch/glm.h"
+
+#include <vector>
+
+/* Meshlets: small clusters of a mesh's triangles with their own bounds, so that the GPU can
+ * cull parts of a mesh instead of whole instances (render/meshlet_culling.h).
+ *
+ * A meshlet lists up to kMaxMeshletVertices vertices of the mesh and up to kMaxMeshletTriangles
+ * triangles indexing into that list, packed as three 8-bit local indices per u32. */
+
+// Match meshlet_cull_comp.glsl and meshlet_vert.glsl.
+constexpr u32 kMaxMeshletVertices  = 64;
+constexpr u32 kMaxMeshletTriangles = 124;
+
+// Matches Meshlet of meshlet_cull_comp.glsl and meshlet_vert.glsl (std430).
+struct Meshlet
+{
+	glm::vec4 boundingSphere;// Object space center and radius
+
+	/* Normal cone in object space: xyz is the axis, w the cutoff. The meshlet only holds back
+	 * faces for a view looking along +z when cone.z < cone.w, -1 when it never does. */
+	glm::vec4 cone;
+
+	u32 vertexOffset;  // Into the meshlet vertex list
+	u32 vertexCount;
+	u32 triangleOffset;// Into the meshlet triangle list
+	u32 triangleCount;
+};
+
+/* Splits the triangles of indices into meshlets appended to meshlets, their vertices (indices
+ * into positions) to meshletVertices and their packed triangles to meshletTriangles. Meshlets
+ * grow greedily over adjacent triangles, preferring those that add the fewest vertices, so each
+ * covers a compact patch and its bounds stay tight. Runs at import time and allocates freely. */
+void BuildMeshlets(
+		const glm::vec3      *positions,
+		u32                   vertexCount,
+		const u32            *indices,
+		u32                   indexCount,
+		std::vector<Meshlet> &meshlets,
+		std::vector<u32>     &meshletVertices,
+		std::vector<u32>     &meshletTriangles
+);
+
+#endif// HEADER_MESHLET_H
@@ -0,0 +1,465 @@
+#include "meshlet_culling.h"
+
+#include "render/pipeline_layout_cache.h"
+#include "render/vk_dispatch.h"
+#include "render/vk_utils.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// Meshlets, meshlet triangles, instances, clusters, indices and draw command.
+constexpr u32 kCullBindingCount = 6;
+// Positions, meshlet vertices, meshlets, clusters and instances.
+constexpr u32 kDrawBindingCount = 5;
+
+// Guaranteed minimum of maxComputeWorkGroupCount[0], larger draws take several dispatches.
+constexpr u32 kMaxDispatchGroups = 65535;
+
+// The draw command buffer holds the draws of the early and the late phase, then the counters.
+constexpr u32 kDrawCommandStride    = sizeof(VkDrawIndexedIndirectCommand);
+constexpr u32 kClusterCounterIndex  = 2 * kDrawCommandStride / sizeof(u32);
+constexpr u32 kOccludedCounterIndex = kClusterCounterIndex + 1;
+
+bool MeshletCulling::Init(
+		VkDevice                     device,
+		VkPhysicalDevice             physicalDevice,
+		PipelineLayoutCache         &layoutCache,
+		VkShaderModule               cullModule,
+		const ShaderReflection      &cullReflection,
+		const GpuMesh               &mesh,
+		const VkBuffer              *instanceBuffers,
+		u32                          frameCount,
+		u32                          maxClusters,
+		const VkAllocationCallbacks *allocator
+)
+{
+	mDevice         = device;
+	mPhysicalDevice = physicalDevice;
+	mLayoutCache    = &layoutCache;
+	mAllocator      = allocator;
+	mMesh           = &mesh;
+	mMaxClusters    = std::max(maxClusters, 1u);
+
+	mFrames.resize(frameCount);
+	for (u32 i = 0; i < frameCount; ++i)
+	{
+		mFrames[i].instances = instanceBuffers[i];
+		if (CreateFrameBuffers(mFrames[i]) == EXIT_FAILURE)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+
+	// One culling and one drawing set per frame.
+	VkDescriptorPoolSize poolSize = {};
+	poolSize.type                 = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount      = frameCount * (kCullBindingCount + kDrawBindingCount);
+
+	VkDescriptorPoolCreateInfo poolInfo = {};
+
+	poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.maxSets       = frameCount * 2;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes    = &poolSize;
+
+	if (vkCreateDescriptorPool(mDevice, &poolInfo, mAllocator, &mDescriptorPool) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create the meshlet culling descriptor pool.");
+		return EXIT_FAILURE;
+	}
+
+	if (CreateCullPipeline(cullModule, cullReflection) == EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	CLOG_INFO("Meshlet culling: up to ", mMaxClusters, " visible clusters per frame.");
+	return EXIT_SUCCESS;
+}
+
+void MeshletCulling::Destroy()
+{
+	if (mDevice == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	vkDestroyPipeline(mDevice, mCullPipeline, mAllocator);
+	vkDestroyDescriptorPool(mDevice, mDescriptorPool, mAllocator);
+
+	for (FrameResources &frame : mFrames)
+	{
+		vkDestroyBuffer(mDevice, frame.clusters, mAllocator);
+		vkFreeMemory(mDevice, frame.clustersMemory, mAllocator);
+		vkDestroyBuffer(mDevice, frame.indices, mAllocator);
+		vkFreeMemory(mDevice, frame.indicesMemory, mAllocator);
+		vkDestroyBuffer(mDevice, frame.drawCommand, mAllocator);
+		vkFreeMemory(mDevice, frame.drawCommandMemory, mAllocator);
+	}
+	mFrames.clear();
+
+	mCullPipeline   = VK_NULL_HANDLE;
+	mDescriptorPool = VK_NULL_HANDLE;
+	mCullLayout     = VK_NULL_HANDLE;
+	mDrawLayout     = VK_NULL_HANDLE;
+	mMesh           = nullptr;
+	mDevice         = VK_NULL_HANDLE;
+}
+
+bool MeshletCulling::BindGraphicsLayout(VkPipelineLayout pipelineLayout, u32 set)
+{
+	std::optional<VkDescriptorSetLayout> setLayout =
+			mLayoutCache->FindSetLayout(pipelineLayout, set);
+	if (!setLayout.has_value())
+	{
+		CLOG_ERR("Meshlet pipeline layout has no meshlet set.");
+		return EXIT_FAILURE;
+	}
+
+	mDrawLayout = pipelineLayout;
+	mDrawSet    = set;
+	return AllocateSets(setLayout.value(), &FrameResources::drawSet, false);
+}
+
+void MeshletCulling::RecordCull(
+		VkCommandBuffer commandBuffer,
+		u32             frameIndex,
+		const MeshDraw *draws,
+		u32             drawCount,
+		CullPhase       phase,
+		VkExtent2D      depthExtent
+)
+{
+	FrameResources &frame = mFrames[frameIndex];
+
+	VkMemoryBarrier2KHR clearBarrier = {};
+	clearBarrier.sType               = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+	clearBarrier.srcStageMask        = VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR;
+	clearBarrier.srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR;
+	clearBarrier.dstStageMask        = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+
+	clearBarrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR
+							   | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR;
+
+	VkDependencyInfoKHR dependencyInfo = {};
+	dependencyInfo.sType               = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+	dependencyInfo.memoryBarrierCount  = 1;
+	dependencyInfo.pMemoryBarriers     = &clearBarrier;
+
+	if (phase == CullPhase::eLate)
+	{
+		// Continues the counters and indices of the early phase.
+		clearBarrier.srcStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+		clearBarrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR;
+	}
+	else
+	{
+		// The frame's fence has passed, the counters still hold what its last culling kept.
+		if (frame.culled)
+		{
+			const u32 clusterCount = frame.drawCommandMapped[kClusterCounterIndex];
+
+			mStats.visibleClusters  += clusterCount;
+			mStats.droppedClusters  += clusterCount - std::min(clusterCount, mMaxClusters);
+			mStats.occludedClusters += frame.drawCommandMapped[kOccludedCounterIndex];
+		}
+		frame.culled = true;
+
+		VulkanDispatch::vkCmdFillBuffer(commandBuffer, frame.drawCommand, 0, VK_WHOLE_SIZE, 0);
+	}
+
+	VulkanDispatch::vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+
+	VulkanDispatch::vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mCullPipeline);
+	VulkanDispatch::vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			mCullLayout,
+			0,
+			1,
+			&frame.cullSet,
+			0,
+			nullptr
+	);
+
+	PushConstants pushConstants   = {};
+	pushConstants.clusterCapacity = mMaxClusters;
+	pushConstants.phase           = phase;
+	pushConstants.depthWidth      = depthExtent.width;
+	pushConstants.depthHeight     = depthExtent.height;
+
+	const MeshLod *lods     = mMesh->GetLods();
+	const u32      lodCount = mMesh->GetLodCount();
+	for (u32 i = 0; i < drawCount; ++i)
+	{
+		const MeshLod &lod   = lods[std::min(draws[i].lod, lodCount - 1)];
+		const u32      pairs = lod.meshletCount * draws[i].instanceCount;
+
+		pushConstants.firstMeshlet  = lod.firstMeshlet;
+		pushConstants.meshletCount  = lod.meshletCount;
+		pushConstants.firstInstance = draws[i].firstInstance;
+		pushConstants.instanceCount = draws[i].instanceCount;
+
+		for (u32 offset = 0; offset < pairs; offset += kMaxDispatchGroups * kWorkgroupSize)
+		{
+			const u32 groupCount = std::min(
+					(pairs - offset + kWorkgroupSize - 1) / kWorkgroupSize, kMaxDispatchGroups
+			);
+
+			pushConstants.invocationOffset = offset;
+			VulkanDispatch::vkCmdPushConstants(
+					commandBuffer,
+					mCullLayout,
+					VK_SHADER_STAGE_COMPUTE_BIT,
+					0,
+					sizeof(PushConstants),
+					&pushConstants
+			);
+			VulkanDispatch::vkCmdDispatch(commandBuffer, groupCount, 1, 1);
+		}
+
+		// The late phase retests the same pairs.
+		if (phase != CullPhase::eLate)
+		{
+			mStats.testedClusters += pairs;
+		}
+	}
+
+	// The host reads the counter back once the frame's fence has passed.
+	VkMemoryBarrier2KHR cullBarrier = {};
+	cullBarrier.sType               = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+	cullBarrier.srcStageMask        = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+	cullBarrier.srcAccessMask       = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR;
+
+	cullBarrier.dstStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR
+							 | VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT_KHR
+							 | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT_KHR
+							 | VK_PIPELINE_STAGE_2_HOST_BIT_KHR;
+
+	cullBarrier.dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT_KHR
+							  | VK_ACCESS_2_INDEX_READ_BIT_KHR
+							  | VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR
+							  | VK_ACCESS_2_HOST_READ_BIT_KHR;
+
+	dependencyInfo.pMemoryBarriers = &cullBarrier;
+
+	VulkanDispatch::vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+}
+
+void MeshletCulling::RecordDraw(
+		VkCommandBuffer commandBuffer,
+		u32             frameIndex,
+		ClusterDraws    clusterDraws
+) const
+{
+	const FrameResources &frame = mFrames[frameIndex];
+
+	VulkanDispatch::vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			mDrawLayout,
+			mDrawSet,
+			1,
+			&frame.drawSet,
+			0,
+			nullptr
+	);
+	VulkanDispatch::vkCmdBindIndexBuffer(commandBuffer, frame.indices, 0, VK_INDEX_TYPE_UINT32);
+
+	// One draw each, several per call would need the multiDrawIndirect feature. Without
+	// occlusion the late draw stays empty.
+	const u32 firstDraw = clusterDraws == ClusterDraws::eLate ? 1 : 0;
+	const u32 lastDraw  = clusterDraws == ClusterDraws::eEarly ? 0 : 1;
+	for (u32 i = firstDraw; i <= lastDraw; ++i)
+	{
+		VulkanDispatch::vkCmdDrawIndexedIndirect(
+				commandBuffer, frame.drawCommand, i * kDrawCommandStride, 1, kDrawCommandStride
+		);
+	}
+}
+
+void MeshletCulling::LogStats() const
+{
+	if (mStats.testedClusters == 0)
+	{
+		return;
+	}
+
+	CLOG_INFO(
+			"Meshlet culling: ",
+			mStats.visibleClusters,
+			" of ",
+			mStats.testedClusters,
+			" clusters visible (",
+			mStats.droppedClusters,
+			" dropped over capacity, ",
+			mStats.occludedClusters,
+			" occluded)."
+	);
+}
+
+bool MeshletCulling::CreateFrameBuffers(FrameResources &frame)
+{
+	if (CreateBuffer(
+				mDevice,
+				mPhysicalDevice,
+				sizeof(glm::uvec2) * mMaxClusters,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				frame.clusters,
+				frame.clustersMemory
+		)
+		== EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	// Every kept cluster can hold a full meshlet.
+	if (CreateBuffer(
+				mDevice,
+				mPhysicalDevice,
+				sizeof(u32) * mMaxClusters * kMaxMeshletTriangles * 3,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				frame.indices,
+				frame.indicesMemory
+		)
+		== EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	const VkDeviceSize drawCommandSize = sizeof(u32) * (kOccludedCounterIndex + 1);
+	if (CreateBuffer(
+				mDevice,
+				mPhysicalDevice,
+				drawCommandSize,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+						| VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				frame.drawCommand,
+				frame.drawCommandMemory
+		)
+		== EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	void *mapped = nullptr;
+	if (vkMapMemory(mDevice, frame.drawCommandMemory, 0, drawCommandSize, 0, &mapped)
+		!= VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to map the meshlet draw command buffer.");
+		return EXIT_FAILURE;
+	}
+	frame.drawCommandMapped = static_cast<const u32 *>(mapped);
+
+	return EXIT_SUCCESS;
+}
+
+bool MeshletCulling::CreateCullPipeline(
+		VkShaderModule          cullModule,
+		const ShaderReflection &cullReflection
+)
+{
+	const ShaderReflection *stages[] = {&cullReflection};
+
+	std::optional<VkPipelineLayout> layout = mLayoutCache->GetPipelineLayout(stages, 1);
+	if (!layout.has_value())
+	{
+		CLOG_ERR("Meshlet culling pipeline layout creation failed.");
+		return EXIT_FAILURE;
+	}
+	mCullLayout = layout.value();
+
+	VkComputePipelineCreateInfo pipelineInfo = {};
+
+	pipelineInfo.sType        = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = cullModule;
+	pipelineInfo.stage.pName  = "main";
+	pipelineInfo.layout       = mCullLayout;
+
+	if (vkCreateComputePipelines(
+				mDevice, VK_NULL_HANDLE, 1, &pipelineInfo, mAllocator, &mCullPipeline
+		)
+		!= VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create the meshlet culling pipeline.");
+		return EXIT_FAILURE;
+	}
+
+	std::optional<VkDescriptorSetLayout> setLayout = mLayoutCache->FindSetLayout(mCullLayout, 0);
+	if (!setLayout.has_value())
+	{
+		CLOG_ERR("Meshlet culling shader declares no descriptor set.");
+		return EXIT_FAILURE;
+	}
+
+	return AllocateSets(setLayout.value(), &FrameResources::cullSet, true);
+}
+
+bool MeshletCulling::AllocateSets(
+		VkDescriptorSetLayout            setLayout,
+		VkDescriptorSet FrameResources::*setMember,
+		bool                             forCulling
+)
+{
+	for (FrameResources &frame : mFrames)
+	{
+		VkDescriptorSetAllocateInfo allocInfo = {};
+
+		allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool     = mDescriptorPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts        = &setLayout;
+
+		if (vkAllocateDescriptorSets(mDevice, &allocInfo, &(frame.*setMember)) != VK_SUCCESS)
+		{
+			CLOG_ERR("Failed to allocate a meshlet culling descriptor set.");
+			return EXIT_FAILURE;
+		}
+
+		const VkBuffer cullBuffers[kCullBindingCount] = {
+				mMesh->GetMeshletBuffer(),
+				mMesh->GetMeshletTriangleBuffer(),
+				frame.instances,
+				frame.clusters,
+				frame.indices,
+				frame.drawCommand
+		};
+
+		const VkBuffer drawBuffers[kDrawBindingCount] = {
+				mMesh->GetVertexBuffer(),
+				mMesh->GetMeshletVertexBuffer(),
+				mMesh->GetMeshletBuffer(),
+				frame.clusters,
+				frame.instances
+		};
+
+		const VkBuffer *buffers      = forCulling ? cullBuffers : drawBuffers;
+		const u32       bindingCount = forCulling ? kCullBindingCount : kDrawBindingCount;
+
+		VkDescriptorBufferInfo bufferInfos[kCullBindingCount] = {};
+		VkWriteDescriptorSet   writes[kCullBindingCount]      = {};
+		for (u32 i = 0; i < bindingCount; ++i)
+		{
+			bufferInfos[i].buffer = buffers[i];
+			bufferInfos[i].offset = 0;
+			bufferInfos[i].range  = VK_WHOLE_SIZE;
+
+			writes[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet          = frame.*setMember;
+			writes[i].dstBinding      = i;
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[i].pBufferInfo     = &bufferInfos[i];
+		}
+
+		vkUpdateDescriptorSets(mDevice, bindingCount, writes, 0, nullptr);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,178 @@
+#ifndef HEADER_MESHLET_CULLING_H
+#define HEADER_MESHLET_CULLING_H
+
+#include "definitions.h"
+#include "render/mesh.h"
+#include "render/spirv_reflect.h"
+#include "vulkan/vulkan_core.h"
+
+#include <vector>
+
+class PipelineLayoutCache;
+
+/* GPU culling of a mesh's meshlets without mesh shaders.
+ *
+ * A compute pass tests every meshlet of every drawn instance against the view box and its
+ * normal cone, and appends the triangles of the visible ones to an index buffer consumed by a
+ * single indexed indirect draw. Each visible cluster gets a slot, and its indices encode the
+ * slot and the meshlet-local vertex, so meshlet_vert.glsl fetches the instance, the meshlet and
+ * the position from storage buffers instead of vertex inputs. Clusters past maxClusters are
+ * dropped for the frame, the index buffer is sized for that many full meshlets.
+ *
+ * Compiled with HIZ_OCCLUSION, the culling shader also tests against render/hiz_pyramid.h in two
+ * phases sharing the index buffer: the early draw holds what the previous frame's depth does not
+ * hide, the late draw what it hid but the early phase's depth does not.
+ *
+ * Every frame in flight owns its output buffers. The render graph only tracks images, so culling
+ * records its own buffer barriers and its pass has to be marked with side effects. */
+class MeshletCulling
+{
+public:
+	// Visible clusters per frame unless Init is told otherwise.
+	static constexpr u32 kDefaultMaxClusters = 16 * 1024;
+
+	// Matches local_size_x of meshlet_cull_comp.glsl.
+	static constexpr u32 kWorkgroupSize = 64;
+
+	// Matches the phase constants of meshlet_cull_comp.glsl.
+	enum class CullPhase : u32
+	{
+		eNoOcclusion,
+		eEarly,// Against the previous frame's pyramid
+		eLate  // What eEarly hid, against the current one
+	};
+
+	enum class ClusterDraws
+	{
+		eEarly,// Also everything eNoOcclusion kept
+		eLate,
+		eAll
+	};
+
+	// Matches CullParams of meshlet_cull_comp.glsl.
+	struct PushConstants
+	{
+		u32       firstMeshlet;
+		u32       meshletCount;
+		u32       firstInstance;
+		u32       instanceCount;
+		u32       invocationOffset;
+		u32       clusterCapacity;
+		CullPhase phase;
+		u32       depthWidth;
+		u32       depthHeight;
+	};
+
+	// Summed over all frames, visible counts are read back once a frame's fence has passed.
+	struct Stats
+	{
+		u64 testedClusters   = 0;// Instance and meshlet pairs dispatched
+		u64 visibleClusters  = 0;
+		u64 droppedClusters  = 0;// Visible but past maxClusters
+		u64 occludedClusters = 0;// Hidden in both phases
+	};
+
+public:
+	/* cullModule is meshlet_cull_comp.glsl, with or without HIZ_OCCLUSION, only used during the
+	 * call. mesh, instanceBuffers (one per frame) and layoutCache have to outlive this object. */
+	bool Init(
+			VkDevice                     device,
+			VkPhysicalDevice             physicalDevice,
+			PipelineLayoutCache         &layoutCache,
+			VkShaderModule               cullModule,
+			const ShaderReflection      &cullReflection,
+			const GpuMesh               &mesh,
+			const VkBuffer              *instanceBuffers,
+			u32                          frameCount,
+			u32                          maxClusters,
+			const VkAllocationCallbacks *allocator
+	);
+
+	void Destroy();
+
+	/* Allocates the per-frame sets of a graphics pipeline layout whose set declares the buffers
+	 * of meshlet_vert.glsl. */
+	bool BindGraphicsLayout(VkPipelineLayout pipelineLayout, u32 set);
+
+	/* Outside render passes, once the previous submission of the frame has completed. Drawing can
+	 * follow without further barriers. Occlusion phases need the pyramid set bound on
+	 * GetCullLayout() and depthExtent of the depth the pyramids are built from. eLate follows
+	 * eEarly in the same frame with the same draws. */
+	void RecordCull(
+			VkCommandBuffer commandBuffer,
+			u32             frameIndex,
+			const MeshDraw *draws,
+			u32             drawCount,
+			CullPhase       phase       = CullPhase::eNoOcclusion,
+			VkExtent2D      depthExtent = {}
+	);
+
+	// Binds the set and index buffer, then draws the clusters RecordCull kept.
+	void RecordDraw(
+			VkCommandBuffer commandBuffer,
+			u32             frameIndex,
+			ClusterDraws    clusterDraws = ClusterDraws::eAll
+	) const;
+
+	[[nodiscard]] VkPipelineLayout GetCullLayout() const
+	{
+		return mCullLayout;
+	}
+
+	void LogStats() const;
+
+private:
+	struct FrameResources
+	{
+		VkBuffer       clusters       = VK_NULL_HANDLE;
+		VkDeviceMemory clustersMemory = VK_NULL_HANDLE;
+
+		VkBuffer       indices       = VK_NULL_HANDLE;
+		VkDeviceMemory indicesMemory = VK_NULL_HANDLE;
+
+		// Host visible so that the cluster counter can be read back for the stats.
+		VkBuffer       drawCommand       = VK_NULL_HANDLE;
+		VkDeviceMemory drawCommandMemory = VK_NULL_HANDLE;
+		const u32     *drawCommandMapped = nullptr;
+		bool           culled            = false;// The counter holds a result
+
+		VkBuffer instances = VK_NULL_HANDLE;// Not owned
+
+		VkDescriptorSet cullSet = VK_NULL_HANDLE;
+		VkDescriptorSet drawSet = VK_NULL_HANDLE;
+	};
+
+	bool CreateFrameBuffers(FrameResources &frame);
+
+	bool CreateCullPipeline(VkShaderModule cullModule, const ShaderReflection &cullReflection);
+
+	// Allocates a set of every frame and writes buffers to bindings 0 and up.
+	bool AllocateSets(
+			VkDescriptorSetLayout            setLayout,
+			VkDescriptorSet FrameResources::*setMember,
+			bool                             forCulling
+	);
+
+private:
+	VkDevice                     mDevice         = VK_NULL_HANDLE;
+	VkPhysicalDevice             mPhysicalDevice = VK_NULL_HANDLE;
+	PipelineLayoutCache         *mLayoutCache    = nullptr;
+	const VkAllocationCallbacks *mAllocator      = nullptr;
+
+	const GpuMesh *mMesh        = nullptr;
+	u32            mMaxClusters = 0;
+
+	VkDescriptorPool mDescriptorPool = VK_NULL_HANDLE;
+
+	VkPipelineLayout mCullLayout   = VK_NULL_HANDLE;// Owned by mLayoutCache
+	VkPipeline       mCullPipeline = VK_NULL_HANDLE;
+
+	VkPipelineLayout mDrawLayout = VK_NULL_HANDLE;// Owned by mLayoutCache
+	u32              mDrawSet    = 0;
+
+	std::vector<FrameResources> mFrames;
+
+	Stats mStats;
+};
+
+#endif// HEADER_MESHLET_CULLING_H
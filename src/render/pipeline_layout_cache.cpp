@@ -0,0 +1,318 @@
+#include "pipeline_layout_cache.h"
+
+#include "core/arena.h"
+#include "render/host_allocator.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+
+// FNV-1a, layouts are a handful of words so anything simple does.
+constexpr u64 kHashSeed  = 14695981039346656037ull;
+constexpr u64 kHashPrime = 1099511628211ull;
+
+static u64 HashCombine(u64 hash, u64 value)
+{
+	for (u32 byte = 0; byte < 8; ++byte)
+	{
+		hash ^= (value >> (byte * 8)) & 0xFF;
+		hash *= kHashPrime;
+	}
+
+	return hash;
+}
+
+static bool operator==(const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b)
+{
+	return a.binding == b.binding && a.descriptorType == b.descriptorType
+		&& a.descriptorCount == b.descriptorCount && a.stageFlags == b.stageFlags
+		&& a.pImmutableSamplers == b.pImmutableSamplers;
+}
+
+static bool operator==(const VkPushConstantRange &a, const VkPushConstantRange &b)
+{
+	return a.stageFlags == b.stageFlags && a.offset == b.offset && a.size == b.size;
+}
+
+void PipelineLayoutCache::Init(VkDevice device)
+{
+	mDevice    = device;
+	mAllocator = HostAllocator::GetCallbacks();
+}
+
+void PipelineLayoutCache::Destroy()
+{
+	for (auto &[hash, entry] : mPipelineLayouts)
+	{
+		vkDestroyPipelineLayout(mDevice, entry.layout, mAllocator);
+	}
+	for (auto &[hash, entry] : mSetLayouts)
+	{
+		vkDestroyDescriptorSetLayout(mDevice, entry.layout, mAllocator);
+	}
+
+	CLOG_INFO(
+			"Layout cache: ",
+			mStats.setLayoutsCreated,
+			" set layouts, ",
+			mStats.pipelineLayoutsCreated,
+			" pipeline layouts, ",
+			mStats.hits,
+			" hits."
+	);
+
+	mPipelineLayouts.clear();
+	mSetLayouts.clear();
+	mStats = {};
+}
+
+std::optional<VkDescriptorSetLayout> PipelineLayoutCache::GetSetLayout(
+		const VkDescriptorSetLayoutBinding *bindings,
+		u32                                 bindingCount
+)
+{
+	u64 hash = HashCombine(kHashSeed, bindingCount);
+	for (u32 i = 0; i < bindingCount; ++i)
+	{
+		hash = HashCombine(hash, bindings[i].binding);
+		hash = HashCombine(hash, bindings[i].descriptorType);
+		hash = HashCombine(hash, bindings[i].descriptorCount);
+		hash = HashCombine(hash, bindings[i].stageFlags);
+	}
+
+	auto [first, last] = mSetLayouts.equal_range(hash);
+	for (auto it = first; it != last; ++it)
+	{
+		const std::vector<VkDescriptorSetLayoutBinding> &cached = it->second.bindings;
+		if (std::equal(cached.begin(), cached.end(), bindings, bindings + bindingCount))
+		{
+			++mStats.hits;
+			return it->second.layout;
+		}
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+
+	layoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = bindingCount;
+	layoutInfo.pBindings    = bindings;
+
+	VkDescriptorSetLayout layout;
+	if (vkCreateDescriptorSetLayout(mDevice, &layoutInfo, mAllocator, &layout) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create descriptor set layout.");
+		return std::nullopt;
+	}
+
+	SetLayoutEntry entry = {};
+	entry.bindings.assign(bindings, bindings + bindingCount);
+	entry.layout = layout;
+	mSetLayouts.emplace(hash, std::move(entry));
+
+	++mStats.setLayoutsCreated;
+	return layout;
+}
+
+std::optional<VkDescriptorSetLayout> PipelineLayoutCache::FindSetLayout(
+		VkPipelineLayout pipelineLayout,
+		u32              set
+) const
+{
+	// Not on any hot path, a scan over the few pipeline layouts is fine.
+	for (const auto &[hash, entry] : mPipelineLayouts)
+	{
+		if (entry.layout == pipelineLayout)
+		{
+			if (set < entry.setLayouts.size())
+			{
+				return entry.setLayouts[set];
+			}
+			break;
+		}
+	}
+
+	return std::nullopt;
+}
+
+std::optional<VkPipelineLayout> PipelineLayoutCache::GetPipelineLayout(
+		const ShaderReflection *const *stages,
+		u32                            stageCount
+)
+{
+	struct SetBinding
+	{
+		u32                          set;
+		VkDescriptorSetLayoutBinding binding;
+	};
+
+	ScratchScope            scratch;
+	ArenaVector<SetBinding> bindings;
+	u32                     setCount = 0;
+
+	for (u32 stageIndex = 0; stageIndex < stageCount; ++stageIndex)
+	{
+		const ShaderReflection &stage = *stages[stageIndex];
+		for (const ReflectedBinding &reflected : stage.bindings)
+		{
+			SetBinding entry              = {};
+			entry.set                     = reflected.set;
+			entry.binding.binding         = reflected.binding;
+			entry.binding.descriptorType  = reflected.type;
+			entry.binding.descriptorCount = reflected.count;
+			entry.binding.stageFlags      = stage.stage;
+
+			bindings.push_back(entry);
+			setCount = std::max(setCount, reflected.set + 1);
+		}
+	}
+
+	std::sort(
+			bindings.begin(),
+			bindings.end(),
+			[](const SetBinding &a, const SetBinding &b)
+			{ return a.set != b.set ? a.set < b.set : a.binding.binding < b.binding.binding; }
+	);
+
+	// Fold bindings declared by several stages into one.
+	u32 mergedCount = 0;
+	for (u32 i = 0; i < bindings.size(); ++i)
+	{
+		SetBinding &current = bindings[i];
+		if (mergedCount > 0)
+		{
+			SetBinding &previous = bindings[mergedCount - 1];
+			if (previous.set == current.set && previous.binding.binding == current.binding.binding)
+			{
+				if (previous.binding.descriptorType != current.binding.descriptorType
+					|| previous.binding.descriptorCount != current.binding.descriptorCount)
+				{
+					CLOG_ERR(
+							"Stages disagree on set ",
+							current.set,
+							", binding ",
+							current.binding.binding,
+							"."
+					);
+					return std::nullopt;
+				}
+
+				previous.binding.stageFlags |= current.binding.stageFlags;
+				continue;
+			}
+		}
+
+		bindings[mergedCount++] = current;
+	}
+	bindings.resize(mergedCount);
+
+	ArenaVector<VkDescriptorSetLayout>        setLayouts(setCount);
+	ArenaVector<VkDescriptorSetLayoutBinding> setBindings;
+	u32                                       bindingIndex = 0;
+	for (u32 set = 0; set < setCount; ++set)
+	{
+		setBindings.clear();
+		for (; bindingIndex < bindings.size() && bindings[bindingIndex].set == set; ++bindingIndex)
+		{
+			setBindings.push_back(bindings[bindingIndex].binding);
+		}
+
+		std::optional<VkDescriptorSetLayout> layout =
+				GetSetLayout(setBindings.data(), (u32)setBindings.size());
+		if (!layout.has_value())
+		{
+			return std::nullopt;
+		}
+		setLayouts[set] = layout.value();
+	}
+
+	// One range per stage, stages pushing the same range share it.
+	ArenaVector<VkPushConstantRange> pushConstants;
+	for (u32 stageIndex = 0; stageIndex < stageCount; ++stageIndex)
+	{
+		const ShaderReflection &stage = *stages[stageIndex];
+		if (stage.pushConstantSize == 0)
+		{
+			continue;
+		}
+
+		auto shared = std::find_if(
+				pushConstants.begin(),
+				pushConstants.end(),
+				[&stage](const VkPushConstantRange &range)
+				{
+					return range.offset == stage.pushConstantOffset
+						&& range.size == stage.pushConstantSize;
+				}
+		);
+
+		if (shared != pushConstants.end())
+		{
+			shared->stageFlags |= stage.stage;
+		}
+		else
+		{
+			pushConstants.push_back({(VkShaderStageFlags)stage.stage,
+									 stage.pushConstantOffset,
+									 stage.pushConstantSize});
+		}
+	}
+
+	// Set layouts are deduplicated already, their handles identify them.
+	u64 hash = HashCombine(kHashSeed, setLayouts.size());
+	for (VkDescriptorSetLayout setLayout : setLayouts)
+	{
+		hash = HashCombine(hash, (u64)setLayout);
+	}
+	for (const VkPushConstantRange &range : pushConstants)
+	{
+		hash = HashCombine(hash, range.stageFlags);
+		hash = HashCombine(hash, ((u64)range.offset << 32) | range.size);
+	}
+
+	auto [first, last] = mPipelineLayouts.equal_range(hash);
+	for (auto it = first; it != last; ++it)
+	{
+		const PipelineLayoutEntry &cached = it->second;
+
+		const bool sameSets = std::equal(
+				cached.setLayouts.begin(),
+				cached.setLayouts.end(),
+				setLayouts.begin(),
+				setLayouts.end()
+		);
+		const bool samePushConstants = std::equal(
+				cached.pushConstants.begin(),
+				cached.pushConstants.end(),
+				pushConstants.begin(),
+				pushConstants.end()
+		);
+
+		if (sameSets && samePushConstants)
+		{
+			++mStats.hits;
+			return cached.layout;
+		}
+	}
+
+	VkPipelineLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType                      = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount             = (u32)setLayouts.size();
+	layoutInfo.pSetLayouts                = setLayouts.data();
+	layoutInfo.pushConstantRangeCount     = (u32)pushConstants.size();
+	layoutInfo.pPushConstantRanges        = pushConstants.data();
+
+	VkPipelineLayout layout;
+	if (vkCreatePipelineLayout(mDevice, &layoutInfo, mAllocator, &layout) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create pipeline layout.");
+		return std::nullopt;
+	}
+
+	PipelineLayoutEntry entry = {};
+	entry.setLayouts.assign(setLayouts.begin(), setLayouts.end());
+	entry.pushConstants.assign(pushConstants.begin(), pushConstants.end());
+	entry.layout = layout;
+	mPipelineLayouts.emplace(hash, std::move(entry));
+
+	++mStats.pipelineLayoutsCreated;
+	return layout;
+}
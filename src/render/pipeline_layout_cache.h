@@ -0,0 +1,81 @@
+#ifndef HEADER_PIPELINE_LAYOUT_CACHE_H
+#define HEADER_PIPELINE_LAYOUT_CACHE_H
+
+#include "definitions.h"
+#include "render/spirv_reflect.h"
+#include "vulkan/vulkan_core.h"
+
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+/* Builds descriptor set and pipeline layouts from shader reflection and shares them between
+ * pipelines. Layouts are looked up by a hash of their content (collisions are resolved by
+ * comparing it), so every distinct layout is created once and identical pipelines end up with
+ * the same handles. The cache owns all layouts it returns. */
+class PipelineLayoutCache
+{
+public:
+	struct Stats
+	{
+		u32 setLayoutsCreated      = 0;
+		u32 pipelineLayoutsCreated = 0;
+		u32 hits                   = 0;
+	};
+
+public:
+	void Init(VkDevice device);
+
+	void Destroy();
+
+	/* Merges the stages of one pipeline: bindings used by several stages get all their stage
+	 * flags and have to agree on type and count. Set indices without bindings get an empty set
+	 * layout. */
+	std::optional<VkPipelineLayout> GetPipelineLayout(
+			const ShaderReflection *const *stages,
+			u32                            stageCount
+	);
+
+	// bindings have to be sorted by binding number.
+	std::optional<VkDescriptorSetLayout> GetSetLayout(
+			const VkDescriptorSetLayoutBinding *bindings,
+			u32                                 bindingCount
+	);
+
+	// Set layout of a pipeline layout from this cache, to allocate descriptor sets for it.
+	[[nodiscard]] std::optional<VkDescriptorSetLayout> FindSetLayout(
+			VkPipelineLayout pipelineLayout,
+			u32              set
+	) const;
+
+	[[nodiscard]] const Stats &GetStats() const
+	{
+		return mStats;
+	}
+
+private:
+	struct SetLayoutEntry
+	{
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		VkDescriptorSetLayout                     layout;
+	};
+
+	struct PipelineLayoutEntry
+	{
+		std::vector<VkDescriptorSetLayout> setLayouts;
+		std::vector<VkPushConstantRange>   pushConstants;
+		VkPipelineLayout                   layout;
+	};
+
+private:
+	VkDevice                     mDevice    = VK_NULL_HANDLE;
+	const VkAllocationCallbacks *mAllocator = nullptr;
+
+	// Hash to entries with that hash, usually exactly one.
+	std::unordered_multimap<u64, SetLayoutEntry>      mSetLayouts;
+	std::unordered_multimap<u64, PipelineLayoutEntry> mPipelineLayouts;
+
+	Stats mStats;
+};
+
+#endif// HEADER_PIPELINE_LAYOUT_CACHE_H
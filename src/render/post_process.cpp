@@ -0,0 +1,250 @@
+#include "post_process.h"
+
+#include "render/pipeline_layout_cache.h"
+#include "render/vk_dispatch.h"
+#include "utils/logger.h"
+
+#include <cstdlib>
+
+bool PostProcess::Init(
+		VkDevice                     device,
+		PipelineLayoutCache         &layoutCache,
+		VkShaderModule               module,
+		const ShaderReflection      &reflection,
+		const Settings              &settings,
+		const VkAllocationCallbacks *allocator
+)
+{
+	mDevice    = device;
+	mAllocator = allocator;
+	mSettings  = settings;
+
+	// texelFetch only, filtering never applies.
+	VkSamplerCreateInfo samplerInfo = {};
+
+	samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter    = VK_FILTER_NEAREST;
+	samplerInfo.minFilter    = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+	if (vkCreateSampler(mDevice, &samplerInfo, mAllocator, &mSampler) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create the post-processing sampler.");
+		return EXIT_FAILURE;
+	}
+
+	const ShaderReflection *stages[] = {&reflection};
+
+	std::optional<VkPipelineLayout> layout = layoutCache.GetPipelineLayout(stages, 1);
+	if (!layout.has_value())
+	{
+		CLOG_ERR("Post-processing pipeline layout creation failed.");
+		return EXIT_FAILURE;
+	}
+	mPipelineLayout = layout.value();
+
+	std::optional<VkDescriptorSetLayout> setLayout = layoutCache.FindSetLayout(mPipelineLayout, 0);
+	if (!setLayout.has_value())
+	{
+		CLOG_ERR("Post-processing shader declares no descriptor set.");
+		return EXIT_FAILURE;
+	}
+	mSetLayout = setLayout.value();
+
+	return CreatePipeline(module, reflection);
+}
+
+void PostProcess::Destroy()
+{
+	if (mDevice == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	vkDestroyPipeline(mDevice, mPipeline, mAllocator);
+	vkDestroyDescriptorPool(mDevice, mDescriptorPool, mAllocator);
+	vkDestroySampler(mDevice, mSampler, mAllocator);
+	mSets.clear();
+
+	mPipeline       = VK_NULL_HANDLE;
+	mDescriptorPool = VK_NULL_HANDLE;
+	mSampler        = VK_NULL_HANDLE;
+	mSetLayout      = VK_NULL_HANDLE;
+	mPipelineLayout = VK_NULL_HANDLE;
+	mDevice         = VK_NULL_HANDLE;
+}
+
+bool PostProcess::Resize(
+		VkImageView                     hdrView,
+		const std::vector<VkImageView> &outputViews,
+		VkExtent2D                      extent
+)
+{
+	// The swap chain image count can change with the swap chain, the pool follows it.
+	vkDestroyDescriptorPool(mDevice, mDescriptorPool, mAllocator);
+	mDescriptorPool = VK_NULL_HANDLE;
+	mSets.clear();
+
+	mExtent = extent;
+
+	const u32 setCount = (u32)outputViews.size();
+
+	VkDescriptorPoolSize poolSizes[2] = {};
+
+	poolSizes[0].type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[0].descriptorCount = setCount;
+	poolSizes[1].type            = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	poolSizes[1].descriptorCount = setCount;
+
+	VkDescriptorPoolCreateInfo poolInfo = {};
+
+	poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.maxSets       = setCount;
+	poolInfo.poolSizeCount = (u32)std::size(poolSizes);
+	poolInfo.pPoolSizes    = poolSizes;
+
+	if (vkCreateDescriptorPool(mDevice, &poolInfo, mAllocator, &mDescriptorPool) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create the post-processing descriptor pool.");
+		return EXIT_FAILURE;
+	}
+
+	const std::vector<VkDescriptorSetLayout> setLayouts(setCount, mSetLayout);
+	mSets.resize(setCount);
+
+	VkDescriptorSetAllocateInfo allocInfo = {};
+
+	allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool     = mDescriptorPool;
+	allocInfo.descriptorSetCount = setCount;
+	allocInfo.pSetLayouts        = setLayouts.data();
+
+	if (vkAllocateDescriptorSets(mDevice, &allocInfo, mSets.data()) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to allocate the post-processing sets.");
+		return EXIT_FAILURE;
+	}
+
+	for (u32 i = 0; i < setCount; ++i)
+	{
+		VkDescriptorImageInfo hdrInfo = {};
+		hdrInfo.sampler               = mSampler;
+		hdrInfo.imageView             = hdrView;
+		hdrInfo.imageLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		VkDescriptorImageInfo outputInfo = {};
+		outputInfo.imageView             = outputViews[i];
+		outputInfo.imageLayout           = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkWriteDescriptorSet writes[2] = {};
+
+		writes[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[0].dstSet          = mSets[i];
+		writes[0].dstBinding      = 0;
+		writes[0].descriptorCount = 1;
+		writes[0].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].pImageInfo      = &hdrInfo;
+
+		writes[1].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[1].dstSet          = mSets[i];
+		writes[1].dstBinding      = 1;
+		writes[1].descriptorCount = 1;
+		writes[1].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writes[1].pImageInfo      = &outputInfo;
+
+		vkUpdateDescriptorSets(mDevice, (u32)std::size(writes), writes, 0, nullptr);
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void PostProcess::Record(VkCommandBuffer commandBuffer, u32 imageIndex)
+{
+	PushConstants pushConstants    = {};
+	pushConstants.exposure         = mSettings.exposure;
+	pushConstants.contrast         = mSettings.contrast;
+	pushConstants.saturation       = mSettings.saturation;
+	pushConstants.sharpness        = mSettings.sharpness;
+	pushConstants.vignetteStrength = mSettings.vignetteStrength;
+	pushConstants.vignetteRadius   = mSettings.vignetteRadius;
+
+	VulkanDispatch::vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mPipeline);
+	VulkanDispatch::vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			mPipelineLayout,
+			0,
+			1,
+			&mSets[imageIndex],
+			0,
+			nullptr
+	);
+	VulkanDispatch::vkCmdPushConstants(
+			commandBuffer,
+			mPipelineLayout,
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			0,
+			sizeof(PushConstants),
+			&pushConstants
+	);
+	VulkanDispatch::vkCmdDispatch(
+			commandBuffer,
+			(mExtent.width + kGroupSize - 1) / kGroupSize,
+			(mExtent.height + kGroupSize - 1) / kGroupSize,
+			1
+	);
+
+	++mDispatches;
+}
+
+void PostProcess::LogStats() const
+{
+	if (mDispatches == 0)
+	{
+		return;
+	}
+
+	CLOG_INFO(
+			"Post-processing: ",
+			mDispatches,
+			" dispatches, tonemap ",
+			(mSettings.effects & kTonemap) ? "on" : "off",
+			", grade ",
+			(mSettings.effects & kColorGrade) ? "on" : "off",
+			", sharpen ",
+			(mSettings.effects & kSharpen) ? "on" : "off",
+			", vignette ",
+			(mSettings.effects & kVignette) ? "on" : "off",
+			"."
+	);
+}
+
+bool PostProcess::CreatePipeline(VkShaderModule module, const ShaderReflection &reflection)
+{
+	if (reflection.pushConstantSize != sizeof(PushConstants))
+	{
+		CLOG_ERR("Post-processing shader push constants do not match PushConstants.");
+		return EXIT_FAILURE;
+	}
+
+	VkComputePipelineCreateInfo pipelineInfo = {};
+
+	pipelineInfo.sType        = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = module;
+	pipelineInfo.stage.pName  = "main";
+	pipelineInfo.layout       = mPipelineLayout;
+
+	if (vkCreateComputePipelines(mDevice, VK_NULL_HANDLE, 1, &pipelineInfo, mAllocator, &mPipeline)
+		!= VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create the post-processing pipeline.");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
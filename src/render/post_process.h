@@ -0,0 +1,111 @@
+#ifndef HEADER_POST_PROCESS_H
+#define HEADER_POST_PROCESS_H
+
+#include "definitions.h"
+#include "render/spirv_reflect.h"
+#include "vulkan/vulkan_core.h"
+
+#include <vector>
+
+class PipelineLayoutCache;
+
+/* Tonemapping, color grading, sharpening and vignette, fused into a single compute dispatch that
+ * reads the HDR scene color and writes the swap chain image.
+ *
+ * The effects are chained in registers, so each one adds no full-screen read or write. Which
+ * ones run is fixed at Init by picking the post_process_comp.glsl permutation of their bits,
+ * disabled effects cost nothing.
+ *
+ * The swap chain image is written as a storage image, in a UNORM format the shader encodes to
+ * sRGB. Both images belong to the render graph: the pass reads the scene color as
+ * eComputeSampled and writes the swap chain image as eComputeStorageWrite. */
+class PostProcess
+{
+public:
+	// Effect bits, matching the permutations built by CMakeLists.txt.
+	static constexpr u32 kTonemap    = 1 << 0;
+	static constexpr u32 kColorGrade = 1 << 1;
+	static constexpr u32 kSharpen    = 1 << 2;
+	static constexpr u32 kVignette   = 1 << 3;
+	static constexpr u32 kAllEffects = kTonemap | kColorGrade | kSharpen | kVignette;
+
+	static constexpr u32 kPermutationCount = kAllEffects + 1;
+
+	// Scene color the main pass renders into when post-processing is on.
+	static constexpr VkFormat kHdrFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+	// Matches the local size of post_process_comp.glsl.
+	static constexpr u32 kGroupSize = 8;
+
+	struct Settings
+	{
+		u32 effects = kAllEffects;
+
+		f32 exposure   = 1.0f;
+		f32 contrast   = 1.1f;// Power around middle grey, 1 keeps the tonemapped image
+		f32 saturation = 1.1f;
+		f32 sharpness  = 0.3f;
+
+		f32 vignetteStrength = 0.35f;// Darkening in the corners
+		f32 vignetteRadius   = 0.6f; // Where darkening starts, 1 being the corners
+	};
+
+	// Matches PostParams of post_process_comp.glsl.
+	struct PushConstants
+	{
+		f32 exposure;
+		f32 contrast;
+		f32 saturation;
+		f32 sharpness;
+		f32 vignetteStrength;
+		f32 vignetteRadius;
+	};
+
+public:
+	// module is the permutation of settings.effects, only used during the call.
+	bool Init(
+			VkDevice                     device,
+			PipelineLayoutCache         &layoutCache,
+			VkShaderModule               module,
+			const ShaderReflection      &reflection,
+			const Settings              &settings,
+			const VkAllocationCallbacks *allocator
+	);
+
+	void Destroy();
+
+	/* Writes one set per swap chain image, reading hdrView and writing the image's view. The
+	 * views stay owned by the caller and are only referenced until the next Resize. */
+	bool Resize(
+			VkImageView                     hdrView,
+			const std::vector<VkImageView> &outputViews,
+			VkExtent2D                      extent
+	);
+
+	void Record(VkCommandBuffer commandBuffer, u32 imageIndex);
+
+	void LogStats() const;
+
+private:
+	bool CreatePipeline(VkShaderModule module, const ShaderReflection &reflection);
+
+private:
+	VkDevice                     mDevice    = VK_NULL_HANDLE;
+	const VkAllocationCallbacks *mAllocator = nullptr;
+
+	Settings mSettings;
+
+	VkSampler             mSampler        = VK_NULL_HANDLE;
+	VkDescriptorPool      mDescriptorPool = VK_NULL_HANDLE;// Recreated by Resize
+	VkDescriptorSetLayout mSetLayout      = VK_NULL_HANDLE;// Owned by the layout cache
+
+	VkPipelineLayout mPipelineLayout = VK_NULL_HANDLE;// Owned by the layout cache
+	VkPipeline       mPipeline       = VK_NULL_HANDLE;
+
+	std::vector<VkDescriptorSet> mSets;// One per swap chain image
+	VkExtent2D                   mExtent = {};
+
+	u64 mDispatches = 0;
+};
+
+#endif// HEADER_POST_PROCESS_H
@@ -0,0 +1,211 @@
+#include "render_extract.h"
+
+#include "core/arena.h"
+#include "core/job_system.h"
+#include "scene/ecs.h"
+#include "scene/simulation.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+
+static u32 SelectLod(const LodSelection &lodSelection, f32 scale)
+{
+	const f32 pixelsPerError = scale * lodSelection.pixelsPerUnit;
+
+	u32 lod = 0;
+	while (lod + 1 < lodSelection.lodCount
+		   && lodSelection.lods[lod + 1].error * pixelsPerError <= lodSelection.maxPixelError)
+	{
+		++lod;
+	}
+	return lod;
+}
+
+u32 ExtractInstances(
+		const EcsWorld     &world,
+		JobSystem          &jobSystem,
+		LinearArena        &frameArena,
+		InstanceData       *dst,
+		u32                 capacity,
+		const LodSelection &lodSelection,
+		InstanceBatches    *batches
+)
+{
+	ArenaVector<EcsWorld::ChunkRef> chunks{ArenaAllocator<EcsWorld::ChunkRef>(frameArena)};
+	world.GatherChunks(ComponentRegistry::GetMask<InstanceTransform, InstanceColor>(), chunks);
+
+	if (batches != nullptr)
+	{
+		*batches = {};
+	}
+
+	if (chunks.empty())
+	{
+		return 0;
+	}
+
+	// Static chunks go first. Order within each group does not matter, std::partition does not
+	// allocate where std::stable_partition would.
+	const ComponentId bodyId = ComponentRegistry::GetId<SimulatedBody>();
+	const auto        firstDynamic = std::partition(
+			chunks.begin(),
+			chunks.end(),
+			[bodyId](const EcsWorld::ChunkRef &ref) { return !ref.archetype->Has(bodyId); }
+	);
+	const u32 staticChunkCount = (u32)(firstDynamic - chunks.begin());
+
+	const u32 lodCount = lodSelection.lods != nullptr
+							   ? std::clamp(lodSelection.lodCount, 1u, kMaxMeshLods)
+							   : 1;
+
+	// Instances of every chunk and LOD, turned into the destination offset of each after counting,
+	// so workers never share output.
+	ArenaVector<u32> lodOffsets{ArenaAllocator<u32>(frameArena)};
+	lodOffsets.assign(chunks.size() * kMaxMeshLods, 0);
+
+	auto countChunks = [&chunks, &lodOffsets, &lodSelection, lodCount](u32 begin, u32 end)
+	{
+		for (u32 i = begin; i < end; ++i)
+		{
+			ChunkView view(*chunks[i].archetype, chunks[i].chunkIndex);
+			u32      *counts = &lodOffsets[i * kMaxMeshLods];
+
+			if (lodCount == 1)
+			{
+				counts[0] = view.Count();
+				continue;
+			}
+
+			const InstanceTransform *transforms = view.Get<InstanceTransform>();
+			for (u32 j = 0; j < view.Count(); ++j)
+			{
+				++counts[SelectLod(lodSelection, transforms[j].scale)];
+			}
+		}
+	};
+	jobSystem.ParallelFor((u32)chunks.size(), 4, countChunks);
+
+	InstanceBatches localBatches;
+	InstanceBatches &out = batches != nullptr ? *batches : localBatches;
+
+	u32 total = 0;
+	for (u32 group = 0; group < 2; ++group)
+	{
+		const u32 chunkBegin = group == 0 ? 0 : staticChunkCount;
+		const u32 chunkEnd   = group == 0 ? staticChunkCount : (u32)chunks.size();
+
+		for (u32 lod = 0; lod < lodCount; ++lod)
+		{
+			const u32 first = total;
+			for (u32 i = chunkBegin; i < chunkEnd; ++i)
+			{
+				const u32 count = lodOffsets[i * kMaxMeshLods + lod];
+
+				lodOffsets[i * kMaxMeshLods + lod]  = total;
+				total                              += count;
+			}
+
+			const u32 clampedFirst = std::min(first, capacity);
+			const u32 clampedEnd   = std::min(total, capacity);
+			if (clampedEnd > clampedFirst)
+			{
+				out.draws[out.drawCount++] = {lod, clampedFirst, clampedEnd - clampedFirst};
+			}
+		}
+
+		if (group == 0)
+		{
+			out.staticDrawCount = out.drawCount;
+			out.staticCount     = std::min(total, capacity);
+		}
+	}
+
+	if (total > capacity)
+	{
+		CLOG_WARN("Instance buffer too small, ", total - capacity, " instances dropped.");
+	}
+
+	auto extractChunks = [&chunks, &lodOffsets, &lodSelection, lodCount, dst, capacity](
+								 u32 begin, u32 end
+						 )
+	{
+		for (u32 i = begin; i < end; ++i)
+		{
+			ChunkView                view(*chunks[i].archetype, chunks[i].chunkIndex);
+			const InstanceTransform *transforms = view.Get<InstanceTransform>();
+			const InstanceColor     *colors     = view.Get<InstanceColor>();
+
+			u32 cursors[kMaxMeshLods];
+			std::copy_n(&lodOffsets[i * kMaxMeshLods], kMaxMeshLods, cursors);
+
+			for (u32 j = 0; j < view.Count(); ++j)
+			{
+				const u32 lod  = lodCount == 1 ? 0 : SelectLod(lodSelection, transforms[j].scale);
+				const u32 slot = cursors[lod]++;
+				if (slot >= capacity)
+				{
+					continue;
+				}
+
+				dst[slot].positionScale = glm::vec4(transforms[j].position, transforms[j].scale);
+				dst[slot].color         = colors[j].color;
+			}
+		}
+	};
+	jobSystem.ParallelFor((u32)chunks.size(), 4, extractChunks);
+
+	return std::min(total, capacity);
+}
+
+u32 ExtractLights(
+		const EcsWorld &world,
+		JobSystem      &jobSystem,
+		LinearArena    &frameArena,
+		LightData      *dst,
+		u32             capacity
+)
+{
+	ArenaVector<EcsWorld::ChunkRef> chunks{ArenaAllocator<EcsWorld::ChunkRef>(frameArena)};
+	world.GatherChunks(ComponentRegistry::GetMask<InstanceTransform, PointLight>(), chunks);
+
+	if (chunks.empty())
+	{
+		return 0;
+	}
+
+	const EcsWorld::ChunkRef &lastChunk = chunks.back();
+	const u32                 total =
+			lastChunk.firstEntity + lastChunk.archetype->GetChunk(lastChunk.chunkIndex).count;
+
+	if (total > capacity)
+	{
+		CLOG_WARN("Light buffer too small, ", total - capacity, " lights dropped.");
+	}
+
+	auto extractChunks = [&chunks, dst, capacity](u32 begin, u32 end)
+	{
+		for (u32 i = begin; i < end; ++i)
+		{
+			const EcsWorld::ChunkRef &ref = chunks[i];
+			if (ref.firstEntity >= capacity)
+			{
+				break;
+			}
+
+			ChunkView                view(*ref.archetype, ref.chunkIndex);
+			const InstanceTransform *transforms = view.Get<InstanceTransform>();
+			const PointLight        *lights     = view.Get<PointLight>();
+			const u32                count      = std::min(view.Count(), capacity - ref.firstEntity);
+
+			LightData *out = dst + ref.firstEntity;
+			for (u32 j = 0; j < count; ++j)
+			{
+				out[j].positionRadius = glm::vec4(transforms[j].position, lights[j].radius);
+				out[j].color          = glm::vec4(lights[j].color, 1.0f);
+			}
+		}
+	};
+	jobSystem.ParallelFor((u32)chunks.size(), 4, extractChunks);
+
+	return std::min(total, capacity);
+}
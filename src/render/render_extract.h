@@ -0,0 +1,95 @@
+#ifndef HEADER_RENDER_EXTRACT_H
+#define HEADER_RENDER_EXTRACT_H
+
+#include "definitions.h"
+#include "pch/glm.h"
+#include "render/mesh.h"
+
+class EcsWorld;
+class JobSystem;
+class LinearArena;
+
+/* Components of renderable entities and the per-instance vertex data the main pass reads. The
+ * extraction step copies the first into the second once per frame, straight into the mapped
+ * instance buffer of the frame being recorded. */
+
+struct InstanceTransform
+{
+	glm::vec3 position = glm::vec3(0.0f);
+	f32       scale    = 1.0f;
+};
+
+struct InstanceColor
+{
+	glm::vec4 color = glm::vec4(1.0f);
+};
+
+// Entities with a PointLight and an InstanceTransform are lights, the transform scale is unused.
+struct PointLight
+{
+	glm::vec3 color  = glm::vec3(1.0f);
+	f32       radius = 0.1f;
+};
+
+// Matches the per-instance attributes of shader_vert.glsl.
+struct InstanceData
+{
+	glm::vec4 positionScale;
+	glm::vec4 color;
+};
+
+// Matches PointLight of light_cull_comp.glsl and clustered_frag.glsl.
+struct LightData
+{
+	glm::vec4 positionRadius;
+	glm::vec4 color;
+};
+
+/* How ExtractInstances picks the LOD of an instance: the coarsest one whose error, scaled by the
+ * instance and projected to the screen, stays within maxPixelError. The projection is
+ * orthographic, so the projected size only depends on the instance scale. The default keeps
+ * every instance at LOD 0. */
+struct LodSelection
+{
+	const MeshLod *lods          = nullptr;
+	u32            lodCount      = 1;
+	f32            pixelsPerUnit = 0.0f;// Screen pixels per scene unit of x and y
+	f32            maxPixelError = 1.0f;
+};
+
+// Draw ranges of the extracted instances: static instances first, each group sorted by LOD.
+struct InstanceBatches
+{
+	MeshDraw draws[2 * kMaxMeshLods];
+	u32      drawCount       = 0;
+	u32      staticDrawCount = 0;// The first draws, covering instances [0, staticCount)
+	u32      staticCount     = 0;
+};
+
+/* Writes one InstanceData per entity having both InstanceTransform and InstanceColor, with chunks
+ * spread over the job system. Returns the number of written instances, at most capacity. The
+ * chunk list and counters are allocated from frameArena.
+ *
+ * Static entities (without a SimulatedBody) are written first so they can be drawn apart from
+ * the moving ones, and each group is sorted by the LOD lodSelection picks. batches receives the
+ * resulting draws and can be nullptr. */
+u32 ExtractInstances(
+		const EcsWorld     &world,
+		JobSystem          &jobSystem,
+		LinearArena        &frameArena,
+		InstanceData       *dst,
+		u32                 capacity,
+		const LodSelection &lodSelection = {},
+		InstanceBatches    *batches      = nullptr
+);
+
+// Same as ExtractInstances, for entities having both InstanceTransform and PointLight.
+u32 ExtractLights(
+		const EcsWorld &world,
+		JobSystem      &jobSystem,
+		LinearArena    &frameArena,
+		LightData      *dst,
+		u32             capacity
+);
+
+#endif// HEADER_RENDER_EXTRACT_H
@@ -0,0 +1,783 @@
+#include "render_graph.h"
+
+#include "render/gpu_trace.h"
+#include "render/host_allocator.h"
+#include "render/vk_dispatch.h"
+#include "render/vk_utils.h"
+#include "utils/logger.h"
+#include "utils/trace.h"
+
+#include <algorithm>
+
+// Barriers are recorded from a stack array, batches larger than this are split.
+constexpr u32 kMaxBarriersPerBatch = 32;
+
+
+/**************************************
+*       PASS BUILDER
+**************************************/
+
+RenderGraph::PassBuilder::PassBuilder(RenderGraph &graph, u32 passIndex)
+	: mGraph(graph)
+	, mPassIndex(passIndex)
+{
+}
+
+RenderGraph::PassBuilder &RenderGraph::PassBuilder::Read(RGHandle resource, RGAccess access)
+{
+	COV_ASSERT(resource < mGraph.mResources.size(), "Invalid render graph resource.");
+	COV_ASSERT(!GetAccessInfo(access).write, "Write access used in PassBuilder::Read.");
+
+	mGraph.mPasses[mPassIndex].accesses.push_back({resource, access});
+	return *this;
+}
+
+RenderGraph::PassBuilder &RenderGraph::PassBuilder::Write(RGHandle resource, RGAccess access)
+{
+	COV_ASSERT(resource < mGraph.mResources.size(), "Invalid render graph resource.");
+	COV_ASSERT(GetAccessInfo(access).write, "Read access used in PassBuilder::Write.");
+
+	mGraph.mPasses[mPassIndex].accesses.push_back({resource, access});
+	return *this;
+}
+
+RenderGraph::PassBuilder &RenderGraph::PassBuilder::SetSideEffects()
+{
+	mGraph.mPasses[mPassIndex].sideEffects = true;
+	return *this;
+}
+
+
+/**************************************
+*       RENDER GRAPH
+**************************************/
+
+void RenderGraph::Init(VkDevice device, VkPhysicalDevice physicalDevice)
+{
+	mDevice         = device;
+	mPhysicalDevice = physicalDevice;
+	mAllocator      = HostAllocator::GetCallbacks();
+}
+
+void RenderGraph::Reset()
+{
+	for (Resource &resource : mResources)
+	{
+		if (resource.imported)
+		{
+			continue;
+		}
+
+		if (resource.view != VK_NULL_HANDLE)
+		{
+			vkDestroyImageView(mDevice, resource.view, mAllocator);
+		}
+
+		if (resource.image != VK_NULL_HANDLE)
+		{
+			vkDestroyImage(mDevice, resource.image, mAllocator);
+		}
+	}
+
+	if (mTransientMemory != VK_NULL_HANDLE)
+	{
+		vkFreeMemory(mDevice, mTransientMemory, mAllocator);
+		mTransientMemory = VK_NULL_HANDLE;
+	}
+
+	if (mLazyMemory != VK_NULL_HANDLE)
+	{
+		vkFreeMemory(mDevice, mLazyMemory, mAllocator);
+		mLazyMemory = VK_NULL_HANDLE;
+	}
+
+	mResources.clear();
+	mPasses.clear();
+	mCompiledPasses.clear();
+	mBarriers.clear();
+
+	mFinalBarrierOffset = 0;
+	mFinalBarrierCount  = 0;
+	mStats              = {};
+}
+
+RGHandle RenderGraph::ImportImage(
+		const char           *name,
+		const RGImageDesc    &desc,
+		VkImageLayout         initialLayout,
+		VkPipelineStageFlags2 initialStage,
+		VkImageLayout         finalLayout
+)
+{
+	Resource resource      = {};
+	resource.name          = name;
+	resource.desc          = desc;
+	resource.imported      = true;
+	resource.initialLayout = initialLayout;
+	resource.initialStage  = initialStage;
+	resource.finalLayout   = finalLayout;
+
+	mResources.push_back(resource);
+	return (RGHandle)(mResources.size() - 1);
+}
+
+RGHandle RenderGraph::CreateImage(const char *name, const RGImageDesc &desc)
+{
+	Resource resource = {};
+	resource.name     = name;
+	resource.desc     = desc;
+
+	mResources.push_back(resource);
+	return (RGHandle)(mResources.size() - 1);
+}
+
+RenderGraph::PassBuilder RenderGraph::AddPass(const char *name, ExecuteFunction execute)
+{
+	Pass pass    = {};
+	pass.name    = name;
+	pass.execute = std::move(execute);
+
+	mPasses.push_back(std::move(pass));
+	return PassBuilder(*this, (u32)(mPasses.size() - 1));
+}
+
+void RenderGraph::MarkOutput(RGHandle resource)
+{
+	COV_ASSERT(resource < mResources.size(), "Invalid render graph resource.");
+	mResources[resource].output = true;
+}
+
+void RenderGraph::SetImportedImage(RGHandle resource, VkImage image, VkImageView view)
+{
+	COV_ASSERT(mResources[resource].imported, "Only imported images can be replaced.");
+
+	mResources[resource].image = image;
+	mResources[resource].view  = view;
+}
+
+VkImage RenderGraph::GetImage(RGHandle resource) const
+{
+	return mResources[resource].image;
+}
+
+VkImageView RenderGraph::GetImageView(RGHandle resource) const
+{
+	return mResources[resource].view;
+}
+
+RenderGraph::AccessInfo RenderGraph::GetAccessInfo(RGAccess access)
+{
+	AccessInfo info = {};
+
+	switch (access)
+	{
+	case RGAccess::eColorAttachmentWrite:
+	case RGAccess::eResolveWrite:
+		info.stages = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR;
+		info.access = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR;
+		info.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		info.write  = true;
+		break;
+	case RGAccess::eColorAttachmentRead:
+		info.stages = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR;
+		info.access = VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT_KHR;
+		info.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		break;
+	case RGAccess::eDepthAttachmentWrite:
+		info.stages = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR
+					| VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR;
+		info.access = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR
+					| VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR;
+		info.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		info.write  = true;
+		break;
+	case RGAccess::eDepthAttachmentRead:
+		info.stages = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR
+					| VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR;
+		info.access = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR;
+		info.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		break;
+	case RGAccess::eFragmentSampled:
+		info.stages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR;
+		info.access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR;
+		info.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		break;
+	case RGAccess::eComputeSampled:
+		info.stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+		info.access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR;
+		info.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		break;
+	case RGAccess::eComputeStorageRead:
+		info.stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+		info.access = VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR;
+		info.layout = VK_IMAGE_LAYOUT_GENERAL;
+		break;
+	case RGAccess::eComputeStorageWrite:
+		info.stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+		info.access = VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR
+					| VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR;
+		info.layout = VK_IMAGE_LAYOUT_GENERAL;
+		info.write  = true;
+		break;
+	case RGAccess::eTransferSrc:
+		info.stages = VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR;
+		info.access = VK_ACCESS_2_TRANSFER_READ_BIT_KHR;
+		info.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		break;
+	case RGAccess::eTransferDst:
+		info.stages = VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR;
+		info.access = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR;
+		info.layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		info.write  = true;
+		break;
+	}
+
+	return info;
+}
+
+bool RenderGraph::Compile()
+{
+	mCompiledPasses.clear();
+	mBarriers.clear();
+
+	mStats                = {};
+	mStats.declaredPasses = (u32)mPasses.size();
+
+	CullPasses();
+	ComputeLifetimes();
+
+	if (AllocateTransients() == EXIT_FAILURE)
+	{
+		CLOG_ERR("Failed to allocate transient render graph resources.");
+		return EXIT_FAILURE;
+	}
+
+	ComputeBarriers();
+
+	mStats.barriers = (u32)mBarriers.size();
+	return EXIT_SUCCESS;
+}
+
+void RenderGraph::CullPasses()
+{
+	// Walk backwards from the outputs: a pass survives if it writes something that is needed
+	// later, and everything it reads becomes needed in turn.
+	std::vector<bool> needed(mResources.size(), false);
+	for (u32 i = 0; i < mResources.size(); ++i)
+	{
+		needed[i] = mResources[i].output;
+	}
+
+	for (u32 passIndex = (u32)mPasses.size(); passIndex-- > 0;)
+	{
+		Pass &pass  = mPasses[passIndex];
+		bool  alive = pass.sideEffects;
+
+		for (const PassAccess &access : pass.accesses)
+		{
+			if (GetAccessInfo(access.access).write && needed[access.resource])
+			{
+				alive = true;
+			}
+		}
+
+		pass.culled = !alive;
+		if (pass.culled)
+		{
+			++mStats.culledPasses;
+			continue;
+		}
+
+		for (const PassAccess &access : pass.accesses)
+		{
+			if (!GetAccessInfo(access.access).write)
+			{
+				needed[access.resource] = true;
+			}
+		}
+	}
+
+	for (u32 passIndex = 0; passIndex < mPasses.size(); ++passIndex)
+	{
+		if (!mPasses[passIndex].culled)
+		{
+			mCompiledPasses.push_back({passIndex, 0, 0});
+		}
+	}
+}
+
+void RenderGraph::ComputeLifetimes()
+{
+	for (u32 order = 0; order < mCompiledPasses.size(); ++order)
+	{
+		const Pass &pass = mPasses[mCompiledPasses[order].passIndex];
+		for (const PassAccess &access : pass.accesses)
+		{
+			Resource &resource = mResources[access.resource];
+			resource.firstPass = std::min(resource.firstPass, order);
+			resource.lastPass  = std::max(resource.lastPass, order);
+		}
+	}
+}
+
+bool RenderGraph::AllocateTransients()
+{
+	std::vector<RGHandle> transients;
+
+	for (RGHandle handle = 0; handle < mResources.size(); ++handle)
+	{
+		Resource &resource = mResources[handle];
+
+		// Imported images are owned elsewhere, unused transients are never created.
+		if (resource.imported || resource.firstPass == ~0u)
+		{
+			continue;
+		}
+
+		VkImageCreateInfo imageInfo = {};
+		imageInfo.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType         = VK_IMAGE_TYPE_2D;
+		imageInfo.format            = resource.desc.format;
+		imageInfo.extent            = {resource.desc.extent.width, resource.desc.extent.height, 1};
+		imageInfo.mipLevels         = resource.desc.mipLevels;
+		imageInfo.arrayLayers       = 1;
+		imageInfo.samples           = resource.desc.samples;
+		imageInfo.tiling            = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage             = resource.desc.usage;
+		imageInfo.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		if (vkCreateImage(mDevice, &imageInfo, mAllocator, &resource.image) != VK_SUCCESS)
+		{
+			CLOG_ERR("Failed to create transient image \"", resource.name, "\".");
+			return EXIT_FAILURE;
+		}
+
+		VkMemoryRequirements requirements = {};
+		vkGetImageMemoryRequirements(mDevice, resource.image, &requirements);
+
+		resource.size      = requirements.size;
+		resource.alignment = requirements.alignment;
+		resource.typeBits  = requirements.memoryTypeBits;
+
+		transients.push_back(handle);
+		mStats.transientBytes += requirements.size;
+	}
+
+	mStats.transientImages = (u32)transients.size();
+
+	/* Attachments which are never loaded or stored can live in lazily allocated memory, which
+	 * tile-based GPUs back with tile memory only. Such memory holds nothing but transient
+	 * attachments, so they get a heap of their own when the device has a matching type. */
+	std::vector<RGHandle> heapTransients;
+	std::vector<RGHandle> lazyTransients;
+	u32                   lazyTypeBits = ~0u;
+	for (RGHandle handle : transients)
+	{
+		if (mResources[handle].desc.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)
+		{
+			lazyTransients.push_back(handle);
+			lazyTypeBits &= mResources[handle].typeBits;
+		}
+		else
+		{
+			heapTransients.push_back(handle);
+		}
+	}
+
+	constexpr VkMemoryPropertyFlags kLazyProperties =
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+	if (!FindMemoryType(mPhysicalDevice, lazyTypeBits, kLazyProperties).has_value())
+	{
+		heapTransients.insert(heapTransients.end(), lazyTransients.begin(), lazyTransients.end());
+		lazyTransients.clear();
+	}
+
+	if (PlaceTransients(lazyTransients, kLazyProperties, mLazyMemory, mStats.lazyHeapSize)
+		== EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	return PlaceTransients(
+			heapTransients,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			mTransientMemory,
+			mStats.transientHeapSize
+	);
+}
+
+bool RenderGraph::PlaceTransients(
+		std::vector<RGHandle> &transients,
+		VkMemoryPropertyFlags  properties,
+		VkDeviceMemory        &memory,
+		u64                   &heapSizeStat
+)
+{
+	if (transients.empty())
+	{
+		return EXIT_SUCCESS;
+	}
+
+	// Greedy placement, largest first: every image goes to the lowest offset that does not
+	// overlap an already placed image which is alive at the same time.
+	std::sort(
+			transients.begin(),
+			transients.end(),
+			[this](RGHandle a, RGHandle b) { return mResources[a].size > mResources[b].size; }
+	);
+
+	std::vector<RGHandle> placed;
+	VkDeviceSize          heapSize = 0;
+	u32                   typeBits = ~0u;
+
+	for (RGHandle handle : transients)
+	{
+		Resource &resource = mResources[handle];
+
+		auto livesWith = [&resource](const Resource &other)
+		{ return resource.firstPass <= other.lastPass && other.firstPass <= resource.lastPass; };
+
+		auto overlapsMemory = [&resource](const Resource &other, VkDeviceSize offset)
+		{ return offset < other.offset + other.size && other.offset < offset + resource.size; };
+
+		VkDeviceSize bestOffset = ~VkDeviceSize(0);
+
+		std::vector<VkDeviceSize> candidates = {0};
+		for (RGHandle other : placed)
+		{
+			candidates.push_back(mResources[other].offset + mResources[other].size);
+		}
+
+		for (VkDeviceSize candidate : candidates)
+		{
+			const VkDeviceSize offset =
+					(candidate + resource.alignment - 1) / resource.alignment * resource.alignment;
+
+			bool fits = true;
+			for (RGHandle other : placed)
+			{
+				if (livesWith(mResources[other]) && overlapsMemory(mResources[other], offset))
+				{
+					fits = false;
+					break;
+				}
+			}
+
+			if (fits && offset < bestOffset)
+			{
+				bestOffset = offset;
+			}
+		}
+
+		resource.offset = bestOffset;
+
+		// The most recent previous user of any of this memory must be done before it is reused.
+		for (RGHandle other : placed)
+		{
+			const Resource &otherResource = mResources[other];
+			if (otherResource.lastPass < resource.firstPass
+				&& overlapsMemory(otherResource, resource.offset)
+				&& (resource.aliasPredecessor == kInvalidRGHandle
+					|| mResources[resource.aliasPredecessor].lastPass < otherResource.lastPass))
+			{
+				resource.aliasPredecessor = other;
+			}
+		}
+
+		heapSize  = std::max(heapSize, resource.offset + resource.size);
+		typeBits &= resource.typeBits;
+		placed.push_back(handle);
+	}
+
+	std::optional<u32> memoryType = FindMemoryType(mPhysicalDevice, typeBits, properties);
+	if (!memoryType.has_value())
+	{
+		CLOG_ERR("Transient images do not share a device local memory type.");
+		return EXIT_FAILURE;
+	}
+
+	VkMemoryAllocateInfo allocInfo = {};
+	allocInfo.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize       = heapSize;
+	allocInfo.memoryTypeIndex      = memoryType.value();
+
+	if (vkAllocateMemory(mDevice, &allocInfo, mAllocator, &memory) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to allocate ", heapSize, " bytes of transient image memory.");
+		return EXIT_FAILURE;
+	}
+
+	heapSizeStat = heapSize;
+
+	for (RGHandle handle : transients)
+	{
+		Resource &resource = mResources[handle];
+
+		if (vkBindImageMemory(mDevice, resource.image, memory, resource.offset)
+			!= VK_SUCCESS)
+		{
+			CLOG_ERR("Failed to bind transient image \"", resource.name, "\".");
+			return EXIT_FAILURE;
+		}
+
+		std::optional<VkImageView> view = CreateImageView(
+				mDevice, resource.image, resource.desc.format, resource.desc.aspect
+		);
+		if (!view.has_value())
+		{
+			return EXIT_FAILURE;
+		}
+		resource.view = view.value();
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void RenderGraph::ComputeBarriers()
+{
+	// Current state of every resource while walking the compiled passes in order.
+	std::vector<AccessInfo> states(mResources.size());
+	for (u32 i = 0; i < mResources.size(); ++i)
+	{
+		const Resource &resource = mResources[i];
+		if (resource.imported)
+		{
+			states[i].stages = resource.initialStage;
+			states[i].layout = resource.initialLayout;
+		}
+	}
+
+	// First uses of transients that no other image used before them in the frame.
+	std::vector<u32> frameStartBarriers;
+
+	for (u32 order = 0; order < mCompiledPasses.size(); ++order)
+	{
+		CompiledPass &compiledPass = mCompiledPasses[order];
+		const Pass   &pass         = mPasses[compiledPass.passIndex];
+
+		// Several accesses to one resource inside a pass are merged into a single state.
+		std::vector<std::pair<RGHandle, AccessInfo>> merged;
+		for (const PassAccess &passAccess : pass.accesses)
+		{
+			const AccessInfo info = GetAccessInfo(passAccess.access);
+
+			auto it = std::find_if(
+					merged.begin(),
+					merged.end(),
+					[&passAccess](const auto &entry) { return entry.first == passAccess.resource; }
+			);
+
+			if (it == merged.end())
+			{
+				merged.emplace_back(passAccess.resource, info);
+				continue;
+			}
+
+			it->second.stages |= info.stages;
+			it->second.access |= info.access;
+			if (info.write)
+			{
+				it->second.write  = true;
+				it->second.layout = info.layout;
+			}
+		}
+
+		compiledPass.firstBarrier = (u32)mBarriers.size();
+
+		for (const auto &[handle, current] : merged)
+		{
+			Resource   &resource = mResources[handle];
+			AccessInfo &previous = states[handle];
+
+			const bool firstUse = !resource.imported && resource.firstPass == order;
+
+			if (firstUse && resource.aliasPredecessor != kInvalidRGHandle)
+			{
+				// Memory was used by another image, wait for it and discard the contents.
+				const AccessInfo &aliased = states[resource.aliasPredecessor];
+				previous.stages           = aliased.stages;
+				previous.access           = aliased.access;
+				previous.write            = true;
+				previous.layout           = VK_IMAGE_LAYOUT_UNDEFINED;
+			}
+
+			const bool needsBarrier =
+					previous.write || current.write || previous.layout != current.layout;
+
+			if (!needsBarrier)
+			{
+				// Read after read in the same layout, later writers have to wait for all readers.
+				previous.stages |= current.stages;
+				previous.access |= current.access;
+				continue;
+			}
+
+			if (firstUse && resource.aliasPredecessor == kInvalidRGHandle)
+			{
+				frameStartBarriers.push_back((u32)mBarriers.size());
+			}
+
+			Barrier barrier   = {};
+			barrier.resource  = handle;
+			barrier.srcStages = previous.stages;
+			// Write-after-read only needs an execution dependency.
+			barrier.srcAccess = previous.write ? previous.access : VK_ACCESS_2_NONE_KHR;
+			barrier.oldLayout = previous.layout;
+			barrier.dstStages = current.stages;
+			barrier.dstAccess = current.access;
+			barrier.newLayout = current.layout;
+			mBarriers.push_back(barrier);
+
+			previous = current;
+		}
+
+		compiledPass.barrierCount = (u32)mBarriers.size() - compiledPass.firstBarrier;
+	}
+
+	/* Transients share one allocation with the frames in flight, so their memory was last used
+	 * by the previous frame's graph. The first use in a frame waits for every transient's final
+	 * access, which covers whichever image aliased that memory last. */
+	VkPipelineStageFlags2 previousFrameStages = VK_PIPELINE_STAGE_2_NONE_KHR;
+	VkAccessFlags2        previousFrameAccess = VK_ACCESS_2_NONE_KHR;
+	for (RGHandle handle = 0; handle < mResources.size(); ++handle)
+	{
+		if (mResources[handle].imported)
+		{
+			continue;
+		}
+
+		previousFrameStages |= states[handle].stages;
+		previousFrameAccess |= states[handle].write ? states[handle].access : VK_ACCESS_2_NONE_KHR;
+	}
+
+	for (u32 barrierIndex : frameStartBarriers)
+	{
+		mBarriers[barrierIndex].srcStages = previousFrameStages;
+		mBarriers[barrierIndex].srcAccess = previousFrameAccess;
+	}
+
+	mFinalBarrierOffset = (u32)mBarriers.size();
+
+	for (RGHandle handle = 0; handle < mResources.size(); ++handle)
+	{
+		const Resource   &resource = mResources[handle];
+		const AccessInfo &state    = states[handle];
+
+		if (!resource.imported || resource.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED
+			|| resource.finalLayout == state.layout)
+		{
+			continue;
+		}
+
+		// Whoever uses the image next synchronizes through a semaphore (e.g. present).
+		Barrier barrier   = {};
+		barrier.resource  = handle;
+		barrier.srcStages = state.stages;
+		barrier.srcAccess = state.write ? state.access : VK_ACCESS_2_NONE_KHR;
+		barrier.oldLayout = state.layout;
+		barrier.dstStages = VK_PIPELINE_STAGE_2_NONE_KHR;
+		barrier.dstAccess = VK_ACCESS_2_NONE_KHR;
+		barrier.newLayout = resource.finalLayout;
+		mBarriers.push_back(barrier);
+	}
+
+	mFinalBarrierCount = (u32)mBarriers.size() - mFinalBarrierOffset;
+}
+
+void RenderGraph::RecordBarriers(
+		VkCommandBuffer commandBuffer,
+		u32             firstBarrier,
+		u32             barrierCount
+) const
+{
+	VkImageMemoryBarrier2KHR imageBarriers[kMaxBarriersPerBatch];
+
+	while (barrierCount > 0)
+	{
+		const u32 batchCount = std::min(barrierCount, kMaxBarriersPerBatch);
+
+		for (u32 i = 0; i < batchCount; ++i)
+		{
+			const Barrier  &barrier  = mBarriers[firstBarrier + i];
+			const Resource &resource = mResources[barrier.resource];
+
+			VkImageMemoryBarrier2KHR &imageBarrier = imageBarriers[i];
+			imageBarrier                           = {};
+			imageBarrier.sType                     = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+			imageBarrier.srcStageMask              = barrier.srcStages;
+			imageBarrier.srcAccessMask             = barrier.srcAccess;
+			imageBarrier.dstStageMask              = barrier.dstStages;
+			imageBarrier.dstAccessMask             = barrier.dstAccess;
+			imageBarrier.oldLayout                 = barrier.oldLayout;
+			imageBarrier.newLayout                 = barrier.newLayout;
+			imageBarrier.srcQueueFamilyIndex       = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.dstQueueFamilyIndex       = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.image                     = resource.image;
+
+			imageBarrier.subresourceRange.aspectMask     = resource.desc.aspect;
+			imageBarrier.subresourceRange.baseMipLevel   = 0;
+			imageBarrier.subresourceRange.levelCount     = VK_REMAINING_MIP_LEVELS;
+			imageBarrier.subresourceRange.baseArrayLayer = 0;
+			imageBarrier.subresourceRange.layerCount     = VK_REMAINING_ARRAY_LAYERS;
+		}
+
+		VkDependencyInfoKHR dependencyInfo     = {};
+		dependencyInfo.sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+		dependencyInfo.imageMemoryBarrierCount = batchCount;
+		dependencyInfo.pImageMemoryBarriers    = imageBarriers;
+
+		VulkanDispatch::vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+
+		firstBarrier += batchCount;
+		barrierCount -= batchCount;
+	}
+}
+
+void RenderGraph::SetGpuTracer(GpuTracer *tracer)
+{
+	mGpuTracer = tracer;
+}
+
+void RenderGraph::Execute(VkCommandBuffer commandBuffer) const
+{
+	for (const CompiledPass &compiledPass : mCompiledPasses)
+	{
+		const Pass &pass = mPasses[compiledPass.passIndex];
+		COV_TRACE_SCOPE(pass.name);
+		COV_TRACE_GPU_SCOPE(mGpuTracer, commandBuffer, pass.name);
+
+		RecordBarriers(commandBuffer, compiledPass.firstBarrier, compiledPass.barrierCount);
+		pass.execute(commandBuffer);
+	}
+
+	RecordBarriers(commandBuffer, mFinalBarrierOffset, mFinalBarrierCount);
+}
+
+void RenderGraph::LogStats() const
+{
+	CLOG_INFO(
+			"Render graph: ",
+			mStats.declaredPasses,
+			" passes (",
+			mStats.culledPasses,
+			" culled), ",
+			mStats.barriers,
+			" barriers, ",
+			mStats.transientImages,
+			" transient images using ",
+			(mStats.transientHeapSize + mStats.lazyHeapSize) / 1024,
+			" KiB instead of ",
+			mStats.transientBytes / 1024,
+			" KiB."
+	);
+
+	if (mStats.lazyHeapSize > 0)
+	{
+		CLOG_INFO(
+				"Render graph: ",
+				mStats.lazyHeapSize / 1024,
+				" KiB of it lazily allocated."
+		);
+	}
+}
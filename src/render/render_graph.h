@@ -0,0 +1,250 @@
+#ifndef HEADER_RENDER_GRAPH_H
+#define HEADER_RENDER_GRAPH_H
+
+#include "definitions.h"
+#include "vulkan/vulkan_core.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/* Frame graph: passes declare which images they read and write, the graph culls passes that do
+ * not contribute to an output, computes synchronization2 barriers between them and places
+ * transient images into one shared allocation, aliasing images whose lifetimes do not overlap.
+ * Transient attachments (VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) get a separate lazily
+ * allocated one where the device offers it.
+ *
+ * Built once per swap chain (transient sizes depend on the extent), executed every frame. */
+
+class GpuTracer;
+
+using RGHandle = u32;
+
+constexpr RGHandle kInvalidRGHandle = ~0u;
+
+enum class RGAccess
+{
+	eColorAttachmentWrite,
+	eColorAttachmentRead,
+	eDepthAttachmentWrite,
+	eDepthAttachmentRead,
+	eResolveWrite,
+	eFragmentSampled,
+	eComputeSampled,
+	eComputeStorageRead,
+	eComputeStorageWrite,
+	eTransferSrc,
+	eTransferDst,
+};
+
+struct RGImageDesc
+{
+	VkFormat              format    = VK_FORMAT_UNDEFINED;
+	VkExtent2D            extent    = {};
+	VkImageUsageFlags     usage     = 0;
+	VkImageAspectFlags    aspect    = VK_IMAGE_ASPECT_COLOR_BIT;
+	VkSampleCountFlagBits samples   = VK_SAMPLE_COUNT_1_BIT;
+	u32                   mipLevels = 1;
+};
+
+class RenderGraph
+{
+public:
+	using ExecuteFunction = std::function<void(VkCommandBuffer commandBuffer)>;
+
+	class PassBuilder
+	{
+	public:
+		PassBuilder &Read(RGHandle resource, RGAccess access);
+
+		PassBuilder &Write(RGHandle resource, RGAccess access);
+
+		// Never culled, e.g. passes writing to buffers the graph does not know about.
+		PassBuilder &SetSideEffects();
+
+	private:
+		friend class RenderGraph;
+
+		PassBuilder(RenderGraph &graph, u32 passIndex);
+
+		RenderGraph &mGraph;
+		u32          mPassIndex;
+	};
+
+	struct Stats
+	{
+		u32 declaredPasses    = 0;
+		u32 culledPasses      = 0;
+		u32 barriers          = 0;
+		u32 transientImages   = 0;
+		u64 transientBytes    = 0;// Sum of all transient image sizes
+		u64 transientHeapSize = 0;// Actually allocated after aliasing
+		u64 lazyHeapSize      = 0;// Transient attachments, allocated separately
+	};
+
+public:
+	RenderGraph() = default;
+
+	RenderGraph(const RenderGraph &) = delete;
+
+	RenderGraph &operator=(const RenderGraph &) = delete;
+
+	void Init(VkDevice device, VkPhysicalDevice physicalDevice);
+
+	// Destroys transient images and their memory and forgets all passes and resources.
+	void Reset();
+
+	/* External image (e.g. swap chain). Its image and view can change every frame through
+	 * SetImportedImage. initialStage is the stage the previous user (or acquire semaphore wait)
+	 * touched it in, finalLayout is the layout it is left in after the graph. */
+	RGHandle ImportImage(
+			const char           *name,
+			const RGImageDesc    &desc,
+			VkImageLayout         initialLayout,
+			VkPipelineStageFlags2 initialStage,
+			VkImageLayout         finalLayout
+	);
+
+	// Graph owned image, only valid during the frame and aliased with other transient images.
+	RGHandle CreateImage(const char *name, const RGImageDesc &desc);
+
+	// name is not copied, the trace (utils/trace.h) keeps it past the frame: a string literal.
+	PassBuilder AddPass(const char *name, ExecuteFunction execute);
+
+	// Resources read after the graph is done, passes feeding them are never culled.
+	void MarkOutput(RGHandle resource);
+
+	bool Compile();
+
+	void SetImportedImage(RGHandle resource, VkImage image, VkImageView view);
+
+	[[nodiscard]] VkImage GetImage(RGHandle resource) const;
+
+	[[nodiscard]] VkImageView GetImageView(RGHandle resource) const;
+
+	[[nodiscard]] const Stats &GetStats() const
+	{
+		return mStats;
+	}
+
+	// Every pass gets a CPU and, with a tracer set, a GPU trace scope. tracer can be nullptr.
+	void SetGpuTracer(GpuTracer *tracer);
+
+	void Execute(VkCommandBuffer commandBuffer) const;
+
+	void LogStats() const;
+
+private:
+	struct AccessInfo
+	{
+		VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_NONE_KHR;
+		VkAccessFlags2        access = VK_ACCESS_2_NONE_KHR;
+		VkImageLayout         layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		bool                  write  = false;
+	};
+
+	struct Resource
+	{
+		std::string name;
+		RGImageDesc desc;
+		bool        imported = false;
+		bool        output   = false;
+
+		VkImageLayout         initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags2 initialStage  = VK_PIPELINE_STAGE_2_NONE_KHR;
+		VkImageLayout         finalLayout   = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		VkImage     image = VK_NULL_HANDLE;
+		VkImageView view  = VK_NULL_HANDLE;
+
+		// Lifetime in compiled pass order, transient only
+		u32 firstPass = ~0u;
+		u32 lastPass  = 0;
+
+		VkDeviceSize size      = 0;
+		VkDeviceSize alignment = 0;
+		VkDeviceSize offset    = 0;
+		u32          typeBits  = 0;
+
+		// Transient image which previously occupied this memory. The first barrier has to wait
+		// for its last use before the memory is reused.
+		RGHandle    aliasPredecessor = kInvalidRGHandle;
+		AccessInfo  lastAccess;
+	};
+
+	struct PassAccess
+	{
+		RGHandle resource;
+		RGAccess access;
+	};
+
+	struct Pass
+	{
+		const char             *name;
+		ExecuteFunction         execute;
+		std::vector<PassAccess> accesses;
+		bool                    sideEffects = false;
+		bool                    culled      = false;
+	};
+
+	struct Barrier
+	{
+		RGHandle              resource;
+		VkPipelineStageFlags2 srcStages;
+		VkAccessFlags2        srcAccess;
+		VkImageLayout         oldLayout;
+		VkPipelineStageFlags2 dstStages;
+		VkAccessFlags2        dstAccess;
+		VkImageLayout         newLayout;
+	};
+
+	struct CompiledPass
+	{
+		u32 passIndex;
+		u32 firstBarrier;
+		u32 barrierCount;
+	};
+
+	static AccessInfo GetAccessInfo(RGAccess access);
+
+	void CullPasses();
+
+	void ComputeLifetimes();
+
+	bool AllocateTransients();
+
+	// Aliases transients into one new allocation of memory and binds them.
+	bool PlaceTransients(
+			std::vector<RGHandle> &transients,
+			VkMemoryPropertyFlags  properties,
+			VkDeviceMemory        &memory,
+			u64                   &heapSizeStat
+	);
+
+	void ComputeBarriers();
+
+	void RecordBarriers(VkCommandBuffer commandBuffer, u32 firstBarrier, u32 barrierCount) const;
+
+private:
+	VkDevice                     mDevice         = VK_NULL_HANDLE;
+	VkPhysicalDevice             mPhysicalDevice = VK_NULL_HANDLE;
+	const VkAllocationCallbacks *mAllocator      = nullptr;
+
+	std::vector<Resource>     mResources;
+	std::vector<Pass>         mPasses;
+	std::vector<CompiledPass> mCompiledPasses;
+	std::vector<Barrier>      mBarriers;
+
+	// Barriers recorded after the last pass (final layouts of imported images)
+	u32 mFinalBarrierOffset = 0;
+	u32 mFinalBarrierCount  = 0;
+
+	VkDeviceMemory mTransientMemory = VK_NULL_HANDLE;
+	VkDeviceMemory mLazyMemory      = VK_NULL_HANDLE;// Transient attachments only
+
+	GpuTracer *mGpuTracer = nullptr;
+
+	Stats mStats;
+};
+
+#endif// HEADER_RENDER_GRAPH_H
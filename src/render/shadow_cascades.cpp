@@ -0,0 +1,825 @@
+#include "shadow_cascades.h"
+
+#include "render/pipeline_layout_cache.h"
+#include "render/render_extract.h"
+#include "render/vk_dispatch.h"
+#include "render/vk_utils.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdlib>
+
+// Against acne on surfaces facing the sun at grazing angles, in depth units and per slope.
+constexpr f32 kDepthBiasConstant = 1.25f;
+constexpr f32 kDepthBiasSlope    = 1.75f;
+
+// Cascade radii are rounded up to this, so float noise in the fit never changes the texel size.
+constexpr f32 kRadiusGranularity = 1.0f / 64.0f;
+
+bool ShadowCascades::Init(
+		VkDevice                     device,
+		VkPhysicalDevice             physicalDevice,
+		PipelineLayoutCache         &layoutCache,
+		VkShaderModule               vertModule,
+		const ShaderReflection      &vertReflection,
+		u32                          frameCount,
+		const Settings              &settings,
+		const VkAllocationCallbacks *allocator
+)
+{
+	mDevice         = device;
+	mPhysicalDevice = physicalDevice;
+	mLayoutCache    = &layoutCache;
+	mAllocator      = allocator;
+
+	mSettings              = settings;
+	mSettings.cascadeCount = std::clamp(settings.cascadeCount, 1u, kMaxCascades);
+	mSettings.resolution   = std::max(settings.resolution, 64u);
+	mSettings.sunDirection = glm::normalize(settings.sunDirection);
+
+	// Tiles are laid out two per row.
+	const u32 rows = (mSettings.cascadeCount + 1) / 2;
+	mColumns       = std::min(mSettings.cascadeCount, 2u);
+	mExtent        = {mSettings.resolution * mColumns, mSettings.resolution * rows};
+
+	std::optional<VkFormat> format = FindDepthFormat(
+			mPhysicalDevice,
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
+					| VK_FORMAT_FEATURE_TRANSFER_SRC_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT
+	);
+	if (!format.has_value())
+	{
+		CLOG_ERR("No depth format usable for shadow maps.");
+		return EXIT_FAILURE;
+	}
+	mFormat = format.value();
+	mAspect = GetDepthFormatAspect(mFormat);
+
+	if (CreateRenderPass() == EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	if (CreateDepthImage(
+				VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+						| VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+				mAtlas
+		)
+		== EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	if (CreateDepthImage(
+				VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+				mCache
+		)
+		== EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	if (CreatePipeline(vertModule, vertReflection) == EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	// Hardware 2x2 PCF where depth can be filtered, outside the atlas counts as lit.
+	VkFormatProperties formatProperties = {};
+	vkGetPhysicalDeviceFormatProperties(mPhysicalDevice, mFormat, &formatProperties);
+
+	const VkFilter filter =
+			(formatProperties.optimalTilingFeatures
+			 & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+					? VK_FILTER_LINEAR
+					: VK_FILTER_NEAREST;
+
+	VkSamplerCreateInfo samplerInfo = {};
+
+	samplerInfo.sType         = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter     = filter;
+	samplerInfo.minFilter     = filter;
+	samplerInfo.mipmapMode    = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.addressModeV  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.addressModeW  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.borderColor   = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	samplerInfo.compareEnable = VK_TRUE;
+	samplerInfo.compareOp     = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+	if (vkCreateSampler(mDevice, &samplerInfo, mAllocator, &mSampler) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create the shadow sampler.");
+		return EXIT_FAILURE;
+	}
+
+	mFrames.resize(frameCount);
+	for (FrameResources &frame : mFrames)
+	{
+		if (CreateBuffer(
+					mDevice,
+					mPhysicalDevice,
+					sizeof(Uniforms),
+					VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+					frame.uniforms,
+					frame.uniformsMemory
+			)
+			== EXIT_FAILURE)
+		{
+			return EXIT_FAILURE;
+		}
+
+		void *mapped = nullptr;
+		if (vkMapMemory(mDevice, frame.uniformsMemory, 0, sizeof(Uniforms), 0, &mapped)
+			!= VK_SUCCESS)
+		{
+			CLOG_ERR("Failed to map shadow uniforms.");
+			return EXIT_FAILURE;
+		}
+		frame.uniformsMapped = static_cast<Uniforms *>(mapped);
+	}
+
+	VkDescriptorPoolSize poolSizes[2] = {};
+	poolSizes[0].type                 = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[0].descriptorCount      = frameCount;
+	poolSizes[1].type                 = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	poolSizes[1].descriptorCount      = frameCount;
+
+	VkDescriptorPoolCreateInfo poolInfo = {};
+
+	poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.maxSets       = frameCount;
+	poolInfo.poolSizeCount = (u32)std::size(poolSizes);
+	poolInfo.pPoolSizes    = poolSizes;
+
+	if (vkCreateDescriptorPool(mDevice, &poolInfo, mAllocator, &mDescriptorPool) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create the shadow descriptor pool.");
+		return EXIT_FAILURE;
+	}
+
+	CLOG_INFO(
+			"Shadow cascades: ",
+			mSettings.cascadeCount,
+			" of ",
+			mSettings.resolution,
+			"x",
+			mSettings.resolution,
+			" in a ",
+			mExtent.width,
+			"x",
+			mExtent.height,
+			" atlas."
+	);
+	return EXIT_SUCCESS;
+}
+
+void ShadowCascades::Destroy()
+{
+	if (mDevice == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	vkDestroyDescriptorPool(mDevice, mDescriptorPool, mAllocator);
+	for (FrameResources &frame : mFrames)
+	{
+		vkDestroyBuffer(mDevice, frame.uniforms, mAllocator);
+		vkFreeMemory(mDevice, frame.uniformsMemory, mAllocator);
+	}
+	mFrames.clear();
+
+	vkDestroySampler(mDevice, mSampler, mAllocator);
+	vkDestroyPipeline(mDevice, mPipeline, mAllocator);
+	DestroyDepthImage(mAtlas);
+	DestroyDepthImage(mCache);
+	vkDestroyRenderPass(mDevice, mRenderPass, mAllocator);
+
+	mDescriptorPool = VK_NULL_HANDLE;
+	mSampler        = VK_NULL_HANDLE;
+	mPipeline       = VK_NULL_HANDLE;
+	mRenderPass     = VK_NULL_HANDLE;
+	mPipelineLayout = VK_NULL_HANDLE;
+	mShadingLayout  = VK_NULL_HANDLE;
+	mDevice         = VK_NULL_HANDLE;
+}
+
+bool ShadowCascades::BindGraphicsLayout(VkPipelineLayout pipelineLayout, u32 set)
+{
+	std::optional<VkDescriptorSetLayout> setLayout =
+			mLayoutCache->FindSetLayout(pipelineLayout, set);
+	if (!setLayout.has_value())
+	{
+		CLOG_ERR("Shading pipeline layout has no shadow set.");
+		return EXIT_FAILURE;
+	}
+
+	mShadingLayout = pipelineLayout;
+	mShadingSet    = set;
+
+	for (FrameResources &frame : mFrames)
+	{
+		VkDescriptorSetAllocateInfo allocInfo = {};
+
+		allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool     = mDescriptorPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts        = &setLayout.value();
+
+		if (vkAllocateDescriptorSets(mDevice, &allocInfo, &frame.set) != VK_SUCCESS)
+		{
+			CLOG_ERR("Failed to allocate a shadow descriptor set.");
+			return EXIT_FAILURE;
+		}
+
+		VkDescriptorImageInfo imageInfo = {};
+		imageInfo.sampler               = mSampler;
+		imageInfo.imageView             = mAtlas.view;
+		imageInfo.imageLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		VkDescriptorBufferInfo bufferInfo = {};
+		bufferInfo.buffer                 = frame.uniforms;
+		bufferInfo.offset                 = 0;
+		bufferInfo.range                  = sizeof(Uniforms);
+
+		VkWriteDescriptorSet writes[2] = {};
+
+		writes[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[0].dstSet          = frame.set;
+		writes[0].dstBinding      = 0;
+		writes[0].descriptorCount = 1;
+		writes[0].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].pImageInfo      = &imageInfo;
+
+		writes[1].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[1].dstSet          = frame.set;
+		writes[1].dstBinding      = 1;
+		writes[1].descriptorCount = 1;
+		writes[1].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		writes[1].pBufferInfo     = &bufferInfo;
+
+		vkUpdateDescriptorSets(mDevice, (u32)std::size(writes), writes, 0, nullptr);
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void ShadowCascades::InvalidateStatic()
+{
+	mCachedStaticCount = ~0u;
+}
+
+void ShadowCascades::Update(
+		u32              frameIndex,
+		const glm::vec3 &viewMin,
+		const glm::vec3 &viewMax,
+		u32              staticInstanceCount
+)
+{
+	++mStats.frames;
+
+	const glm::vec3 toSun = mSettings.sunDirection;
+	const glm::vec3 up =
+			std::abs(toSun.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	const glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), -toSun, up);
+
+	// Depth range covers the whole view box, casters outside a cascade's slice still land in it.
+	f32 nearDistance = FLT_MAX;
+	f32 farDistance  = -FLT_MAX;
+	for (u32 corner = 0; corner < 8; ++corner)
+	{
+		const glm::vec3 point = glm::vec3(
+				corner & 1 ? viewMax.x : viewMin.x,
+				corner & 2 ? viewMax.y : viewMin.y,
+				corner & 4 ? viewMax.z : viewMin.z
+		);
+		const f32 distance = -(lightView * glm::vec4(point, 1.0f)).z;
+
+		nearDistance = std::min(nearDistance, distance);
+		farDistance  = std::max(farDistance, distance);
+	}
+
+	Uniforms &uniforms = *mFrames[frameIndex].uniformsMapped;
+
+	// Logarithmic splits need a positive near plane, the first slice starts at the box anyway.
+	const u32 cascadeCount = mSettings.cascadeCount;
+	const f32 depthRange   = viewMax.z - viewMin.z;
+	const f32 logNear      = std::max(depthRange * 0.01f, 1e-4f);
+
+	f32 sliceNear = viewMin.z;
+	for (u32 cascade = 0; cascade < cascadeCount; ++cascade)
+	{
+		const f32 ratio    = (f32)(cascade + 1) / (f32)cascadeCount;
+		const f32 uniform  = depthRange * ratio;
+		const f32 log      = logNear * std::pow(depthRange / logNear, ratio);
+		const f32 sliceFar = viewMin.z + glm::mix(uniform, log, mSettings.splitLambda);
+
+		const glm::vec3 sliceMin    = glm::vec3(viewMin.x, viewMin.y, sliceNear);
+		const glm::vec3 sliceMax    = glm::vec3(viewMax.x, viewMax.y, sliceFar);
+		const glm::vec3 sliceCenter = (sliceMin + sliceMax) * 0.5f;
+
+		f32 radius = glm::length(sliceMax - sliceCenter);
+		radius     = std::ceil(radius / kRadiusGranularity) * kRadiusGranularity;
+
+		// Snapping the center to texels keeps the rasterization of static casters identical
+		// while the cascade follows the view.
+		const f32 texelSize = 2.0f * radius / (f32)mSettings.resolution;
+		glm::vec4 center    = lightView * glm::vec4(sliceCenter, 1.0f);
+		center.x            = std::floor(center.x / texelSize) * texelSize;
+		center.y            = std::floor(center.y / texelSize) * texelSize;
+
+		const glm::mat4 projection = glm::orthoRH_ZO(
+				center.x - radius,
+				center.x + radius,
+				center.y - radius,
+				center.y + radius,
+				nearDistance,
+				farDistance
+		);
+		mMatrices[cascade] = projection * lightView;
+
+		if (mMatrices[cascade] != mCacheMatrices[cascade])
+		{
+			mOutdatedCascades |= 1u << cascade;
+		}
+
+		// Light clip space to the cascade's tile of the atlas, depth is kept as is.
+		const VkRect2D  tile      = GetTileRect(cascade);
+		const glm::vec2 atlasSize = glm::vec2((f32)mExtent.width, (f32)mExtent.height);
+		const glm::vec2 scale     = glm::vec2(tile.extent.width, tile.extent.height) / atlasSize;
+		const glm::vec2 offset    = glm::vec2(tile.offset.x, tile.offset.y) / atlasSize;
+
+		glm::mat4 toAtlas = glm::translate(glm::mat4(1.0f), glm::vec3(offset + scale * 0.5f, 0.0f));
+		toAtlas           = glm::scale(toAtlas, glm::vec3(scale * 0.5f, 1.0f));
+
+		uniforms.cascadeMatrices[cascade] = toAtlas * mMatrices[cascade];
+		uniforms.cascadeSplits[cascade]   = sliceFar;
+
+		sliceNear = sliceFar;
+	}
+
+	if (staticInstanceCount != mCachedStaticCount)
+	{
+		mOutdatedCascades  = (1u << cascadeCount) - 1;
+		mCachedStaticCount = staticInstanceCount;
+	}
+
+	uniforms.sunDirection = glm::vec4(toSun, 0.0f);
+	uniforms.sunColor     = glm::vec4(mSettings.sunColor, 1.0f);
+	uniforms.cascadeCount = glm::uvec4(cascadeCount, 0, 0, 0);
+}
+
+RGImageDesc ShadowCascades::GetAtlasDesc() const
+{
+	RGImageDesc desc = {};
+	desc.format      = mFormat;
+	desc.extent      = mExtent;
+	desc.aspect      = mAspect;
+
+	desc.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+			   | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	return desc;
+}
+
+void ShadowCascades::RecordCache(
+		VkCommandBuffer commandBuffer,
+		const GpuMesh  &mesh,
+		VkBuffer        instanceBuffer,
+		const MeshDraw *draws,
+		u32             drawCount
+)
+{
+	VkImageMemoryBarrier2KHR cacheBarrier = {};
+
+	cacheBarrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+	cacheBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	cacheBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	cacheBarrier.image               = mCache.image;
+
+	cacheBarrier.subresourceRange.aspectMask = mAspect;
+	cacheBarrier.subresourceRange.levelCount = 1;
+	cacheBarrier.subresourceRange.layerCount = 1;
+
+	VkDependencyInfoKHR dependencyInfo     = {};
+	dependencyInfo.sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+	dependencyInfo.imageMemoryBarrierCount = 1;
+	dependencyInfo.pImageMemoryBarriers    = &cacheBarrier;
+
+	if (mOutdatedCascades != 0)
+	{
+		// Waits for the copies of earlier frames, up-to-date tiles are kept.
+		cacheBarrier.srcStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR;
+		cacheBarrier.srcAccessMask = VK_ACCESS_2_NONE_KHR;
+		cacheBarrier.dstStageMask  = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR
+								  | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR;
+		cacheBarrier.dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR
+								   | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR;
+		cacheBarrier.oldLayout = mCacheLayout;
+		cacheBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VulkanDispatch::vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+
+		BeginCascades(commandBuffer, mCache.framebuffer, mesh, instanceBuffer);
+
+		for (u32 cascade = 0; cascade < mSettings.cascadeCount; ++cascade)
+		{
+			if ((mOutdatedCascades & (1u << cascade)) == 0)
+			{
+				continue;
+			}
+
+			VkClearAttachment clear       = {};
+			clear.aspectMask              = VK_IMAGE_ASPECT_DEPTH_BIT;
+			clear.clearValue.depthStencil = {1.0f, 0};
+
+			VkClearRect clearRect    = {};
+			clearRect.rect           = GetTileRect(cascade);
+			clearRect.baseArrayLayer = 0;
+			clearRect.layerCount     = 1;
+
+			VulkanDispatch::vkCmdClearAttachments(commandBuffer, 1, &clear, 1, &clearRect);
+
+			SetCascade(commandBuffer, cascade);
+			mesh.Draw(commandBuffer, draws, drawCount);
+
+			mCacheMatrices[cascade] = mMatrices[cascade];
+			++mStats.staticCascadeRenders;
+		}
+
+		VulkanDispatch::vkCmdEndRenderPass(commandBuffer);
+
+		cacheBarrier.srcStageMask  = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR
+								  | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR;
+		cacheBarrier.srcAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR;
+		cacheBarrier.dstStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR;
+		cacheBarrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT_KHR;
+		cacheBarrier.oldLayout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		cacheBarrier.newLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+		VulkanDispatch::vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+
+		mCacheLayout      = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		mOutdatedCascades = 0;
+	}
+
+	VkImageCopy region = {};
+
+	region.srcSubresource.aspectMask = mAspect;
+	region.srcSubresource.layerCount = 1;
+	region.dstSubresource.aspectMask = mAspect;
+	region.dstSubresource.layerCount = 1;
+	region.extent                    = {mExtent.width, mExtent.height, 1};
+
+	VulkanDispatch::vkCmdCopyImage(
+			commandBuffer,
+			mCache.image,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			mAtlas.image,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1,
+			&region
+	);
+}
+
+void ShadowCascades::RecordDynamic(
+		VkCommandBuffer commandBuffer,
+		const GpuMesh  &mesh,
+		VkBuffer        instanceBuffer,
+		const MeshDraw *draws,
+		u32             drawCount
+)
+{
+	BeginCascades(commandBuffer, mAtlas.framebuffer, mesh, instanceBuffer);
+
+	for (u32 cascade = 0; cascade < mSettings.cascadeCount && drawCount > 0; ++cascade)
+	{
+		SetCascade(commandBuffer, cascade);
+		mesh.Draw(commandBuffer, draws, drawCount);
+	}
+
+	VulkanDispatch::vkCmdEndRenderPass(commandBuffer);
+}
+
+void ShadowCascades::BindForShading(VkCommandBuffer commandBuffer, u32 frameIndex) const
+{
+	VulkanDispatch::vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			mShadingLayout,
+			mShadingSet,
+			1,
+			&mFrames[frameIndex].set,
+			0,
+			nullptr
+	);
+}
+
+void ShadowCascades::LogStats() const
+{
+	if (mStats.frames == 0)
+	{
+		return;
+	}
+
+	CLOG_INFO(
+			"Shadow cascades: ",
+			mStats.staticCascadeRenders,
+			" static cascade renders in ",
+			mStats.frames,
+			" frames (",
+			mStats.frames * mSettings.cascadeCount,
+			" without the cache)."
+	);
+}
+
+bool ShadowCascades::CreateDepthImage(VkImageUsageFlags usage, DepthImage &depthImage)
+{
+	VkImageCreateInfo imageInfo = {};
+
+	imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+	imageInfo.format        = mFormat;
+	imageInfo.extent        = {mExtent.width, mExtent.height, 1};
+	imageInfo.mipLevels     = 1;
+	imageInfo.arrayLayers   = 1;
+	imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage         = usage;
+	imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	if (vkCreateImage(mDevice, &imageInfo, mAllocator, &depthImage.image) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create a shadow atlas image.");
+		return EXIT_FAILURE;
+	}
+
+	VkMemoryRequirements requirements = {};
+	vkGetImageMemoryRequirements(mDevice, depthImage.image, &requirements);
+
+	std::optional<u32> memoryType = FindMemoryType(
+			mPhysicalDevice, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+	);
+	if (!memoryType.has_value())
+	{
+		CLOG_ERR("No memory type for the shadow atlas.");
+		return EXIT_FAILURE;
+	}
+
+	VkMemoryAllocateInfo allocInfo = {};
+
+	allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize  = requirements.size;
+	allocInfo.memoryTypeIndex = memoryType.value();
+
+	if (vkAllocateMemory(mDevice, &allocInfo, mAllocator, &depthImage.memory) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to allocate shadow atlas memory.");
+		return EXIT_FAILURE;
+	}
+	vkBindImageMemory(mDevice, depthImage.image, depthImage.memory, 0);
+
+	// Depth only, which is what gets sampled. Shadow passes never touch stencil.
+	std::optional<VkImageView> view =
+			CreateImageView(mDevice, depthImage.image, mFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+	if (!view.has_value())
+	{
+		return EXIT_FAILURE;
+	}
+	depthImage.view = view.value();
+
+	VkFramebufferCreateInfo framebufferInfo = {};
+	framebufferInfo.sType                   = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass              = mRenderPass;
+	framebufferInfo.attachmentCount         = 1;
+	framebufferInfo.pAttachments            = &depthImage.view;
+	framebufferInfo.width                   = mExtent.width;
+	framebufferInfo.height                  = mExtent.height;
+	framebufferInfo.layers                  = 1;
+
+	if (vkCreateFramebuffer(mDevice, &framebufferInfo, mAllocator, &depthImage.framebuffer)
+		!= VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create a shadow atlas framebuffer.");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void ShadowCascades::DestroyDepthImage(DepthImage &depthImage)
+{
+	vkDestroyFramebuffer(mDevice, depthImage.framebuffer, mAllocator);
+	vkDestroyImageView(mDevice, depthImage.view, mAllocator);
+	vkDestroyImage(mDevice, depthImage.image, mAllocator);
+	vkFreeMemory(mDevice, depthImage.memory, mAllocator);
+
+	depthImage = {};
+}
+
+bool ShadowCascades::CreateRenderPass()
+{
+	// Both atlases keep their contents: the cache between frames, the atlas its cache copy.
+	VkAttachmentDescription depthAttachment = {};
+	depthAttachment.format                  = mFormat;
+	depthAttachment.samples                 = VK_SAMPLE_COUNT_1_BIT;
+
+	depthAttachment.loadOp  = VK_ATTACHMENT_LOAD_OP_LOAD;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+
+	depthAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthAttachment.finalLayout   = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+
+	VkAttachmentReference depthAttachmentRef = {};
+	depthAttachmentRef.attachment            = 0;
+	depthAttachmentRef.layout                = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+
+	VkSubpassDescription subpass    = {};
+	subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+
+	VkRenderPassCreateInfo renderPassInfo = {};
+	renderPassInfo.sType                  = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount        = 1;
+	renderPassInfo.pAttachments           = &depthAttachment;
+	renderPassInfo.subpassCount           = 1;
+	renderPassInfo.pSubpasses             = &subpass;
+
+	if (vkCreateRenderPass(mDevice, &renderPassInfo, mAllocator, &mRenderPass) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create the shadow render pass.");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+bool ShadowCascades::CreatePipeline(
+		VkShaderModule          vertModule,
+		const ShaderReflection &vertReflection
+)
+{
+	const ShaderReflection *stages[] = {&vertReflection};
+
+	std::optional<VkPipelineLayout> layout = mLayoutCache->GetPipelineLayout(stages, 1);
+	if (!layout.has_value())
+	{
+		CLOG_ERR("Shadow pipeline layout creation failed.");
+		return EXIT_FAILURE;
+	}
+	mPipelineLayout = layout.value();
+
+	VkPipelineShaderStageCreateInfo stageInfo = {};
+	stageInfo.sType                           = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stageInfo.stage                           = VK_SHADER_STAGE_VERTEX_BIT;
+	stageInfo.module                          = vertModule;
+	stageInfo.pName                           = "main";
+
+	// Same mesh and per-instance data as the main pass.
+	MeshVertexInput vertexInput;
+	if (BuildMeshVertexInput(vertReflection, sizeof(InstanceData), vertexInput) == EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	const VkPipelineVertexInputStateCreateInfo vertexInputInfo = vertexInput.GetCreateInfo();
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+	inputAssembly.sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	// Set per cascade.
+	VkPipelineViewportStateCreateInfo viewportState = {};
+	viewportState.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportState.viewportCount = 1;
+	viewportState.scissorCount  = 1;
+
+	const VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+	VkPipelineDynamicStateCreateInfo dynamicState = {};
+	dynamicState.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = (u32)std::size(dynamicStates);
+	dynamicState.pDynamicStates    = dynamicStates;
+
+	// Seen from the sun the triangles can face either way.
+	VkPipelineRasterizationStateCreateInfo rasterizer = {};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+
+	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizer.lineWidth   = 1.0f;
+	rasterizer.cullMode    = VK_CULL_MODE_NONE;
+	rasterizer.frontFace   = VK_FRONT_FACE_CLOCKWISE;
+
+	rasterizer.depthBiasEnable         = VK_TRUE;
+	rasterizer.depthBiasConstantFactor = kDepthBiasConstant;
+	rasterizer.depthBiasSlopeFactor    = kDepthBiasSlope;
+
+	VkPipelineMultisampleStateCreateInfo multisampling = {};
+	multisampling.sType                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+
+	depthStencil.depthTestEnable  = VK_TRUE;
+	depthStencil.depthWriteEnable = VK_TRUE;
+	depthStencil.depthCompareOp   = VK_COMPARE_OP_LESS;
+
+	VkPipelineColorBlendStateCreateInfo colorBlending = {};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType                        = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount                   = 1;
+	pipelineInfo.pStages                      = &stageInfo;
+
+	pipelineInfo.pVertexInputState   = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState      = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pMultisampleState   = &multisampling;
+	pipelineInfo.pDepthStencilState  = &depthStencil;
+	pipelineInfo.pColorBlendState    = &colorBlending;
+	pipelineInfo.pDynamicState       = &dynamicState;
+
+	pipelineInfo.layout     = mPipelineLayout;
+	pipelineInfo.renderPass = mRenderPass;
+	pipelineInfo.subpass    = 0;
+
+	if (vkCreateGraphicsPipelines(mDevice, VK_NULL_HANDLE, 1, &pipelineInfo, mAllocator, &mPipeline)
+		!= VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create the shadow pipeline.");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void ShadowCascades::BeginCascades(
+		VkCommandBuffer commandBuffer,
+		VkFramebuffer   framebuffer,
+		const GpuMesh  &mesh,
+		VkBuffer        instanceBuffer
+)
+{
+	VkRenderPassBeginInfo renderPassInfo = {};
+
+	renderPassInfo.sType       = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass  = mRenderPass;
+	renderPassInfo.framebuffer = framebuffer;
+
+	renderPassInfo.renderArea.offset = {0, 0};
+	renderPassInfo.renderArea.extent = mExtent;
+
+	VulkanDispatch::vkCmdBeginRenderPass(
+			commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE
+	);
+
+	VulkanDispatch::vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipeline);
+
+	mesh.Bind(commandBuffer, instanceBuffer);
+}
+
+void ShadowCascades::SetCascade(VkCommandBuffer commandBuffer, u32 cascade)
+{
+	const VkRect2D tile = GetTileRect(cascade);
+
+	VkViewport viewport = {};
+	viewport.x          = (f32)tile.offset.x;
+	viewport.y          = (f32)tile.offset.y;
+	viewport.width      = (f32)tile.extent.width;
+	viewport.height     = (f32)tile.extent.height;
+	viewport.minDepth   = 0.0f;
+	viewport.maxDepth   = 1.0f;
+	VulkanDispatch::vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	VulkanDispatch::vkCmdSetScissor(commandBuffer, 0, 1, &tile);
+
+	VulkanDispatch::vkCmdPushConstants(
+			commandBuffer,
+			mPipelineLayout,
+			VK_SHADER_STAGE_VERTEX_BIT,
+			0,
+			sizeof(glm::mat4),
+			&mMatrices[cascade]
+	);
+}
+
+VkRect2D ShadowCascades::GetTileRect(u32 cascade) const
+{
+	const u32 column = cascade % mColumns;
+	const u32 row    = cascade / mColumns;
+
+	VkRect2D rect = {};
+	rect.offset   = {(i32)(mSettings.resolution * column), (i32)(mSettings.resolution * row)};
+	rect.extent   = {mSettings.resolution, mSettings.resolution};
+	return rect;
+}
@@ -0,0 +1,206 @@
+#ifndef HEADER_SHADOW_CASCADES_H
+#define HEADER_SHADOW_CASCADES_H
+
+#include "definitions.h"
+#include "pch/glm.h"
+#include "render/mesh.h"
+#include "render/render_graph.h"
+#include "render/spirv_reflect.h"
+#include "vulkan/vulkan_core.h"
+
+#include <vector>
+
+class PipelineLayoutCache;
+
+/* Cascaded shadow maps of a directional sun, all cascades in the tiles of one depth atlas.
+ *
+ * The view box is split along its depth into cascadeCount slices (blend of uniform and
+ * logarithmic splits). Each cascade is an orthographic projection around the bounding sphere of
+ * its slice, so its size does not change with the sun direction, and its center is snapped to
+ * whole texels in light space: moving the view only moves a cascade once it moved by a texel.
+ *
+ * Static casters (instances without a SimulatedBody) are rendered into a separate cache atlas,
+ * and only into the cascades whose projection changed since or when the static set changed.
+ * Every frame the cache is copied into the atlas and the dynamic casters are drawn on top, so a
+ * frame pays for one atlas copy and the moving casters instead of every caster.
+ *
+ * The atlas is imported into the render graph (its previous contents never matter), the cache
+ * is private and synchronized here. */
+class ShadowCascades
+{
+public:
+	// Matches kMaxCascades of clustered_frag.glsl.
+	static constexpr u32 kMaxCascades = 4;
+
+	struct Settings
+	{
+		u32 cascadeCount = 3;
+		u32 resolution   = 1024;// Of each cascade tile
+
+		// 0 splits uniformly, 1 logarithmically.
+		f32 splitLambda = 0.6f;
+
+		glm::vec3 sunDirection = glm::vec3(-0.4f, -0.3f, -1.0f);// Towards the sun
+		glm::vec3 sunColor     = glm::vec3(0.8f);
+	};
+
+	// Matches ShadowParams of clustered_frag.glsl, std140.
+	struct Uniforms
+	{
+		glm::mat4  cascadeMatrices[kMaxCascades];// Scene space to atlas uv and light depth
+		glm::vec4  cascadeSplits;                // Far depth of each cascade
+		glm::vec4  sunDirection;
+		glm::vec4  sunColor;
+		glm::uvec4 cascadeCount;
+	};
+
+	struct Stats
+	{
+		u64 frames               = 0;
+		u64 staticCascadeRenders = 0;
+	};
+
+public:
+	/* vertModule is shadow_vert.glsl, only used during the call. Layouts come from layoutCache,
+	 * which has to outlive this object. */
+	bool Init(
+			VkDevice                     device,
+			VkPhysicalDevice             physicalDevice,
+			PipelineLayoutCache         &layoutCache,
+			VkShaderModule               vertModule,
+			const ShaderReflection      &vertReflection,
+			u32                          frameCount,
+			const Settings              &settings,
+			const VkAllocationCallbacks *allocator
+	);
+
+	void Destroy();
+
+	// Allocates the per-frame sets of a graphics pipeline layout declaring ShadowParams at set.
+	bool BindGraphicsLayout(VkPipelineLayout pipelineLayout, u32 set);
+
+	// Re-renders every cached cascade, for static casters that moved without changing in count.
+	void InvalidateStatic();
+
+	/* Fits the cascades to the view box and writes the frame's uniforms. Cascades whose
+	 * projection moved, or all of them when staticInstanceCount changed, are re-rendered into the
+	 * cache by the next RecordCache. */
+	void Update(
+			u32              frameIndex,
+			const glm::vec3 &viewMin,
+			const glm::vec3 &viewMax,
+			u32              staticInstanceCount
+	);
+
+	// For RenderGraph::ImportImage, the contents are rebuilt every frame.
+	[[nodiscard]] RGImageDesc GetAtlasDesc() const;
+
+	[[nodiscard]] VkImage GetAtlasImage() const
+	{
+		return mAtlas.image;
+	}
+
+	[[nodiscard]] VkImageView GetAtlasView() const
+	{
+		return mAtlas.view;
+	}
+
+	/* Re-renders the outdated cascades of the cache from the draws of the static instances, then
+	 * copies the cache into the atlas, which has to be in TRANSFER_DST_OPTIMAL. */
+	void RecordCache(
+			VkCommandBuffer commandBuffer,
+			const GpuMesh  &mesh,
+			VkBuffer        instanceBuffer,
+			const MeshDraw *draws,
+			u32             drawCount
+	);
+
+	// Draws instances into every cascade of the atlas, on top of the cache copy.
+	void RecordDynamic(
+			VkCommandBuffer commandBuffer,
+			const GpuMesh  &mesh,
+			VkBuffer        instanceBuffer,
+			const MeshDraw *draws,
+			u32             drawCount
+	);
+
+	// Binds the set and layout given to BindGraphicsLayout.
+	void BindForShading(VkCommandBuffer commandBuffer, u32 frameIndex) const;
+
+	void LogStats() const;
+
+private:
+	struct DepthImage
+	{
+		VkImage        image  = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkImageView    view   = VK_NULL_HANDLE;
+
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+	};
+
+	struct FrameResources
+	{
+		VkBuffer        uniforms       = VK_NULL_HANDLE;
+		VkDeviceMemory  uniformsMemory = VK_NULL_HANDLE;
+		Uniforms       *uniformsMapped = nullptr;
+		VkDescriptorSet set            = VK_NULL_HANDLE;
+	};
+
+	bool CreateDepthImage(VkImageUsageFlags usage, DepthImage &depthImage);
+
+	void DestroyDepthImage(DepthImage &depthImage);
+
+	bool CreateRenderPass();
+
+	bool CreatePipeline(VkShaderModule vertModule, const ShaderReflection &vertReflection);
+
+	// Begins the render pass, binds the pipeline, the mesh and its instances.
+	void BeginCascades(
+			VkCommandBuffer commandBuffer,
+			VkFramebuffer   framebuffer,
+			const GpuMesh  &mesh,
+			VkBuffer        instanceBuffer
+	);
+
+	void SetCascade(VkCommandBuffer commandBuffer, u32 cascade);
+
+	[[nodiscard]] VkRect2D GetTileRect(u32 cascade) const;
+
+private:
+	VkDevice                     mDevice         = VK_NULL_HANDLE;
+	VkPhysicalDevice             mPhysicalDevice = VK_NULL_HANDLE;
+	PipelineLayoutCache         *mLayoutCache    = nullptr;
+	const VkAllocationCallbacks *mAllocator      = nullptr;
+
+	Settings mSettings;
+
+	VkFormat           mFormat  = VK_FORMAT_UNDEFINED;
+	VkImageAspectFlags mAspect  = VK_IMAGE_ASPECT_DEPTH_BIT;
+	VkExtent2D         mExtent  = {};
+	u32                mColumns = 1;// Tiles per atlas row
+
+	DepthImage    mAtlas;
+	DepthImage    mCache;
+	VkImageLayout mCacheLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	VkRenderPass     mRenderPass     = VK_NULL_HANDLE;
+	VkPipelineLayout mPipelineLayout = VK_NULL_HANDLE;// Owned by mLayoutCache
+	VkPipeline       mPipeline       = VK_NULL_HANDLE;
+	VkSampler        mSampler        = VK_NULL_HANDLE;
+
+	VkDescriptorPool            mDescriptorPool = VK_NULL_HANDLE;
+	VkPipelineLayout            mShadingLayout  = VK_NULL_HANDLE;// Owned by mLayoutCache
+	u32                         mShadingSet     = 0;
+	std::vector<FrameResources> mFrames;
+
+	// Current light view-projection of each cascade, and the one its cached tile was drawn with.
+	glm::mat4 mMatrices[kMaxCascades]      = {};
+	glm::mat4 mCacheMatrices[kMaxCascades] = {};
+	u32       mOutdatedCascades            = 0;// Bit per cascade
+	u32       mCachedStaticCount           = ~0u;
+
+	Stats mStats;
+};
+
+#endif// HEADER_SHADOW_CASCADES_H
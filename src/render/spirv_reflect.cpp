@@ -0,0 +1,625 @@
+#include "spirv_reflect.h"
+
+#include "core/arena.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// Values from the SPIR-V specification, only the ones reflection looks at.
+constexpr u32 kSpirvMagic      = 0x07230203;
+constexpr u32 kSpirvHeaderSize = 5;
+
+constexpr u32 kOpEntryPoint                 = 15;
+constexpr u32 kOpTypeBool                   = 20;
+constexpr u32 kOpTypeInt                    = 21;
+constexpr u32 kOpTypeFloat                  = 22;
+constexpr u32 kOpTypeVector                 = 23;
+constexpr u32 kOpTypeMatrix                 = 24;
+constexpr u32 kOpTypeImage                  = 25;
+constexpr u32 kOpTypeSampler                = 26;
+constexpr u32 kOpTypeSampledImage           = 27;
+constexpr u32 kOpTypeArray                  = 28;
+constexpr u32 kOpTypeRuntimeArray           = 29;
+constexpr u32 kOpTypeStruct                 = 30;
+constexpr u32 kOpTypePointer                = 32;
+constexpr u32 kOpConstant                   = 43;
+constexpr u32 kOpSpecConstantTrue           = 48;
+constexpr u32 kOpSpecConstantFalse          = 49;
+constexpr u32 kOpSpecConstant               = 50;
+constexpr u32 kOpVariable                   = 59;
+constexpr u32 kOpDecorate                   = 71;
+constexpr u32 kOpMemberDecorate             = 72;
+constexpr u32 kOpTypeAccelerationStructure  = 5341;
+
+constexpr u32 kDecorationSpecId        = 1;
+constexpr u32 kDecorationBufferBlock   = 3;
+constexpr u32 kDecorationArrayStride   = 6;
+constexpr u32 kDecorationMatrixStride  = 7;
+constexpr u32 kDecorationBuiltIn       = 11;
+constexpr u32 kDecorationLocation      = 30;
+constexpr u32 kDecorationBinding       = 33;
+constexpr u32 kDecorationDescriptorSet = 34;
+constexpr u32 kDecorationOffset        = 35;
+
+constexpr u32 kStorageUniformConstant = 0;
+constexpr u32 kStorageInput           = 1;
+constexpr u32 kStorageUniform         = 2;
+constexpr u32 kStoragePushConstant    = 9;
+constexpr u32 kStorageStorageBuffer   = 12;
+
+constexpr u32 kDimBuffer      = 5;
+constexpr u32 kDimSubpassData = 6;
+
+constexpr u32 kUnset = ~0u;
+
+static VkShaderStageFlagBits ExecutionModelToStage(u32 model)
+{
+	switch (model)
+	{
+		case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+		case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+		case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+		case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+		case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+		case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+		case 5364: return VK_SHADER_STAGE_TASK_BIT_EXT;
+		case 5365: return VK_SHADER_STAGE_MESH_BIT_EXT;
+		default: return VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM;
+	}
+}
+
+
+/**************************************
+*       PARSER
+**************************************/
+
+// What reflection needs to know about one result id.
+struct SpirvId
+{
+	u32  opcode      = 0;
+	u32  wordOffset  = 0;// Declaring instruction, operands are read from the code on demand
+	u32  set         = kUnset;
+	u32  binding     = kUnset;
+	u32  location    = kUnset;
+	u32  specId      = kUnset;
+	u32  arrayStride = 0;
+	bool bufferBlock = false;
+	bool builtIn     = false;
+};
+
+struct MemberDecoration
+{
+	u32 structId;
+	u32 member;
+	u32 decoration;
+	u32 value;
+};
+
+class SpirvParser
+{
+public:
+	SpirvParser(const u32 *code, u32 wordCount)
+		: mCode(code)
+		, mWordCount(wordCount)
+	{
+	}
+
+	bool Parse(ShaderReflection &reflection);
+
+private:
+	bool ReadInstructions(ShaderReflection &reflection);
+
+	bool IsValid(u32 id) const
+	{
+		return id < mIds.size() && mIds[id].opcode != 0;
+	}
+
+	// Operands of the instruction declaring id, without the opcode word.
+	const u32 *Operands(u32 id) const
+	{
+		return mCode + mIds[id].wordOffset + 1;
+	}
+
+	u32 GetMemberDecoration(u32 structId, u32 member, u32 decoration) const;
+
+	u32 GetConstantValue(u32 id) const;
+
+	// Byte size of a type laid out with its explicit offsets and strides.
+	u32 GetTypeSize(u32 typeId, u32 matrixStride = 0) const;
+
+	VkFormat GetVertexFormat(u32 typeId) const;
+
+	bool ReflectVariable(u32 variableId, ShaderReflection &reflection) const;
+
+	bool ReflectDescriptor(
+			const SpirvId    &variable,
+			u32               storage,
+			u32               typeId,
+			ShaderReflection &reflection
+	) const;
+
+private:
+	const u32 *mCode;
+	u32        mWordCount;
+
+	ArenaVector<SpirvId>          mIds;
+	ArenaVector<MemberDecoration> mMemberDecorations;
+	ArenaVector<u32>              mVariables;
+	ArenaVector<u32>              mSpecConstants;
+};
+
+bool SpirvParser::Parse(ShaderReflection &reflection)
+{
+	if (mWordCount < kSpirvHeaderSize || mCode[0] != kSpirvMagic)
+	{
+		CLOG_ERR("Not a SPIR-V module.");
+		return EXIT_FAILURE;
+	}
+
+	// Word 3 is the id bound, every result id is below it.
+	mIds.resize(mCode[3]);
+
+	if (ReadInstructions(reflection) == EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	for (u32 variableId : mVariables)
+	{
+		if (ReflectVariable(variableId, reflection) == EXIT_FAILURE)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+
+	for (u32 constantId : mSpecConstants)
+	{
+		const SpirvId &constant = mIds[constantId];
+		if (constant.specId == kUnset)
+		{
+			continue;
+		}
+
+		const u32 typeId = Operands(constantId)[0];
+		const u32 size =
+				constant.opcode == kOpSpecConstant ? GetTypeSize(typeId) : (u32)sizeof(VkBool32);
+		reflection.specConstants.push_back({constant.specId, size});
+	}
+
+	std::sort(
+			reflection.bindings.begin(),
+			reflection.bindings.end(),
+			[](const ReflectedBinding &a, const ReflectedBinding &b)
+			{ return a.set != b.set ? a.set < b.set : a.binding < b.binding; }
+	);
+	std::sort(
+			reflection.inputs.begin(),
+			reflection.inputs.end(),
+			[](const ReflectedVertexInput &a, const ReflectedVertexInput &b)
+			{ return a.location < b.location; }
+	);
+	std::sort(
+			reflection.specConstants.begin(),
+			reflection.specConstants.end(),
+			[](const ReflectedSpecConstant &a, const ReflectedSpecConstant &b)
+			{ return a.id < b.id; }
+	);
+
+	return EXIT_SUCCESS;
+}
+
+bool SpirvParser::ReadInstructions(ShaderReflection &reflection)
+{
+	bool hasEntryPoint = false;
+
+	for (u32 offset = kSpirvHeaderSize; offset < mWordCount;)
+	{
+		const u32  wordCount = mCode[offset] >> 16;
+		const u32  opcode    = mCode[offset] & 0xFFFF;
+		const u32 *operands  = mCode + offset + 1;
+
+		if (wordCount == 0 || offset + wordCount > mWordCount)
+		{
+			CLOG_ERR("Malformed SPIR-V instruction at word ", offset, ".");
+			return EXIT_FAILURE;
+		}
+
+		// Id carrying the result of the instruction, kUnset for instructions reflection skips.
+		u32 resultId = kUnset;
+
+		switch (opcode)
+		{
+			case kOpEntryPoint:
+				if (!hasEntryPoint)
+				{
+					reflection.stage = ExecutionModelToStage(operands[0]);
+					hasEntryPoint    = true;
+				}
+				break;
+
+			case kOpDecorate:
+			{
+				if (operands[0] >= mIds.size())
+				{
+					break;
+				}
+
+				SpirvId  &target = mIds[operands[0]];
+				const u32 value  = wordCount > 3 ? operands[2] : 0;
+				switch (operands[1])
+				{
+					case kDecorationSpecId: target.specId = value; break;
+					case kDecorationBufferBlock: target.bufferBlock = true; break;
+					case kDecorationArrayStride: target.arrayStride = value; break;
+					case kDecorationBuiltIn: target.builtIn = true; break;
+					case kDecorationLocation: target.location = value; break;
+					case kDecorationBinding: target.binding = value; break;
+					case kDecorationDescriptorSet: target.set = value; break;
+					default: break;
+				}
+				break;
+			}
+
+			case kOpMemberDecorate:
+				if (wordCount > 4
+					&& (operands[2] == kDecorationOffset || operands[2] == kDecorationMatrixStride))
+				{
+					mMemberDecorations.push_back(
+							{operands[0], operands[1], operands[2], operands[3]}
+					);
+				}
+				break;
+
+			case kOpTypeBool:
+			case kOpTypeInt:
+			case kOpTypeFloat:
+			case kOpTypeVector:
+			case kOpTypeMatrix:
+			case kOpTypeImage:
+			case kOpTypeSampler:
+			case kOpTypeSampledImage:
+			case kOpTypeArray:
+			case kOpTypeRuntimeArray:
+			case kOpTypeStruct:
+			case kOpTypePointer:
+			case kOpTypeAccelerationStructure:
+				resultId = operands[0];
+				break;
+
+			case kOpConstant:
+				resultId = operands[1];
+				break;
+
+			case kOpSpecConstantTrue:
+			case kOpSpecConstantFalse:
+			case kOpSpecConstant:
+				resultId = operands[1];
+				mSpecConstants.push_back(resultId);
+				break;
+
+			case kOpVariable:
+				resultId = operands[1];
+				mVariables.push_back(resultId);
+				break;
+
+			default: break;
+		}
+
+		if (resultId != kUnset)
+		{
+			if (resultId >= mIds.size())
+			{
+				CLOG_ERR("SPIR-V id ", resultId, " is out of bounds.");
+				return EXIT_FAILURE;
+			}
+
+			mIds[resultId].opcode     = opcode;
+			mIds[resultId].wordOffset = offset;
+		}
+
+		offset += wordCount;
+	}
+
+	if (!hasEntryPoint)
+	{
+		CLOG_ERR("SPIR-V module has no entry point.");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+u32 SpirvParser::GetMemberDecoration(u32 structId, u32 member, u32 decoration) const
+{
+	for (const MemberDecoration &entry : mMemberDecorations)
+	{
+		if (entry.structId == structId && entry.member == member && entry.decoration == decoration)
+		{
+			return entry.value;
+		}
+	}
+
+	return kUnset;
+}
+
+u32 SpirvParser::GetConstantValue(u32 id) const
+{
+	// Array lengths are 32 bit integers, the low word is all of it.
+	return IsValid(id) && mIds[id].opcode == kOpConstant ? Operands(id)[2] : 0;
+}
+
+u32 SpirvParser::GetTypeSize(u32 typeId, u32 matrixStride) const
+{
+	if (!IsValid(typeId))
+	{
+		return 0;
+	}
+
+	const u32 *operands = Operands(typeId);
+	switch (mIds[typeId].opcode)
+	{
+		case kOpTypeBool: return sizeof(VkBool32);
+		case kOpTypeInt:
+		case kOpTypeFloat: return operands[1] / 8;
+		case kOpTypeVector: return operands[2] * GetTypeSize(operands[1]);
+		case kOpTypeMatrix:
+			return operands[2] * (matrixStride > 0 ? matrixStride : GetTypeSize(operands[1]));
+		case kOpTypeArray:
+		{
+			const u32 stride = mIds[typeId].arrayStride;
+			return GetConstantValue(operands[2]) * (stride > 0 ? stride : GetTypeSize(operands[1]));
+		}
+		case kOpTypeStruct:
+		{
+			const u32 wordCount   = mCode[mIds[typeId].wordOffset] >> 16;
+			const u32 memberCount = wordCount - 2;
+
+			u32 size = 0;
+			for (u32 member = 0; member < memberCount; ++member)
+			{
+				const u32 offset = GetMemberDecoration(typeId, member, kDecorationOffset);
+				const u32 stride = GetMemberDecoration(typeId, member, kDecorationMatrixStride);
+				const u32 memberSize =
+						GetTypeSize(operands[1 + member], stride != kUnset ? stride : 0);
+
+				// Without explicit offsets (not a block) members are packed.
+				size = std::max(size, (offset != kUnset ? offset : size) + memberSize);
+			}
+			return size;
+		}
+		default: return 0;
+	}
+}
+
+VkFormat SpirvParser::GetVertexFormat(u32 typeId) const
+{
+	static constexpr VkFormat kFloatFormats[] = {
+			VK_FORMAT_R32_SFLOAT,
+			VK_FORMAT_R32G32_SFLOAT,
+			VK_FORMAT_R32G32B32_SFLOAT,
+			VK_FORMAT_R32G32B32A32_SFLOAT,
+	};
+	static constexpr VkFormat kIntFormats[] = {
+			VK_FORMAT_R32_SINT,
+			VK_FORMAT_R32G32_SINT,
+			VK_FORMAT_R32G32B32_SINT,
+			VK_FORMAT_R32G32B32A32_SINT,
+	};
+	static constexpr VkFormat kUintFormats[] = {
+			VK_FORMAT_R32_UINT,
+			VK_FORMAT_R32G32_UINT,
+			VK_FORMAT_R32G32B32_UINT,
+			VK_FORMAT_R32G32B32A32_UINT,
+	};
+
+	u32 componentType  = typeId;
+	u32 componentCount = 1;
+	if (IsValid(typeId) && mIds[typeId].opcode == kOpTypeVector)
+	{
+		componentType  = Operands(typeId)[1];
+		componentCount = Operands(typeId)[2];
+	}
+
+	if (!IsValid(componentType) || componentCount == 0 || componentCount > 4
+		|| Operands(componentType)[1] != 32)
+	{
+		return VK_FORMAT_UNDEFINED;
+	}
+
+	switch (mIds[componentType].opcode)
+	{
+		case kOpTypeFloat: return kFloatFormats[componentCount - 1];
+		case kOpTypeInt:
+			return Operands(componentType)[2] != 0 ? kIntFormats[componentCount - 1]
+												   : kUintFormats[componentCount - 1];
+		default: return VK_FORMAT_UNDEFINED;
+	}
+}
+
+bool SpirvParser::ReflectVariable(u32 variableId, ShaderReflection &reflection) const
+{
+	const SpirvId &variable = mIds[variableId];
+	const u32      storage  = Operands(variableId)[2];
+	const u32      pointer  = Operands(variableId)[0];
+
+	if (!IsValid(pointer) || mIds[pointer].opcode != kOpTypePointer)
+	{
+		CLOG_ERR("SPIR-V variable ", variableId, " is not a pointer.");
+		return EXIT_FAILURE;
+	}
+	const u32 typeId = Operands(pointer)[2];
+
+	switch (storage)
+	{
+		case kStorageInput:
+		{
+			if (reflection.stage != VK_SHADER_STAGE_VERTEX_BIT || variable.builtIn
+				|| variable.location == kUnset)
+			{
+				break;
+			}
+
+			// Matrices take one location per column.
+			u32 columnType  = typeId;
+			u32 columnCount = 1;
+			if (IsValid(typeId) && mIds[typeId].opcode == kOpTypeMatrix)
+			{
+				columnType  = Operands(typeId)[1];
+				columnCount = Operands(typeId)[2];
+			}
+
+			const VkFormat format = GetVertexFormat(columnType);
+			const u32      size   = format != VK_FORMAT_UNDEFINED ? GetTypeSize(columnType) : 0;
+			if (format == VK_FORMAT_UNDEFINED)
+			{
+				CLOG_WARN("Unsupported vertex input type at location ", variable.location, ".");
+			}
+
+			for (u32 column = 0; column < columnCount; ++column)
+			{
+				reflection.inputs.push_back({variable.location + column, format, size});
+			}
+			break;
+		}
+
+		case kStoragePushConstant:
+		{
+			// The range starts at the first member, blocks may leave room for other stages.
+			u32 firstOffset = 0;
+			if (IsValid(typeId) && mIds[typeId].opcode == kOpTypeStruct)
+			{
+				const u32 memberCount = (mCode[mIds[typeId].wordOffset] >> 16) - 2;
+
+				firstOffset = kUnset;
+				for (u32 member = 0; member < memberCount; ++member)
+				{
+					const u32 offset = GetMemberDecoration(typeId, member, kDecorationOffset);
+					firstOffset      = std::min(firstOffset, offset != kUnset ? offset : 0);
+				}
+				firstOffset = firstOffset == kUnset ? 0 : firstOffset;
+			}
+
+			reflection.pushConstantOffset = firstOffset;
+			reflection.pushConstantSize   = GetTypeSize(typeId) - firstOffset;
+			break;
+		}
+
+		case kStorageUniformConstant:
+		case kStorageUniform:
+		case kStorageStorageBuffer:
+			return ReflectDescriptor(variable, storage, typeId, reflection);
+
+		default: break;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+bool SpirvParser::ReflectDescriptor(
+		const SpirvId    &variable,
+		u32               storage,
+		u32               typeId,
+		ShaderReflection &reflection
+) const
+{
+	if (variable.set == kUnset || variable.binding == kUnset)
+	{
+		CLOG_ERR("SPIR-V resource without set and binding decorations.");
+		return EXIT_FAILURE;
+	}
+
+	ReflectedBinding binding = {};
+	binding.set              = variable.set;
+	binding.binding          = variable.binding;
+
+	if (IsValid(typeId) && mIds[typeId].opcode == kOpTypeArray)
+	{
+		binding.count = GetConstantValue(Operands(typeId)[2]);
+		typeId        = Operands(typeId)[1];
+	}
+	else if (IsValid(typeId) && mIds[typeId].opcode == kOpTypeRuntimeArray)
+	{
+		// Needs descriptor indexing, which layouts do not set up yet.
+		CLOG_WARN("Runtime array at binding ", binding.binding, " reflected as one descriptor.");
+		typeId = Operands(typeId)[1];
+	}
+
+	if (!IsValid(typeId))
+	{
+		CLOG_ERR("SPIR-V resource with an unknown type.");
+		return EXIT_FAILURE;
+	}
+
+	const u32 *operands = Operands(typeId);
+	switch (mIds[typeId].opcode)
+	{
+		case kOpTypeStruct:
+			if (storage == kStorageStorageBuffer || mIds[typeId].bufferBlock)
+			{
+				binding.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			}
+			else
+			{
+				binding.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			}
+			break;
+
+		case kOpTypeSampler: binding.type = VK_DESCRIPTOR_TYPE_SAMPLER; break;
+
+		case kOpTypeSampledImage:
+			binding.type = IsValid(operands[1]) && Operands(operands[1])[2] == kDimBuffer
+								 ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
+								 : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			break;
+
+		case kOpTypeImage:
+		{
+			// result, sampled type, dim, depth, arrayed, ms, sampled (1 sampled, 2 storage), ...
+			const u32  dim     = operands[2];
+			const bool sampled = operands[6] == 1;
+			if (dim == kDimSubpassData)
+			{
+				binding.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+			}
+			else if (dim == kDimBuffer)
+			{
+				binding.type = sampled ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
+									   : VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+			}
+			else
+			{
+				binding.type = sampled ? VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE
+									   : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			}
+			break;
+		}
+
+		case kOpTypeAccelerationStructure:
+			binding.type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+			break;
+
+		default:
+			CLOG_ERR("Unsupported descriptor at binding ", binding.binding, ".");
+			return EXIT_FAILURE;
+	}
+
+	reflection.bindings.push_back(binding);
+	return EXIT_SUCCESS;
+}
+
+
+/**************************************
+*       REFLECTION
+**************************************/
+
+bool ReflectSpirv(const u32 *code, size_t codeSize, ShaderReflection &reflection)
+{
+	reflection = {};
+
+	// Parser tables only live for this call.
+	ScratchScope scratch;
+	SpirvParser  parser(code, (u32)(codeSize / sizeof(u32)));
+
+	return parser.Parse(reflection);
+}
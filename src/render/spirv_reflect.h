@@ -0,0 +1,52 @@
+#ifndef HEADER_SPIRV_REFLECT_H
+#define HEADER_SPIRV_REFLECT_H
+
+#include "definitions.h"
+#include "vulkan/vulkan_core.h"
+
+#include <vector>
+
+/* Minimal SPIR-V reflection, enough to build layouts without writing them by hand: descriptor
+ * bindings, the push constant block, vertex stage inputs and specialization constants of the
+ * module's first entry point.
+ *
+ * Only decorations and type declarations are read, so everything a module declares is
+ * reported, whether the entry point uses it or not. */
+
+struct ReflectedBinding
+{
+	u32              set     = 0;
+	u32              binding = 0;
+	VkDescriptorType type    = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+	u32              count   = 1;
+};
+
+struct ReflectedVertexInput
+{
+	u32      location = 0;
+	VkFormat format   = VK_FORMAT_UNDEFINED;
+	u32      size     = 0;// Bytes, 0 when the format is undefined
+};
+
+struct ReflectedSpecConstant
+{
+	u32 id   = 0;
+	u32 size = 0;// Bytes in VkSpecializationMapEntry, booleans are a VkBool32
+};
+
+struct ShaderReflection
+{
+	VkShaderStageFlagBits stage = VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM;
+
+	std::vector<ReflectedBinding>      bindings;// Sorted by set, then binding
+	std::vector<ReflectedVertexInput>  inputs;  // Vertex stage only, sorted by location
+	std::vector<ReflectedSpecConstant> specConstants;
+
+	// Byte range of the push constant block, pushConstantSize is 0 without one.
+	u32 pushConstantOffset = 0;
+	u32 pushConstantSize   = 0;
+};
+
+bool ReflectSpirv(const u32 *code, size_t codeSize, ShaderReflection &reflection);
+
+#endif// HEADER_SPIRV_REFLECT_H
@@ -0,0 +1,229 @@
+#include "validation.h"
+
+#include "utils/logger.h"
+
+#include <chrono>
+#include <cstdio>
+
+// Tracked keys beyond this share the overflow entry, keeping probe sequences short.
+constexpr u32 kMaxTrackedLoad = ValidationMessenger::kMaxTrackedMessages / 4 * 3;
+
+static u64 GetSteadyTimeNs()
+{
+	return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+				   std::chrono::steady_clock::now().time_since_epoch()
+	)
+			.count();
+}
+
+// FNV-1a of the ID number and name, never 0 as that marks free slots.
+static u64 HashMessageKey(i32 idNumber, const char *text)
+{
+	u64 hash = 14695981039346656037ull ^ (u32)idNumber;
+	for (const char *c = text; *c != '\0'; ++c)
+	{
+		hash ^= (u8)*c;
+		hash *= 1099511628211ull;
+	}
+
+	return hash != 0 ? hash : 1;
+}
+
+void ValidationMessenger::PopulateCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo)
+{
+	createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+
+	createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT
+							   // | VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT
+							   // | VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT
+							   | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+
+	createInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT
+						   | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT
+						   | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+
+	createInfo.pfnUserCallback = Callback;
+	createInfo.pUserData       = this;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (mLastSummary == 0)
+	{
+		mLastSummary = GetSteadyTimeNs();
+	}
+}
+
+void ValidationMessenger::LogSummary()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	LogSuppressed(GetSteadyTimeNs());
+
+	u64 total = mOverflow.total;
+	for (const MessageStats &stats : mMessages)
+	{
+		total += stats.total;
+	}
+
+	if (total == 0)
+	{
+		return;
+	}
+
+	CLOG_INFO("Validation: ", total, " messages, ", mTrackedCount, " distinct.");
+	for (const MessageStats &stats : mMessages)
+	{
+		if (stats.total > kMessagesPerWindow)
+		{
+			CLOG_INFO("    ", stats.idName, ": ", stats.total, " times.");
+		}
+	}
+	if (mOverflow.total > 0)
+	{
+		CLOG_INFO("    Untracked messages: ", mOverflow.total, " times.");
+	}
+}
+
+VkBool32 ValidationMessenger::Callback(
+		VkDebugUtilsMessageSeverityFlagBitsEXT      messageSeverity,
+		VkDebugUtilsMessageTypeFlagsEXT             messageType,
+		const VkDebugUtilsMessengerCallbackDataEXT *pCallbackData,
+		void                                       *pUserData
+)
+{
+	ValidationMessenger *messenger = static_cast<ValidationMessenger *>(pUserData);
+
+	const u64 now = GetSteadyTimeNs();
+
+	bool log = false;
+	{
+		std::lock_guard<std::mutex> lock(messenger->mMutex);
+		log = messenger->Track(*pCallbackData, now);
+
+		if (now - messenger->mLastSummary >= kSummaryIntervalNs)
+		{
+			messenger->LogSuppressed(now);
+		}
+	}
+
+	if (!log)
+	{
+		return VK_FALSE;
+	}
+
+	if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
+	{
+		CLOG_WARN("Validation layer: ", pCallbackData->pMessage);
+	}
+	else if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+	{
+		CLOG_ERR("Validation layer: ", pCallbackData->pMessage);
+	}
+	else if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT)
+	{
+		CLOG_INFO("Validation layer: ", pCallbackData->pMessage);
+	}
+	else if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT)
+	{
+		CLOG_DEBUG("Validation layer: ", pCallbackData->pMessage);
+	}
+
+	return VK_FALSE;
+}
+
+bool ValidationMessenger::Track(const VkDebugUtilsMessengerCallbackDataEXT &data, u64 now)
+{
+	// Messages without an ID name are told apart by their text.
+	const char *idName  = data.pMessageIdName;
+	const char *keyText = idName != nullptr ? idName : data.pMessage;
+	const u64   key     = HashMessageKey(data.messageIdNumber, keyText);
+
+	MessageStats &stats = FindStats(key, idName);
+	++stats.total;
+
+	if (now - stats.windowStart >= kRateWindowNs)
+	{
+		stats.windowStart  = now;
+		stats.windowLogged = 0;
+	}
+
+	if (stats.windowLogged < kMessagesPerWindow)
+	{
+		++stats.windowLogged;
+		return true;
+	}
+
+	++stats.suppressed;
+	return false;
+}
+
+ValidationMessenger::MessageStats &ValidationMessenger::FindStats(u64 key, const char *idName)
+{
+	u32 index = (u32)key & (kMaxTrackedMessages - 1);
+	for (u32 probe = 0; probe < kMaxTrackedMessages; ++probe)
+	{
+		MessageStats &stats = mMessages[index];
+		if (stats.key == key)
+		{
+			return stats;
+		}
+
+		if (stats.key == 0)
+		{
+			if (mTrackedCount >= kMaxTrackedLoad)
+			{
+				break;
+			}
+
+			stats.key = key;
+			snprintf(
+					stats.idName,
+					sizeof(stats.idName),
+					"%s",
+					idName != nullptr ? idName : "(no message ID)"
+			);
+			++mTrackedCount;
+			return stats;
+		}
+
+		index = (index + 1) & (kMaxTrackedMessages - 1);
+	}
+
+	return mOverflow;
+}
+
+void ValidationMessenger::LogSuppressed(u64 now)
+{
+	u64 suppressed = mOverflow.suppressed;
+	for (const MessageStats &stats : mMessages)
+	{
+		suppressed += stats.suppressed;
+	}
+
+	if (suppressed > 0)
+	{
+		CLOG_WARN(
+				"Validation: ",
+				suppressed,
+				" repeated messages suppressed in the last ",
+				(f64)(now - mLastSummary) * 1e-9,
+				" s."
+		);
+
+		for (MessageStats &stats : mMessages)
+		{
+			if (stats.suppressed > 0)
+			{
+				CLOG_WARN("    ", stats.idName, ": ", stats.suppressed, " suppressed.");
+				stats.suppressed = 0;
+			}
+		}
+
+		if (mOverflow.suppressed > 0)
+		{
+			CLOG_WARN("    Untracked messages: ", mOverflow.suppressed, " suppressed.");
+			mOverflow.suppressed = 0;
+		}
+	}
+
+	mLastSummary = now;
+}
@@ -0,0 +1,93 @@
+#ifndef HEADER_VALIDATION_H
+#define HEADER_VALIDATION_H
+
+#include "definitions.h"
+#include "vulkan/vulkan_core.h"
+
+#include <mutex>
+
+// How much the Khronos validation layer checks, chosen at startup.
+enum class ValidationPreset
+{
+	eOff,
+	eCore,           // Default checks of the layer
+	eSynchronization,// Adds synchronization validation (hazards between commands)
+	eGpuAssisted,    // Adds GPU-assisted validation (shader instrumentation), slowest
+	eCount
+};
+
+#ifdef NDEBUG
+constexpr ValidationPreset kDefaultValidationPreset = ValidationPreset::eOff;
+#else
+constexpr ValidationPreset kDefaultValidationPreset = ValidationPreset::eCore;
+#endif
+
+constexpr const char *kValidationPresetNames[(u32)ValidationPreset::eCount] = {
+		"off", "core", "sync", "gpu"
+};
+
+/* Debug utils messenger that keeps a broken draw from burying the log.
+ *
+ * Messages are keyed by their message ID (VUID), or by the text for messages without one. Each
+ * key may log kMessagesPerWindow times per kRateWindowNs, the rest is only counted. Suppressed
+ * counts are summarized every kSummaryIntervalNs, from the callback itself, and by LogSummary()
+ * at shutdown. The table is fixed size and the callback never allocates; keys beyond
+ * kMaxTrackedMessages share one rate limit. Callbacks can come from any thread. */
+class ValidationMessenger
+{
+public:
+	static constexpr u32 kMaxTrackedMessages = 256;// Power of two
+	static constexpr u32 kMessagesPerWindow  = 3;
+	static constexpr u64 kRateWindowNs       = 1'000'000'000;
+	static constexpr u64 kSummaryIntervalNs  = 10'000'000'000;
+
+	// Message ID names longer than this are cut in the summary.
+	static constexpr u32 kMaxIdNameSize = 64;
+
+	static_assert((kMaxTrackedMessages & (kMaxTrackedMessages - 1)) == 0);
+
+public:
+	// Points the callback at this messenger, which has to outlive the instance.
+	void PopulateCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
+
+	// Logs the suppressed counts not reported yet and the totals per message.
+	void LogSummary();
+
+private:
+	struct MessageStats
+	{
+		u64  key                    = 0;// 0 marks a free slot
+		char idName[kMaxIdNameSize] = "";
+
+		u64 total      = 0;
+		u64 suppressed = 0;// Since the last summary
+
+		u64 windowStart  = 0;
+		u32 windowLogged = 0;
+	};
+
+	static VKAPI_ATTR VkBool32 VKAPI_CALL Callback(
+			VkDebugUtilsMessageSeverityFlagBitsEXT      messageSeverity,
+			VkDebugUtilsMessageTypeFlagsEXT             messageType,
+			const VkDebugUtilsMessengerCallbackDataEXT *pCallbackData,
+			void                                       *pUserData
+	);
+
+	// Counts the message, true when it is within its rate limit.
+	bool Track(const VkDebugUtilsMessengerCallbackDataEXT &data, u64 now);
+
+	MessageStats &FindStats(u64 key, const char *idName);
+
+	void LogSuppressed(u64 now);
+
+private:
+	std::mutex mMutex;
+
+	MessageStats mMessages[kMaxTrackedMessages];
+	u32          mTrackedCount = 0;
+	MessageStats mOverflow;// Every key that did not fit
+
+	u64 mLastSummary = 0;
+};
+
+#endif// HEADER_VALIDATION_H
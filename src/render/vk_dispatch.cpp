@@ -0,0 +1,61 @@
+#include "vk_dispatch.h"
+
+#include "utils/logger.h"
+
+#include <cstdlib>
+
+bool VulkanDispatch::LoadInstance(VkInstance instance)
+{
+	bool loaded = true;
+
+#define COV_VK_LOAD_FUNCTION(name)                                                                 \
+	name = PFN_##name(vkGetInstanceProcAddr(instance, #name));                                     \
+	if (name == nullptr)                                                                           \
+	{                                                                                              \
+		CLOG_ERR("Failed to load " #name ".");                                                     \
+		loaded = false;                                                                            \
+	}
+	COV_VK_INSTANCE_FUNCTIONS(COV_VK_LOAD_FUNCTION)
+#undef COV_VK_LOAD_FUNCTION
+
+#define COV_VK_LOAD_OPTIONAL_FUNCTION(name)                                                        \
+	name = PFN_##name(vkGetInstanceProcAddr(instance, #name));
+	COV_VK_INSTANCE_EXTENSION_FUNCTIONS(COV_VK_LOAD_OPTIONAL_FUNCTION)
+#undef COV_VK_LOAD_OPTIONAL_FUNCTION
+
+	return loaded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+bool VulkanDispatch::LoadDevice(VkDevice device)
+{
+	COV_ASSERT(vkGetDeviceProcAddr != nullptr, "LoadDevice before LoadInstance.");
+
+	bool loaded = true;
+
+	// Through the driver's vkGetDeviceProcAddr, so even the lookup skips the loader.
+#define COV_VK_LOAD_FUNCTION(name)                                                                 \
+	name = PFN_##name(vkGetDeviceProcAddr(device, #name));                                         \
+	if (name == nullptr)                                                                           \
+	{                                                                                              \
+		CLOG_ERR("Failed to load " #name ".");                                                     \
+		loaded = false;                                                                            \
+	}
+	COV_VK_DEVICE_FUNCTIONS(COV_VK_LOAD_FUNCTION)
+#undef COV_VK_LOAD_FUNCTION
+
+#define COV_VK_LOAD_OPTIONAL_FUNCTION(name) name = PFN_##name(vkGetDeviceProcAddr(device, #name));
+	COV_VK_DEVICE_EXTENSION_FUNCTIONS(COV_VK_LOAD_OPTIONAL_FUNCTION)
+#undef COV_VK_LOAD_OPTIONAL_FUNCTION
+
+	return loaded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void VulkanDispatch::Reset()
+{
+#define COV_VK_RESET_FUNCTION(name) name = nullptr;
+	COV_VK_INSTANCE_FUNCTIONS(COV_VK_RESET_FUNCTION)
+	COV_VK_INSTANCE_EXTENSION_FUNCTIONS(COV_VK_RESET_FUNCTION)
+	COV_VK_DEVICE_FUNCTIONS(COV_VK_RESET_FUNCTION)
+	COV_VK_DEVICE_EXTENSION_FUNCTIONS(COV_VK_RESET_FUNCTION)
+#undef COV_VK_RESET_FUNCTION
+}
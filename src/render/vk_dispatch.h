@@ -0,0 +1,81 @@
+#ifndef HEADER_VK_DISPATCH_H
+#define HEADER_VK_DISPATCH_H
+
+#include "definitions.h"
+#include "vulkan/vulkan_core.h"
+
+/* Vulkan entry points queried from the driver instead of the loader's exported symbols.
+ *
+ * Exported device functions are trampolines: the loader looks up the dispatch table of the
+ * handle and jumps to the driver. Pointers from vkGetDeviceProcAddr go straight to the driver
+ * (or the first enabled layer), which matters for the calls made per draw and per frame. The
+ * tables below are expanded into static members of VulkanDispatch, adding a function is adding
+ * it to a list. Creation and destruction of objects stays on the exported symbols.
+ *
+ * One instance and one device at a time. */
+
+// Core instance functions, loading fails when one is missing.
+#define COV_VK_INSTANCE_FUNCTIONS(X) X(vkGetDeviceProcAddr)
+
+// Instance functions of optional extensions, left null when not available.
+#define COV_VK_INSTANCE_EXTENSION_FUNCTIONS(X)                                                     \
+	X(vkCreateDebugUtilsMessengerEXT)                                                              \
+	X(vkDestroyDebugUtilsMessengerEXT)                                                             \
+	X(vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)
+
+// Device functions on the frame path, all of them required.
+#define COV_VK_DEVICE_FUNCTIONS(X)                                                                 \
+	X(vkAcquireNextImageKHR)                                                                       \
+	X(vkBeginCommandBuffer)                                                                        \
+	X(vkCmdBeginRenderPass)                                                                        \
+	X(vkCmdBindDescriptorSets)                                                                     \
+	X(vkCmdBindIndexBuffer)                                                                        \
+	X(vkCmdBindPipeline)                                                                           \
+	X(vkCmdBindVertexBuffers)                                                                      \
+	X(vkCmdClearAttachments)                                                                       \
+	X(vkCmdCopyImage)                                                                              \
+	X(vkCmdDispatch)                                                                               \
+	X(vkCmdDraw)                                                                                   \
+	X(vkCmdDrawIndexed)                                                                            \
+	X(vkCmdDrawIndexedIndirect)                                                                    \
+	X(vkCmdEndRenderPass)                                                                          \
+	X(vkCmdFillBuffer)                                                                             \
+	X(vkCmdPipelineBarrier2KHR)                                                                    \
+	X(vkCmdPushConstants)                                                                          \
+	X(vkCmdResetQueryPool)                                                                         \
+	X(vkCmdSetScissor)                                                                             \
+	X(vkCmdSetViewport)                                                                            \
+	X(vkCmdWriteTimestamp)                                                                         \
+	X(vkEndCommandBuffer)                                                                          \
+	X(vkGetQueryPoolResults)                                                                       \
+	X(vkQueuePresentKHR)                                                                           \
+	X(vkQueueSubmit)                                                                               \
+	X(vkResetCommandBuffer)                                                                        \
+	X(vkResetFences)                                                                               \
+	X(vkWaitForFences)
+
+// Device functions of optional extensions, left null when the extension is not enabled.
+#define COV_VK_DEVICE_EXTENSION_FUNCTIONS(X) X(vkGetCalibratedTimestampsEXT)
+
+class VulkanDispatch
+{
+public:
+#define COV_VK_DECLARE_FUNCTION(name) static inline PFN_##name name = nullptr;
+	COV_VK_INSTANCE_FUNCTIONS(COV_VK_DECLARE_FUNCTION)
+	COV_VK_INSTANCE_EXTENSION_FUNCTIONS(COV_VK_DECLARE_FUNCTION)
+	COV_VK_DEVICE_FUNCTIONS(COV_VK_DECLARE_FUNCTION)
+	COV_VK_DEVICE_EXTENSION_FUNCTIONS(COV_VK_DECLARE_FUNCTION)
+#undef COV_VK_DECLARE_FUNCTION
+
+public:
+	// Right after the instance is created.
+	static bool LoadInstance(VkInstance instance);
+
+	// Right after the device is created, needs LoadInstance().
+	static bool LoadDevice(VkDevice device);
+
+	// Nulls every pointer, call when the instance is destroyed.
+	static void Reset();
+};
+
+#endif// HEADER_VK_DISPATCH_H
@@ -0,0 +1,155 @@
+#include "vk_utils.h"
+
+#include "render/host_allocator.h"
+#include "utils/logger.h"
+
+#include <cstdlib>
+
+std::optional<u32> FindMemoryType(
+		VkPhysicalDevice      physicalDevice,
+		u32                   typeBits,
+		VkMemoryPropertyFlags properties
+)
+{
+	VkPhysicalDeviceMemoryProperties memoryProperties = {};
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+	for (u32 i = 0; i < memoryProperties.memoryTypeCount; ++i)
+	{
+		if ((typeBits & (1u << i))
+			&& (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+		{
+			return i;
+		}
+	}
+
+	return std::nullopt;
+}
+
+std::optional<VkFormat> FindDepthFormat(
+		VkPhysicalDevice     physicalDevice,
+		VkFormatFeatureFlags features
+)
+{
+	const VkFormat candidates[] = {
+			VK_FORMAT_D32_SFLOAT,
+			VK_FORMAT_D32_SFLOAT_S8_UINT,
+			VK_FORMAT_D24_UNORM_S8_UINT,
+			VK_FORMAT_D16_UNORM,
+	};
+
+	for (VkFormat format : candidates)
+	{
+		VkFormatProperties properties = {};
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+
+		if ((properties.optimalTilingFeatures & features) == features)
+		{
+			return format;
+		}
+	}
+
+	return std::nullopt;
+}
+
+VkImageAspectFlags GetDepthFormatAspect(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+	default: return VK_IMAGE_ASPECT_DEPTH_BIT;
+	}
+}
+
+std::optional<VkImageView> CreateImageView(
+		VkDevice           device,
+		VkImage            image,
+		VkFormat           format,
+		VkImageAspectFlags aspect
+)
+{
+	VkImageViewCreateInfo createInfo = {};
+
+	createInfo.sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	createInfo.image    = image;
+	createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	createInfo.format   = format;
+
+	createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+	createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+	createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+	createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+
+	createInfo.subresourceRange.aspectMask     = aspect;
+	createInfo.subresourceRange.baseMipLevel   = 0;
+	createInfo.subresourceRange.levelCount     = 1;
+	createInfo.subresourceRange.baseArrayLayer = 0;
+	createInfo.subresourceRange.layerCount     = 1;
+
+	const VkAllocationCallbacks *allocator = HostAllocator::GetCallbacks();
+
+	VkImageView imageView;
+	if (vkCreateImageView(device, &createInfo, allocator, &imageView) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create image view.");
+		return std::nullopt;
+	}
+
+	return imageView;
+}
+
+bool CreateBuffer(
+		VkDevice              device,
+		VkPhysicalDevice      physicalDevice,
+		VkDeviceSize          size,
+		VkBufferUsageFlags    usage,
+		VkMemoryPropertyFlags properties,
+		VkBuffer             &buffer,
+		VkDeviceMemory       &memory
+)
+{
+	VkBufferCreateInfo bufferInfo = {};
+
+	bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size        = size;
+	bufferInfo.usage       = usage;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	const VkAllocationCallbacks *allocator = HostAllocator::GetCallbacks();
+	if (vkCreateBuffer(device, &bufferInfo, allocator, &buffer) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to create buffer.");
+		return EXIT_FAILURE;
+	}
+
+	VkMemoryRequirements requirements = {};
+	vkGetBufferMemoryRequirements(device, buffer, &requirements);
+
+	std::optional<u32> memoryType =
+			FindMemoryType(physicalDevice, requirements.memoryTypeBits, properties);
+	if (!memoryType.has_value())
+	{
+		CLOG_ERR("No memory type for buffer.");
+		vkDestroyBuffer(device, buffer, allocator);
+		return EXIT_FAILURE;
+	}
+
+	VkMemoryAllocateInfo allocInfo = {};
+
+	allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize  = requirements.size;
+	allocInfo.memoryTypeIndex = memoryType.value();
+
+	if (vkAllocateMemory(device, &allocInfo, allocator, &memory) != VK_SUCCESS)
+	{
+		CLOG_ERR("Failed to allocate buffer memory.");
+		vkDestroyBuffer(device, buffer, allocator);
+		return EXIT_FAILURE;
+	}
+
+	vkBindBufferMemory(device, buffer, memory, 0);
+	return EXIT_SUCCESS;
+}
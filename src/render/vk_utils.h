@@ -0,0 +1,43 @@
+#ifndef HEADER_VK_UTILS_H
+#define HEADER_VK_UTILS_H
+
+#include "definitions.h"
+#include "vulkan/vulkan_core.h"
+
+#include <optional>
+
+std::optional<u32> FindMemoryType(
+		VkPhysicalDevice      physicalDevice,
+		u32                   typeBits,
+		VkMemoryPropertyFlags properties
+);
+
+/* First depth format whose optimal tiling supports features, preferring 32-bit float. The default
+ * asks for a depth attachment only, shadow maps also need sampling. */
+std::optional<VkFormat> FindDepthFormat(
+		VkPhysicalDevice     physicalDevice,
+		VkFormatFeatureFlags features = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+);
+
+// Depth aspect, plus stencil for combined formats. Barriers on those need both.
+VkImageAspectFlags GetDepthFormatAspect(VkFormat format);
+
+std::optional<VkImageView> CreateImageView(
+		VkDevice           device,
+		VkImage            image,
+		VkFormat           format,
+		VkImageAspectFlags aspect
+);
+
+// Creates a buffer with its own dedicated allocation, bound at offset 0.
+bool CreateBuffer(
+		VkDevice              device,
+		VkPhysicalDevice      physicalDevice,
+		VkDeviceSize          size,
+		VkBufferUsageFlags    usage,
+		VkMemoryPropertyFlags properties,
+		VkBuffer             &buffer,
+		VkDeviceMemory       &memory
+);
+
+#endif// HEADER_VK_UTILS_H
@@ -0,0 +1,254 @@
+#include "ecs.h"
+
+#include <atomic>
+#include <cstring>
+#include <new>
+
+// Chunks are cache line aligned so columns can start on a line boundary.
+constexpr std::align_val_t kChunkAlignment{64};
+
+static ComponentInfo    sComponentInfos[kMaxComponents];
+static std::atomic<u32> sComponentCount{0};
+
+
+/**************************************
+*       COMPONENT REGISTRY
+**************************************/
+
+ComponentId ComponentRegistry::Register(u32 size, u32 alignment)
+{
+	const ComponentId id = sComponentCount.fetch_add(1, std::memory_order_relaxed);
+	COV_ASSERT(id < kMaxComponents, "Too many component types.");
+
+	sComponentInfos[id].size      = size;
+	sComponentInfos[id].alignment = alignment;
+	return id;
+}
+
+const ComponentInfo &ComponentRegistry::GetInfo(ComponentId id)
+{
+	return sComponentInfos[id];
+}
+
+
+/**************************************
+*       ARCHETYPE
+**************************************/
+
+static u32 AlignUp(u32 value, u32 alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+Archetype::Archetype(ComponentMask mask)
+	: mMask(mask)
+{
+	u32 rowSize = (u32)sizeof(Entity);
+	for (ComponentId id = 0; id < kMaxComponents; ++id)
+	{
+		if ((mask >> id) & 1)
+		{
+			mComponents.push_back(id);
+			rowSize += ComponentRegistry::GetInfo(id).size;
+		}
+	}
+
+	// Start from the unpadded estimate and shrink until the aligned columns fit the chunk.
+	for (mCapacity = kChunkSize / rowSize; mCapacity > 0; --mCapacity)
+	{
+		u32 offset = (u32)sizeof(Entity) * mCapacity;
+		for (ComponentId id : mComponents)
+		{
+			const ComponentInfo &info = ComponentRegistry::GetInfo(id);
+			offset                    = AlignUp(offset, info.alignment);
+			mColumnOffsets[id]        = offset;
+			offset                   += info.size * mCapacity;
+		}
+
+		if (offset <= kChunkSize)
+		{
+			break;
+		}
+	}
+
+	COV_ASSERT(mCapacity > 0, "Archetype row does not fit in a chunk.");
+}
+
+Archetype::~Archetype()
+{
+	for (Chunk &chunk : mChunks)
+	{
+		::operator delete(chunk.data, kChunkAlignment);
+	}
+}
+
+void *Archetype::GetComponent(u32 row, ComponentId id) const
+{
+	const Chunk &chunk = mChunks[row / mCapacity];
+	return chunk.data + mColumnOffsets[id] + (row % mCapacity) * ComponentRegistry::GetInfo(id).size;
+}
+
+u32 Archetype::AllocateRow(Entity entity)
+{
+	if (mChunks.empty() || mChunks.back().count == mCapacity)
+	{
+		Chunk chunk = {};
+		chunk.data  = static_cast<u8 *>(::operator new(kChunkSize, kChunkAlignment));
+		mChunks.push_back(chunk);
+	}
+
+	Chunk &chunk = mChunks.back();
+	reinterpret_cast<Entity *>(chunk.data)[chunk.count] = entity;
+	++chunk.count;
+
+	return mEntityCount++;
+}
+
+Entity Archetype::RemoveRow(u32 row)
+{
+	const u32 lastRow = mEntityCount - 1;
+	Entity    moved   = kInvalidEntity;
+
+	if (row != lastRow)
+	{
+		Chunk       &dstChunk = mChunks[row / mCapacity];
+		const Chunk &srcChunk = mChunks[lastRow / mCapacity];
+		const u32    dstIndex = row % mCapacity;
+		const u32    srcIndex = lastRow % mCapacity;
+
+		Entity *dstEntities   = reinterpret_cast<Entity *>(dstChunk.data);
+		Entity *srcEntities   = reinterpret_cast<Entity *>(srcChunk.data);
+		dstEntities[dstIndex] = srcEntities[srcIndex];
+		moved                 = srcEntities[srcIndex];
+
+		for (ComponentId id : mComponents)
+		{
+			const u32 size = ComponentRegistry::GetInfo(id).size;
+			memcpy(dstChunk.data + mColumnOffsets[id] + dstIndex * size,
+				   srcChunk.data + mColumnOffsets[id] + srcIndex * size,
+				   size);
+		}
+	}
+
+	Chunk &lastChunk = mChunks.back();
+	if (--lastChunk.count == 0)
+	{
+		::operator delete(lastChunk.data, kChunkAlignment);
+		mChunks.pop_back();
+	}
+
+	--mEntityCount;
+	return moved;
+}
+
+void Archetype::CopyRow(const Archetype &from, u32 fromRow, Archetype &to, u32 toRow)
+{
+	for (ComponentId id : from.mComponents)
+	{
+		if (to.Has(id))
+		{
+			memcpy(to.GetComponent(toRow, id),
+				   from.GetComponent(fromRow, id),
+				   ComponentRegistry::GetInfo(id).size);
+		}
+	}
+}
+
+
+/**************************************
+*       WORLD
+**************************************/
+
+Archetype &EcsWorld::GetOrCreateArchetype(ComponentMask mask)
+{
+	auto it = mArchetypeLookup.find(mask);
+	if (it != mArchetypeLookup.end())
+	{
+		return *it->second;
+	}
+
+	mArchetypes.push_back(std::make_unique<Archetype>(mask));
+	Archetype *archetype = mArchetypes.back().get();
+	mArchetypeLookup.emplace(mask, archetype);
+
+	return *archetype;
+}
+
+Entity EcsWorld::AllocateEntity()
+{
+	Entity entity = {};
+
+	if (!mFreeIndices.empty())
+	{
+		entity.index = mFreeIndices.back();
+		mFreeIndices.pop_back();
+	}
+	else
+	{
+		entity.index = (u32)mRecords.size();
+		mRecords.emplace_back();
+	}
+
+	entity.generation = mRecords[entity.index].generation;
+	++mAliveCount;
+
+	return entity;
+}
+
+bool EcsWorld::IsAlive(Entity entity) const
+{
+	return entity.index < mRecords.size() && mRecords[entity.index].archetype != nullptr
+		&& mRecords[entity.index].generation == entity.generation;
+}
+
+void EcsWorld::RemoveFromArchetype(EntityRecord &record)
+{
+	const Entity moved = record.archetype->RemoveRow(record.row);
+	if (moved != kInvalidEntity)
+	{
+		mRecords[moved.index].row = record.row;
+	}
+}
+
+void EcsWorld::DestroyEntity(Entity entity)
+{
+	if (!IsAlive(entity))
+	{
+		return;
+	}
+
+	EntityRecord &record = mRecords[entity.index];
+	RemoveFromArchetype(record);
+
+	record.archetype = nullptr;
+	++record.generation;
+
+	mFreeIndices.push_back(entity.index);
+	--mAliveCount;
+}
+
+void EcsWorld::MoveEntity(Entity entity, Archetype &target)
+{
+	EntityRecord &record = mRecords[entity.index];
+	const u32     newRow = target.AllocateRow(entity);
+
+	Archetype::CopyRow(*record.archetype, record.row, target, newRow);
+	RemoveFromArchetype(record);
+
+	record.archetype = &target;
+	record.row       = newRow;
+}
+
+u32 EcsWorld::CountEntities(ComponentMask mask) const
+{
+	u32 count = 0;
+	for (const std::unique_ptr<Archetype> &archetype : mArchetypes)
+	{
+		if ((archetype->GetMask() & mask) == mask)
+		{
+			count += archetype->GetEntityCount();
+		}
+	}
+
+	return count;
+}
@@ -0,0 +1,410 @@
+#ifndef HEADER_ECS_H
+#define HEADER_ECS_H
+
+#include "core/arena.h"
+#include "core/job_system.h"
+#include "definitions.h"
+#include "utils/logger.h"
+
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/* Archetype based entity-component storage.
+ *
+ * Every distinct set of components is an archetype. Its entities live in 16 KB chunks, each
+ * chunk holding one contiguous column per component (plus one for the entity handles), so a
+ * query walks matching chunks linearly instead of chasing per-entity pointers. Chunks of an
+ * archetype are kept dense: all of them are full except the last one.
+ *
+ * Components are plain data (trivially copyable), moving an entity between archetypes or rows is
+ * a memcpy per column. */
+
+using ComponentId   = u32;
+using ComponentMask = u64;
+
+constexpr u32 kMaxComponents = 64;
+constexpr u32 kChunkSize     = 16 * 1024;
+
+struct Entity
+{
+	u32 index      = ~0u;
+	u32 generation = 0;
+
+	bool operator==(const Entity &other) const
+	{
+		return index == other.index && generation == other.generation;
+	}
+
+	bool operator!=(const Entity &other) const
+	{
+		return !(*this == other);
+	}
+};
+
+constexpr Entity kInvalidEntity = {};
+
+struct ComponentInfo
+{
+	u32 size      = 0;
+	u32 alignment = 0;
+};
+
+class ComponentRegistry
+{
+public:
+	template<typename T>
+	static ComponentId GetId()
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Components must be trivially copyable.");
+
+		static const ComponentId id = Register((u32)sizeof(T), (u32)alignof(T));
+		return id;
+	}
+
+	template<typename... Ts>
+	static ComponentMask GetMask()
+	{
+		return (ComponentMask(0) | ... | (ComponentMask(1) << GetId<Ts>()));
+	}
+
+	static const ComponentInfo &GetInfo(ComponentId id);
+
+private:
+	static ComponentId Register(u32 size, u32 alignment);
+};
+
+class Archetype
+{
+public:
+	struct Chunk
+	{
+		u8 *data  = nullptr;
+		u32 count = 0;
+	};
+
+public:
+	explicit Archetype(ComponentMask mask);
+
+	Archetype(const Archetype &) = delete;
+
+	Archetype &operator=(const Archetype &) = delete;
+
+	~Archetype();
+
+	[[nodiscard]] ComponentMask GetMask() const
+	{
+		return mMask;
+	}
+
+	[[nodiscard]] bool Has(ComponentId id) const
+	{
+		return (mMask >> id) & 1;
+	}
+
+	[[nodiscard]] u32 GetEntityCount() const
+	{
+		return mEntityCount;
+	}
+
+	[[nodiscard]] u32 GetChunkCapacity() const
+	{
+		return mCapacity;
+	}
+
+	[[nodiscard]] u32 GetChunkCount() const
+	{
+		return (u32)mChunks.size();
+	}
+
+	[[nodiscard]] const Chunk &GetChunk(u32 chunkIndex) const
+	{
+		return mChunks[chunkIndex];
+	}
+
+	[[nodiscard]] void *GetColumn(u32 chunkIndex, ComponentId id) const
+	{
+		return mChunks[chunkIndex].data + mColumnOffsets[id];
+	}
+
+	[[nodiscard]] Entity *GetEntities(u32 chunkIndex) const
+	{
+		return reinterpret_cast<Entity *>(mChunks[chunkIndex].data);
+	}
+
+	[[nodiscard]] void *GetComponent(u32 row, ComponentId id) const;
+
+	// Appends an uninitialized row and returns its index.
+	u32 AllocateRow(Entity entity);
+
+	/* Fills the hole at row with the last row. Returns the entity that moved into row, or
+	 * kInvalidEntity when the removed row was the last one. */
+	Entity RemoveRow(u32 row);
+
+	// Copies every component both archetypes share from one row to another.
+	static void CopyRow(const Archetype &from, u32 fromRow, Archetype &to, u32 toRow);
+
+private:
+	ComponentMask            mMask = 0;
+	std::vector<ComponentId> mComponents;
+	u32                      mColumnOffsets[kMaxComponents] = {};
+	u32                      mCapacity                      = 0;
+	u32                      mEntityCount                   = 0;
+	std::vector<Chunk>       mChunks;
+};
+
+// Typed access to one chunk inside a query callback.
+class ChunkView
+{
+public:
+	ChunkView(const Archetype &archetype, u32 chunkIndex)
+		: mArchetype(archetype)
+		, mChunkIndex(chunkIndex)
+	{
+	}
+
+	[[nodiscard]] u32 Count() const
+	{
+		return mArchetype.GetChunk(mChunkIndex).count;
+	}
+
+	[[nodiscard]] const Entity *GetEntities() const
+	{
+		return mArchetype.GetEntities(mChunkIndex);
+	}
+
+	template<typename T>
+	[[nodiscard]] T *Get() const
+	{
+		return static_cast<T *>(mArchetype.GetColumn(mChunkIndex, ComponentRegistry::GetId<T>()));
+	}
+
+private:
+	const Archetype &mArchetype;
+	u32              mChunkIndex;
+};
+
+class EcsWorld
+{
+public:
+	// Chunk of a matching archetype, as handed out by GatherChunks.
+	struct ChunkRef
+	{
+		const Archetype *archetype;
+		u32              chunkIndex;
+		u32              firstEntity;// Running entity count of all chunks gathered before
+	};
+
+public:
+	template<typename... Ts>
+	Entity CreateEntity(const Ts &...components);
+
+	void DestroyEntity(Entity entity);
+
+	[[nodiscard]] bool IsAlive(Entity entity) const;
+
+	template<typename T>
+	void AddComponent(Entity entity, const T &component);
+
+	template<typename T>
+	void RemoveComponent(Entity entity);
+
+	template<typename T>
+	[[nodiscard]] T *GetComponent(Entity entity) const;
+
+	[[nodiscard]] u32 GetEntityCount() const
+	{
+		return mAliveCount;
+	}
+
+	// func(ChunkView &) for every chunk having at least all of Ts.
+	template<typename... Ts, typename Func>
+	void ForEachChunk(Func &&func) const;
+
+	// func(Entity, Ts &...) for every entity having at least all of Ts.
+	template<typename... Ts, typename Func>
+	void ForEach(Func &&func) const;
+
+	// Like ForEachChunk, with chunks spread over the job system. func has to be thread safe.
+	template<typename... Ts, typename Func>
+	void ParallelForEachChunk(JobSystem &jobSystem, Func &func) const;
+
+	// Every matching chunk with its entity offset, in iteration order.
+	template<typename Allocator>
+	void GatherChunks(ComponentMask mask, std::vector<ChunkRef, Allocator> &chunks) const;
+
+	[[nodiscard]] u32 CountEntities(ComponentMask mask) const;
+
+private:
+	struct EntityRecord
+	{
+		Archetype *archetype  = nullptr;
+		u32        row        = 0;
+		u32        generation = 0;
+	};
+
+	Archetype &GetOrCreateArchetype(ComponentMask mask);
+
+	Entity AllocateEntity();
+
+	// Moves the entity into the archetype, keeping the components both archetypes have.
+	void MoveEntity(Entity entity, Archetype &target);
+
+	void RemoveFromArchetype(EntityRecord &record);
+
+private:
+	std::vector<std::unique_ptr<Archetype>>        mArchetypes;
+	std::unordered_map<ComponentMask, Archetype *> mArchetypeLookup;
+
+	std::vector<EntityRecord> mRecords;
+	std::vector<u32>          mFreeIndices;
+	u32                       mAliveCount = 0;
+};
+
+template<typename... Ts>
+Entity EcsWorld::CreateEntity(const Ts &...components)
+{
+	const Entity entity    = AllocateEntity();
+	Archetype   &archetype = GetOrCreateArchetype(ComponentRegistry::GetMask<Ts...>());
+
+	EntityRecord &record = mRecords[entity.index];
+	record.archetype     = &archetype;
+	record.row           = archetype.AllocateRow(entity);
+
+	(..., (*static_cast<Ts *>(archetype.GetComponent(record.row, ComponentRegistry::GetId<Ts>()))
+		   = components));
+
+	return entity;
+}
+
+template<typename T>
+void EcsWorld::AddComponent(Entity entity, const T &component)
+{
+	COV_ASSERT(IsAlive(entity), "AddComponent on a dead entity.");
+
+	const ComponentId id     = ComponentRegistry::GetId<T>();
+	EntityRecord     &record = mRecords[entity.index];
+
+	if (!record.archetype->Has(id))
+	{
+		const ComponentMask mask = record.archetype->GetMask() | (ComponentMask(1) << id);
+		MoveEntity(entity, GetOrCreateArchetype(mask));
+	}
+
+	*static_cast<T *>(record.archetype->GetComponent(record.row, id)) = component;
+}
+
+template<typename T>
+void EcsWorld::RemoveComponent(Entity entity)
+{
+	COV_ASSERT(IsAlive(entity), "RemoveComponent on a dead entity.");
+
+	const ComponentId id     = ComponentRegistry::GetId<T>();
+	EntityRecord     &record = mRecords[entity.index];
+
+	if (record.archetype->Has(id))
+	{
+		const ComponentMask mask = record.archetype->GetMask() & ~(ComponentMask(1) << id);
+		MoveEntity(entity, GetOrCreateArchetype(mask));
+	}
+}
+
+template<typename T>
+T *EcsWorld::GetComponent(Entity entity) const
+{
+	if (!IsAlive(entity))
+	{
+		return nullptr;
+	}
+
+	const ComponentId   id     = ComponentRegistry::GetId<T>();
+	const EntityRecord &record = mRecords[entity.index];
+
+	if (!record.archetype->Has(id))
+	{
+		return nullptr;
+	}
+
+	return static_cast<T *>(record.archetype->GetComponent(record.row, id));
+}
+
+template<typename... Ts, typename Func>
+void EcsWorld::ForEachChunk(Func &&func) const
+{
+	const ComponentMask mask = ComponentRegistry::GetMask<Ts...>();
+
+	for (const std::unique_ptr<Archetype> &archetype : mArchetypes)
+	{
+		if ((archetype->GetMask() & mask) != mask)
+		{
+			continue;
+		}
+
+		for (u32 chunkIndex = 0; chunkIndex < archetype->GetChunkCount(); ++chunkIndex)
+		{
+			ChunkView view(*archetype, chunkIndex);
+			func(view);
+		}
+	}
+}
+
+template<typename... Ts, typename Func>
+void EcsWorld::ForEach(Func &&func) const
+{
+	ForEachChunk<Ts...>(
+			[&func](ChunkView &view)
+			{
+				const Entity *entities = view.GetEntities();
+				const auto    columns  = std::make_tuple(view.Get<Ts>()...);
+
+				for (u32 i = 0; i < view.Count(); ++i)
+				{
+					func(entities[i], std::get<Ts *>(columns)[i]...);
+				}
+			}
+	);
+}
+
+template<typename... Ts, typename Func>
+void EcsWorld::ParallelForEachChunk(JobSystem &jobSystem, Func &func) const
+{
+	// Only lives until ParallelFor returns, so the chunk list goes to scratch memory.
+	ScratchScope          scratch;
+	ArenaVector<ChunkRef> chunks;
+	GatherChunks(ComponentRegistry::GetMask<Ts...>(), chunks);
+
+	auto processChunks = [&chunks, &func](u32 begin, u32 end)
+	{
+		for (u32 i = begin; i < end; ++i)
+		{
+			ChunkView view(*chunks[i].archetype, chunks[i].chunkIndex);
+			func(view);
+		}
+	};
+	jobSystem.ParallelFor((u32)chunks.size(), 4, processChunks);
+}
+
+template<typename Allocator>
+void EcsWorld::GatherChunks(ComponentMask mask, std::vector<ChunkRef, Allocator> &chunks) const
+{
+	chunks.clear();
+
+	u32 firstEntity = 0;
+	for (const std::unique_ptr<Archetype> &archetype : mArchetypes)
+	{
+		if ((archetype->GetMask() & mask) != mask)
+		{
+			continue;
+		}
+
+		for (u32 chunkIndex = 0; chunkIndex < archetype->GetChunkCount(); ++chunkIndex)
+		{
+			chunks.push_back({archetype.get(), chunkIndex, firstEntity});
+			firstEntity += archetype->GetChunk(chunkIndex).count;
+		}
+	}
+}
+
+#endif// HEADER_ECS_H
@@ -0,0 +1,288 @@
+#include "simulation.h"
+
+#include "render/render_extract.h"
+#include "scene/ecs.h"
+#include "utils/logger.h"
+#include "utils/trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+// Bodies oscillate around their spawn position, integrated with symplectic Euler.
+constexpr f32 kSpringFrequency = 0.5f;
+constexpr f32 kSpringStiffness = (2.0f * 3.14159265f * kSpringFrequency)
+								 * (2.0f * 3.14159265f * kSpringFrequency);
+
+// Damping ratio 0.15, the swing of the default scene dies out within about 15 seconds.
+constexpr f32 kSpringDamping = 2.0f * 0.15f * (2.0f * 3.14159265f * kSpringFrequency);
+
+/* A body this close to its spawn position and this slow is put to rest on it. The damped swing
+ * only decays exponentially, without this the bodies would never stop moving. */
+constexpr f32 kRestDistance = 1e-4f;
+constexpr f32 kRestSpeed    = 1e-3f;
+
+static u64 GetSteadyTimeNs()
+{
+	return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+				   std::chrono::steady_clock::now().time_since_epoch()
+	)
+			.count();
+}
+
+Simulation::~Simulation()
+{
+	Stop();
+}
+
+u32 Simulation::AddBody(const glm::vec3 &position, const glm::vec3 &velocity)
+{
+	COV_ASSERT(!IsRunning(), "Bodies can not be added while the simulation runs.");
+
+	mHomePositions.push_back(position);
+	mPositions.push_back(position);
+	mPreviousPositions.push_back(position);
+	mVelocities.push_back(velocity);
+
+	return (u32)mPositions.size() - 1;
+}
+
+void Simulation::SetTickRate(f64 tickRate)
+{
+	COV_ASSERT(!IsRunning(), "Tick rate can not change while the simulation runs.");
+	mTickRate = tickRate;
+}
+
+void Simulation::SetManualClock(bool manual)
+{
+	COV_ASSERT(!IsRunning(), "The clock can not change while the simulation runs.");
+	mManualClock = manual;
+}
+
+bool Simulation::Start()
+{
+	if (IsRunning())
+	{
+		CLOG_WARN("Simulation is already running.");
+		return EXIT_SUCCESS;
+	}
+
+	if (mTickRate <= 0.0)
+	{
+		CLOG_ERR("Invalid simulation tick rate ", mTickRate, ".");
+		return EXIT_FAILURE;
+	}
+
+	CLOG_INFO("Starting simulation at ", mTickRate, " Hz with ", mPositions.size(), " bodies.");
+
+	mStopRequested.store(false, std::memory_order_relaxed);
+	mStartTimeNs  = GetSteadyTimeNs();
+	mManualTime   = 0.0;
+	mPreviousTime = 0.0;
+	mAccumulator  = 0.0;
+
+	if (!mManualClock)
+	{
+		mThread = std::thread(&Simulation::ThreadLoop, this);
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void Simulation::Stop()
+{
+	if (!IsRunning())
+	{
+		return;
+	}
+
+	mStopRequested.store(true, std::memory_order_relaxed);
+	mThread.join();
+}
+
+f64 Simulation::GetTime() const
+{
+	if (mManualClock)
+	{
+		return mManualTime;
+	}
+
+	return (f64)(GetSteadyTimeNs() - mStartTimeNs) * 1e-9;
+}
+
+void Simulation::Advance(f64 seconds)
+{
+	COV_ASSERT(mManualClock, "Only a manual clock can be advanced.");
+
+	mManualTime += seconds;
+	Update();
+}
+
+void Simulation::ThreadLoop()
+{
+	Trace::SetThreadName("Simulation");
+
+	mPreviousTime = GetTime();
+
+	while (!mStopRequested.load(std::memory_order_relaxed))
+	{
+		const f64 untilNextStep = Update();
+		std::this_thread::sleep_for(std::chrono::duration<f64>(untilNextStep));
+	}
+}
+
+f64 Simulation::Update()
+{
+	const f64 dt = 1.0 / mTickRate;
+
+	const f64 now  = GetTime();
+	mAccumulator  += now - mPreviousTime;
+	mPreviousTime  = now;
+
+	u32  steps = 0;
+	bool moved = false;
+	while (mAccumulator >= dt && steps < kMaxStepsPerUpdate)
+	{
+		COV_TRACE_SCOPE("SimulationStep");
+
+		const u64 stepStart = GetSteadyTimeNs();
+		moved = Step((f32)dt) || moved;
+		const f64 stepTime = (f64)(GetSteadyTimeNs() - stepStart) * 1e-9;
+
+		mStats.stepTimeTotal += stepTime;
+		mStats.stepTimeMax    = std::max(mStats.stepTimeMax, stepTime);
+
+		mAccumulator -= dt;
+		++steps;
+	}
+
+	if (mAccumulator >= dt)
+	{
+		const f64 kept       = std::fmod(mAccumulator, dt);
+		mStats.droppedTime  += mAccumulator - kept;
+		mAccumulator         = kept;
+	}
+
+	/* The newest state became due `mAccumulator` seconds ago. Once the bodies stop, a single
+	 * still snapshot lets the renderer settle on the final positions and nothing more is
+	 * published until they move again. */
+	if (steps > 0 && (moved || mPublishedMoving || mStats.published == 0))
+	{
+		PublishSnapshot(now - mAccumulator, moved);
+	}
+
+	return dt - mAccumulator;
+}
+
+bool Simulation::Step(f32 dt)
+{
+	mPreviousPositions.swap(mPositions);
+
+	bool moved = false;
+
+	for (u32 i = 0; i < mPositions.size(); ++i)
+	{
+		const glm::vec3 offset       = mPreviousPositions[i] - mHomePositions[i];
+		const glm::vec3 acceleration = -kSpringStiffness * offset - kSpringDamping * mVelocities[i];
+
+		mVelocities[i] += acceleration * dt;
+		mPositions[i]   = mPreviousPositions[i] + mVelocities[i] * dt;
+
+		if (glm::dot(offset, offset) < kRestDistance * kRestDistance
+			&& glm::dot(mVelocities[i], mVelocities[i]) < kRestSpeed * kRestSpeed)
+		{
+			mPositions[i]  = mHomePositions[i];
+			mVelocities[i] = glm::vec3(0.0f);
+		}
+
+		moved = moved || mPositions[i] != mPreviousPositions[i];
+	}
+
+	++mTick;
+	++mStats.ticks;
+
+	return moved;
+}
+
+void Simulation::PublishSnapshot(f64 currentTime, bool moving)
+{
+	// The write slot holds an older snapshot, assigning reuses its capacity.
+	Snapshot &snapshot = mSnapshots.GetWriteBuffer();
+
+	snapshot.tick              = mTick;
+	snapshot.previousTime      = currentTime - 1.0 / mTickRate;
+	snapshot.currentTime       = currentTime;
+	snapshot.previousPositions = mPreviousPositions;
+	snapshot.currentPositions  = mPositions;
+	snapshot.moving            = moving;
+
+	mSnapshots.Publish();
+	mPublishedMoving = moving;
+	++mStats.published;
+}
+
+bool Simulation::Interpolate(EcsWorld &world, JobSystem &jobSystem)
+{
+	if (mSnapshots.Acquire())
+	{
+		++mStats.acquired;
+	}
+
+	const Snapshot &snapshot = mSnapshots.GetReadBuffer();
+	mReadMoving              = snapshot.moving;
+	if (snapshot.tick == 0)
+	{
+		return false;
+	}
+
+	// Rendering one tick behind keeps the render time between the two states as long as the
+	// simulation keeps up, past the newest state the positions are held instead of extrapolated.
+	const f64 tickLength = snapshot.currentTime - snapshot.previousTime;
+	const f64 renderTime = GetTime() - tickLength;
+	const f32 alpha      = (f32)std::clamp((renderTime - snapshot.previousTime) / tickLength, 0.0, 1.0);
+
+	auto interpolateChunk = [&snapshot, alpha](ChunkView &view)
+	{
+		InstanceTransform   *transforms = view.Get<InstanceTransform>();
+		const SimulatedBody *bodies     = view.Get<SimulatedBody>();
+
+		for (u32 i = 0; i < view.Count(); ++i)
+		{
+			const u32 body = bodies[i].index;
+			if (body < snapshot.currentPositions.size())
+			{
+				transforms[i].position = glm::mix(
+						snapshot.previousPositions[body], snapshot.currentPositions[body], alpha
+				);
+			}
+		}
+	};
+	world.ParallelForEachChunk<InstanceTransform, SimulatedBody>(jobSystem, interpolateChunk);
+
+	return true;
+}
+
+void Simulation::LogStats() const
+{
+	if (mStats.ticks == 0)
+	{
+		return;
+	}
+
+	CLOG_INFO(
+			"Simulation stats: ",
+			mStats.ticks,
+			" ticks, step avg ",
+			mStats.stepTimeTotal / (f64)mStats.ticks * 1000.0,
+			" ms max ",
+			mStats.stepTimeMax * 1000.0,
+			" ms, ",
+			mStats.published,
+			" snapshots published, ",
+			mStats.acquired,
+			" acquired, ",
+			mStats.droppedTime * 1000.0,
+			" ms dropped."
+	);
+}
@@ -0,0 +1,151 @@
+#ifndef HEADER_SIMULATION_H
+#define HEADER_SIMULATION_H
+
+#include "core/triple_buffer.h"
+#include "definitions.h"
+#include "pch/glm.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+class EcsWorld;
+class JobSystem;
+
+/* Fixed-timestep simulation running on its own thread.
+ *
+ * The thread accumulates wall clock time and advances the state in steps of exactly 1 / tickRate
+ * seconds, so the result does not depend on how fast (or whether) frames are presented. After
+ * each batch of steps it publishes the last two states through a triple buffer. The renderer
+ * never waits for the simulation: it takes whatever snapshot is newest and interpolates
+ * between its two states, drawing one tick behind real time.
+ *
+ * Snapshots are only published while bodies move, plus one still snapshot once they settle, so
+ * an at rest simulation lets on-demand rendering go idle.
+ *
+ * With a manual clock there is no thread: time only passes through Advance(), which steps and
+ * publishes on the calling thread, so the same calls always produce the same snapshots. */
+
+// Links an entity to the simulation body driving its InstanceTransform position.
+struct SimulatedBody
+{
+	u32 index = 0;
+};
+
+class Simulation
+{
+public:
+	static constexpr f64 kDefaultTickRate = 60.0;
+
+	// Steps done in one go at most, the rest of a longer stall is dropped instead of making the
+	// simulation fall further behind every tick.
+	static constexpr u32 kMaxStepsPerUpdate = 8;
+
+	struct Snapshot
+	{
+		u64 tick = 0;
+
+		// Seconds since Start() at which each state is due, one tick apart.
+		f64 previousTime = 0.0;
+		f64 currentTime  = 0.0;
+
+		std::vector<glm::vec3> previousPositions;
+		std::vector<glm::vec3> currentPositions;
+
+		bool moving = false;// Some body moved during the steps leading to this snapshot
+	};
+
+	struct Stats
+	{
+		u64 ticks         = 0;
+		f64 stepTimeTotal = 0.0;
+		f64 stepTimeMax   = 0.0;
+		f64 droppedTime   = 0.0;// Time skipped because of kMaxStepsPerUpdate
+		u64 published     = 0;
+
+		u64 acquired = 0;// Snapshots picked up by Interpolate(), written by the render thread
+	};
+
+public:
+	Simulation() = default;
+
+	Simulation(const Simulation &) = delete;
+
+	Simulation &operator=(const Simulation &) = delete;
+
+	~Simulation();
+
+	// Bodies can only be added before Start().
+	u32 AddBody(const glm::vec3 &position, const glm::vec3 &velocity);
+
+	void SetTickRate(f64 tickRate);
+
+	// Only before Start(), which then spawns no thread.
+	void SetManualClock(bool manual);
+
+	bool Start();
+
+	void Stop();
+
+	[[nodiscard]] bool IsRunning() const
+	{
+		return mThread.joinable();
+	}
+
+	// Manual clock only. Moves the clock forward by seconds and runs the steps that became due.
+	void Advance(f64 seconds);
+
+	/* Render thread side. Writes interpolated body positions into the InstanceTransform of every
+	 * entity with a SimulatedBody, returns false before the first snapshot arrives. */
+	bool Interpolate(EcsWorld &world, JobSystem &jobSystem);
+
+	/* Render thread side. True while the drawn snapshot is moving or a newer one is waiting, the
+	 * interpolated positions then change from frame to frame. */
+	[[nodiscard]] bool NeedsRedraw() const
+	{
+		return mReadMoving || mSnapshots.HasFresh();
+	}
+
+	void LogStats() const;
+
+private:
+	void ThreadLoop();
+
+	// Runs the steps due since the last call and publishes them, returns the time until the next.
+	f64 Update();
+
+	// Returns whether any body moved.
+	bool Step(f32 dt);
+
+	void PublishSnapshot(f64 currentTime, bool moving);
+
+	// Seconds since Start(), on the clock both threads share.
+	[[nodiscard]] f64 GetTime() const;
+
+private:
+	f64 mTickRate = kDefaultTickRate;
+
+	// Owned by the simulation thread while it runs
+	std::vector<glm::vec3> mHomePositions;
+	std::vector<glm::vec3> mPositions;
+	std::vector<glm::vec3> mPreviousPositions;
+	std::vector<glm::vec3> mVelocities;
+	u64                    mTick            = 0;
+	bool                   mPublishedMoving = false;
+	f64                    mPreviousTime    = 0.0;
+	f64                    mAccumulator     = 0.0;
+	Stats                  mStats;
+
+	TripleBuffer<Snapshot> mSnapshots;
+
+	bool mReadMoving = false;// Owned by the render thread
+
+	std::thread       mThread;
+	std::atomic<bool> mStopRequested{false};
+	u64               mStartTimeNs = 0;
+
+	bool mManualClock = false;
+	f64  mManualTime  = 0.0;// Seconds since Start() with a manual clock
+};
+
+#endif// HEADER_SIMULATION_H
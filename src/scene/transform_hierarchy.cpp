@@ -0,0 +1,614 @@
+#include "transform_hierarchy.h"
+
+#include "core/job_system.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#define TRANSFORM_SSE 1
+#endif
+
+// Depth levels with fewer nodes to update are not worth splitting over the job system.
+constexpr u32 kParallelLevelThreshold = 8192;
+constexpr u32 kParallelBatchSize      = 4096;
+
+constexpr u32 kNoParent = ~0u;
+
+static const glm::mat4 kIdentity(1.0f);
+
+
+/**************************************
+*       MATRIX KERNELS
+**************************************/
+
+using MatrixBatch = TransformHierarchy::MatrixBatch;
+
+// Element (column, row) of a * b for the matrix in lane.
+static void MultiplyLane(const MatrixBatch &a, const MatrixBatch &b, MatrixBatch &out, u32 lane)
+{
+	for (u32 column = 0; column < 4; ++column)
+	{
+		for (u32 row = 0; row < 4; ++row)
+		{
+			f32 result = a.m[row][lane] * b.m[column * 4][lane];
+			result    += a.m[4 + row][lane] * b.m[column * 4 + 1][lane];
+			result    += a.m[8 + row][lane] * b.m[column * 4 + 2][lane];
+			result    += a.m[12 + row][lane] * b.m[column * 4 + 3][lane];
+
+			out.m[column * 4 + row][lane] = result;
+		}
+	}
+}
+
+#if defined(__AVX__)
+
+using Lanes = __m256;
+
+constexpr u32 kLaneCount = 8;
+
+static Lanes LoadLanes(const f32 *values)
+{
+	return _mm256_load_ps(values);
+}
+
+static void StoreLanes(f32 *values, Lanes lanes)
+{
+	_mm256_store_ps(values, lanes);
+}
+
+static Lanes Multiply(Lanes a, Lanes b)
+{
+	return _mm256_mul_ps(a, b);
+}
+
+static Lanes MultiplyAdd(Lanes a, Lanes b, Lanes c)
+{
+	return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+}
+
+#elif defined(TRANSFORM_SSE)
+
+using Lanes = __m128;
+
+constexpr u32 kLaneCount = 4;
+
+static Lanes LoadLanes(const f32 *values)
+{
+	return _mm_load_ps(values);
+}
+
+static void StoreLanes(f32 *values, Lanes lanes)
+{
+	_mm_store_ps(values, lanes);
+}
+
+static Lanes Multiply(Lanes a, Lanes b)
+{
+	return _mm_mul_ps(a, b);
+}
+
+static Lanes MultiplyAdd(Lanes a, Lanes b, Lanes c)
+{
+	return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+
+#endif
+
+#if defined(__AVX__) || defined(TRANSFORM_SSE)
+
+/* Same sums as MultiplyLane for the kLaneCount matrices from lane first, one per SIMD lane. The
+ * batch is aligned and first a multiple of kLaneCount, so every load is aligned. */
+static void MultiplyLanes(const MatrixBatch &a, const MatrixBatch &b, MatrixBatch &out, u32 first)
+{
+	for (u32 column = 0; column < 4; ++column)
+	{
+		const Lanes b0 = LoadLanes(&b.m[column * 4][first]);
+		const Lanes b1 = LoadLanes(&b.m[column * 4 + 1][first]);
+		const Lanes b2 = LoadLanes(&b.m[column * 4 + 2][first]);
+		const Lanes b3 = LoadLanes(&b.m[column * 4 + 3][first]);
+
+		for (u32 row = 0; row < 4; ++row)
+		{
+			Lanes result = Multiply(LoadLanes(&a.m[row][first]), b0);
+			result       = MultiplyAdd(LoadLanes(&a.m[4 + row][first]), b1, result);
+			result       = MultiplyAdd(LoadLanes(&a.m[8 + row][first]), b2, result);
+			result       = MultiplyAdd(LoadLanes(&a.m[12 + row][first]), b3, result);
+
+			StoreLanes(&out.m[column * 4 + row][first], result);
+		}
+	}
+}
+
+#endif
+
+void TransformHierarchy::MatrixBatch::Set(u32 lane, const glm::mat4 &matrix)
+{
+	const f32 *values = glm::value_ptr(matrix);
+	for (u32 element = 0; element < 16; ++element)
+	{
+		m[element][lane] = values[element];
+	}
+}
+
+glm::mat4 TransformHierarchy::MatrixBatch::Get(u32 lane) const
+{
+	glm::mat4 matrix;
+	f32      *values = glm::value_ptr(matrix);
+	for (u32 element = 0; element < 16; ++element)
+	{
+		values[element] = m[element][lane];
+	}
+	return matrix;
+}
+
+void TransformHierarchy::MultiplyBatchScalar(
+		const MatrixBatch &parents,
+		const MatrixBatch &locals,
+		MatrixBatch       &out,
+		u32                count
+)
+{
+	for (u32 lane = 0; lane < count; ++lane)
+	{
+		MultiplyLane(parents, locals, out, lane);
+	}
+}
+
+void TransformHierarchy::MultiplyBatch(
+		const MatrixBatch &parents,
+		const MatrixBatch &locals,
+		MatrixBatch       &out,
+		u32                count
+)
+{
+#if defined(__AVX__) || defined(TRANSFORM_SSE)
+	const u32 vectorCount = count / kLaneCount * kLaneCount;
+	for (u32 first = 0; first < vectorCount; first += kLaneCount)
+	{
+		MultiplyLanes(parents, locals, out, first);
+	}
+
+	// A partly filled batch ends with fewer matrices than lanes.
+	for (u32 lane = vectorCount; lane < count; ++lane)
+	{
+		MultiplyLane(parents, locals, out, lane);
+	}
+#else
+	MultiplyBatchScalar(parents, locals, out, count);
+#endif
+}
+
+
+/**************************************
+*       TRANSFORM HIERARCHY
+**************************************/
+
+void TransformHierarchy::Reserve(u32 nodeCount)
+{
+	mParents.reserve(nodeCount);
+	mLocalPositions.reserve(nodeCount);
+	mLocalRotations.reserve(nodeCount);
+	mLocalScales.reserve(nodeCount);
+	mWorldMatrices.reserve(nodeCount);
+	mDirty.reserve(nodeCount);
+	mDepths.reserve(nodeCount);
+	mChildOffsets.reserve(nodeCount + 1);
+	mDirtyNodes.reserve(nodeCount);
+	mIndexToId.reserve(nodeCount);
+	mIdToIndex.reserve(nodeCount);
+}
+
+TransformId TransformHierarchy::AddNode(TransformId parent)
+{
+	COV_ASSERT(
+			parent == kInvalidTransform || parent < mIdToIndex.size(),
+			"Parent transform does not exist."
+	);
+
+	const TransformId id          = (TransformId)mIdToIndex.size();
+	const u32         index       = (u32)mParents.size();
+	const u32         parentIndex = parent == kInvalidTransform ? kNoParent : mIdToIndex[parent];
+
+	mParents.push_back(parentIndex);
+	mLocalPositions.emplace_back(0.0f);
+	mLocalRotations.emplace_back(1.0f, 0.0f, 0.0f, 0.0f);
+	mLocalScales.emplace_back(1.0f);
+	mWorldMatrices.emplace_back(1.0f);
+	mDirty.push_back(0);
+	mDepths.push_back(parentIndex == kNoParent ? 0 : mDepths[parentIndex] + 1);
+
+	mIndexToId.push_back(id);
+	mIdToIndex.push_back(index);
+
+	MarkDirty(index);
+	mOrderDirty = true;
+
+	return id;
+}
+
+void TransformHierarchy::Clear()
+{
+	mParents.clear();
+	mLocalPositions.clear();
+	mLocalRotations.clear();
+	mLocalScales.clear();
+	mWorldMatrices.clear();
+	mDirty.clear();
+	mDepths.clear();
+	mChildOffsets.clear();
+	mDirtyNodes.clear();
+	mRanges.clear();
+	mNextRanges.clear();
+	mIndexToId.clear();
+	mIdToIndex.clear();
+	mLevelOffsets.clear();
+
+	mOrderDirty = false;
+	mStats      = {};
+}
+
+void TransformHierarchy::MarkDirty(u32 index)
+{
+	if (!mDirty[index])
+	{
+		mDirty[index] = 1;
+		mDirtyNodes.push_back(index);
+	}
+}
+
+void TransformHierarchy::SetLocal(
+		TransformId      node,
+		const glm::vec3 &position,
+		const glm::quat &rotation,
+		const glm::vec3 &scale
+)
+{
+	const u32 index        = mIdToIndex[node];
+	mLocalPositions[index] = position;
+	mLocalRotations[index] = rotation;
+	mLocalScales[index]    = scale;
+	MarkDirty(index);
+}
+
+void TransformHierarchy::SetLocalPosition(TransformId node, const glm::vec3 &position)
+{
+	const u32 index        = mIdToIndex[node];
+	mLocalPositions[index] = position;
+	MarkDirty(index);
+}
+
+void TransformHierarchy::SetLocalRotation(TransformId node, const glm::quat &rotation)
+{
+	const u32 index        = mIdToIndex[node];
+	mLocalRotations[index] = rotation;
+	MarkDirty(index);
+}
+
+void TransformHierarchy::SetLocalScale(TransformId node, const glm::vec3 &scale)
+{
+	const u32 index     = mIdToIndex[node];
+	mLocalScales[index] = scale;
+	MarkDirty(index);
+}
+
+const glm::mat4 &TransformHierarchy::GetWorldMatrix(TransformId node) const
+{
+	return mWorldMatrices[mIdToIndex[node]];
+}
+
+template<typename T>
+static void Permute(std::vector<T> &values, const std::vector<u32> &newToOld)
+{
+	std::vector<T> sorted(values.size());
+	for (u32 i = 0; i < newToOld.size(); ++i)
+	{
+		sorted[i] = values[newToOld[i]];
+	}
+	values.swap(sorted);
+}
+
+void TransformHierarchy::RebuildOrder()
+{
+	const u32 nodeCount = (u32)mParents.size();
+
+	// Children of every node in insertion order: childList[childStart[i]..childStart[i + 1]).
+	std::vector<u32> childStart(nodeCount + 1, 0);
+	for (u32 parent : mParents)
+	{
+		if (parent != kNoParent)
+		{
+			++childStart[parent + 1];
+		}
+	}
+	for (u32 index = 1; index <= nodeCount; ++index)
+	{
+		childStart[index] += childStart[index - 1];
+	}
+
+	std::vector<u32> childList(childStart[nodeCount]);
+	std::vector<u32> cursor(childStart.begin(), childStart.end() - 1);
+	for (u32 index = 0; index < nodeCount; ++index)
+	{
+		if (mParents[index] != kNoParent)
+		{
+			childList[cursor[mParents[index]]++] = index;
+		}
+	}
+
+	// Breadth-first: the roots, then the children of every placed node in turn.
+	std::vector<u32> newToOld;
+	newToOld.reserve(nodeCount);
+	for (u32 index = 0; index < nodeCount; ++index)
+	{
+		if (mParents[index] == kNoParent)
+		{
+			newToOld.push_back(index);
+		}
+	}
+
+	mChildOffsets.resize(nodeCount + 1);
+	for (u32 newIndex = 0; newIndex < nodeCount; ++newIndex)
+	{
+		const u32 oldIndex      = newToOld[newIndex];
+		mChildOffsets[newIndex] = (u32)newToOld.size();
+		newToOld.insert(
+				newToOld.end(),
+				childList.begin() + childStart[oldIndex],
+				childList.begin() + childStart[oldIndex + 1]
+		);
+	}
+	mChildOffsets[nodeCount] = nodeCount;
+
+	std::vector<u32> oldToNew(nodeCount);
+	for (u32 newIndex = 0; newIndex < nodeCount; ++newIndex)
+	{
+		oldToNew[newToOld[newIndex]] = newIndex;
+	}
+
+	Permute(mParents, newToOld);
+	Permute(mLocalPositions, newToOld);
+	Permute(mLocalRotations, newToOld);
+	Permute(mLocalScales, newToOld);
+	Permute(mWorldMatrices, newToOld);
+	Permute(mDirty, newToOld);
+	Permute(mDepths, newToOld);
+	Permute(mIndexToId, newToOld);
+
+	for (u32 &parent : mParents)
+	{
+		if (parent != kNoParent)
+		{
+			parent = oldToNew[parent];
+		}
+	}
+
+	for (u32 &index : mDirtyNodes)
+	{
+		index = oldToNew[index];
+	}
+
+	for (u32 index = 0; index < nodeCount; ++index)
+	{
+		mIdToIndex[mIndexToId[index]] = index;
+	}
+
+	// Breadth-first order is depth sorted, so every level is one range.
+	const u32 levelCount = nodeCount == 0 ? 0 : mDepths[nodeCount - 1] + 1;
+	mLevelOffsets.assign(levelCount + 1, 0);
+	for (u32 depth : mDepths)
+	{
+		++mLevelOffsets[depth + 1];
+	}
+	for (u32 level = 1; level < mLevelOffsets.size(); ++level)
+	{
+		mLevelOffsets[level] += mLevelOffsets[level - 1];
+	}
+
+	mOrderDirty = false;
+}
+
+void TransformHierarchy::ComposeTRS(
+		const glm::vec3 &t,
+		const glm::quat &r,
+		const glm::vec3 &s,
+		MatrixBatch     &batch,
+		u32              lane
+)
+{
+	const glm::mat3 rotation = glm::mat3_cast(r);
+
+	for (i32 column = 0; column < 3; ++column)
+	{
+		const glm::vec3 axis = rotation[column] * s[column];
+
+		batch.m[column * 4][lane]     = axis.x;
+		batch.m[column * 4 + 1][lane] = axis.y;
+		batch.m[column * 4 + 2][lane] = axis.z;
+		batch.m[column * 4 + 3][lane] = 0.0f;
+	}
+
+	batch.m[12][lane] = t.x;
+	batch.m[13][lane] = t.y;
+	batch.m[14][lane] = t.z;
+	batch.m[15][lane] = 1.0f;
+}
+
+void TransformHierarchy::GatherLevelRanges(u32 levelEnd, u32 &dirtyCursor)
+{
+	mNextRanges.clear();
+
+	// Touching or overlapping ranges are merged, both inputs come in ascending order.
+	auto append = [this](u32 begin, u32 end)
+	{
+		if (begin == end)
+		{
+			return;
+		}
+
+		if (!mNextRanges.empty() && begin <= mNextRanges.back().end)
+		{
+			mNextRanges.back().end = std::max(mNextRanges.back().end, end);
+			return;
+		}
+
+		mNextRanges.push_back({begin, end, 0});
+	};
+
+	u32 parentRange = 0;
+	while (true)
+	{
+		const bool hasDirty =
+				dirtyCursor < mDirtyNodes.size() && mDirtyNodes[dirtyCursor] < levelEnd;
+		const bool hasChildren = parentRange < mRanges.size();
+
+		if (!hasDirty && !hasChildren)
+		{
+			break;
+		}
+
+		const u32 childBegin = hasChildren ? mChildOffsets[mRanges[parentRange].begin] : kNoParent;
+		if (hasDirty && mDirtyNodes[dirtyCursor] < childBegin)
+		{
+			append(mDirtyNodes[dirtyCursor], mDirtyNodes[dirtyCursor] + 1);
+			++dirtyCursor;
+		}
+		else
+		{
+			append(childBegin, mChildOffsets[mRanges[parentRange].end]);
+			++parentRange;
+		}
+	}
+
+	u32 offset = 0;
+	for (NodeRange &range : mNextRanges)
+	{
+		range.offset  = offset;
+		offset       += range.end - range.begin;
+	}
+}
+
+void TransformHierarchy::UpdateRanges(u32 first, u32 last)
+{
+	MatrixBatch parents;
+	MatrixBatch locals;
+	MatrixBatch worlds;
+	u32         indices[kBatchSize];
+	u32         batchCount = 0;
+
+	auto flush = [&]()
+	{
+		MultiplyBatch(parents, locals, worlds, batchCount);
+		for (u32 lane = 0; lane < batchCount; ++lane)
+		{
+			mWorldMatrices[indices[lane]] = worlds.Get(lane);
+		}
+		batchCount = 0;
+	};
+
+	// Last range starting at or before first.
+	auto startsAfter = [](u32 position, const NodeRange &range)
+	{
+		return position < range.offset;
+	};
+	auto range = std::upper_bound(mRanges.begin(), mRanges.end(), first, startsAfter) - 1;
+
+	for (u32 position = first; position < last; ++range)
+	{
+		const u32 begin = range->begin + (position - range->offset);
+		const u32 end   = std::min(range->end, begin + (last - position));
+
+		for (u32 index = begin; index < end; ++index)
+		{
+			const u32 parent = mParents[index];
+
+			// Parents live in an earlier level which is already final for this update.
+			parents.Set(batchCount, parent == kNoParent ? kIdentity : mWorldMatrices[parent]);
+			ComposeTRS(
+					mLocalPositions[index],
+					mLocalRotations[index],
+					mLocalScales[index],
+					locals,
+					batchCount
+			);
+			indices[batchCount] = index;
+
+			if (++batchCount == kBatchSize)
+			{
+				flush();
+			}
+		}
+
+		position += end - begin;
+	}
+
+	flush();
+}
+
+void TransformHierarchy::Update(JobSystem *jobSystem)
+{
+	mStats.updated = 0;
+	mStats.ranges  = 0;
+
+	if (mOrderDirty)
+	{
+		RebuildOrder();
+	}
+
+	mStats.nodes  = (u32)mParents.size();
+	mStats.levels = mLevelOffsets.empty() ? 0 : (u32)mLevelOffsets.size() - 1;
+
+	if (mDirtyNodes.empty())
+	{
+		return;
+	}
+
+	// Sorted by index is sorted by level, so each level takes the next run of dirty nodes.
+	std::sort(mDirtyNodes.begin(), mDirtyNodes.end());
+
+	u32 dirtyCursor = 0;
+	mRanges.clear();
+
+	for (u32 level = 0; level + 1 < mLevelOffsets.size(); ++level)
+	{
+		GatherLevelRanges(mLevelOffsets[level + 1], dirtyCursor);
+		mRanges.swap(mNextRanges);
+
+		if (mRanges.empty())
+		{
+			if (dirtyCursor == mDirtyNodes.size())
+			{
+				break;
+			}
+			continue;
+		}
+
+		const NodeRange &lastRange  = mRanges.back();
+		const u32        levelCount = lastRange.offset + lastRange.end - lastRange.begin;
+
+		mStats.updated += levelCount;
+		mStats.ranges  += (u32)mRanges.size();
+
+		if (jobSystem == nullptr || levelCount < kParallelLevelThreshold)
+		{
+			UpdateRanges(0, levelCount);
+			continue;
+		}
+
+		auto updateBatch = [this](u32 begin, u32 end)
+		{
+			UpdateRanges(begin, end);
+		};
+		jobSystem->ParallelFor(levelCount, kParallelBatchSize, updateBatch);
+	}
+
+	for (u32 index : mDirtyNodes)
+	{
+		mDirty[index] = 0;
+	}
+	mDirtyNodes.clear();
+}
@@ -0,0 +1,162 @@
+#ifndef HEADER_TRANSFORM_HIERARCHY_H
+#define HEADER_TRANSFORM_HIERARCHY_H
+
+#include "definitions.h"
+#include "pch/glm.h"
+
+#include <vector>
+
+class JobSystem;
+
+/* Scene graph flattened into SoA arrays in breadth-first order, so every parent is stored (and
+ * updated) before its children, each depth level is a contiguous range that can be processed in
+ * parallel, and the children of consecutive nodes are consecutive too.
+ *
+ * Nodes are addressed by a stable TransformId, the array index of a node changes whenever
+ * RebuildOrder() resorts the arrays. Setting a local transform marks the node dirty. Update()
+ * walks the levels through ranges of nodes to recompute: the dirty nodes of the level merged
+ * with the children of the previous level's ranges. Unchanged subtrees are never visited.
+ *
+ * World matrices are multiplied kBatchSize at a time, gathered into a MatrixBatch so that the
+ * SIMD lanes run across matrices.
+ *
+ * Not part of the application: its InstanceTransform is a position and a uniform scale without
+ * parents. Only TransformBench builds it (update_source_files.py leaves it out). */
+
+using TransformId = u32;
+
+constexpr TransformId kInvalidTransform = ~0u;
+
+class TransformHierarchy
+{
+public:
+	// Matrices multiplied per kernel call.
+	static constexpr u32 kBatchSize = 64;
+
+	/* kBatchSize matrices stored element by element: m[e][i] is element e (column e / 4, row
+	 * e % 4) of matrix i, so a SIMD register holds the same element of consecutive matrices. */
+	struct MatrixBatch
+	{
+		alignas(32) f32 m[16][kBatchSize];
+
+		void Set(u32 lane, const glm::mat4 &matrix);
+
+		[[nodiscard]] glm::mat4 Get(u32 lane) const;
+	};
+
+	struct Stats
+	{
+		u32 nodes   = 0;
+		u32 levels  = 0;
+		u32 updated = 0;// World matrices recomputed by the last Update()
+		u32 ranges  = 0;// Contiguous node ranges the last Update() walked
+	};
+
+public:
+	void Reserve(u32 nodeCount);
+
+	// The parent has to exist already. Added nodes only become visible to Update() after
+	// RebuildOrder(), which Update() calls on its own if needed.
+	TransformId AddNode(TransformId parent);
+
+	void Clear();
+
+	void SetLocal(
+			TransformId      node,
+			const glm::vec3 &position,
+			const glm::quat &rotation,
+			const glm::vec3 &scale
+	);
+
+	void SetLocalPosition(TransformId node, const glm::vec3 &position);
+
+	void SetLocalRotation(TransformId node, const glm::quat &rotation);
+
+	void SetLocalScale(TransformId node, const glm::vec3 &scale);
+
+	[[nodiscard]] const glm::mat4 &GetWorldMatrix(TransformId node) const;
+
+	/* Recomputes world matrices of dirty nodes and their descendants. With a job system, big
+	 * depth levels are split over its workers. */
+	void Update(JobSystem *jobSystem = nullptr);
+
+	[[nodiscard]] const Stats &GetStats() const
+	{
+		return mStats;
+	}
+
+	/* out = parents * locals for the first count matrices of the batches, column-major. Each
+	 * instruction works on 8 matrices with AVX and 4 with SSE, the rest is a scalar loop. */
+	static void MultiplyBatch(
+			const MatrixBatch &parents,
+			const MatrixBatch &locals,
+			MatrixBatch       &out,
+			u32                count
+	);
+
+	static void MultiplyBatchScalar(
+			const MatrixBatch &parents,
+			const MatrixBatch &locals,
+			MatrixBatch       &out,
+			u32                count
+	);
+
+private:
+	struct NodeRange
+	{
+		u32 begin  = 0;
+		u32 end    = 0;
+		u32 offset = 0;// Nodes in the ranges before this one
+	};
+
+	void MarkDirty(u32 index);
+
+	void RebuildOrder();
+
+	/* Fills mNextRanges with the ranges of the level ending at levelEnd to recompute: the
+	 * children of mRanges merged with the dirty nodes in mDirtyNodes from dirtyCursor on. */
+	void GatherLevelRanges(u32 levelEnd, u32 &dirtyCursor);
+
+	/* Recomputes the nodes [first, last) of mRanges, counted across the ranges, so that short
+	 * ranges still fill whole batches. */
+	void UpdateRanges(u32 first, u32 last);
+
+	static void ComposeTRS(
+			const glm::vec3 &t,
+			const glm::quat &r,
+			const glm::vec3 &s,
+			MatrixBatch     &batch,
+			u32              lane
+	);
+
+private:
+	// Indexed by array position (depth sorted)
+	std::vector<u32>       mParents;// Array index of the parent, ~0u for roots
+	std::vector<glm::vec3> mLocalPositions;
+	std::vector<glm::quat> mLocalRotations;
+	std::vector<glm::vec3> mLocalScales;
+	std::vector<glm::mat4> mWorldMatrices;
+	std::vector<u8>        mDirty;// Set while the node is listed in mDirtyNodes
+	std::vector<u32>       mDepths;
+
+	// mChildOffsets[i]..mChildOffsets[i + 1] is the range of the children of node i
+	std::vector<u32> mChildOffsets;
+
+	// Array indices of the nodes set since the last Update(), sorted by it
+	std::vector<u32> mDirtyNodes;
+
+	// Ranges of the level being updated and of the next one, kept to reuse their capacity
+	std::vector<NodeRange> mRanges;
+	std::vector<NodeRange> mNextRanges;
+
+	std::vector<u32> mIndexToId;
+	std::vector<u32> mIdToIndex;
+
+	// mLevelOffsets[d]..mLevelOffsets[d + 1] is the range of nodes at depth d
+	std::vector<u32> mLevelOffsets;
+
+	bool  mOrderDirty = false;
+	Stats mStats;
+};
+
+#endif// HEADER_TRANSFORM_HIERARCHY_H
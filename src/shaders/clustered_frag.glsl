@@ -0,0 +1,91 @@
+#version 450
+
+// Forward shading with the lights binned by light_cull_comp.glsl, each fragment only loops over
+// the lights of its cluster. The sun is shadowed through the cascades of render/shadow_cascades.h.
+
+layout(location = 0) out vec4 outColor;
+
+layout(location = 0) in vec3 fragColor;
+
+struct PointLight
+{
+    vec4 positionRadius;
+    vec4 color;
+};
+
+layout(set = 0, binding = 0) readonly buffer Lights
+{
+    PointLight lights[];
+};
+
+layout(set = 0, binding = 1) readonly buffer Clusters
+{
+    uvec2 clusters[];
+};
+
+layout(set = 0, binding = 2) readonly buffer LightIndices
+{
+    uint lightIndices[];
+};
+
+layout(push_constant) uniform ClusterParams
+{
+    uvec4 gridSize;
+    vec2  viewportSize;
+    uint  lightCount;
+    uint  indexCapacity;
+} params;
+
+const uint kMaxCascades = 4;
+
+// Depth compare sampler, 1 where the fragment is lit.
+layout(set = 1, binding = 0) uniform sampler2DShadow shadowAtlas;
+
+layout(set = 1, binding = 1) uniform ShadowParams
+{
+    mat4  cascadeMatrices[kMaxCascades];// Scene space to atlas uv and light depth
+    vec4  cascadeSplits;                // Far scene depth of each cascade
+    vec4  sunDirection;                 // Towards the sun
+    vec4  sunColor;
+    uvec4 cascadeCount;
+} shadow;
+
+const vec3 kAmbient = vec3(0.05);
+
+float SampleShadow(vec3 position)
+{
+    uint cascade = 0;
+    while (cascade + 1 < shadow.cascadeCount.x && position.z > shadow.cascadeSplits[cascade])
+    {
+        ++cascade;
+    }
+
+    vec4 coord = shadow.cascadeMatrices[cascade] * vec4(position, 1.0);
+    return texture(shadowAtlas, coord.xyz);
+}
+
+void main()
+{
+    vec2 screen   = gl_FragCoord.xy / params.viewportSize;
+    vec3 position = vec3(screen * 2.0 - 1.0, gl_FragCoord.z);
+
+    uvec3 coord = min(
+        uvec3(vec3(screen, gl_FragCoord.z) * vec3(params.gridSize.xyz)),
+        params.gridSize.xyz - 1u
+    );
+    uvec2 range = clusters[(coord.z * params.gridSize.y + coord.y) * params.gridSize.x + coord.x];
+
+    // Surfaces face the viewer, the sun term only depends on its elevation.
+    float sunFacing = max(-shadow.sunDirection.z, 0.0);
+    vec3  lighting  = kAmbient + shadow.sunColor.rgb * sunFacing * SampleShadow(position);
+    for (uint i = 0; i < range.y; ++i)
+    {
+        PointLight light = lights[lightIndices[range.x + i]];
+
+        float distanceRatio = distance(position, light.positionRadius.xyz) / light.positionRadius.w;
+        float falloff       = max(1.0 - distanceRatio, 0.0);
+        lighting += light.color.rgb * falloff * falloff;
+    }
+
+    outColor = vec4(fragColor * lighting, 1.0);
+}
@@ -0,0 +1,171 @@
+#version 450
+
+// Builds a farthest depth pyramid of render/hiz_pyramid.h in one dispatch. Every workgroup
+// reduces a 32x32 tile of mip 0 (64x64 depth texels) down to a single mip 5 texel in shared
+// memory, the last workgroup to finish then reduces mip 5 (at most 64x64) down to mip 11.
+//
+// Mip l texel (x, y) holds the farthest depth of pixels [x, x + 1) * 2^(l + 1), mip 0 having
+// power of two dimensions. Reads past the edge of the depth image or of mip 5 are clamped, they
+// only repeat pixels the texel covers. Texels wholly past the edge are never sampled.
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+// Matches HiZPyramid::kMaxMips.
+const uint kMaxMips = 12;
+
+layout(set = 0, binding = 0) uniform sampler2D depth;
+
+// Levels from mipCount on repeat the last one and are never written.
+layout(set = 0, binding = 1, r32f) uniform coherent image2D mips[kMaxMips];
+
+// Zeroed before the dispatch.
+layout(set = 0, binding = 2) coherent buffer Counter
+{
+    uint finishedWorkgroups;
+};
+
+layout(push_constant) uniform BuildParams
+{
+    uvec2 depthSize;
+    uint  mipCount;
+    uint  workgroupCount;
+} params;
+
+shared float tileValues[16][16];
+shared bool  lastWorkgroup;
+
+// Image arrays are only indexed with constants, dynamic indexing is an optional feature.
+#define STORE_MIP_CASE(LEVEL)                                \
+    case LEVEL:                                              \
+        if (all(lessThan(texel, imageSize(mips[LEVEL]))))    \
+        {                                                    \
+            imageStore(mips[LEVEL], texel, vec4(value));     \
+        }                                                    \
+        break;
+
+void StoreMip(uint level, ivec2 texel, float value)
+{
+    if (level >= params.mipCount)
+    {
+        return;
+    }
+
+    switch (int(level))
+    {
+        STORE_MIP_CASE(0)
+        STORE_MIP_CASE(1)
+        STORE_MIP_CASE(2)
+        STORE_MIP_CASE(3)
+        STORE_MIP_CASE(4)
+        STORE_MIP_CASE(5)
+        STORE_MIP_CASE(6)
+        STORE_MIP_CASE(7)
+        STORE_MIP_CASE(8)
+        STORE_MIP_CASE(9)
+        STORE_MIP_CASE(10)
+        STORE_MIP_CASE(11)
+    }
+}
+
+float FetchDepth(ivec2 pixel)
+{
+    return texelFetch(depth, min(pixel, ivec2(params.depthSize) - 1), 0).r;
+}
+
+float LoadMip5(ivec2 texel)
+{
+    return imageLoad(mips[5], min(texel, imageSize(mips[5]) - 1)).r;
+}
+
+// Reduces the 16x16 texels of level firstLevel - 1 held by the workgroup, one per invocation,
+// into levels firstLevel to firstLevel + 3. tile is the position of the block in texels of the
+// last level.
+void ReduceTile(float value, ivec2 tile, uint firstLevel)
+{
+    ivec2 local = ivec2(gl_LocalInvocationID.xy);
+    tileValues[local.y][local.x] = value;
+
+    uint level = firstLevel;
+    for (int size = 8; size >= 1; size >>= 1)
+    {
+        barrier();
+
+        bool active = all(lessThan(local, ivec2(size)));
+        if (active)
+        {
+            ivec2 source = local * 2;
+
+            value = max(
+                max(tileValues[source.y][source.x], tileValues[source.y][source.x + 1]),
+                max(tileValues[source.y + 1][source.x], tileValues[source.y + 1][source.x + 1])
+            );
+        }
+
+        barrier();
+
+        if (active)
+        {
+            tileValues[local.y][local.x] = value;
+            StoreMip(level, tile * size + local, value);
+        }
+        ++level;
+    }
+}
+
+void main()
+{
+    ivec2 group = ivec2(gl_WorkGroupID.xy);
+    ivec2 local = ivec2(gl_LocalInvocationID.xy);
+
+    // 2x2 mip 0 texels per invocation, which make up its mip 1 texel.
+    float value = 0.0;
+    for (int i = 0; i < 4; ++i)
+    {
+        ivec2 texel = group * 32 + local * 2 + ivec2(i & 1, i >> 1);
+        ivec2 pixel = texel * 2;
+
+        float texelValue = max(
+            max(FetchDepth(pixel), FetchDepth(pixel + ivec2(1, 0))),
+            max(FetchDepth(pixel + ivec2(0, 1)), FetchDepth(pixel + ivec2(1, 1)))
+        );
+
+        StoreMip(0, texel, texelValue);
+        value = max(value, texelValue);
+    }
+    StoreMip(1, group * 16 + local, value);
+
+    ReduceTile(value, group, 2);
+
+    // The mip 5 texel of every workgroup has to be visible to the last one.
+    memoryBarrierImage();
+    barrier();
+
+    if (gl_LocalInvocationIndex == 0)
+    {
+        lastWorkgroup = atomicAdd(finishedWorkgroups, 1) == params.workgroupCount - 1;
+    }
+    barrier();
+
+    if (!lastWorkgroup || params.mipCount <= 6)
+    {
+        return;
+    }
+
+    value = 0.0;
+    for (int i = 0; i < 4; ++i)
+    {
+        ivec2 texel  = local * 2 + ivec2(i & 1, i >> 1);
+        ivec2 source = texel * 2;
+
+        float texelValue = max(
+            max(LoadMip5(source), LoadMip5(source + ivec2(1, 0))),
+            max(LoadMip5(source + ivec2(0, 1)), LoadMip5(source + ivec2(1, 1)))
+        );
+
+        StoreMip(6, texel, texelValue);
+        value = max(value, texelValue);
+    }
+    StoreMip(7, local, value);
+
+    ReduceTile(value, ivec2(0), 8);
+}
@@ -0,0 +1,116 @@
+#version 450
+
+// Bins point lights into the cluster grid, one invocation per cluster. Layouts match
+// render/clustered_lighting.h.
+
+layout(local_size_x = 64) in;
+
+struct PointLight
+{
+    vec4 positionRadius;
+    vec4 color;
+};
+
+layout(set = 0, binding = 0) readonly buffer Lights
+{
+    PointLight lights[];
+};
+
+// Offset into lightIndices and light count of every cluster.
+layout(set = 0, binding = 1) writeonly buffer Clusters
+{
+    uvec2 clusters[];
+};
+
+layout(set = 0, binding = 2) writeonly buffer LightIndices
+{
+    uint lightIndices[];
+};
+
+// Zeroed before the dispatch.
+layout(set = 0, binding = 3) buffer Counter
+{
+    uint indexCount;
+};
+
+layout(push_constant) uniform ClusterParams
+{
+    uvec4 gridSize;// xyz clusters
+    vec2  viewportSize;
+    uint  lightCount;
+    uint  indexCapacity;
+} params;
+
+// Lights are tested in batches loaded once per workgroup.
+shared vec4 sharedLights[gl_WorkGroupSize.x];
+
+bool Intersects(vec4 light, vec3 boundsMin, vec3 boundsMax)
+{
+    vec3 closest = clamp(light.xyz, boundsMin, boundsMax);
+    vec3 delta   = closest - light.xyz;
+    return dot(delta, delta) <= light.w * light.w;
+}
+
+// Counts the lights touching the cluster, or writes their indices from offset when write is set.
+uint BinLights(bool inGrid, vec3 boundsMin, vec3 boundsMax, bool write, uint offset, uint capacity)
+{
+    uint count = 0;
+    for (uint batch = 0; batch < params.lightCount; batch += gl_WorkGroupSize.x)
+    {
+        uint index = batch + gl_LocalInvocationIndex;
+        if (index < params.lightCount)
+        {
+            sharedLights[gl_LocalInvocationIndex] = lights[index].positionRadius;
+        }
+        barrier();
+
+        uint batchSize = min(gl_WorkGroupSize.x, params.lightCount - batch);
+        for (uint i = 0; inGrid && i < batchSize; ++i)
+        {
+            if (Intersects(sharedLights[i], boundsMin, boundsMax))
+            {
+                if (write && count < capacity)
+                {
+                    lightIndices[offset + count] = batch + i;
+                }
+                ++count;
+            }
+        }
+        barrier();
+    }
+
+    return count;
+}
+
+void main()
+{
+    uint clusterCount = params.gridSize.x * params.gridSize.y * params.gridSize.z;
+    uint cluster      = gl_GlobalInvocationID.x;
+    bool inGrid       = cluster < clusterCount;
+
+    // Lights live in the space the instances are drawn in: x and y in NDC, z in depth.
+    uvec3 coord = uvec3(
+        cluster % params.gridSize.x,
+        cluster / params.gridSize.x % params.gridSize.y,
+        cluster / (params.gridSize.x * params.gridSize.y)
+    );
+    vec3 cellSize  = vec3(2.0, 2.0, 1.0) / vec3(params.gridSize.xyz);
+    vec3 boundsMin = vec3(-1.0, -1.0, 0.0) + vec3(coord) * cellSize;
+    vec3 boundsMax = boundsMin + cellSize;
+
+    // Counting first keeps the index list compact without a per-invocation array.
+    uint count  = BinLights(inGrid, boundsMin, boundsMax, false, 0, 0);
+    uint offset = 0;
+    if (inGrid && count > 0)
+    {
+        offset = atomicAdd(indexCount, count);
+        count  = offset < params.indexCapacity ? min(count, params.indexCapacity - offset) : 0;
+    }
+
+    BinLights(inGrid && count > 0, boundsMin, boundsMax, true, offset, count);
+
+    if (inGrid)
+    {
+        clusters[cluster] = uvec2(offset, count);
+    }
+}
@@ -0,0 +1,26 @@
+#version 450
+
+// Mesh vertices placed by their instance (render/mesh.h): x and y scaled into NDC, z into depth
+// squashed by kDepthScale so that meshes stay thin slabs of the [0, 1] depth range.
+
+layout(location = 0) in vec3 inPosition;// Object space
+layout(location = 1) in vec4 inPositionScale;
+layout(location = 2) in vec4 inColor;
+
+layout(location = 0) out vec3 fragColor;
+
+// Matches kMeshDepthScale of render/mesh.h.
+const float kDepthScale = 0.1;
+
+// The depth prepass and the main pass have to compute the same depth for EQUAL testing.
+invariant gl_Position;
+
+void main()
+{
+    vec3 offset = inPosition * inPositionScale.w * vec3(1.0, 1.0, kDepthScale);
+    gl_Position = vec4(inPositionScale.xyz + offset, 1.0);
+
+    // Shaded like a sphere around the origin seen from the front, there are no normals.
+    float facing = max(-normalize(inPosition).z, 0.0);
+    fragColor    = inColor.rgb * (0.4 + 0.6 * facing);
+}
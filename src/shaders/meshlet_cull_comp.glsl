@@ -0,0 +1,237 @@
+#version 450
+
+// Culls the meshlets of instances drawn with one LOD, one invocation per (instance, meshlet)
+// pair, and appends the triangles of the visible ones to the frame's index buffer. Layouts
+// match render/meshlet.h and render/meshlet_culling.h.
+//
+// Compiled a second time with HIZ_OCCLUSION as meshlet_cull_occlusion_comp, which also tests
+// the bounds against the depth pyramids of render/hiz_pyramid.h in two phases: the early phase
+// keeps what the previous frame's pyramid does not hide, the late phase retests what it hid
+// against the pyramid of the early phase's depth, so clusters that became visible still appear.
+
+layout(local_size_x = 64) in;
+
+struct Meshlet
+{
+    vec4 boundingSphere;
+    vec4 cone;
+    uint vertexOffset;
+    uint vertexCount;
+    uint triangleOffset;
+    uint triangleCount;
+};
+
+struct Instance
+{
+    vec4 positionScale;
+    vec4 color;
+};
+
+// VkDrawIndexedIndirectCommand
+struct DrawCommand
+{
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int  vertexOffset;
+    uint firstInstance;
+};
+
+layout(set = 0, binding = 0) readonly buffer Meshlets
+{
+    Meshlet meshlets[];
+};
+
+// Three 8-bit meshlet-local vertex indices per triangle.
+layout(set = 0, binding = 1) readonly buffer MeshletTriangles
+{
+    uint meshletTriangles[];
+};
+
+layout(set = 0, binding = 2) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+// Instance and meshlet of every visible cluster.
+layout(set = 0, binding = 3) writeonly buffer VisibleClusters
+{
+    uvec2 visibleClusters[];
+};
+
+// Cluster slot * kMaxMeshletVertices + meshlet-local vertex index.
+layout(set = 0, binding = 4) writeonly buffer ClusterIndices
+{
+    uint clusterIndices[];
+};
+
+// Draws of the early (or only) and the late phase, the late one continuing after the early one
+// in clusterIndices. Zeroed before the first dispatch of a frame.
+layout(set = 0, binding = 5) buffer DrawCommands
+{
+    DrawCommand commands[2];
+    uint        clusterCount;
+    uint        occludedCount;
+} draw;
+
+#ifdef HIZ_OCCLUSION
+// Farthest depth pyramids, mip 0 at half the depth resolution rounded up to a power of two, so
+// level l texels cover 2^(l + 1) pixels everywhere.
+layout(set = 1, binding = 0) uniform sampler2D previousPyramid;
+layout(set = 1, binding = 1) uniform sampler2D currentPyramid;
+#endif
+
+layout(push_constant) uniform CullParams
+{
+    uint firstMeshlet;
+    uint meshletCount;
+    uint firstInstance;
+    uint instanceCount;
+    uint invocationOffset;// Of this dispatch, draws too large for one are split
+    uint clusterCapacity;
+    uint phase;
+    uint depthWidth;
+    uint depthHeight;
+} params;
+
+// Matches MeshletCulling::CullPhase.
+const uint kPhaseNoOcclusion = 0;
+const uint kPhaseEarly       = 1;
+const uint kPhaseLate        = 2;
+
+const uint kMaxMeshletVertices = 64;
+
+// Matches kMeshDepthScale of render/mesh.h.
+const float kDepthScale = 0.1;
+
+// The view box: x and y in NDC, z in depth.
+bool OutsideView(vec3 center, float radius)
+{
+    return any(lessThan(center + radius, vec3(-1.0, -1.0, 0.0)))
+        || any(greaterThan(center - radius, vec3(1.0)));
+}
+
+#ifdef HIZ_OCCLUSION
+// Whether the pyramid is farther than the nearest point of the box everywhere the box covers.
+// Reads the level where the box spans at most 2x2 texels.
+bool Occluded(sampler2D pyramid, vec3 boxMin, vec3 boxMax)
+{
+    ivec2 depthSize = ivec2(params.depthWidth, params.depthHeight);
+
+    vec2  uvMin    = clamp(boxMin.xy * 0.5 + 0.5, 0.0, 1.0);
+    vec2  uvMax    = clamp(boxMax.xy * 0.5 + 0.5, 0.0, 1.0);
+    ivec2 pixelMin = min(ivec2(uvMin * vec2(depthSize)), depthSize - 1);
+    ivec2 pixelMax = min(ivec2(uvMax * vec2(depthSize)), depthSize - 1);
+
+    // Texels of level l cover 2^(l + 1) pixels, a span of up to that many touches two of them.
+    ivec2 span  = pixelMax - pixelMin + 1;
+    int   level = max(findMSB(max(span.x, span.y) - 1), 0);
+    if (level >= textureQueryLevels(pyramid))
+    {
+        return false;
+    }
+
+    // The levels cover the whole depth image, the clamp only guards the fetches.
+    ivec2 lastTexel = textureSize(pyramid, level) - 1;
+    ivec2 texelMin  = min(pixelMin >> (level + 1), lastTexel);
+    ivec2 texelMax  = min(pixelMax >> (level + 1), lastTexel);
+
+    float farthest = max(
+        max(texelFetch(pyramid, texelMin, level).r,
+            texelFetch(pyramid, ivec2(texelMax.x, texelMin.y), level).r),
+        max(texelFetch(pyramid, ivec2(texelMin.x, texelMax.y), level).r,
+            texelFetch(pyramid, texelMax, level).r)
+    );
+
+    return boxMin.z > farthest;
+}
+#endif
+
+void main()
+{
+    // The early phase is complete when the late one runs, its index count is final.
+    uint commandIndex = params.phase == kPhaseLate ? 1 : 0;
+    uint firstIndex   = commandIndex == 1 ? draw.commands[0].indexCount : 0;
+
+    if (gl_GlobalInvocationID.x == 0)
+    {
+        draw.commands[commandIndex].instanceCount = 1;
+        draw.commands[commandIndex].firstIndex    = firstIndex;
+    }
+
+    uint pair = params.invocationOffset + gl_GlobalInvocationID.x;
+    if (pair >= params.meshletCount * params.instanceCount)
+    {
+        return;
+    }
+
+    uint instanceIndex = params.firstInstance + pair / params.meshletCount;
+    uint meshletIndex  = params.firstMeshlet + pair % params.meshletCount;
+
+    Instance instance = instances[instanceIndex];
+    Meshlet  meshlet  = meshlets[meshletIndex];
+
+    // Placement only scales, so the sphere stays a sphere around the placed center. Squashing z
+    // shrinks it, the unscaled radius stays conservative.
+    vec3  scale  = instance.positionScale.w * vec3(1.0, 1.0, kDepthScale);
+    vec3  center = instance.positionScale.xyz + meshlet.boundingSphere.xyz * scale;
+    float radius = meshlet.boundingSphere.w * instance.positionScale.w;
+    if (OutsideView(center, radius))
+    {
+        return;
+    }
+
+    // The view looks along +z and positive scales keep the sign of every normal's z, so the
+    // object space cone decides.
+    if (meshlet.cone.z < meshlet.cone.w)
+    {
+        return;
+    }
+
+#ifdef HIZ_OCCLUSION
+    // The placed sphere is an ellipsoid, squashed along z.
+    vec3 extent = meshlet.boundingSphere.w * scale;
+    vec3 boxMin = center - extent;
+    vec3 boxMax = center + extent;
+
+    if (params.phase == kPhaseEarly && Occluded(previousPyramid, boxMin, boxMax))
+    {
+        return;
+    }
+
+    // Same test as the early phase: only what it hid is left to draw.
+    if (params.phase == kPhaseLate)
+    {
+        if (!Occluded(previousPyramid, boxMin, boxMax))
+        {
+            return;
+        }
+        if (Occluded(currentPyramid, boxMin, boxMax))
+        {
+            atomicAdd(draw.occludedCount, 1);
+            return;
+        }
+    }
+#endif
+
+    uint slot = atomicAdd(draw.clusterCount, 1);
+    if (slot >= params.clusterCapacity)
+    {
+        return;
+    }
+
+    // Only clusters holding a slot reserve indices, so the indices stay within capacity.
+    uint indexCount = meshlet.triangleCount * 3;
+    uint first      = firstIndex + atomicAdd(draw.commands[commandIndex].indexCount, indexCount);
+    uint base       = slot * kMaxMeshletVertices;
+
+    visibleClusters[slot] = uvec2(instanceIndex, meshletIndex);
+    for (uint i = 0; i < meshlet.triangleCount; ++i)
+    {
+        uint triangle = meshletTriangles[meshlet.triangleOffset + i];
+
+        clusterIndices[first + i * 3 + 0] = base + (triangle & 0xff);
+        clusterIndices[first + i * 3 + 1] = base + ((triangle >> 8) & 0xff);
+        clusterIndices[first + i * 3 + 2] = base + ((triangle >> 16) & 0xff);
+    }
+}
@@ -0,0 +1,76 @@
+#version 450
+
+// mesh_vert.glsl for the clusters left by meshlet_cull_comp.glsl. There are no vertex inputs:
+// every index encodes a cluster slot and a meshlet-local vertex, everything else is fetched from
+// the buffers of render/meshlet_culling.h.
+
+struct Meshlet
+{
+    vec4 boundingSphere;
+    vec4 cone;
+    uint vertexOffset;
+    uint vertexCount;
+    uint triangleOffset;
+    uint triangleCount;
+};
+
+struct Instance
+{
+    vec4 positionScale;
+    vec4 color;
+};
+
+// Mesh vertex positions, three floats each.
+layout(set = 2, binding = 0) readonly buffer Positions
+{
+    float positions[];
+};
+
+layout(set = 2, binding = 1) readonly buffer MeshletVertices
+{
+    uint meshletVertices[];
+};
+
+layout(set = 2, binding = 2) readonly buffer Meshlets
+{
+    Meshlet meshlets[];
+};
+
+layout(set = 2, binding = 3) readonly buffer VisibleClusters
+{
+    uvec2 visibleClusters[];
+};
+
+layout(set = 2, binding = 4) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+layout(location = 0) out vec3 fragColor;
+
+const uint kMaxMeshletVertices = 64;
+
+// Matches kMeshDepthScale of render/mesh.h.
+const float kDepthScale = 0.1;
+
+// The depth prepass and the main pass have to compute the same depth for EQUAL testing.
+invariant gl_Position;
+
+void main()
+{
+    uvec2 cluster = visibleClusters[uint(gl_VertexIndex) / kMaxMeshletVertices];
+    uint  local   = uint(gl_VertexIndex) % kMaxMeshletVertices;
+
+    Instance instance = instances[cluster.x];
+    uint     vertex   = meshletVertices[meshlets[cluster.y].vertexOffset + local];
+
+    vec3 inPosition = vec3(
+        positions[vertex * 3 + 0], positions[vertex * 3 + 1], positions[vertex * 3 + 2]
+    );
+
+    vec3 offset = inPosition * instance.positionScale.w * vec3(1.0, 1.0, kDepthScale);
+    gl_Position = vec4(instance.positionScale.xyz + offset, 1.0);
+
+    float facing = max(-normalize(inPosition).z, 0.0);
+    fragColor    = instance.color.rgb * (0.4 + 0.6 * facing);
+}
@@ -0,0 +1,106 @@
+#version 450
+
+// Post-processing of render/post_process.h: reads the HDR scene color once and writes the swap
+// chain image once. Every enabled effect works on the pixel in registers, so an effect costs ALU
+// instead of another full-screen read and write.
+//
+// CMakeLists.txt compiles a permutation for every combination of POST_TONEMAP, POST_GRADE,
+// POST_SHARPEN and POST_VIGNETTE as post_process_<bits>_comp, the bits matching the effect bits
+// of PostProcess. Disabled effects are compiled out, not branched over.
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(set = 0, binding = 0) uniform sampler2D hdrColor;
+
+// The swap chain format is picked at runtime, so the image has no format qualifier, which needs
+// shaderStorageImageWriteWithoutFormat. Its format is UNORM, the sRGB encode is done here.
+layout(set = 0, binding = 1) writeonly uniform image2D outputImage;
+
+layout(push_constant) uniform PostParams
+{
+    float exposure;
+    float contrast;
+    float saturation;
+    float sharpness;
+    float vignetteStrength;
+    float vignetteRadius;
+} params;
+
+const float kMiddleGrey = 0.18;
+
+vec3 Load(ivec2 texel)
+{
+    return texelFetch(hdrColor, texel, 0).rgb;
+}
+
+float Luminance(vec3 color)
+{
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+// Narkowicz's fit of the ACES filmic curve, maps [0, inf) to [0, 1].
+vec3 TonemapAces(vec3 color)
+{
+    vec3 mapped = (color * (2.51 * color + 0.03)) / (color * (2.43 * color + 0.59) + 0.14);
+    return clamp(mapped, 0.0, 1.0);
+}
+
+vec3 EncodeSrgb(vec3 color)
+{
+    vec3 low  = color * 12.92;
+    vec3 high = 1.055 * pow(color, vec3(1.0 / 2.4)) - 0.055;
+    return mix(high, low, lessThanEqual(color, vec3(0.0031308)));
+}
+
+void main()
+{
+    ivec2 size  = textureSize(hdrColor, 0);
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, size)))
+    {
+        return;
+    }
+
+    vec3 color = Load(texel);
+
+#ifdef POST_SHARPEN
+    // Unsharp mask on the linear HDR color, before tonemapping compresses the edges. Neighbours
+    // are fetched by the adjacent invocations too and come from the texture cache.
+    ivec2 lastTexel = size - 1;
+    vec3  north     = Load(clamp(texel + ivec2(0, -1), ivec2(0), lastTexel));
+    vec3  south     = Load(clamp(texel + ivec2(0, 1), ivec2(0), lastTexel));
+    vec3  west      = Load(clamp(texel + ivec2(-1, 0), ivec2(0), lastTexel));
+    vec3  east      = Load(clamp(texel + ivec2(1, 0), ivec2(0), lastTexel));
+
+    vec3 sharpened = color + (4.0 * color - (north + south + west + east)) * params.sharpness;
+
+    // Kept within the neighbourhood, so edges do not ring.
+    vec3 minimum = min(color, min(min(north, south), min(west, east)));
+    vec3 maximum = max(color, max(max(north, south), max(west, east)));
+    color        = clamp(sharpened, minimum, maximum);
+#endif
+
+#ifdef POST_TONEMAP
+    color = TonemapAces(color * params.exposure);
+#else
+    color = clamp(color, 0.0, 1.0);
+#endif
+
+#ifdef POST_GRADE
+    // Contrast as a power curve pivoting on middle grey, then saturation around the luminance.
+    color = kMiddleGrey * pow(color / kMiddleGrey, vec3(params.contrast));
+    color = mix(vec3(Luminance(color)), color, params.saturation);
+    color = clamp(color, 0.0, 1.0);
+#endif
+
+#ifdef POST_VIGNETTE
+    // Round on any aspect ratio, 0 at the center and 1 in the corners.
+    vec2  offset   = (vec2(texel) + 0.5) / vec2(size) - 0.5;
+    vec2  aspect   = vec2(float(size.x) / float(size.y), 1.0);
+    float distance = length(offset * aspect) / length(0.5 * aspect);
+
+    color *= 1.0 - params.vignetteStrength * smoothstep(params.vignetteRadius, 1.0, distance);
+#endif
+
+    imageStore(outputImage, texel, vec4(EncodeSrgb(color), 1.0));
+}
@@ -4,7 +4,17 @@ layout(location = 0) out vec4 outColor;
 
 layout(location = 0) in vec3 fragColor;
 
+// Extra arithmetic per fragment standing in for expensive shading, see
+// Application::SetShadingIterations.
+layout(constant_id = 0) const int kShadingIterations = 0;
+
 void main()
 {
-    outColor = vec4(fragColor, 1.0);
+    vec3 color = fragColor;
+    for (int i = 0; i < kShadingIterations; ++i)
+    {
+        color = fract(color * 1.618 + 0.1);
+    }
+
+    outColor = vec4(color, 1.0);
 }
@@ -1,5 +1,8 @@
 #version 450
 
+// One procedural triangle per instance. The application draws meshes with mesh_vert.glsl,
+// RenderBench keeps this one so that its reports stay comparable.
+
 vec2 positions[3] = vec2[](
     vec2(0.0, -0.5),
     vec2(0.5, 0.5),
@@ -12,10 +15,16 @@ vec3 colors[3] = vec3[](
     vec3(0.0, 0.0, 1.0)
 );
 
+layout(location = 0) in vec4 inPositionScale;
+layout(location = 1) in vec4 inColor;
+
 layout(location = 0) out vec3 fragColor;
 
+// The depth prepass and the main pass have to compute the same depth for EQUAL testing.
+invariant gl_Position;
+
 void main()
 {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
+    gl_Position = vec4(positions[gl_VertexIndex] * inPositionScale.w + inPositionScale.xy, inPositionScale.z, 1.0);
+    fragColor = colors[gl_VertexIndex] * inColor.rgb;
 }
@@ -0,0 +1,24 @@
+#version 450
+
+// Depth of the instances seen from the sun, for one cascade of the shadow atlas. Places mesh
+// vertices like mesh_vert.glsl.
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec4 inPositionScale;
+layout(location = 2) in vec4 inColor;
+
+// Scene space to the cascade's light clip space.
+layout(push_constant) uniform CascadeParams
+{
+    mat4 lightViewProjection;
+} params;
+
+// Matches kMeshDepthScale of render/mesh.h.
+const float kDepthScale = 0.1;
+
+void main()
+{
+    vec3 offset   = inPosition * inPositionScale.w * vec3(1.0, 1.0, kDepthScale);
+    vec3 position = inPositionScale.xyz + offset;
+    gl_Position   = params.lightViewProjection * vec4(position, 1.0);
+}
@@ -0,0 +1,23 @@
+#include "json.h"
+
+void WriteJsonString(FILE *file, const char *string)
+{
+	fputc('"', file);
+	for (const char *c = string; *c != '\0'; ++c)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			fputc('\\', file);
+			fputc(*c, file);
+		}
+		else if ((unsigned char)*c < 0x20)
+		{
+			fprintf(file, "\\u%04x", (unsigned int)(unsigned char)*c);
+		}
+		else
+		{
+			fputc(*c, file);
+		}
+	}
+	fputc('"', file);
+}
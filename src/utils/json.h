@@ -0,0 +1,9 @@
+#ifndef HEADER_JSON_H
+#define HEADER_JSON_H
+
+#include <cstdio>
+
+// Writes string as a quoted JSON string, escaping quotes, backslashes and control characters.
+void WriteJsonString(FILE *file, const char *string);
+
+#endif// HEADER_JSON_H
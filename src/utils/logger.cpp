@@ -1,6 +1,9 @@
 #include "logger.h"
 
+#include <algorithm>
+#include <cstdarg>
 #include <cstdio>
+#include <iterator>
 
 #ifdef LOGGER_NO_ANSI_COLORS
 #define COLOR_ESCAPE_START(Color) ""
@@ -12,28 +15,91 @@
 
 #define COLORIZED_TEXT(Text, Color) COLOR_ESCAPE_START(Color) Text COLOR_ESCAPE_END()
 
+// Indexed by Covlog::Type.
 constexpr const char *kPrefixes[]{
 		COLORIZED_TEXT("[ERROR]  ", 31),
 		COLORIZED_TEXT("[WARNING]", 33),
-		COLORIZED_TEXT("[DEBUG]  ", 36),
-		COLORIZED_TEXT("[INFO]   ", 32)
+		COLORIZED_TEXT("[INFO]   ", 32),
+		COLORIZED_TEXT("[DEBUG]  ", 36)
 };
 
 constexpr const char *kPrefixesColors[]{
-		COLOR_ESCAPE_START(31), COLOR_ESCAPE_START(33), COLOR_ESCAPE_START(36), COLOR_ESCAPE_START(32)
+		COLOR_ESCAPE_START(31), COLOR_ESCAPE_START(33), COLOR_ESCAPE_START(32), COLOR_ESCAPE_START(36)
 };
 
+static_assert(std::size(kPrefixes) == Covlog::eCount);
+static_assert(std::size(kPrefixesColors) == Covlog::eCount);
+
+// Whole line: time, prefix, location and color escapes around a message of kMessageBufferSize.
 constexpr size_t kLogBufferSize = 1024;
 
+void Covlog::SetLevel(Covlog::Type level)
+{
+	if (level > kCompiledLevel)
+	{
+		CLOG_WARN("Messages above level ", kCompiledLevel, " are not compiled in (COV_LOG_LEVEL).");
+	}
+
+	sLevel.store(level, std::memory_order_relaxed);
+}
+
+void Covlog::MessageBuffer::Append(const char *text, size_t length)
+{
+	// One byte stays reserved for the terminator.
+	const size_t copied = std::min(length, kMessageBufferSize - 1 - mLength);
+
+	memcpy(mText + mLength, text, copied);
+	mLength += copied;
+	mText[mLength] = '\0';
+}
+
+void Covlog::MessageBuffer::AppendFormat(const char *format, ...)
+{
+	const size_t available = kMessageBufferSize - mLength;
+
+	va_list args;
+	va_start(args, format);
+	const int written = vsnprintf(mText + mLength, available, format, args);
+	va_end(args);
+
+	if (written > 0)
+	{
+		mLength += std::min((size_t)written, available - 1);
+	}
+}
+
+void Covlog::LogFormat(
+		Covlog::Type type,
+		const char  *fileName,
+		int          lineNumber,
+		const char  *format,
+		...
+)
+{
+	char message[kMessageBufferSize];
+
+	va_list args;
+	va_start(args, format);
+	const int written = vsnprintf(message, kMessageBufferSize, format, args);
+	va_end(args);
+
+	if (written < 0)
+	{
+		return;
+	}
+
+	LogMessage(type, fileName, lineNumber, message);
+}
+
 void Covlog::LogMessage(Covlog::Type type, const char *fileName, int lineNumber, const char *message)
 {
 	time_t now{time(nullptr)};
 	tm     time{};
 	localtime_s(&time, &now);
 
-	char logBuffer[kLogBufferSize]{};
+	char logBuffer[kLogBufferSize];
 
-	snprintf(
+	const int written = snprintf(
 			logBuffer,
 			kLogBufferSize,
 			"%02i:%02i:%02i %s %s%s:%i%s: %s%s%s\n",
@@ -50,5 +116,19 @@ void Covlog::LogMessage(Covlog::Type type, const char *fileName, int lineNumber,
 			COLOR_ESCAPE_END()
 	);
 
-	fwrite(logBuffer, kLogBufferSize, 1, stdout);
+	if (written < 0)
+	{
+		return;
+	}
+
+	// Only the formatted part, a cut off line still ends with its newline.
+	size_t length = (size_t)written;
+	if (length >= kLogBufferSize)
+	{
+		length                = kLogBufferSize - 1;
+		logBuffer[length - 1] = '\n';
+	}
+
+	// A single write per line, so lines from different threads do not interleave.
+	fwrite(logBuffer, 1, length, stdout);
 }
@@ -1,45 +1,196 @@
 #ifndef LOGGER_HPP
 #define LOGGER_HPP
 
+#include "core/arena.h"
+
+#include <atomic>
+#include <cstring>
 #include <sstream>
+#include <string_view>
+#include <type_traits>
+
+/* Most verbose level compiled in: 0 error, 1 warning, 2 info, 3 debug. Messages above it compile
+ * to nothing, arguments included. Release builds leave out debug messages unless built with
+ * -DCOV_LOG_LEVEL=3, which keeps them behind the runtime level (off by default) at the cost of a
+ * load and a branch per call site. */
+#ifndef COV_LOG_LEVEL
+#ifdef NDEBUG
+#define COV_LOG_LEVEL 2
+#else
+#define COV_LOG_LEVEL 3
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define COV_PRINTF_FORMAT(formatIndex, firstArg)                                                   \
+	__attribute__((format(printf, formatIndex, firstArg)))
+#else
+#define COV_PRINTF_FORMAT(formatIndex, firstArg)
+#endif
 
 namespace Covlog
 {
+// Ordered from most to least severe.
 enum Type
 {
 	eError,
 	eWarning,
-	eDebug,
 	eInfo,
+	eDebug,
 	eCount
 };
 
+constexpr Type kCompiledLevel = (Type)COV_LOG_LEVEL;
+
+#ifdef NDEBUG
+constexpr Type kDefaultLevel = kCompiledLevel < eInfo ? kCompiledLevel : eInfo;
+#else
+constexpr Type kDefaultLevel = kCompiledLevel;
+#endif
+
+// Longest message text, longer ones are cut off.
+constexpr size_t kMessageBufferSize = 512;
+
+// Formatting fallback for types MessageBuffer does not know, allocates from scratch memory.
+using ArenaOStringStream =
+		std::basic_ostringstream<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+// Runtime level, read by every enabled call site. Use SetLevel().
+inline std::atomic<Type> sLevel = kDefaultLevel;
+
+// Messages above level are dropped from now on, levels above kCompiledLevel stay compiled out.
+void SetLevel(Type level);
+
+[[nodiscard]] constexpr bool IsCompiledIn(Type type)
+{
+	return type <= kCompiledLevel;
+}
+
+[[nodiscard]] inline bool IsEnabled(Type type)
+{
+	return type <= sLevel.load(std::memory_order_relaxed);
+}
+
+// Message text on the stack, built without iostreams for strings, numbers, enums and pointers.
+class MessageBuffer
+{
+public:
+	void Append(const char *text, size_t length);
+
+	void AppendFormat(const char *format, ...) COV_PRINTF_FORMAT(2, 3);
+
+	template<typename T>
+	void AppendValue(const T &value);
+
+	[[nodiscard]] const char *GetText() const
+	{
+		return mText;
+	}
+
+private:
+	char   mText[kMessageBufferSize] = "";
+	size_t mLength                   = 0;
+};
+
 void LogMessage(Type type, const char *fileName, int lineNumber, const char *message);
 
+// printf-style, formats straight into a stack buffer.
+void LogFormat(Type type, const char *fileName, int lineNumber, const char *format, ...)
+		COV_PRINTF_FORMAT(4, 5);
+
+// Arguments are written one after another, like a chain of operator<<.
 template<typename... Args>
-void Log(Covlog::Type type, const char *fileName, int lineNumber, Args &&...args);
+void Log(Type type, const char *fileName, int lineNumber, const Args &...args);
 }// namespace Covlog
 
-template<typename... Args>
-void Covlog::Log(Covlog::Type type, const char *fileName, int lineNumber, Args &&...args)
+template<typename T>
+void Covlog::MessageBuffer::AppendValue(const T &value)
 {
-	// FIXME: I hate this function
+	using Value = std::decay_t<T>;
 
-	std::ostringstream os;
-	(os << ... << std::forward<Args>(args));
-	LogMessage(type, fileName, lineNumber, os.str().c_str());
+	// Same text an std::ostream with default flags would produce.
+	if constexpr (std::is_same_v<Value, char>)
+	{
+		Append(&value, 1);
+	}
+	else if constexpr (std::is_same_v<Value, const char *> || std::is_same_v<Value, char *>)
+	{
+		const char *text = value != nullptr ? value : "(null)";
+		Append(text, strlen(text));
+	}
+	else if constexpr (std::is_convertible_v<const T &, std::string_view>)
+	{
+		const std::string_view text = value;
+		Append(text.data(), text.size());
+	}
+	else if constexpr (std::is_integral_v<Value> && std::is_signed_v<Value>)
+	{
+		AppendFormat("%lld", (long long)value);
+	}
+	else if constexpr (std::is_integral_v<Value>)
+	{
+		AppendFormat("%llu", (unsigned long long)value);
+	}
+	else if constexpr (std::is_floating_point_v<Value>)
+	{
+		AppendFormat("%g", (double)value);
+	}
+	else if constexpr (std::is_enum_v<Value>)
+	{
+		AppendValue((std::underlying_type_t<Value>)value);
+	}
+	else if constexpr (std::is_pointer_v<Value>)
+	{
+		AppendFormat("%p", (const void *)value);
+	}
+	else
+	{
+		ScratchScope       scratch;
+		ArenaOStringStream os;
+		os << value;
+		AppendValue(os.str());
+	}
+}
+
+template<typename... Args>
+void Covlog::Log(Covlog::Type type, const char *fileName, int lineNumber, const Args &...args)
+{
+	MessageBuffer message;
+	(message.AppendValue(args), ...);
+	LogMessage(type, fileName, lineNumber, message.GetText());
 }
 
 #ifndef __FILE_NAME__
 #define __FILE_NAME__ (strrchr(__FILE__, '\\') ? strrchr(__FILE__, '\\') + 1 : __FILE__)
 #endif
 
-#define CLOG(logger, ...) Covlog::Log(logger, __FILE_NAME__, __LINE__, "", __VA_ARGS__)
+/* Call sites of levels above COV_LOG_LEVEL are discarded at compile time but still type checked,
+ * so variables only used in messages do not trigger warnings. Enabled ones test the runtime level
+ * before formatting anything. */
+#define COV_LOG_CALL(logger, function, ...)                                                        \
+	do                                                                                             \
+	{                                                                                              \
+		if constexpr (Covlog::IsCompiledIn(logger))                                                \
+		{                                                                                          \
+			if (Covlog::IsEnabled(logger))                                                         \
+			{                                                                                      \
+				function(logger, __FILE_NAME__, __LINE__, __VA_ARGS__);                            \
+			}                                                                                      \
+		}                                                                                          \
+	} while (0)
+
+#define CLOG(logger, ...) COV_LOG_CALL(logger, Covlog::Log, __VA_ARGS__)
 #define CLOG_ERR(...) CLOG(Covlog::eError, __VA_ARGS__)
 #define CLOG_WARN(...) CLOG(Covlog::eWarning, __VA_ARGS__)
 #define CLOG_DEBUG(...) CLOG(Covlog::eDebug, __VA_ARGS__)
 #define CLOG_INFO(...) CLOG(Covlog::eInfo, __VA_ARGS__)
 
+#define CLOGF(logger, ...) COV_LOG_CALL(logger, Covlog::LogFormat, __VA_ARGS__)
+#define CLOGF_ERR(...) CLOGF(Covlog::eError, __VA_ARGS__)
+#define CLOGF_WARN(...) CLOGF(Covlog::eWarning, __VA_ARGS__)
+#define CLOGF_DEBUG(...) CLOGF(Covlog::eDebug, __VA_ARGS__)
+#define CLOGF_INFO(...) CLOGF(Covlog::eInfo, __VA_ARGS__)
+
 #define COV_ASSERT(expr, msg)          \
 	if (expr)                          \
 	{                                  \
@@ -0,0 +1,321 @@
+#include "trace.h"
+
+#include "utils/json.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+enum class TraceEventType : u8
+{
+	eBegin,
+	eEnd,
+	eComplete,
+};
+
+struct TraceEvent
+{
+	const char    *name;
+	u64            timestamp;
+	u64            duration;// eComplete only
+	TraceEventType type;
+};
+
+// Events of one thread, or of the GPU track. Only its owner writes to it.
+struct TraceBuffer
+{
+	std::unique_ptr<TraceEvent[]> events;
+	u32                           capacity = 0;
+
+	// Capture the events belong to, the owner clears the buffer on its first event of a new one.
+	std::atomic<u32> generation = 0;
+	std::atomic<u32> count      = 0;
+	std::atomic<u64> dropped    = 0;
+
+	// Begun scopes not ended yet, each keeps a slot free for its end event.
+	u32 openScopes = 0;
+
+	u32  trackId                        = 0;
+	char name[Trace::kMaxThreadNameSize] = "";
+};
+
+// Never shrinks, threads keep pointers to their buffers.
+static std::mutex                                sBuffersMutex;
+static std::vector<std::unique_ptr<TraceBuffer>> sBuffers;
+
+static TraceBuffer sGpuBuffer;
+
+static std::atomic<u32> sGeneration      = 0;
+static std::atomic<u32> sEventsPerThread = Trace::kDefaultEventsPerThread;
+static u64              sStartTime       = 0;
+
+static thread_local TraceBuffer *tBuffer                               = nullptr;
+static thread_local char         tThreadName[Trace::kMaxThreadNameSize] = "";
+
+// Called by the buffer's owner only.
+static void PrepareBuffer(TraceBuffer &buffer)
+{
+	const u32 generation = sGeneration.load(std::memory_order_acquire);
+	if (buffer.generation.load(std::memory_order_relaxed) == generation)
+	{
+		return;
+	}
+
+	const u32 capacity = sEventsPerThread.load(std::memory_order_relaxed);
+	if (buffer.capacity != capacity)
+	{
+		buffer.events   = std::make_unique<TraceEvent[]>(capacity);
+		buffer.capacity = capacity;
+	}
+
+	buffer.count.store(0, std::memory_order_relaxed);
+	buffer.dropped.store(0, std::memory_order_relaxed);
+	buffer.openScopes = 0;
+	buffer.generation.store(generation, std::memory_order_release);
+}
+
+static TraceBuffer &GetThreadBuffer()
+{
+	if (tBuffer == nullptr)
+	{
+		auto buffer = std::make_unique<TraceBuffer>();
+		memcpy(buffer->name, tThreadName, sizeof(buffer->name));
+
+		std::lock_guard<std::mutex> lock(sBuffersMutex);
+		buffer->trackId = (u32)sBuffers.size() + 1;
+		tBuffer         = buffer.get();
+		sBuffers.push_back(std::move(buffer));
+	}
+
+	PrepareBuffer(*tBuffer);
+	return *tBuffer;
+}
+
+static void Record(TraceBuffer &buffer, const TraceEvent &event)
+{
+	const u32 index      = buffer.count.load(std::memory_order_relaxed);
+	buffer.events[index] = event;
+	buffer.count.store(index + 1, std::memory_order_release);
+}
+
+void Trace::Start(u32 eventsPerThread)
+{
+	sEventsPerThread.store(std::max(eventsPerThread, 2u), std::memory_order_relaxed);
+	sStartTime = Now();
+	sGeneration.fetch_add(1, std::memory_order_release);
+	sCapturing.store(true, std::memory_order_release);
+
+	CLOG_INFO("Trace capture started.");
+}
+
+void Trace::Stop()
+{
+	sCapturing.store(false, std::memory_order_release);
+}
+
+u64 Trace::Now()
+{
+	using namespace std::chrono;
+	return (u64)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+bool Trace::BeginScope(const char *name)
+{
+	if (!IsCapturing())
+	{
+		return false;
+	}
+
+	TraceBuffer &buffer = GetThreadBuffer();
+
+	// This event and the end events of every open scope, this one included.
+	const u32 needed = buffer.count.load(std::memory_order_relaxed) + buffer.openScopes + 2;
+	if (needed > buffer.capacity)
+	{
+		buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	++buffer.openScopes;
+	Record(buffer, {name, Now(), 0, TraceEventType::eBegin});
+	return true;
+}
+
+void Trace::EndScope()
+{
+	// Ends are recorded after Stop() too, only a new capture orphans them.
+	TraceBuffer *buffer = tBuffer;
+	if (buffer == nullptr || buffer->openScopes == 0
+		|| buffer->generation.load(std::memory_order_relaxed)
+				   != sGeneration.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+
+	--buffer->openScopes;
+	Record(*buffer, {nullptr, Now(), 0, TraceEventType::eEnd});
+}
+
+void Trace::AddGpuScope(const char *name, u64 beginNs, u64 endNs)
+{
+	if (!IsCapturing())
+	{
+		return;
+	}
+
+	PrepareBuffer(sGpuBuffer);
+	if (sGpuBuffer.count.load(std::memory_order_relaxed) >= sGpuBuffer.capacity)
+	{
+		sGpuBuffer.dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	Record(sGpuBuffer,
+		   {name, beginNs, endNs > beginNs ? endNs - beginNs : 0, TraceEventType::eComplete});
+}
+
+void Trace::SetThreadName(const char *name)
+{
+	snprintf(tThreadName, sizeof(tThreadName), "%s", name);
+	if (tBuffer != nullptr)
+	{
+		memcpy(tBuffer->name, tThreadName, sizeof(tThreadName));
+	}
+}
+
+// Microseconds since the capture started, with nanosecond digits.
+static f64 ToTraceTime(u64 timestamp)
+{
+	return (f64)((i64)timestamp - (i64)sStartTime) / 1000.0;
+}
+
+// Appends the events of one track, returns how many were written.
+static u64 WriteTrack(FILE *file, const TraceBuffer &buffer, u32 pid, const char *defaultName)
+{
+	fprintf(file,
+			",\n{\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":",
+			pid,
+			buffer.trackId
+	);
+	if (buffer.name[0] != '\0')
+	{
+		WriteJsonString(file, buffer.name);
+	}
+	else
+	{
+		fprintf(file, "\"%s %u\"", defaultName, buffer.trackId);
+	}
+	fprintf(file, "}}");
+
+	const u32 count = buffer.count.load(std::memory_order_acquire);
+	for (u32 i = 0; i < count; ++i)
+	{
+		const TraceEvent &event = buffer.events[i];
+		const f64         ts    = ToTraceTime(event.timestamp);
+
+		switch (event.type)
+		{
+		case TraceEventType::eBegin:
+			fprintf(file,
+					",\n{\"ph\":\"B\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"name\":",
+					pid,
+					buffer.trackId,
+					ts
+			);
+			WriteJsonString(file, event.name);
+			fprintf(file, "}");
+			break;
+		case TraceEventType::eEnd:
+			fprintf(file,
+					",\n{\"ph\":\"E\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f}",
+					pid,
+					buffer.trackId,
+					ts
+			);
+			break;
+		case TraceEventType::eComplete:
+			fprintf(file,
+					",\n{\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":",
+					pid,
+					buffer.trackId,
+					ts,
+					(f64)event.duration / 1000.0
+			);
+			WriteJsonString(file, event.name);
+			fprintf(file, "}");
+			break;
+		}
+	}
+
+	return count;
+}
+
+bool Trace::WriteChromeJson(const char *path)
+{
+	COV_ASSERT(!IsCapturing(), "WriteChromeJson during a capture.");
+
+	FILE *file = fopen(path, "w");
+	if (file == nullptr)
+	{
+		CLOG_ERR("Failed to open \"", path, "\" for writing.");
+		return EXIT_FAILURE;
+	}
+
+	// CPU threads are process 0, the GPU queue process 1, so viewers show them as two groups.
+	fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	for (u32 pid = 0; pid < 2; ++pid)
+	{
+		fprintf(file,
+				"%s{\"ph\":\"M\",\"pid\":%u,\"name\":\"process_name\",\"args\":{\"name\":\"%s\"}}",
+				pid == 0 ? "" : ",\n",
+				pid,
+				pid == 0 ? "CPU" : "GPU"
+		);
+	}
+
+	const u32 generation = sGeneration.load(std::memory_order_acquire);
+
+	u64 written = 0;
+	u64 dropped = 0;
+	{
+		std::lock_guard<std::mutex> lock(sBuffersMutex);
+		for (const std::unique_ptr<TraceBuffer> &buffer : sBuffers)
+		{
+			if (buffer->generation.load(std::memory_order_acquire) == generation)
+			{
+				written += WriteTrack(file, *buffer, 0, "Thread");
+				dropped += buffer->dropped.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	if (sGpuBuffer.generation.load(std::memory_order_acquire) == generation)
+	{
+		written += WriteTrack(file, sGpuBuffer, 1, "Queue");
+		dropped += sGpuBuffer.dropped.load(std::memory_order_relaxed);
+	}
+
+	fprintf(file, "\n]}\n");
+
+	const bool failed = ferror(file) != 0;
+	fclose(file);
+
+	if (failed)
+	{
+		CLOG_ERR("Failed to write \"", path, "\".");
+		return EXIT_FAILURE;
+	}
+
+	if (dropped > 0)
+	{
+		CLOG_WARN("Trace buffers were full, ", dropped, " events dropped.");
+	}
+	CLOG_INFO("Trace with ", written, " events written to \"", path, "\".");
+	return EXIT_SUCCESS;
+}
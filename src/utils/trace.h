@@ -0,0 +1,94 @@
+#ifndef HEADER_TRACE_H
+#define HEADER_TRACE_H
+
+#include "definitions.h"
+
+#include <atomic>
+
+/* Timeline capture written as Chrome Trace Event JSON, which chrome://tracing and the Perfetto UI
+ * open directly.
+ *
+ * COV_TRACE_SCOPE records a begin and an end event into the calling thread's buffer. Only that
+ * thread writes it and each event is published with one release store, so recording takes no
+ * lock and, once the buffer exists (on the thread's first event of a capture), never allocates.
+ * A full buffer drops events and counts them. GPU scopes (render/gpu_trace.h) go to a track of
+ * their own with timestamps already converted to Now()'s clock.
+ *
+ * Names are not copied and have to outlive the capture: string literals, render graph pass
+ * names. Outside a capture a scope costs one relaxed load, building with COV_DISABLE_TRACING
+ * removes them entirely. */
+class Trace
+{
+public:
+	static constexpr u32 kDefaultEventsPerThread = 64 * 1024;
+
+	// Longest thread name kept, including the terminator.
+	static constexpr u32 kMaxThreadNameSize = 32;
+
+public:
+	/* Starts a new capture, events of the previous one are discarded. Each thread recording
+	 * during the capture gets room for eventsPerThread events. */
+	static void Start(u32 eventsPerThread = kDefaultEventsPerThread);
+
+	static void Stop();
+
+	[[nodiscard]] static bool IsCapturing()
+	{
+		return sCapturing.load(std::memory_order_relaxed);
+	}
+
+	// Steady clock in nanoseconds, the time base of every event.
+	[[nodiscard]] static u64 Now();
+
+	// False when not capturing or when the thread's buffer is full, such a scope is not ended.
+	static bool BeginScope(const char *name);
+
+	static void EndScope();
+
+	/* Adds a finished GPU scope, timestamps in Now()'s clock. Meant to be called from a single
+	 * thread, the one reading back the GPU queries. */
+	static void AddGpuScope(const char *name, u64 beginNs, u64 endNs);
+
+	// Names the calling thread's track, copied.
+	static void SetThreadName(const char *name);
+
+	// Writes the last capture, call after Stop().
+	static bool WriteChromeJson(const char *path);
+
+private:
+	static inline std::atomic<bool> sCapturing = false;
+};
+
+class TraceScope
+{
+public:
+	explicit TraceScope(const char *name)
+		: mActive(Trace::IsCapturing() && Trace::BeginScope(name))
+	{
+	}
+
+	~TraceScope()
+	{
+		if (mActive)
+		{
+			Trace::EndScope();
+		}
+	}
+
+	TraceScope(const TraceScope &)            = delete;
+	TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+	bool mActive;
+};
+
+#define COV_TRACE_CONCAT_INNER(a, b) a##b
+#define COV_TRACE_CONCAT(a, b) COV_TRACE_CONCAT_INNER(a, b)
+
+#ifdef COV_DISABLE_TRACING
+#define COV_TRACE_SCOPE(name)
+#else
+#define COV_TRACE_SCOPE(name) TraceScope COV_TRACE_CONCAT(traceScope, __LINE__)(name)
+#endif
+
+#endif// HEADER_TRACE_H
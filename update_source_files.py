@@ -1,13 +1,19 @@
 import os
 import re
 
+# Sources only the benchmarks build, CMakeLists.txt lists them for their targets.
+BENCH_ONLY_SOURCES = (
+    "src/scene/transform_hierarchy.cpp",
+)
+
 def find_source_files(directory, extensions):
     source_files = []
     for root, _, files in os.walk(directory):
         for file in files:
             if any(file.endswith(ext) for ext in extensions):
                 rel_path = directory + "/" + os.path.relpath(os.path.join(root, file), directory).replace('\\', '/')
-                source_files.append(rel_path)
+                if rel_path not in BENCH_ONLY_SOURCES:
+                    source_files.append(rel_path)
     return sorted(source_files)
 
 def update_cmake_file(cmake_file, variable_name, file_list):